@@ -86,6 +86,8 @@ int enmx_L7_connect( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress )
     
     connInfo->L7connection = 0;
     connInfo->L7sequence_id = 0;
+    connInfo->L7mask = 0;
+    connInfo->L7maxapdu = 0;
     
     // get mask version
     for( loop = 0; loop < ENMX_L7_MAXREPEAT; loop++ ) {
@@ -120,6 +122,7 @@ int enmx_L7_connect( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress )
             connInfo->L7sequence_id = 0;
         }
         mask = (uint16_t *) &buf[2];
+        connInfo->L7mask = ntohs( *mask );
         if( ntohs( *mask ) < 0x12 ) {
             connInfo->errorcode = ENMX_E_L7_MASK;
             return( -1 );
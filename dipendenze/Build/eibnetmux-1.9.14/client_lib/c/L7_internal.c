@@ -38,6 +38,7 @@
 static int  _enmx_L7SendAckNak( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress, uint8_t tpci, uint8_t acknak );
 static int  _enmx_L7CheckResponse( CEMIFRAME *cemi, uint8_t tpci, uint16_t apci, int sequence );
 static int  _enmx_L7MapError( uint16_t error );
+static int  _enmx_L7ReceiveResponse( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress, unsigned char *buf, int *length, uint8_t tpci, uint16_t apci, int ack );
 
 
 /*!
@@ -61,7 +62,7 @@ int _enmx_L7Passthrough( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress )
     // request passthrough connection
     cmd_head.cmd = SOCKET_CMD_PASSTHROUGH;
     cmd_head.address = htons( knxaddress );
-    ecode = pConn->send( pConn->socket, (unsigned char *)&cmd_head, sizeof( cmd_head ));
+    ecode = pConn->send( pConn->handle, (unsigned char *)&cmd_head, sizeof( cmd_head ));
     if( ecode < 0 ) {
         pConn->errorcode = ecode;
         return( -1 );
@@ -160,7 +161,7 @@ static int _enmx_L7SendAckNak( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress,
     params.tpci = acknak | (tpci & 0x3c);
     params.apci = 0;
     params.priority = ENMX_PRIO_SYSTEM;
-    ecode = pConn->send( pConn->socket, (unsigned char *)&params, sizeof( params ));
+    ecode = pConn->send( pConn->handle, (unsigned char *)&params, sizeof( params ));
     if( ecode < 0 ) {
         pConn->errorcode = ecode;
         return( -1 );
@@ -226,7 +227,7 @@ int _enmx_L7GetAckNak( sConnectionInfo *pConn )
     
     // get acknowledgement
     // we will receive the full cemi frame and extract the response code (which must be T_CONNECT_CONF_PDU)
-    ecode = pConn->recv( pConn->socket, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
+    ecode = pConn->recv( pConn->handle, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
     if( ecode < 0 ) {
         pConn->errorcode = ecode;
         return( -1 );
@@ -245,7 +246,7 @@ int _enmx_L7GetAckNak( sConnectionInfo *pConn )
         pConn->errorcode = ENMX_E_NO_MEMORY;
         return( -1 );
     }
-    ecode = pConn->recv( pConn->socket, (unsigned char *)cemi, rsp_head.size, 1 );
+    ecode = pConn->recv( pConn->handle, (unsigned char *)cemi, rsp_head.size, 1 );
     if( ecode == 0 ) {
         if( cemi->length == 0 ) {
             if( cemi->tpci == (T_DATA_ACK_PDU | ((pConn->L7sequence_id & 0xff) << 2)) ) {
@@ -271,6 +272,46 @@ int _enmx_L7GetAckNak( sConnectionInfo *pConn )
  * \return                  0: ok, -1: error (errorcode set accordingly)
  */
 int _enmx_L7Response( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress, unsigned char *buf, int *length, uint8_t tpci, uint16_t apci )
+{
+    return( _enmx_L7ReceiveResponse( pConn, knxaddress, buf, length, tpci, apci, 1 ));
+}
+
+
+/*!
+ * \brief get and check response to last layer 7 request, do not acknowledge it
+ * 
+ * The caller must send the T_ACK itself (tpci is returned in buf[0]).
+ * This allows to send it together with the next request.
+ * 
+ * \param   pConn           pointer to connection structure
+ * \param   knxaddress      physical address of remote device
+ * \param   buf             pointer to buffer receiving data (tpci, apci, data), must not be NULL
+ * \param   length          pointer to variable specifying maximum size of data buffer, receives actual length of received data
+ * \param   tpci            required transport control field setting
+ * \param   apci            required application control field setting
+ * 
+ * \return                  0: ok, -1: error (errorcode set accordingly)
+ */
+int _enmx_L7ResponseNoAck( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress, unsigned char *buf, int *length, uint8_t tpci, uint16_t apci )
+{
+    return( _enmx_L7ReceiveResponse( pConn, knxaddress, buf, length, tpci, apci, 0 ));
+}
+
+
+/*!
+ * \brief receive and check response, acknowledge it if requested
+ * 
+ * \param   pConn           pointer to connection structure
+ * \param   knxaddress      physical address of remote device
+ * \param   buf             pointer to buffer receiving data (tpci, apci, data)
+ * \param   length          pointer to variable specifying maximum size of data buffer, receives actual length of received data
+ * \param   tpci            required transport control field setting
+ * \param   apci            required application control field setting
+ * \param   ack             true: send T_ACK for valid response
+ * 
+ * \return                  0: ok, -1: error (errorcode set accordingly)
+ */
+static int _enmx_L7ReceiveResponse( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress, unsigned char *buf, int *length, uint8_t tpci, uint16_t apci, int ack )
 {
     SOCKET_RSP_HEAD     rsp_head;
     CEMIFRAME           *cemi;
@@ -278,7 +319,7 @@ int _enmx_L7Response( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress, unsigned
     
     // get acknowledgement
     // we will receive the full cemi frame and extract the response code
-    ecode = pConn->recv( pConn->socket, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
+    ecode = pConn->recv( pConn->handle, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
     if( ecode < 0 ) {
         pConn->errorcode = ecode;
         return( -1 );
@@ -297,7 +338,7 @@ int _enmx_L7Response( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress, unsigned
         pConn->errorcode = ENMX_E_NO_MEMORY;
         return( -1 );
     }
-    ecode = pConn->recv( pConn->socket, (unsigned char *)cemi, rsp_head.size, 1 );
+    ecode = pConn->recv( pConn->handle, (unsigned char *)cemi, rsp_head.size, 1 );
     if( ecode == 0 ) {
         if( _enmx_L7CheckResponse( cemi, tpci, apci, pConn->L7sequence_id )) {
             (void) _enmx_L7SendAckNak( pConn, knxaddress, cemi->tpci, T_DATA_NAK_PDU );
@@ -311,7 +352,9 @@ int _enmx_L7Response( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress, unsigned
                 memcpy( buf, &cemi->tpci, cemi->length +1 );
                 *length = cemi->length +1;
             }
-            (void) _enmx_L7SendAckNak( pConn, knxaddress, cemi->tpci, T_DATA_ACK_PDU );
+            if( ack ) {
+                (void) _enmx_L7SendAckNak( pConn, knxaddress, cemi->tpci, T_DATA_ACK_PDU );
+            }
         }
     } else {
         pConn->errorcode = ecode;
@@ -38,6 +38,14 @@
 #include "enmx_lib.private.h"
 
 #define CHUNKSIZE           12
+#define TXBUFSIZE           (2 * (sizeof( SOCKET_CMD_HEAD ) + sizeof( sLayer7Params )) + ENMX_L7_MEMORY_MAX + 2)
+
+
+/*
+ * local functions
+ */
+static int  _enmx_L7Append( unsigned char *txbuf, int txlen, ENMX_ADDRESS knxaddress, sLayer7Params *params, unsigned char *data, int datalen );
+static void _enmx_L7Progress( ENMX_L7_PROGRESS progress, void *arg, ENMX_ADDRESS knxaddress, uint32_t done, uint32_t total, long long start );
 
 
 /*!
@@ -209,4 +217,326 @@ int enmx_L7_writememory( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t o
     
     return( bytes );
 }
+
+
+/*!
+ * \brief append passthrough request to transmit buffer
+ * 
+ * Several requests can be sent to the server with a single write.
+ * 
+ * \param   txbuf           transmit buffer
+ * \param   txlen           number of bytes already in buffer
+ * \param   knxaddress      physical address of remote device
+ * \param   params          layer 7 parameters
+ * \param   data            data following parameters (address, memory bytes)
+ * \param   datalen         number of data bytes
+ * 
+ * \return                  new number of bytes in buffer
+ */
+static int _enmx_L7Append( unsigned char *txbuf, int txlen, ENMX_ADDRESS knxaddress, sLayer7Params *params, unsigned char *data, int datalen )
+{
+    SOCKET_CMD_HEAD         cmd_head;
+    
+    cmd_head.cmd = SOCKET_CMD_PASSTHROUGH;
+    cmd_head.address = htons( knxaddress );
+    memcpy( txbuf + txlen, &cmd_head, sizeof( cmd_head ));
+    txlen += sizeof( cmd_head );
+    memcpy( txbuf + txlen, params, sizeof( sLayer7Params ));
+    txlen += sizeof( sLayer7Params );
+    if( datalen > 0 ) {
+        memcpy( txbuf + txlen, data, datalen );
+        txlen += datalen;
+    }
+    return( txlen );
+}
+
+
+/*!
+ * \brief report progress of bulk transfer
+ */
+static void _enmx_L7Progress( ENMX_L7_PROGRESS progress, void *arg, ENMX_ADDRESS knxaddress, uint32_t done, uint32_t total, long long start )
+{
+    long long               elapsed;
+    
+    if( progress == NULL ) {
+        return;
+    }
+    elapsed = _enmx_msec() - start;
+    if( elapsed <= 0 ) {
+        elapsed = 1;
+    }
+    progress( knxaddress, done, total, (uint32_t)(done * 1000LL / elapsed), arg );
+}
+
+
+/*!
+ * \brief determine maximum APDU length supported by remote KNX device
+ * 
+ * Devices with interface objects are asked for property PID_MAX_APDU_LENGTH
+ * of their device object. Older devices (see mask version read by enmx_L7_connect()),
+ * and devices which do not know the property, support standard frames only.
+ * The result is cached until the next enmx_L7_connect().
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   knxaddress      physical address of remote device
+ * 
+ * \return                  >0: maximum APDU length, -1: error (get error code with enmx_geterror), ENMX_E_NO_CONNECTION: invalid handle
+ */
+int enmx_L7_maxapdu( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress )
+{
+    sConnectionInfo         *connInfo;
+    sLayer7Params           params;
+    unsigned char           data[16];
+    int                     len;
+    int                     ecode;
+    uint16_t                maxapdu;
+    
+    // get connection info block
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    if( _enmx_connectionState( connInfo, stateLayer7 ) != 0 ) {
+        return( -1 );
+    }
+    if( _enmx_L7State( connInfo ) != 0 ) {
+        return( -1 );
+    }
+    if( connInfo->L7maxapdu != 0 ) {
+        return( connInfo->L7maxapdu );
+    }
+    if( connInfo->L7mask < ENMX_L7_MASK_PROPERTIES ) {
+        connInfo->L7maxapdu = ENMX_L7_APDU_STANDARD;
+        return( connInfo->L7maxapdu );
+    }
+    
+    if( _enmx_L7Passthrough( connInfo, knxaddress ) != 0 ) {
+        return( -1 );
+    }
+    
+    // read property of device object (index 0), 1 element starting at index 1
+    params.length = 5;
+    params.tpci = T_DATA_REQ_PDU | ((A_READ_PROPERTY_VALUE_REQ_PDU & 0x0300) >> 8) | ((connInfo->L7sequence_id & 0x0f) << 2);
+    params.apci = (A_READ_PROPERTY_VALUE_REQ_PDU & 0x00ff);
+    params.priority = ENMX_PRIO_SYSTEM;
+    data[0] = 0;
+    data[1] = ENMX_L7_PID_MAX_APDU;
+    data[2] = 0x10;
+    data[3] = 0x01;
+    ecode = connInfo->send( handle, (unsigned char *)&params, sizeof( params ));
+    if( ecode == 0 ) {
+        ecode = connInfo->send( handle, data, 4 );
+    }
+    if( ecode < 0 ) {
+        connInfo->errorcode = ecode;
+        return( -1 );
+    }
+    if( _enmx_L7GetAckNak( connInfo ) != 0 ) {
+        return( -1 );
+    }
+    len = sizeof( data );
+    if( _enmx_L7Response( connInfo, knxaddress, data, &len, T_DATA_REQ_PDU, A_READ_PROPERTY_VALUE_RES_PDU ) != 0 ) {
+        return( -1 );
+    }
+    if( ++connInfo->L7sequence_id > 15 ) {
+        connInfo->L7sequence_id = 0;
+    }
+    
+    // response: tpci, apci, object index, property id, count/start index (2 bytes), value (2 bytes)
+    // a count of 0 indicates that the property does not exist
+    maxapdu = ENMX_L7_APDU_STANDARD;
+    if( len >= 8 && (data[4] & 0xf0) != 0 ) {
+        maxapdu = (data[6] << 8) | data[7];
+        if( maxapdu < ENMX_L7_APDU_STANDARD ) {
+            maxapdu = ENMX_L7_APDU_STANDARD;
+        } else if( maxapdu > ENMX_L7_MEMORY_MAX + 3 ) {
+            maxapdu = ENMX_L7_MEMORY_MAX + 3;
+        }
+    }
+    connInfo->L7maxapdu = maxapdu;
+    
+    return( connInfo->L7maxapdu );
+}
+
+
+/*!
+ * \brief read large block of memory of remote KNX device
+ * 
+ * Works like enmx_L7_readmemory() but uses the largest chunks the device
+ * supports (see enmx_L7_maxapdu()). The transport layer acknowledge of each
+ * response is sent together with the request for the next chunk.
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   knxaddress      physical address of remote device
+ * \param   offset          start address of memory to read
+ * \param   length          number of bytes to read
+ * \param   buf             buffer receiving read bytes
+ * \param   progress        function called after each chunk, may be NULL
+ * \param   arg             passed to progress function
+ * 
+ * \return                  >=0: number of bytes read, -1: error (get error code with enmx_geterror), ENMX_E_NO_CONNECTION: invalid handle
+ *                          if number of bytes read is less then requested length, there was an error
+ */
+int enmx_L7_readmemory_bulk( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t offset, uint16_t length, unsigned char *buf, ENMX_L7_PROGRESS progress, void *arg )
+{
+    sConnectionInfo         *connInfo;
+    sLayer7Params           params;
+    unsigned char           txbuf[TXBUFSIZE];
+    unsigned char           data[ENMX_L7_MEMORY_MAX + 8];
+    unsigned char           address[2];
+    uint16_t                bytes;
+    long long               start;
+    int                     txlen;
+    int                     len;
+    int                     chunkMax;
+    int                     chunkSize;
+    int                     ecode;
+    
+    // get connection info block
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    if( (chunkMax = enmx_L7_maxapdu( handle, knxaddress )) < 0 ) {
+        return( chunkMax );
+    }
+    chunkMax -= 3;
+    
+    start = _enmx_msec();
+    txlen = 0;
+    bytes = 0;
+    while( bytes < length ) {
+        // request next chunk, behind acknowledge of previous response
+        chunkSize = (length - bytes >= chunkMax) ? chunkMax : (length - bytes);
+        params.length = 3;
+        params.tpci = T_DATA_REQ_PDU | ((A_READ_MEMORY_REQ_PDU & 0x0300) >> 8) | ((connInfo->L7sequence_id & 0x0f) << 2);
+        params.apci = (A_READ_MEMORY_REQ_PDU & 0x00ff) | chunkSize;
+        params.priority = ENMX_PRIO_SYSTEM;
+        address[0] = (( offset + bytes ) & 0xff00) >> 8;
+        address[1] = ( offset + bytes ) & 0x00ff;
+        txlen = _enmx_L7Append( txbuf, txlen, knxaddress, &params, address, 2 );
+        ecode = connInfo->send( handle, txbuf, txlen );
+        txlen = 0;
+        if( ecode < 0 ) {
+            connInfo->errorcode = ecode;
+            return( bytes );
+        }
+        connInfo->state = stateLayer7;
+        
+        if( _enmx_L7GetAckNak( connInfo ) != 0 ) {
+            return( bytes );
+        }
+        len = sizeof( data );
+        if( _enmx_L7ResponseNoAck( connInfo, knxaddress, data, &len, T_DATA_REQ_PDU, A_READ_MEMORY_RES_PDU ) != 0 ) {
+            return( bytes );
+        }
+        
+        // queue acknowledge
+        params.length = 0;
+        params.tpci = T_DATA_ACK_PDU | (data[0] & 0x3c);
+        params.apci = 0;
+        params.priority = ENMX_PRIO_SYSTEM;
+        txlen = _enmx_L7Append( txbuf, txlen, knxaddress, &params, NULL, 0 );
+        if( ++connInfo->L7sequence_id > 15 ) {
+            connInfo->L7sequence_id = 0;
+        }
+        if( len <= 4 ) {
+            break;
+        }
+        // never more than requested, whatever the device returns
+        len -= 4;
+        if( len > chunkSize ) {
+            len = chunkSize;
+        }
+        if( len > length - bytes ) {
+            len = length - bytes;
+        }
+        memcpy( buf + bytes, &data[4], len );
+        bytes += len;
+        _enmx_L7Progress( progress, arg, knxaddress, bytes, length, start );
+    }
+    
+    // send last acknowledge
+    if( txlen > 0 ) {
+        ecode = connInfo->send( handle, txbuf, txlen );
+        if( ecode < 0 ) {
+            connInfo->errorcode = ecode;
+        }
+    }
+    
+    return( bytes );
+}
+
+
+/*!
+ * \brief write large block of memory of remote KNX device
+ * 
+ * Works like enmx_L7_writememory() but uses the largest chunks the device
+ * supports (see enmx_L7_maxapdu()) and sends each chunk with a single write.
+ * The transport layer allows only one unacknowledged request,
+ * so the next chunk is sent as soon as the acknowledge has been received.
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   knxaddress      physical address of remote device
+ * \param   offset          start address of memory to write
+ * \param   length          number of bytes to write
+ * \param   buf             bytes to write
+ * \param   progress        function called after each chunk, may be NULL
+ * \param   arg             passed to progress function
+ * 
+ * \return                  >=0: number of bytes written, -1: error (get error code with enmx_geterror), ENMX_E_NO_CONNECTION: invalid handle
+ *                          if number of bytes written is less then requested length, there was an error
+ */
+int enmx_L7_writememory_bulk( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t offset, uint16_t length, unsigned char *buf, ENMX_L7_PROGRESS progress, void *arg )
+{
+    sConnectionInfo         *connInfo;
+    sLayer7Params           params;
+    unsigned char           txbuf[TXBUFSIZE];
+    unsigned char           data[ENMX_L7_MEMORY_MAX + 2];
+    uint16_t                bytes;
+    long long               start;
+    int                     txlen;
+    int                     chunkMax;
+    int                     chunkSize;
+    int                     ecode;
+    
+    // get connection info block
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    if( (chunkMax = enmx_L7_maxapdu( handle, knxaddress )) < 0 ) {
+        return( chunkMax );
+    }
+    chunkMax -= 3;
+    
+    start = _enmx_msec();
+    bytes = 0;
+    while( bytes < length ) {
+        chunkSize = (length - bytes >= chunkMax) ? chunkMax : (length - bytes);
+        params.length = chunkSize +3;
+        params.tpci = T_DATA_REQ_PDU | ((A_WRITE_MEMORY_REQ_PDU & 0x0300) >> 8) | ((connInfo->L7sequence_id & 0x0f) << 2);
+        params.apci = (A_WRITE_MEMORY_REQ_PDU & 0x00ff) | chunkSize;
+        params.priority = ENMX_PRIO_SYSTEM;
+        data[0] = (( offset + bytes ) & 0xff00) >> 8;
+        data[1] = ( offset + bytes ) & 0x00ff;
+        memcpy( &data[2], buf + bytes, chunkSize );
+        txlen = _enmx_L7Append( txbuf, 0, knxaddress, &params, data, chunkSize +2 );
+        ecode = connInfo->send( handle, txbuf, txlen );
+        if( ecode < 0 ) {
+            connInfo->errorcode = ecode;
+            return( bytes );
+        }
+        connInfo->state = stateLayer7;
+        
+        if( _enmx_L7GetAckNak( connInfo ) != 0 ) {
+            return( bytes );
+        }
+        
+        bytes += chunkSize;
+        if( ++connInfo->L7sequence_id > 15 ) {
+            connInfo->L7sequence_id = 0;
+        }
+        _enmx_L7Progress( progress, arg, knxaddress, bytes, length, start );
+    }
+    
+    return( bytes );
+}
 /*! @} */
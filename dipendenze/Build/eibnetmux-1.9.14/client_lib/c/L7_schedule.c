@@ -0,0 +1,402 @@
+/*!
+ * eibnetmux - eibnet/ip multiplexer
+ * Copyright (C) 2006-2009 Urs Zurbuchen <going_nuts@users.sourceforge.net>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * \if DeveloperDocs
+ *   \brief Layer 7 API - process jobs for many devices concurrently
+ * \endif
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <pth.h>
+
+#include "enmx_lib.private.h"
+
+#define CHUNKSIZE_DEFAULT   256
+#define LINES               256
+#define LINE( a )           (((a) >> 8) & 0xff)
+
+#define JOB_PENDING         0
+#define JOB_RUNNING         1
+#define JOB_DONE            2
+
+
+/*
+ * scheduler state shared by all worker threads
+ */
+typedef struct _sL7Scheduler {
+    sENMX_L7Schedule        *schedule;
+    sENMX_L7Job             *jobs;
+    int                     count;
+    int                     *state;             // JOB_PENDING, ...
+    int                     next;               // first job which may still be pending
+    int                     busy[LINES];        // active sessions per line
+    int                     per_line;
+    int                     chunksize;
+    char                    **servers;
+    int                     nr_servers;
+    int                     errorcode;          // last connection error
+    pth_mutex_t             mtx;
+    pth_cond_t              cond;
+} sL7Scheduler;
+
+typedef struct _sL7Worker {
+    sL7Scheduler            *sched;
+    char                    *server;
+} sL7Worker;
+
+
+/*
+ * local functions
+ */
+static void         *_enmx_L7Worker( void *arg );
+static sENMX_L7Job  *_enmx_L7NextJob( sL7Scheduler *sched, int *index );
+static void         _enmx_L7JobDone( sL7Scheduler *sched, int index );
+static int          _enmx_L7RunJob( sL7Scheduler *sched, ENMX_HANDLE handle, sENMX_L7Job *job );
+static int          _enmx_L7Reconnect( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, int retries );
+
+
+/*!
+ * \addtogroup xgBus
+ * @{
+ */
+
+/*!
+ * \brief process layer 7 jobs for many devices concurrently
+ * 
+ * Up to schedule->sessions worker threads are started, each with its own
+ * connection to one of the eibnetmux servers (round-robin).
+ * Each worker takes the next job whose KNX line has less than
+ * schedule->sessions_per_line active sessions, so one busy line
+ * does not hold up the others.
+ * 
+ * Memory is transferred in chunks of schedule->chunksize bytes using
+ * enmx_L7_readmemory_bulk()/enmx_L7_writememory_bulk(). A failed chunk
+ * is retried after re-establishing the layer 7 connection.
+ * 
+ * Workers use PTH threads. If the application has not initialised PTH,
+ * this is done (and undone) by the function.
+ * 
+ * \param   schedule        scheduling parameters and callbacks
+ * \param   jobs            array of jobs, result is filled in for each job
+ * \param   count           number of jobs
+ * 
+ * \return                  number of successful jobs, <0: error
+ */
+int enmx_L7_schedule( sENMX_L7Schedule *schedule, sENMX_L7Job *jobs, int count )
+{
+    sL7Scheduler            sched;
+    sL7Worker               *workers;
+    char                    *noserver[2] = { NULL, NULL };
+    pth_t                   *tids;
+    pth_attr_t              thread_attr;
+    int                     pth_ours;
+    int                     nr_workers;
+    int                     loop;
+    int                     ok;
+    
+    if( schedule == NULL || jobs == NULL || count < 0 || schedule->sessions <= 0 ) {
+        return( ENMX_E_PARAMETER );
+    }
+    if( enmx_mode != ENMX_LIB_INITIALISED ) {
+        return( ENMX_E_NOT_INITIALISED );
+    }
+    if( count == 0 ) {
+        return( 0 );
+    }
+    
+    // initialise pth unless application already did
+    pth_ours = (pth_init() == TRUE);
+    
+    memset( &sched, 0, sizeof( sched ));
+    sched.schedule  = schedule;
+    sched.jobs      = jobs;
+    sched.count     = count;
+    sched.per_line  = (schedule->sessions_per_line > 0) ? schedule->sessions_per_line : 1;
+    sched.chunksize = (schedule->chunksize > 0) ? schedule->chunksize : CHUNKSIZE_DEFAULT;
+    sched.errorcode = ENMX_E_SERVER_NOTRUNNING;
+    pth_mutex_init( &sched.mtx );
+    pth_cond_init( &sched.cond );
+    
+    // list of servers, without a list enmx_pth_open() searches for the server
+    if( schedule->servers != NULL && schedule->servers[0] != NULL ) {
+        for( sched.nr_servers = 0; schedule->servers[sched.nr_servers] != NULL; sched.nr_servers++ );
+        sched.servers = schedule->servers;
+    } else {
+        sched.nr_servers = 1;
+        sched.servers = noserver;
+    }
+    
+    sched.state = calloc( count, sizeof( int ));
+    nr_workers = (schedule->sessions < count) ? schedule->sessions : count;
+    workers = malloc( nr_workers * sizeof( sL7Worker ));
+    tids = calloc( nr_workers, sizeof( pth_t ));
+    if( sched.state == NULL || workers == NULL || tids == NULL ) {
+        if( sched.state ) free( sched.state );
+        if( workers ) free( workers );
+        if( tids ) free( tids );
+        if( pth_ours ) pth_kill();
+        return( ENMX_E_NO_MEMORY );
+    }
+    
+    // start workers
+    thread_attr = pth_attr_new();
+    pth_attr_set( thread_attr, PTH_ATTR_JOINABLE, TRUE );
+    for( loop = 0; loop < nr_workers; loop++ ) {
+        workers[loop].sched = &sched;
+        workers[loop].server = sched.servers[loop % sched.nr_servers];
+        tids[loop] = pth_spawn( thread_attr, _enmx_L7Worker, &workers[loop] );
+    }
+    pth_attr_destroy( thread_attr );
+    for( loop = 0; loop < nr_workers; loop++ ) {
+        if( tids[loop] != NULL ) {
+            pth_join( tids[loop], NULL );
+        }
+    }
+    
+    // jobs nobody could process (no connection)
+    ok = 0;
+    for( loop = 0; loop < count; loop++ ) {
+        if( sched.state[loop] != JOB_DONE ) {
+            jobs[loop].result = sched.errorcode;
+            if( schedule->done != NULL ) {
+                schedule->done( &jobs[loop], schedule->arg );
+            }
+        } else if( jobs[loop].result >= 0 ) {
+            ok++;
+        }
+    }
+    
+    free( tids );
+    free( workers );
+    free( sched.state );
+    if( pth_ours ) pth_kill();
+    
+    return( ok );
+}
+/*! @} */
+
+
+/*!
+ * \cond DeveloperDocs
+ */
+
+/*!
+ * \brief worker thread
+ * 
+ * Opens its own connection to eibnetmux and processes jobs until none are left.
+ * 
+ * \param   arg             worker description (sL7Worker)
+ */
+static void *_enmx_L7Worker( void *arg )
+{
+    sL7Worker               *worker = (sL7Worker *)arg;
+    sL7Scheduler            *sched = worker->sched;
+    sENMX_L7Job             *job;
+    ENMX_HANDLE             handle;
+    int                     index;
+    
+    handle = enmx_pth_open( worker->server, "L7 scheduler" );
+    if( handle < 0 ) {
+        sched->errorcode = handle;
+        return( NULL );
+    }
+    while( (job = _enmx_L7NextJob( sched, &index )) != NULL ) {
+        job->result = _enmx_L7RunJob( sched, handle, job );
+        _enmx_L7JobDone( sched, index );
+        if( sched->schedule->done != NULL ) {
+            sched->schedule->done( job, sched->schedule->arg );
+        }
+    }
+    
+    enmx_close( handle );
+    return( NULL );
+}
+
+
+/*!
+ * \brief get next job whose line is not busy
+ * 
+ * Waits until a session on a line becomes available.
+ * 
+ * \param   sched           scheduler state
+ * \param   index           receives index of job
+ * 
+ * \return                  job, NULL: no jobs left
+ */
+static sENMX_L7Job *_enmx_L7NextJob( sL7Scheduler *sched, int *index )
+{
+    sENMX_L7Job             *job;
+    int                     pending;
+    int                     loop;
+    
+    job = NULL;
+    pth_mutex_acquire( &sched->mtx, FALSE, NULL );
+    while( job == NULL ) {
+        pending = 0;
+        for( loop = sched->next; loop < sched->count; loop++ ) {
+            if( sched->state[loop] != JOB_PENDING ) {
+                if( loop == sched->next ) {
+                    sched->next++;
+                }
+                continue;
+            }
+            pending = 1;
+            if( sched->busy[LINE( sched->jobs[loop].knxaddress )] < sched->per_line ) {
+                sched->state[loop] = JOB_RUNNING;
+                sched->busy[LINE( sched->jobs[loop].knxaddress )]++;
+                job = &sched->jobs[loop];
+                *index = loop;
+                break;
+            }
+        }
+        if( pending == 0 ) {
+            break;
+        }
+        if( job == NULL ) {
+            pth_cond_await( &sched->cond, &sched->mtx, NULL );
+        }
+    }
+    pth_mutex_release( &sched->mtx );
+    
+    return( job );
+}
+
+
+/*!
+ * \brief mark job as done, release its line
+ * 
+ * \param   sched           scheduler state
+ * \param   index           index of job
+ */
+static void _enmx_L7JobDone( sL7Scheduler *sched, int index )
+{
+    pth_mutex_acquire( &sched->mtx, FALSE, NULL );
+    sched->state[index] = JOB_DONE;
+    sched->busy[LINE( sched->jobs[index].knxaddress )]--;
+    pth_cond_notify( &sched->cond, TRUE );
+    pth_mutex_release( &sched->mtx );
+}
+
+
+/*!
+ * \brief (re-)establish layer 7 connection with remote device
+ * 
+ * \param   handle          connection handle
+ * \param   knxaddress      physical address of remote device
+ * \param   retries         number of additional attempts
+ * 
+ * \return                  0: ok, <0: error code
+ */
+static int _enmx_L7Reconnect( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, int retries )
+{
+    int                     loop;
+    
+    for( loop = 0; loop <= retries; loop++ ) {
+        if( enmx_L7_connect( handle, knxaddress ) == 0 ) {
+            return( 0 );
+        }
+        if( enmx_geterror( handle ) == ENMX_E_L7_MASK ) {
+            break;
+        }
+        (void) enmx_L7_disconnect( handle, knxaddress );
+    }
+    return( enmx_geterror( handle ));
+}
+
+
+/*!
+ * \brief process one job
+ * 
+ * \param   sched           scheduler state
+ * \param   handle          connection handle
+ * \param   job             job to process
+ * 
+ * \return                  >=0: number of bytes transferred, <0: error code
+ */
+static int _enmx_L7RunJob( sL7Scheduler *sched, ENMX_HANDLE handle, sENMX_L7Job *job )
+{
+    sENMX_L7Schedule        *schedule = sched->schedule;
+    uint16_t                done;
+    uint16_t                chunk;
+    int                     bytes;
+    int                     tries;
+    int                     ecode;
+    
+    if( (ecode = _enmx_L7Reconnect( handle, job->knxaddress, schedule->retries )) != 0 ) {
+        return( ecode );
+    }
+    
+    switch( job->operation ) {
+        case ENMX_L7_JOB_RESET:
+            ecode = (enmx_L7_reset( handle, job->knxaddress ) == 0) ? 0 : enmx_geterror( handle );
+            return( ecode );
+        case ENMX_L7_JOB_READ:
+        case ENMX_L7_JOB_WRITE:
+            break;
+        default:
+            (void) enmx_L7_disconnect( handle, job->knxaddress );
+            return( ENMX_E_PARAMETER );
+    }
+    
+    done = 0;
+    tries = 0;
+    ecode = 0;
+    while( done < job->length ) {
+        chunk = (job->length - done > sched->chunksize) ? sched->chunksize : job->length - done;
+        if( job->operation == ENMX_L7_JOB_READ ) {
+            bytes = enmx_L7_readmemory_bulk( handle, job->knxaddress, job->offset + done, chunk, job->buf + done, NULL, NULL );
+        } else {
+            bytes = enmx_L7_writememory_bulk( handle, job->knxaddress, job->offset + done, chunk, job->buf + done, NULL, NULL );
+        }
+        if( bytes > 0 ) {
+            if( schedule->chunk != NULL ) {
+                schedule->chunk( job, job->offset + done, bytes, schedule->arg );
+            }
+            done += bytes;
+        }
+        if( bytes == chunk ) {
+            tries = 0;
+            continue;
+        }
+        
+        // failed - keep what we got and retry remainder of chunk on a fresh layer 7 connection
+        ecode = enmx_geterror( handle );
+        if( ecode >= 0 ) {
+            ecode = ENMX_E_L7_SEQUENCE;
+        }
+        if( ++tries > schedule->retries ) {
+            break;
+        }
+        (void) enmx_L7_disconnect( handle, job->knxaddress );
+        if( (ecode = _enmx_L7Reconnect( handle, job->knxaddress, 0 )) != 0 ) {
+            break;
+        }
+    }
+    (void) enmx_L7_disconnect( handle, job->knxaddress );
+    
+    return( (done == job->length) ? done : ecode );
+}
+/*!
+ * \endcond
+ */
@@ -78,7 +78,7 @@ int enmx_auth( ENMX_HANDLE handle, char *user, char *password )
     int                     len;
     havege_state            hs;
     dhm_context             dhm;
-    aes_context             aes;
+    sConnectionCrypt        *crypt;
     unsigned char           buf[1024];
     unsigned char           *ptr_start;
     unsigned char           *ptr_end;
@@ -87,11 +87,7 @@ int enmx_auth( ENMX_HANDLE handle, char *user, char *password )
 #endif
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( ENMX_E_NO_CONNECTION );
     }
@@ -172,22 +168,39 @@ int enmx_auth( ENMX_HANDLE handle, char *user, char *password )
     dhm_calc_secret( &dhm, buf, &len );
     dhm_free( &dhm );
     
+    // expand key schedules once, they are kept for the lifetime of the connection
+    // an already encrypted stream keeps its session key (as does the server)
+    crypt = connInfo->crypt;
+    if( crypt == NULL ) {
+        crypt = malloc( sizeof( sConnectionCrypt ));
+        if( crypt == NULL ) {
+            connInfo->errorcode = ENMX_E_NO_MEMORY;
+            return( -1 );
+        }
+        memset( crypt, 0, sizeof( sConnectionCrypt ));
+        connInfo->crypt = crypt;
+    }
+    if( crypt->stream == 0 ) {
+        aes_setkey_enc( &crypt->enc, buf, 256 );
+        aes_setkey_dec( &crypt->dec, buf, 256 );
+    }
+    memset( buf, '\0', len );
+    
     // encrypt username & password
     // format: ecb( iv ), cfb( user \0 password \0 )
-    aes_setkey_enc( &aes, buf, 256 );
     memset( iv, '\0', 16 );
     for( len = 0; len < 16; len += 4 ) {
         ecode = havege_rand( &hs );
         memcpy( &iv[len], &ecode, sizeof( int ));
     }
-    aes_crypt_ecb( &aes, AES_ENCRYPT, iv, buf );
+    aes_crypt_ecb( &crypt->enc, AES_ENCRYPT, iv, buf );
     len = 16;
     strcpy( (char *)(buf + len), user );
     len += strlen( user ) +1;
     strcpy( (char *)(buf + len), password );
     len += strlen( password ) + 1;
     iv_off = 0;
-    aes_crypt_cfb128( &aes, AES_ENCRYPT, len -16, &iv_off, iv, buf + 16, buf + 16 );
+    aes_crypt_cfb128( &crypt->enc, AES_ENCRYPT, len -16, &iv_off, iv, buf + 16, buf + 16 );
     
     // authenticate to eibnetmux
     cmd_head.cmd = SOCKET_CMD_AUTH;
@@ -205,7 +218,6 @@ int enmx_auth( ENMX_HANDLE handle, char *user, char *password )
     ecode = connInfo->recv( handle, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
     if( ecode < 0 ) {
         connInfo->errorcode = ecode;
-        dhm_free( &dhm );
         return( -1 );
     }
     if( rsp_head.status != SOCKET_STAT_AUTH ) {
@@ -220,4 +232,196 @@ int enmx_auth( ENMX_HANDLE handle, char *user, char *password )
     return( -1 );
 #endif
 }
+
+
+/*!
+ * \brief encrypt connection
+ * 
+ * After successful authentication, the session key negotiated by enmx_auth()
+ * can be used to encrypt all further traffic on the connection (AES CFB-128
+ * in both directions). This protects e.g. monitoring clients connected over
+ * an untrusted network.
+ * 
+ * The key schedules are expanded only once per connection, so encryption
+ * adds little overhead per message.
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * 
+ * \return                  0: ok, -1: error (get error code with enmx_geterror), ENMX_E_NO_CONNECTION: invalid handle
+ */
+int enmx_encrypt( ENMX_HANDLE handle )
+{
+    sConnectionInfo         *connInfo;
+#ifdef WITH_AUTHENTICATION
+    sConnectionCrypt        *crypt;
+    SOCKET_CMD_HEAD         cmd_head;
+    SOCKET_RSP_HEAD         rsp_head;
+    havege_state            hs;
+    unsigned char           buf[32];
+    unsigned char           iv[32];
+    int                     ecode;
+    int                     len;
+#endif
+    
+    // get connection info block
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    
+#ifdef WITH_AUTHENTICATION
+    crypt = connInfo->crypt;
+    if( crypt == NULL ) {
+        connInfo->errorcode = ENMX_E_WRONG_USAGE;
+        return( -1 );
+    }
+    if( crypt->stream != 0 ) {
+        connInfo->errorcode = ENMX_E_NO_ERROR;
+        return( 0 );
+    }
+    
+    // create initialisation vectors for both directions
+    // format: ecb( iv client->server ), ecb( iv server->client )
+    havege_init( &hs );
+    for( len = 0; len < 32; len += 4 ) {
+        ecode = havege_rand( &hs );
+        memcpy( &iv[len], &ecode, sizeof( int ));
+    }
+    aes_crypt_ecb( &crypt->enc, AES_ENCRYPT, iv, buf );
+    aes_crypt_ecb( &crypt->enc, AES_ENCRYPT, iv + 16, buf + 16 );
+    
+    cmd_head.cmd = SOCKET_CMD_ENCRYPT;
+    cmd_head.address = htons( 32 );
+    ecode = connInfo->send( handle, (unsigned char *)&cmd_head, sizeof( cmd_head ));
+    if( ecode < 0 ) {
+        connInfo->errorcode = ecode;
+        return( -1 );
+    }
+    ecode = connInfo->send( handle, buf, 32 );
+    if( ecode < 0 ) {
+        connInfo->errorcode = ecode;
+        return( -1 );
+    }
+    ecode = connInfo->recv( handle, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
+    if( ecode < 0 ) {
+        connInfo->errorcode = ecode;
+        return( -1 );
+    }
+    if( rsp_head.status != SOCKET_STAT_ENCRYPT ) {
+        connInfo->errorcode = ENMX_E_DHM_FAILURE;
+        return( -1 );
+    }
+    
+    // from now on, everything is encrypted
+    memcpy( crypt->tx_iv, iv, 16 );
+    memcpy( crypt->rx_iv, iv + 16, 16 );
+    crypt->tx_off = 0;
+    crypt->rx_off = 0;
+    crypt->stream = 1;
+    crypt->send = connInfo->send;
+    crypt->recv = connInfo->recv;
+    connInfo->send = _enmx_crypt_send;
+    connInfo->recv = _enmx_crypt_receive;
+    
+    connInfo->errorcode = ENMX_E_NO_ERROR;
+    return( 0 );
+#else
+    connInfo->errorcode = ENMX_E_AUTH_UNSUPPORTED;
+    return( -1 );
+#endif
+}
 /*! @} */
+
+
+/*!
+ * \cond DeveloperDocs
+ */
+
+#ifdef WITH_AUTHENTICATION
+/*!
+ * \brief send a byte stream to the server, encrypted
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   buf             pointer to buffer (left untouched)
+ * \param   length          length of buffer
+ * 
+ * \return                  0: ok, -1: error
+ */
+int _enmx_crypt_send( ENMX_HANDLE handle, unsigned char *buf, uint16_t length )
+{
+    sConnectionInfo         *connInfo;
+    sConnectionCrypt        *crypt;
+    unsigned char           local[256];
+    unsigned char           *data;
+    int                     result;
+    
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL || connInfo->crypt == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    crypt = connInfo->crypt;
+    data = (length <= sizeof( local )) ? local : malloc( length );
+    if( data == NULL ) {
+        return( ENMX_E_NO_MEMORY );
+    }
+    aes_crypt_cfb128( &crypt->enc, AES_ENCRYPT, length, &crypt->tx_off, crypt->tx_iv, buf, data );
+    result = crypt->send( handle, data, length );
+    if( data != local ) free( data );
+    return( result );
+}
+
+
+/*!
+ * \brief receive a byte stream from the server and decrypt it
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   buf             pointer to receive buffer
+ * \param   length          length of byte stream to receive
+ * \param   timeout         maximum time to wait to get all data
+ * 
+ * \return                  0: ok, -1: error
+ */
+int _enmx_crypt_receive( ENMX_HANDLE handle, unsigned char *buf, uint16_t length, int timeout )
+{
+    sConnectionInfo         *connInfo;
+    sConnectionCrypt        *crypt;
+    int                     result;
+    
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL || connInfo->crypt == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    crypt = connInfo->crypt;
+    result = crypt->recv( handle, buf, length, timeout );
+    if( result == ENMX_E_NO_ERROR ) {
+        aes_crypt_cfb128( &crypt->enc, AES_DECRYPT, length, &crypt->rx_off, crypt->rx_iv, buf, buf );
+    }
+    return( result );
+}
+#endif
+
+
+/*!
+ * \brief release session encryption state of a connection being closed
+ * 
+ * \param   pConn           pointer to connection structure
+ * \param   cmd_head        final command to send, encrypted in place if the stream is encrypted
+ */
+void _enmx_crypt_release( sConnectionInfo *pConn, SOCKET_CMD_HEAD *cmd_head )
+{
+#ifdef WITH_AUTHENTICATION
+    sConnectionCrypt        *crypt;
+    
+    crypt = pConn->crypt;
+    if( crypt != NULL ) {
+        if( crypt->stream != 0 && cmd_head != NULL ) {
+            aes_crypt_cfb128( &crypt->enc, AES_ENCRYPT, sizeof( SOCKET_CMD_HEAD ), &crypt->tx_off, crypt->tx_iv,
+                              (unsigned char *)cmd_head, (unsigned char *)cmd_head );
+        }
+        memset( crypt, 0, sizeof( sConnectionCrypt ));
+        free( crypt );
+        pConn->crypt = NULL;
+    }
+#endif
+}
+
+/*!
+ * \endcond
+ */
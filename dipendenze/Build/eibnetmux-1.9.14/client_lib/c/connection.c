@@ -29,6 +29,7 @@
 #include <string.h>
 #include <time.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 
@@ -51,43 +52,31 @@ static ENMX_HANDLE  _enmx_open( int mode, char *hostname, char *myname );
 /*!
  * \brief close connection with eibnetmux socket server
  * 
+ * The connection's resources are released immediately. In a multi-threaded
+ * application no other thread may be using the handle at that time.
+ * 
  * \param   conn            connection handle as returned by enmx_open()
  */
 void enmx_close( ENMX_HANDLE conn )
 {
-    sConnectionInfo         **connInfo, *temp;
+    sConnectionInfo         *temp;
     SOCKET_CMD_HEAD         cmd_head;
     pth_event_t             ev_wakeup;
     time_t                  secs;
     
-    temp = NULL;
-    for( connInfo = &enmx_connections; *connInfo != NULL; connInfo = &(*connInfo)->next ) {
-        if( (*connInfo)->socket == conn ) {
-            temp = *connInfo;
-            *connInfo = (*connInfo)->next;
-            break;
-        }
-    }
-    
+    temp = _enmx_connectionRemove( conn );
     if( temp != NULL ) {
         cmd_head.cmd = SOCKET_CMD_EXIT;
         cmd_head.address = 0xffff;
+        _enmx_crypt_release( temp, &cmd_head );
         secs = time( NULL ) + TIMEOUT;
         switch( temp->mode ) {
             case ENMX_MODE_STANDARD:
-                while( write( conn, &cmd_head, sizeof( cmd_head )) == -1 ) {
-                    if( errno == EAGAIN ) {
-                        if( secs <= time( NULL )) {
-                            break;
-                        }
-                        usleep( 10 * 1000 );
-                        continue;
-                    }
-                }
+                (void) _enmx_send( conn, (unsigned char *)&cmd_head, sizeof( cmd_head ));
                 break;
             case ENMX_MODE_PTH:
                 ev_wakeup = pth_event( PTH_EVENT_TIME, pth_time( secs, 0 ));
-                pth_write_ev( conn, &cmd_head, sizeof( cmd_head ), ev_wakeup );
+                pth_write_ev( temp->socket, &cmd_head, sizeof( cmd_head ), ev_wakeup );
                 // either the request has been sent or timeout reached
                 // in any case, we've finished
                 pth_event_free( ev_wakeup, PTH_FREE_ALL );
@@ -95,10 +84,10 @@ void enmx_close( ENMX_HANDLE conn )
         }
         if( temp->hostname ) free( temp->hostname );
         if( temp->name ) free( temp->name );
+        if( temp->rxbuf ) free( temp->rxbuf );
+        close( temp->socket );
         free( temp );
     }
-
-    close( conn );
 }
 
 
@@ -151,11 +140,7 @@ char *enmx_gethost( ENMX_HANDLE handle )
     sConnectionInfo         *connInfo;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( NULL );
     }
@@ -164,6 +149,52 @@ char *enmx_gethost( ENMX_HANDLE handle )
 }
 
 
+/*!
+ * \brief retrieve file descriptor of connection
+ * 
+ * Allows to wait for data from eibnetmux in the application's own
+ * select/poll/epoll loop. Connections opened with enmx_open() are non-blocking.
+ * The library buffers received data, so check enmx_pending() before
+ * waiting for the descriptor to become readable.
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * 
+ * \return                  file descriptor, <0: invalid handle
+ */
+int enmx_getfd( ENMX_HANDLE handle )
+{
+    sConnectionInfo         *connInfo;
+    
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    
+    return( connInfo->socket );
+}
+
+
+/*!
+ * \brief number of received bytes buffered by the library
+ * 
+ * If this is not 0, the next enmx_monitor() or enmx_read() may complete
+ * without the file descriptor becoming readable.
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * 
+ * \return                  number of buffered bytes, <0: invalid handle
+ */
+int enmx_pending( ENMX_HANDLE handle )
+{
+    sConnectionInfo         *connInfo;
+    
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    
+    return( (connInfo->rxbuf != NULL) ? connInfo->rxend - connInfo->rxstart : 0 );
+}
+
+
 /*!
  * \if DeveloperDocs
  * \brief internal worker function to establishes connection with eibnetmux socket server
@@ -195,6 +226,8 @@ static ENMX_HANDLE _enmx_open( int mode, char *hostname, char *myname )
     SOCKET_CMD_HEAD         cmd_head;
     SOCKET_RSP_HEAD         rsp_head;
     int                     ecode;
+    int                     flags;
+    ENMX_HANDLE             handle;
     
     // library initialised?
     if( enmx_mode != ENMX_LIB_INITIALISED ) {
@@ -273,6 +306,9 @@ static ENMX_HANDLE _enmx_open( int mode, char *hostname, char *myname )
                 close( sock_con );
                 return( ENMX_E_SERVER_NOTRUNNING );
             }
+            // keep socket non-blocking, _enmx_send/_enmx_receive wait with poll()
+            flags = fcntl( sock_con, F_GETFL );
+            fcntl( sock_con, F_SETFL, flags | O_NONBLOCK );
             break;
         case ENMX_MODE_PTH:
             if( pth_connect( sock_con, (struct sockaddr *)&server, sizeof( struct sockaddr_in )) != 0 ) {
@@ -293,15 +329,21 @@ static ENMX_HANDLE _enmx_open( int mode, char *hostname, char *myname )
     connInfo = malloc( sizeof( sConnectionInfo ));
     connInfo->socket    = sock_con;
     connInfo->errorcode = 0;
-    connInfo->next      = enmx_connections;
     connInfo->state     = stateUnused;
     connInfo->hostname  = target_name;      // strdup'ed above
     connInfo->name      = strdup( myname );
     connInfo->mode      = mode;
     connInfo->L7connection = 0;
     connInfo->L7sequence_id = 0;
+    connInfo->L7mask    = 0;
+    connInfo->L7maxapdu = 0;
+    connInfo->crypt     = NULL;
+    connInfo->rxbuf     = NULL;
+    connInfo->rxstart   = 0;
+    connInfo->rxend     = 0;
     switch( mode ) {
         case ENMX_MODE_STANDARD:
+            connInfo->rxbuf = malloc( ENMX_RXBUF_SIZE );
             connInfo->send = _enmx_send;
             connInfo->recv = _enmx_receive;
             connInfo->wait = _enmx_wait;
@@ -311,35 +353,43 @@ static ENMX_HANDLE _enmx_open( int mode, char *hostname, char *myname )
             connInfo->recv = _enmx_pth_receive;
             connInfo->wait = _enmx_pth_wait;
     }
-    enmx_connections    = connInfo;
+    handle = _enmx_connectionAdd( connInfo );
+    if( handle < 0 ) {
+        close( sock_con );
+        if( connInfo->rxbuf ) free( connInfo->rxbuf );
+        free( connInfo->hostname );
+        free( connInfo->name );
+        free( connInfo );
+        return( handle );
+    }
     
     // register clientid
     cmd_head.cmd = SOCKET_CMD_NAME;
     cmd_head.address = htons( strlen( myname ));
-    ecode = connInfo->send( sock_con, (unsigned char *)&cmd_head, sizeof( cmd_head ));
+    ecode = connInfo->send( handle, (unsigned char *)&cmd_head, sizeof( cmd_head ));
     if( ecode < 0 ) {
-        enmx_close( sock_con );
+        enmx_close( handle );
         return( ENMX_E_REGISTER_CLIENT );
     }
     
     // append name
-    ecode = connInfo->send( sock_con, (unsigned char *)myname, strlen( myname ));
+    ecode = connInfo->send( handle, (unsigned char *)myname, strlen( myname ));
     if( ecode < 0 ) {
-        enmx_close( sock_con );
+        enmx_close( handle );
         return( ENMX_E_REGISTER_CLIENT );
     }
     
     // get acknowledgement
-    ecode = connInfo->recv( sock_con, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
+    ecode = connInfo->recv( handle, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
     if( ecode < 0 ) {
-        enmx_close( sock_con );
+        enmx_close( handle );
         return( ENMX_E_REGISTER_CLIENT );
     }
     if( rsp_head.status != SOCKET_STAT_NAME ) {
-        enmx_close( sock_con );
+        enmx_close( handle );
         return( ENMX_E_REGISTER_CLIENT );
     }
     
-    return( sock_con );
+    return( handle );
 }
 /*! @} */
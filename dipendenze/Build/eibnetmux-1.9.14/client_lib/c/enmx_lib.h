@@ -155,6 +155,12 @@ typedef struct _sEibnetmuxStatus {
         uint16_t            target_port;            //!< UDP port used for control connection by upstream EIBnet/IP server (should generally be 3601)
         uint32_t            source_ip;              //!< eibnetmux' IP address used to communicate with upstream server
         uint8_t             loopback;               //!< set to 2 if EIBnetmux operates in loopback mode and has no connection to a KNX bus
+        uint16_t            bus_rate;               //!< maximum number of telegrams per second sent to the bus, 0 if unlimited
+        struct {
+            uint32_t        sent;                   //!< number of requests taken from queue
+            uint32_t        delay_avg;              //!< average time in milliseconds requests waited in queue
+            uint32_t        delay_max;              //!< longest time in milliseconds a request waited in queue
+        } priority[4];                              //!< queue statistics per KNX priority: system, high, alarm, low
     } client;                                   //!< eibnetmux client status
     struct {
         int                 status_version;         //!< version of EIBnet/IP server block status information, indicates valid fields
@@ -214,6 +220,58 @@ typedef struct _sENMX_Server {
 } sENMX_Server;
 /*! @} */
 
+/*!
+ * \addtogroup xgBus
+ * @{
+ */
+/*!
+ * \brief progress callback of bulk memory transfers
+ * 
+ * Called after each chunk with the number of bytes transferred so far,
+ * the total number of bytes and the average throughput in bytes per second.
+ */
+typedef void (*ENMX_L7_PROGRESS)( ENMX_ADDRESS knxaddress, uint32_t done, uint32_t total, uint32_t rate, void *arg );
+
+#define ENMX_L7_JOB_READ        1           //!< read memory of remote device
+#define ENMX_L7_JOB_WRITE       2           //!< write memory of remote device
+#define ENMX_L7_JOB_RESET       3           //!< reset remote device
+
+/*!
+ * \brief layer 7 job processed by enmx_L7_schedule()
+ */
+typedef struct _sENMX_L7Job {
+    ENMX_ADDRESS            knxaddress;         //!< physical address of remote device
+    int                     operation;          //!< ENMX_L7_JOB_READ, ENMX_L7_JOB_WRITE or ENMX_L7_JOB_RESET
+    uint16_t                offset;             //!< start address of memory
+    uint16_t                length;             //!< number of bytes to read or write
+    unsigned char           *buf;               //!< buffer receiving or holding memory bytes
+    int                     result;             //!< set when done: number of bytes transferred (0 for reset) or error code
+    void                    *arg;               //!< free for use by caller
+} sENMX_L7Job;
+
+/*!
+ * \brief parameters of enmx_L7_schedule()
+ */
+typedef struct _sENMX_L7Schedule {
+    char                    **servers;          //!< NULL-terminated list of eibnetmux servers (hostname:port), NULL: search for server
+    int                     sessions;           //!< maximum number of concurrent layer 7 sessions
+    int                     sessions_per_line;  //!< maximum number of concurrent sessions on one KNX line, 0: 1
+    int                     chunksize;          //!< number of bytes transferred between retries, 0: 256
+    int                     retries;            //!< number of retries of a failed chunk
+    void                    (*chunk)( sENMX_L7Job *job, uint16_t offset, uint16_t length, void *arg );  //!< called for each chunk transferred, may be NULL
+    void                    (*done)( sENMX_L7Job *job, void *arg );                                     //!< called when job has finished, may be NULL
+    void                    *arg;               //!< passed to callback functions
+} sENMX_L7Schedule;
+
+/*!
+ * \brief frame descriptor filled in by enmx_monitor_batch()
+ */
+typedef struct _sENMX_Frame {
+    unsigned char           *data;              //!< CEMI frame, points into library's receive buffer
+    uint16_t                length;             //!< length of CEMI frame
+} sENMX_Frame;
+/*! @} */
+
 /*
  * function declarations
  */
@@ -222,10 +280,16 @@ extern ENMX_HANDLE          enmx_open( char *hostname, char *myname );
 extern ENMX_HANDLE          enmx_pth_open( char *hostname, char *myname );
 extern void                 enmx_close( ENMX_HANDLE conn );
 extern char *               enmx_gethost( ENMX_HANDLE handle );
+extern int                  enmx_getfd( ENMX_HANDLE handle );
+extern int                  enmx_pending( ENMX_HANDLE handle );
 extern int                  enmx_auth( ENMX_HANDLE handle, char *user, char *password );
+extern int                  enmx_encrypt( ENMX_HANDLE handle );
 extern int                  enmx_write( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t length, unsigned char *value );
 extern unsigned char *      enmx_read( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t *length );
+extern unsigned char *      enmx_read_cached( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t maxage, uint16_t *length );
+extern int                  enmx_monitor_start( ENMX_HANDLE handle, ENMX_ADDRESS mask );
 extern unsigned char *      enmx_monitor( ENMX_HANDLE handle, ENMX_ADDRESS mask, unsigned char *buf, uint16_t *buflen, uint16_t *length );
+extern int                  enmx_monitor_batch( ENMX_HANDLE handle, ENMX_ADDRESS mask, sENMX_Frame *frames, int maxframes );
 extern int                  enmx_geterror( ENMX_HANDLE handle );
 extern char *               enmx_errormessage( ENMX_HANDLE handle );
 extern sENMX_Server *       enmx_getservers( int seconds );
@@ -247,7 +311,11 @@ extern int                  enmx_L7_connect( ENMX_HANDLE handle, ENMX_ADDRESS kn
 extern int                  enmx_L7_disconnect( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress );
 extern int                  enmx_L7_readmemory( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t offset, uint16_t length, unsigned char *buf );
 extern int                  enmx_L7_writememory( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t offset, uint16_t length, unsigned char *buf );
+extern int                  enmx_L7_maxapdu( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress );
+extern int                  enmx_L7_readmemory_bulk( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t offset, uint16_t length, unsigned char *buf, ENMX_L7_PROGRESS progress, void *arg );
+extern int                  enmx_L7_writememory_bulk( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t offset, uint16_t length, unsigned char *buf, ENMX_L7_PROGRESS progress, void *arg );
 extern int                  enmx_L7_reset( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress );
+extern int                  enmx_L7_schedule( sENMX_L7Schedule *schedule, sENMX_L7Job *jobs, int count );
 
 
 /*
@@ -77,18 +77,62 @@
 
 #include "enmx_lib.h"
 
+#ifdef WITH_AUTHENTICATION
+#include "polarssl/aes.h"
+#endif
+
+#ifdef ENMX_THREADSAFE
+#include <pthread.h>
+#endif
+
 /*
  * constants
  */
-#define ENMX_VERSION_API        4
+#define ENMX_VERSION_API        5
 
 // #define SOCKET_TCP_PORT                 4390
 #define TIMEOUT                 3
+#define ENMX_RXBUF_SIZE         4096
 #define ENMX_LIB_INITIALISED    0
 #define ENMX_LIB_UNDEFINED     -1
 #define ENMX_MODE_STANDARD      0
 #define ENMX_MODE_PTH           1
 
+/*
+ * connection handles
+ * 
+ * A handle combines the socket descriptor (index into the handle table)
+ * with the generation of its table slot. Once a connection has been closed,
+ * its handle stays invalid even if the descriptor is reused by the system.
+ * 
+ * With ENMX_THREADSAFE the lock protects the table itself (lookup against
+ * growth and removal), not the connection structure returned by a lookup:
+ * as with close(2), a handle must not be closed while another thread is
+ * still using it. Applications sharing a handle between threads have to
+ * serialise enmx_close() with their own I/O on it.
+ */
+#define ENMX_HANDLE_FD_BITS     20
+#define ENMX_HANDLE_FD_MASK     ((1 << ENMX_HANDLE_FD_BITS) - 1)
+#define ENMX_HANDLE_GEN_MASK    0x07ff
+#define ENMX_HANDLE_FD(h)       ((h) & ENMX_HANDLE_FD_MASK)
+#define ENMX_HANDLE_MAKE(fd,g)  (((g) << ENMX_HANDLE_FD_BITS) | (fd))
+#define ENMX_HANDLE_TABLE_MIN   64
+
+#ifdef ENMX_THREADSAFE
+#define ENMX_HANDLES_RDLOCK()   pthread_rwlock_rdlock( &enmx_handles_lock )
+#define ENMX_HANDLES_WRLOCK()   pthread_rwlock_wrlock( &enmx_handles_lock )
+#define ENMX_HANDLES_UNLOCK()   pthread_rwlock_unlock( &enmx_handles_lock )
+#else
+#define ENMX_HANDLES_RDLOCK()
+#define ENMX_HANDLES_WRLOCK()
+#define ENMX_HANDLES_UNLOCK()
+#endif
+
+#define ENMX_L7_APDU_STANDARD   15          // maximum APDU length of standard frames (12 bytes of memory)
+#define ENMX_L7_MEMORY_MAX      63          // maximum byte count of A_Memory_Read/A_Memory_Write
+#define ENMX_L7_MASK_PROPERTIES 0x0020      // devices with older mask versions have no interface objects
+#define ENMX_L7_PID_MAX_APDU    56          // device object property PID_MAX_APDU_LENGTH
+
 #define ENMX_L7_MAXREPEAT       5
 #define ENMX_L7_REPEAT_DELAY    3000
 
@@ -148,20 +192,54 @@
  * \brief socketserver client connection
  */
 typedef struct _connInfo {
+    ENMX_HANDLE             handle;         //!< handle returned to application (socket and generation)
     int                     socket;         //!< unix socket client is connected on
     int                     errorcode;      //!< error code of last command
     int                     state;          //!< state of connection (see eConnectionState)
     char                    *hostname;      //!< hostname of client
     char                    *name;          //!< client identifier
-    struct _connInfo        *next;          //!< link to next connection in linked list
     int                     mode;           //!< ENMX_MODE_STANDARD or ENMX_MODE_PTH
     int                     L7connection;   //!< >0 if layer 7 connection has been established with remote device
     int                     L7sequence_id;  //!< sequence id for layer 7 data requests/responses
+    uint16_t                L7mask;         //!< mask version of remote device, read by enmx_L7_connect()
+    uint16_t                L7maxapdu;      //!< maximum APDU length of remote device, 0 until probed
     int                     (*send)( ENMX_HANDLE handle, unsigned char *buf, uint16_t length );                 //!< pointer to send function (standard or PTH)
     int                     (*recv)( ENMX_HANDLE handle, unsigned char *buf, uint16_t length, int timeout );    //!< pointer to receive function (standard or PTH)
     void                    (*wait)( int usec );    //!< pointer to wait function (standard or PTH)
+    void                    *crypt;         //!< session key schedules (sConnectionCrypt), NULL until enmx_auth() completed key exchange
+    unsigned char           *rxbuf;         //!< receive buffer (standard mode only, socket is non-blocking)
+    uint16_t                rxstart;        //!< offset of first unread byte in rxbuf
+    uint16_t                rxend;          //!< offset behind last received byte in rxbuf
 } sConnectionInfo;
 
+/*!
+ * \brief entry of handle table, indexed by socket descriptor
+ */
+typedef struct _handleSlot {
+    sConnectionInfo         *conn;          //!< connection using this descriptor, NULL if unused
+    uint16_t                generation;     //!< incremented each time the slot is taken
+} sHandleSlot;
+
+#ifdef WITH_AUTHENTICATION
+/*!
+ * \brief session encryption state
+ * 
+ * Key schedules are expanded once after the key exchange and reused
+ * for authentication and, if enabled with enmx_encrypt(), for the whole stream.
+ */
+typedef struct _connCrypt {
+    aes_context             enc;            //!< expanded encryption key schedule
+    aes_context             dec;            //!< expanded decryption key schedule
+    int                     stream;         //!< true if all traffic is encrypted
+    int                     rx_off;         //!< cfb128 offset for data received from server
+    unsigned char           rx_iv[16];      //!< cfb128 iv for data received from server
+    int                     tx_off;         //!< cfb128 offset for data sent to server
+    unsigned char           tx_iv[16];      //!< cfb128 iv for data sent to server
+    int                     (*send)( ENMX_HANDLE handle, unsigned char *buf, uint16_t length );                 //!< unencrypted send function
+    int                     (*recv)( ENMX_HANDLE handle, unsigned char *buf, uint16_t length, int timeout );    //!< unencrypted receive function
+} sConnectionCrypt;
+#endif
+
 /*!
  * \brief EIBnet/IP search request
  * 
@@ -208,7 +286,11 @@ typedef struct __attribute__((packed)) {
 /*
  * globals
  */
-extern sConnectionInfo         *enmx_connections;
+extern sHandleSlot             *enmx_handles;
+extern int                      enmx_handles_size;
+#ifdef ENMX_THREADSAFE
+extern pthread_rwlock_t         enmx_handles_lock;
+#endif
 extern int                      enmx_mode;
 
 /*
@@ -216,17 +298,27 @@ extern int                      enmx_mode;
  */
 extern int                  _enmx_send( ENMX_HANDLE handle, unsigned char *buf, uint16_t length );
 extern int                  _enmx_receive( ENMX_HANDLE handle, unsigned char *buf, uint16_t length, int timeout );
+extern int                  _enmx_rxfill( sConnectionInfo *connInfo, uint16_t need, int timeout );
 extern void                 _enmx_wait( int msec );
+extern long long            _enmx_msec( void );
 extern int                  _enmx_pth_send( ENMX_HANDLE handle, unsigned char *buf, uint16_t length );
 extern int                  _enmx_pth_receive( ENMX_HANDLE handle, unsigned char *buf, uint16_t length, int timeout );
 extern void                 _enmx_pth_wait( int msec );
+extern void                 _enmx_crypt_release( sConnectionInfo *pConn, SOCKET_CMD_HEAD *cmd_head );
+#ifdef WITH_AUTHENTICATION
+extern int                  _enmx_crypt_send( ENMX_HANDLE handle, unsigned char *buf, uint16_t length );
+extern int                  _enmx_crypt_receive( ENMX_HANDLE handle, unsigned char *buf, uint16_t length, int timeout );
+#endif
 extern int                  _enmx_maperror( int code );
 extern sConnectionInfo *    _enmx_connectionGet( ENMX_HANDLE handle );
+extern ENMX_HANDLE          _enmx_connectionAdd( sConnectionInfo *pConn );
+extern sConnectionInfo *    _enmx_connectionRemove( ENMX_HANDLE handle );
 extern int                  _enmx_connectionState( sConnectionInfo *pConn, int state );
 extern int                  _enmx_L7Passthrough( sConnectionInfo *pConn, ENMX_ADDRESS knxaddress );
 extern int                  _enmx_L7GetAckNak( sConnectionInfo *pConn );
 extern int                  _enmx_L7State( sConnectionInfo *pConn );
 extern int                  _enmx_L7Response( sConnectionInfo *connInfo, ENMX_ADDRESS knxaddress, unsigned char *buf, int *length, uint8_t tpci, uint16_t apci );
+extern int                  _enmx_L7ResponseNoAck( sConnectionInfo *connInfo, ENMX_ADDRESS knxaddress, unsigned char *buf, int *length, uint8_t tpci, uint16_t apci );
 
 
 /*!
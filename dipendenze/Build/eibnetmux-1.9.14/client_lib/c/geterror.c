@@ -91,11 +91,7 @@ int enmx_geterror( ENMX_HANDLE handle )
     sConnectionInfo         *connInfo;
 
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( ENMX_E_NO_CONNECTION );
     } else {
@@ -47,6 +47,10 @@
 /*!
  * \brief find connection info structure for given handle
  * 
+ * The structure is returned without holding the table lock. It stays valid
+ * until the handle is closed, so callers must not race enmx_close() against
+ * I/O on the same handle (see connection handles in enmx_lib.private.h).
+ * 
  * \param   handle          connection handle as returned by enmx_open()
  * 
  * \return                  NULL: not found, pointer to structure otherwise
@@ -54,12 +58,101 @@
 sConnectionInfo *_enmx_connectionGet( ENMX_HANDLE handle )
 {
     sConnectionInfo     *pConn;
+    int                 fd;
+    
+    if( handle < 0 ) {
+        return( NULL );
+    }
+    pConn = NULL;
+    fd = ENMX_HANDLE_FD( handle );
+    ENMX_HANDLES_RDLOCK();
+    if( fd < enmx_handles_size ) {
+        pConn = enmx_handles[fd].conn;
+        // stale handle if descriptor has been reused since
+        if( pConn != NULL && pConn->handle != handle ) {
+            pConn = NULL;
+        }
+    }
+    ENMX_HANDLES_UNLOCK();
+    return( pConn );
+}
+
+
+/*!
+ * \brief enter connection into handle table
+ * 
+ * The table grows as required to hold the connection's socket descriptor.
+ * pConn->socket must be set, pConn->handle is filled in.
+ * 
+ * \param   pConn           pointer to connection structure
+ * 
+ * \return                  handle, <0: error
+ */
+ENMX_HANDLE _enmx_connectionAdd( sConnectionInfo *pConn )
+{
+    sHandleSlot         *table;
+    sHandleSlot         *slot;
+    int                 size;
+    
+    if( pConn->socket < 0 || pConn->socket > ENMX_HANDLE_FD_MASK ) {
+        return( ENMX_E_RESOURCE );
+    }
     
-    for( pConn = enmx_connections; pConn != NULL; pConn = pConn->next ) {
-        if( pConn->socket == handle ) {
-            break;
+    ENMX_HANDLES_WRLOCK();
+    if( pConn->socket >= enmx_handles_size ) {
+        size = (enmx_handles_size > 0) ? enmx_handles_size : ENMX_HANDLE_TABLE_MIN;
+        while( size <= pConn->socket ) {
+            size *= 2;
+        }
+        table = realloc( enmx_handles, size * sizeof( sHandleSlot ));
+        if( table == NULL ) {
+            ENMX_HANDLES_UNLOCK();
+            return( ENMX_E_NO_MEMORY );
+        }
+        memset( &table[enmx_handles_size], 0, (size - enmx_handles_size) * sizeof( sHandleSlot ));
+        enmx_handles = table;
+        enmx_handles_size = size;
+    }
+    slot = &enmx_handles[pConn->socket];
+    slot->generation = (slot->generation + 1) & ENMX_HANDLE_GEN_MASK;
+    if( slot->generation == 0 ) {
+        slot->generation = 1;
+    }
+    slot->conn = pConn;
+    pConn->handle = ENMX_HANDLE_MAKE( pConn->socket, slot->generation );
+    ENMX_HANDLES_UNLOCK();
+    
+    return( pConn->handle );
+}
+
+
+/*!
+ * \brief remove connection from handle table
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * 
+ * \return                  NULL: not found, pointer to removed structure otherwise
+ */
+sConnectionInfo *_enmx_connectionRemove( ENMX_HANDLE handle )
+{
+    sConnectionInfo     *pConn;
+    int                 fd;
+    
+    if( handle < 0 ) {
+        return( NULL );
+    }
+    pConn = NULL;
+    fd = ENMX_HANDLE_FD( handle );
+    ENMX_HANDLES_WRLOCK();
+    if( fd < enmx_handles_size ) {
+        pConn = enmx_handles[fd].conn;
+        if( pConn != NULL && pConn->handle == handle ) {
+            enmx_handles[fd].conn = NULL;
+        } else {
+            pConn = NULL;
         }
     }
+    ENMX_HANDLES_UNLOCK();
     return( pConn );
 }
 
@@ -32,6 +32,7 @@
 #include <time.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <poll.h>
 
 #include "enmx_lib.private.h"
 
@@ -44,9 +45,63 @@
  * \cond DeveloperDocs
  */
 
+/*!
+ * \brief current time in milliseconds from a monotonic clock
+ */
+long long _enmx_msec( void )
+{
+    struct timespec     ts;
+    
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 );
+}
+
+
+/*!
+ * \brief wait until socket is ready or deadline has passed
+ * 
+ * \param   fd              socket descriptor
+ * \param   events          POLLIN or POLLOUT
+ * \param   deadline        absolute time in milliseconds (_enmx_msec), <0: wait forever
+ * 
+ * \return                  0: ok, error code otherwise
+ */
+static int _enmx_poll( int fd, short events, long long deadline )
+{
+    struct pollfd       pfd;
+    long long           wait;
+    
+    pfd.fd = fd;
+    pfd.events = events;
+    for( ;; ) {
+        wait = -1;
+        if( deadline >= 0 ) {
+            wait = deadline - _enmx_msec();
+            if( wait <= 0 ) {
+                return( ENMX_E_TIMEOUT );
+            }
+        }
+        switch( poll( &pfd, 1, (int)wait )) {
+            case -1:
+                if( errno == EINTR ) {
+                    continue;
+                }
+                return( ENMX_E_COMMUNICATION );
+            case 0:
+                return( ENMX_E_TIMEOUT );
+            default:
+                return( ENMX_E_NO_ERROR );
+        }
+    }
+}
+
+
 /*!
  * \brief send a byte stream to the server
  * 
+ * The socket is non-blocking. If the kernel buffer is full, wait with poll()
+ * until the data can be sent or the timeout has expired.
+ * 
  * \param   handle          connection handle as returned by enmx_open()
  * \param   buf             pointer to buffer
  * \param   length          length of buffer
@@ -55,28 +110,28 @@
  */
 int _enmx_send( ENMX_HANDLE handle, unsigned char *buf, uint16_t length )
 {
-    time_t          now;
-    int             flags;
+    long long       deadline;
+    int             len;
+    int             bytes;
     int             result;
     
     result = ENMX_E_NO_ERROR;
-    flags = fcntl( handle, F_GETFL );
-    fcntl( handle, F_SETFL, flags | O_NONBLOCK );
-    now = time( NULL );
-    while( write( handle, buf, length ) == -1 ) {
-        if( errno == EAGAIN ) {
-            if( now + TIMEOUT <= time( NULL )) {
-                result = ENMX_E_TIMEOUT;
-                break;
-            }
-            usleep( 10 * 1000 );
+    deadline = _enmx_msec() + TIMEOUT * 1000;
+    for( len = 0; len < length; ) {
+        if( (bytes = write( ENMX_HANDLE_FD( handle ), buf + len, length - len )) == -1 ) {
+            if( errno == EAGAIN || errno == EWOULDBLOCK ) {
+                if( (result = _enmx_poll( ENMX_HANDLE_FD( handle ), POLLOUT, deadline )) != ENMX_E_NO_ERROR ) {
+                    break;
+                }
                 continue;
-        } else {
+            } else if( errno == EINTR ) {
+                continue;
+            }
             result = ENMX_E_COMMUNICATION;
             break;
         }
+        len += bytes;
     }
-    fcntl( handle, F_SETFL, flags );
     
     return( result );
 }
@@ -85,53 +140,131 @@ int _enmx_send( ENMX_HANDLE handle, unsigned char *buf, uint16_t length )
 /*!
  * \brief receive a byte stream from the server
  * 
+ * Data is read from the socket in large blocks into the connection's receive buffer
+ * and handed out from there. Usually, a response header and its payload
+ * (and any further frames already received) are fetched with a single read.
+ * 
  * \param   handle          connection handle as returned by enmx_open()
  * \param   buf             pointer to receive buffer
  * \param   length          length of byte stream to receive
- * \param   timeout         maximum time to wait to get all data
+ * \param   timeout         0: wait forever, otherwise wait at most TIMEOUT seconds to get all data
  * 
  * \return                  0: ok, -1: error
  */
 int _enmx_receive( ENMX_HANDLE handle, unsigned char *buf, uint16_t length, int timeout )
 {
-    time_t          now;
+    sConnectionInfo *connInfo;
+    long long       deadline;
     int             len;
     int             bytes;
-    int             flags;
     int             result;
     
+    connInfo = _enmx_connectionGet( handle );
     result = ENMX_E_NO_ERROR;
-    flags = fcntl( handle, F_GETFL );
-    if( timeout != 0 ) {
-        fcntl( handle, F_SETFL, flags | O_NONBLOCK );
-    }
-    now = time( NULL );
+    deadline = (timeout != 0) ? _enmx_msec() + TIMEOUT * 1000 : -1;
     for( len = 0; len < length; ) {
-        if( (bytes = read( handle, buf, length - len )) == -1 ) {
-            if( errno == EAGAIN ) {
-                if( now + TIMEOUT <= time( NULL )) {
-                    result = ENMX_E_TIMEOUT;
-                    break;
-                }
-                usleep( 10 * 1000 );
+        // hand out buffered data first
+        if( connInfo != NULL && connInfo->rxbuf != NULL && connInfo->rxstart < connInfo->rxend ) {
+            bytes = connInfo->rxend - connInfo->rxstart;
+            if( bytes > length - len ) {
+                bytes = length - len;
+            }
+            memcpy( buf + len, connInfo->rxbuf + connInfo->rxstart, bytes );
+            connInfo->rxstart += bytes;
+            len += bytes;
+            continue;
+        }
+        
+        if( connInfo != NULL && connInfo->rxbuf != NULL ) {
+            bytes = read( connInfo->socket, connInfo->rxbuf, ENMX_RXBUF_SIZE );
+            if( bytes > 0 ) {
+                connInfo->rxstart = 0;
+                connInfo->rxend = bytes;
+                continue;
+            }
+        } else {
+            bytes = read( ENMX_HANDLE_FD( handle ), buf + len, length - len );
+            if( bytes > 0 ) {
+                len += bytes;
                 continue;
-            } else {
-                result = ENMX_E_COMMUNICATION;
-                break;
             }
         }
         if( bytes == 0 ) {
             result = ENMX_E_SERVER_ABORTED;
             break;
         }
-        len += bytes;
+        if( errno == EAGAIN || errno == EWOULDBLOCK ) {
+            if( (result = _enmx_poll( ENMX_HANDLE_FD( handle ), POLLIN, deadline )) != ENMX_E_NO_ERROR ) {
+                break;
+            }
+        } else if( errno != EINTR ) {
+            result = ENMX_E_COMMUNICATION;
+            break;
+        }
     }
-    fcntl( handle, F_SETFL, flags );
 
     return( result );
 }
 
 
+/*!
+ * \brief make sure a number of bytes is available in the receive buffer
+ * 
+ * Unlike _enmx_receive(), the data is not copied. Upon successful return,
+ * at least need bytes are available contiguously at rxbuf + rxstart.
+ * Unread data is moved to the start of the buffer if there is not enough room
+ * behind it. Each read fetches as much as the buffer can hold.
+ * 
+ * \param   connInfo        connection (standard mode, must have a receive buffer)
+ * \param   need            number of bytes required, at most ENMX_RXBUF_SIZE
+ * \param   timeout         0: wait forever, otherwise wait at most TIMEOUT seconds
+ * 
+ * \return                  0: ok, error code otherwise
+ */
+int _enmx_rxfill( sConnectionInfo *connInfo, uint16_t need, int timeout )
+{
+    long long       deadline;
+    int             bytes;
+    int             result;
+    
+    if( connInfo->rxbuf == NULL || need > ENMX_RXBUF_SIZE ) {
+        return( ENMX_E_INTERNAL );
+    }
+    if( connInfo->rxstart == connInfo->rxend ) {
+        connInfo->rxstart = connInfo->rxend = 0;
+    }
+    if( connInfo->rxstart + need > ENMX_RXBUF_SIZE ) {
+        memmove( connInfo->rxbuf, connInfo->rxbuf + connInfo->rxstart, connInfo->rxend - connInfo->rxstart );
+        connInfo->rxend -= connInfo->rxstart;
+        connInfo->rxstart = 0;
+    }
+    
+    result = ENMX_E_NO_ERROR;
+    deadline = (timeout != 0) ? _enmx_msec() + TIMEOUT * 1000 : -1;
+    while( connInfo->rxend - connInfo->rxstart < need ) {
+        bytes = read( connInfo->socket, connInfo->rxbuf + connInfo->rxend, ENMX_RXBUF_SIZE - connInfo->rxend );
+        if( bytes > 0 ) {
+            connInfo->rxend += bytes;
+            continue;
+        }
+        if( bytes == 0 ) {
+            result = ENMX_E_SERVER_ABORTED;
+            break;
+        }
+        if( errno == EAGAIN || errno == EWOULDBLOCK ) {
+            if( (result = _enmx_poll( connInfo->socket, POLLIN, deadline )) != ENMX_E_NO_ERROR ) {
+                break;
+            }
+        } else if( errno != EINTR ) {
+            result = ENMX_E_COMMUNICATION;
+            break;
+        }
+    }
+    
+    return( result );
+}
+
+
 /*!
  * \brief map eibnetmux server's error code to library error
  * 
@@ -123,11 +123,7 @@ int enmx_mgmt_getloglevel( ENMX_HANDLE handle )
     int                     ecode;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( -1 );
     }
@@ -171,11 +167,7 @@ int enmx_mgmt_setloglevel( ENMX_HANDLE handle, uint16_t level )
     int                     ecode;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( -1 );
     }
@@ -219,11 +211,7 @@ int enmx_mgmt_getaccessblock( ENMX_HANDLE handle )
     int                     ecode;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( -1 );
     }
@@ -267,11 +255,7 @@ int enmx_mgmt_setaccessblock( ENMX_HANDLE handle, uint16_t level )
     int                     ecode;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( -1 );
     }
@@ -317,11 +301,7 @@ int enmx_mgmt_close_session( ENMX_HANDLE handle, int session_type, uint32_t sess
     int                     ecode;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( -1 );
     }
@@ -415,11 +395,7 @@ sENMX_Status *enmx_mgmt_getstatus( ENMX_HANDLE handle )
     sENMX_Status            *status;
     
      // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( NULL );
     }
@@ -452,11 +428,7 @@ static int _client_connect( ENMX_HANDLE handle, int newstate )
     int                     ecode;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( -1 );
     }
@@ -609,14 +581,14 @@ static sENMX_Status *_getStatus( sConnectionInfo *connInfo )
     // request connection of client to N148/21
     cmd_head.cmd = SOCKET_CMD_MGMT_STATUS;
     cmd_head.address = 0;
-    ecode = connInfo->send( connInfo->socket, (unsigned char *)&cmd_head, sizeof( cmd_head ));
+    ecode = connInfo->send( connInfo->handle, (unsigned char *)&cmd_head, sizeof( cmd_head ));
     if( ecode < 0 ) {
         connInfo->errorcode = ecode;
         return( NULL );
     }
     
     // get status
-    ecode = connInfo->recv( connInfo->socket, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
+    ecode = connInfo->recv( connInfo->handle, (unsigned char *)&rsp_head, sizeof( rsp_head ), 1 );
     if( ecode < 0 ) {
         connInfo->errorcode = ecode;
         return( NULL );
@@ -630,7 +602,7 @@ static sENMX_Status *_getStatus( sConnectionInfo *connInfo )
         connInfo->errorcode = ENMX_E_NO_MEMORY;
         return( NULL );
     }
-    ecode = connInfo->recv( connInfo->socket, buf, rsp_head.size, 1 );
+    ecode = connInfo->recv( connInfo->handle, buf, rsp_head.size, 1 );
     if( ecode < 0 ) {
         connInfo->errorcode = ecode;
         free( buf );
@@ -674,8 +646,8 @@ static sENMX_Status *_getStatus( sConnectionInfo *connInfo )
     
     ptr += 2;
     status->client.status_version = _get_byte( &ptr );
-    if( status->client.status_version > 4 ) {
-        // does only support EIBnetmux status, client information version 1 - 4
+    if( status->client.status_version > 5 ) {
+        // does only support EIBnetmux status, client information version 1 - 5
         free( status );
         connInfo->errorcode = ENMX_E_VERSIONMISMATCH;
         return( NULL );
@@ -693,6 +665,8 @@ static sENMX_Status *_getStatus( sConnectionInfo *connInfo )
     status->client.target_port = 0;
     status->client.source_ip = 0;
     status->client.loopback = 0;
+    status->client.bus_rate = 0;
+    memset( status->client.priority, 0, sizeof( status->client.priority ));
     switch( status->client.status_version ) {
         case 1:
             break;
@@ -712,6 +686,19 @@ static sENMX_Status *_getStatus( sConnectionInfo *connInfo )
             status->client.source_ip = htonl( _get_long( &ptr ));
             status->client.loopback = _get_byte( &ptr );
             break;
+        case 5:
+            status->client.target_name = _get_nstring( &ptr );
+            status->client.target_ip = htonl( _get_long( &ptr ));
+            status->client.target_port = _get_word( &ptr );
+            status->client.source_ip = htonl( _get_long( &ptr ));
+            status->client.loopback = _get_byte( &ptr );
+            status->client.bus_rate = _get_word( &ptr );
+            for( loop = 0; loop < 4; loop++ ) {
+                status->client.priority[loop].sent = _get_long( &ptr );
+                status->client.priority[loop].delay_avg = _get_long( &ptr );
+                status->client.priority[loop].delay_max = _get_long( &ptr );
+            }
+            break;
     }
     
     ptr += 2;
@@ -45,6 +45,51 @@
  * @{
  */
 
+/*!
+ * \brief request monitoring of group addresses without waiting for a frame
+ * 
+ * enmx_monitor() and enmx_monitor_batch() send the request on their first
+ * call and then wait for a frame, which may take very long on a quiet bus.
+ * Applications which wait for enmx_getfd() themselves, e.g. to wake up
+ * periodically, call this function first.
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   mask            mask of knx group addresses to monitor (as 16-bit integer)
+ * 
+ * \return                  0: ok, error code otherwise
+ */
+int enmx_monitor_start( ENMX_HANDLE handle, ENMX_ADDRESS mask )
+{
+    sConnectionInfo         *connInfo;
+    SOCKET_CMD_HEAD         cmd_head;
+    int                     ecode;
+    
+    // get connection info block
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+
+    // check state
+    if( connInfo->state == stateUnused ) {
+        // request monitoring connection
+        cmd_head.cmd = SOCKET_CMD_MONITOR;
+        cmd_head.address = mask;
+        ecode = connInfo->send( handle, (unsigned char *)&cmd_head, sizeof( cmd_head ));
+        if( ecode < 0 ) {
+            connInfo->errorcode = ecode;
+            return( ecode );
+        }
+        connInfo->state = stateMonitor;
+    }
+    if( connInfo->state != stateMonitor ) {
+        connInfo->errorcode = ENMX_E_WRONG_USAGE;
+        return( ENMX_E_WRONG_USAGE );
+    }
+    connInfo->errorcode = ENMX_E_NO_ERROR;
+    return( ENMX_E_NO_ERROR );
+}
+
+
 /*!
  * \brief monitor group addresses
  * 
@@ -75,11 +120,7 @@ unsigned char *enmx_monitor( ENMX_HANDLE handle, ENMX_ADDRESS mask, unsigned cha
     int                     ecode;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( NULL );
     }
@@ -135,4 +176,102 @@ unsigned char *enmx_monitor( ENMX_HANDLE handle, ENMX_ADDRESS mask, unsigned cha
     connInfo->errorcode = ENMX_E_NO_ERROR;
     return( buf );
 }
+
+
+/*!
+ * \brief monitor group addresses, return several frames at once
+ * 
+ * Works like enmx_monitor() but hands out all complete frames which have
+ * already been received, up to maxframes. The function waits only if no
+ * complete frame is available.
+ * 
+ * Frames are not copied. The descriptors point into the connection's receive
+ * buffer and remain valid until the next call using this handle.
+ * 
+ * Only available on connections opened with enmx_open() which are not encrypted.
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   mask            mask of knx group addresses to monitor (as 16-bit integer)
+ * \param   frames          array of frame descriptors to fill in
+ * \param   maxframes       number of elements in frames
+ * 
+ * \return                  number of frames returned (>0), error code otherwise
+ */
+int enmx_monitor_batch( ENMX_HANDLE handle, ENMX_ADDRESS mask, sENMX_Frame *frames, int maxframes )
+{
+    sConnectionInfo         *connInfo;
+    SOCKET_CMD_HEAD         cmd_head;
+    SOCKET_RSP_HEAD         rsp_head;
+    uint16_t                available;
+    int                     count;
+    int                     ecode;
+    
+    // get connection info block
+    if( (connInfo = _enmx_connectionGet( handle )) == NULL ) {
+        return( ENMX_E_NO_CONNECTION );
+    }
+    if( frames == NULL || maxframes <= 0 ) {
+        connInfo->errorcode = ENMX_E_PARAMETER;
+        return( ENMX_E_PARAMETER );
+    }
+    if( connInfo->rxbuf == NULL || connInfo->recv != _enmx_receive ) {
+        connInfo->errorcode = ENMX_E_WRONG_USAGE;
+        return( ENMX_E_WRONG_USAGE );
+    }
+
+    // check state
+    if( connInfo->state == stateUnused ) {
+        // request monitoring connection
+        cmd_head.cmd = SOCKET_CMD_MONITOR;
+        cmd_head.address = mask;
+        ecode = connInfo->send( handle, (unsigned char *)&cmd_head, sizeof( cmd_head ));
+        if( ecode < 0 ) {
+            connInfo->errorcode = ecode;
+            return( ecode );
+        }
+        connInfo->state = stateMonitor;
+    }
+    if( connInfo->state != stateMonitor ) {
+        connInfo->errorcode = ENMX_E_WRONG_USAGE;
+        return( ENMX_E_WRONG_USAGE );
+    }
+    
+    // wait for first complete frame
+    ecode = _enmx_rxfill( connInfo, sizeof( rsp_head ), 0 );
+    if( ecode == ENMX_E_NO_ERROR ) {
+        memcpy( &rsp_head, connInfo->rxbuf + connInfo->rxstart, sizeof( rsp_head ));
+        if( rsp_head.status != SOCKET_STAT_MONITOR ) {
+            connInfo->errorcode = ENMX_E_INTERNAL;
+            return( ENMX_E_INTERNAL );
+        }
+        ecode = _enmx_rxfill( connInfo, sizeof( rsp_head ) + ntohs( rsp_head.size ), 1 );
+    }
+    if( ecode < 0 ) {
+        connInfo->errorcode = ecode;
+        return( ecode );
+    }
+    
+    // hand out all complete frames in receive buffer
+    for( count = 0; count < maxframes; count++ ) {
+        available = connInfo->rxend - connInfo->rxstart;
+        if( available < sizeof( rsp_head )) {
+            break;
+        }
+        memcpy( &rsp_head, connInfo->rxbuf + connInfo->rxstart, sizeof( rsp_head ));
+        if( rsp_head.status != SOCKET_STAT_MONITOR ) {
+            // leave it for the next call to report
+            break;
+        }
+        rsp_head.size = ntohs( rsp_head.size );
+        if( available < sizeof( rsp_head ) + rsp_head.size ) {
+            break;
+        }
+        frames[count].data = connInfo->rxbuf + connInfo->rxstart + sizeof( rsp_head );
+        frames[count].length = rsp_head.size;
+        connInfo->rxstart += sizeof( rsp_head ) + rsp_head.size;
+    }
+    
+    connInfo->errorcode = ENMX_E_NO_ERROR;
+    return( count );
+}
 /*! @} */
@@ -64,7 +64,7 @@ int _enmx_pth_send( ENMX_HANDLE handle, unsigned char *buf, uint16_t length )
     secs = time( NULL ) + TIMEOUT;
     ev_wakeup = pth_event( PTH_EVENT_TIME, pth_time( secs, 0 ));
 
-    if( pth_write_ev( handle, buf, length, ev_wakeup ) == length ) {
+    if( pth_write_ev( ENMX_HANDLE_FD( handle ), buf, length, ev_wakeup ) == length ) {
         result = ENMX_E_NO_ERROR;
     } else {
         if( pth_event_status( ev_wakeup ) == PTH_STATUS_OCCURRED ) {
@@ -105,7 +105,7 @@ int _enmx_pth_receive( ENMX_HANDLE handle, unsigned char *buf, uint16_t length,
     result = ENMX_E_NO_ERROR;
     for( len = 0; len < length; ) {
         if( timeout != 0 ) {
-            bytes = pth_read_ev( handle, buf + len, length - len, ev_wakeup );
+            bytes = pth_read_ev( ENMX_HANDLE_FD( handle ), buf + len, length - len, ev_wakeup );
             if( pth_event_status( ev_wakeup ) == PTH_STATUS_OCCURRED ) {
                 result = ENMX_E_TIMEOUT;
                 break;
@@ -114,7 +114,7 @@ int _enmx_pth_receive( ENMX_HANDLE handle, unsigned char *buf, uint16_t length,
                 break;
             }
         } else {
-            if( (bytes = pth_read( handle, buf + len, length - len )) == -1 ) {
+            if( (bytes = pth_read( ENMX_HANDLE_FD( handle ), buf + len, length - len )) == -1 ) {
                 result = ENMX_E_COMMUNICATION;
                 break;
             }
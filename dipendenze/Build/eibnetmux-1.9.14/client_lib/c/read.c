@@ -42,35 +42,22 @@
  * @{
  */
 
-/*!
- * \brief read value from group address
- * 
- * Returned data comes directly from the CEMI frame and must be analysed according to
- * the KNX group's EIS data type.
- * 
- * ATTENTION:
- *      caller has to release returned buffer
- * 
- * \param   handle          connection handle as returned by enmx_open()
- * \param   knxaddress      knx group address as 16-bit integer
- * \param   length          pointer to variable which will receive length of byte stream
- * 
- * \return                  pointer to received byte stream or NULL upon error (get error code with enmx_geterror)
+/*
+ * send read request and receive value
+ * maxage is only sent for SOCKET_CMD_READ_CACHED
  */
-unsigned char *enmx_read( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t *length )
+static unsigned char *_enmx_read( ENMX_HANDLE handle, uint8_t cmd, ENMX_ADDRESS knxaddress, uint16_t maxage, uint16_t *length )
 {
     sConnectionInfo         *connInfo;
-    SOCKET_CMD_HEAD         cmd_head;
+    SOCKET_CMD_HEAD         *cmd_head;
     SOCKET_RSP_HEAD         rsp_head;
+    unsigned char           request[sizeof( SOCKET_CMD_HEAD ) + sizeof( uint16_t )];
     unsigned char           *buf;
+    int                     len;
     int                     ecode;
     
    // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( NULL );
     }
@@ -82,9 +69,16 @@ unsigned char *enmx_read( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t
     }
     
     // request reading connection
-    cmd_head.cmd = SOCKET_CMD_READ;
-    cmd_head.address = htons( knxaddress );
-    ecode = connInfo->send( handle, (unsigned char *)&cmd_head, sizeof( cmd_head ));
+    cmd_head = (SOCKET_CMD_HEAD *)request;
+    cmd_head->cmd = cmd;
+    cmd_head->address = htons( knxaddress );
+    len = sizeof( SOCKET_CMD_HEAD );
+    if( cmd == SOCKET_CMD_READ_CACHED ) {
+        maxage = htons( maxage );
+        memcpy( &request[len], &maxage, sizeof( maxage ));
+        len += sizeof( maxage );
+    }
+    ecode = connInfo->send( handle, request, len );
     if( ecode < 0 ) {
         connInfo->errorcode = ecode;
         return( NULL );
@@ -119,4 +113,48 @@ unsigned char *enmx_read( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t
     connInfo->errorcode = ENMX_E_NO_ERROR;
     return( buf );
 }
+
+
+/*!
+ * \brief read value from group address
+ * 
+ * Returned data comes directly from the CEMI frame and must be analysed according to
+ * the KNX group's EIS data type.
+ * 
+ * ATTENTION:
+ *      caller has to release returned buffer
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   knxaddress      knx group address as 16-bit integer
+ * \param   length          pointer to variable which will receive length of byte stream
+ * 
+ * \return                  pointer to received byte stream or NULL upon error (get error code with enmx_geterror)
+ */
+unsigned char *enmx_read( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t *length )
+{
+    return( _enmx_read( handle, SOCKET_CMD_READ, knxaddress, 0, length ));
+}
+
+
+/*!
+ * \brief read value from group address, accepting a cached value
+ * 
+ * Like enmx_read() but eibnetmux answers from its group value cache if the last value
+ * seen on the bus is not older than maxage seconds. Otherwise, the value is read from
+ * the bus. Concurrent reads of the same group are combined into a single bus request.
+ * 
+ * ATTENTION:
+ *      caller has to release returned buffer
+ * 
+ * \param   handle          connection handle as returned by enmx_open()
+ * \param   knxaddress      knx group address as 16-bit integer
+ * \param   maxage          maximum acceptable age of cached value in seconds
+ * \param   length          pointer to variable which will receive length of byte stream
+ * 
+ * \return                  pointer to received byte stream or NULL upon error (get error code with enmx_geterror)
+ */
+unsigned char *enmx_read_cached( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t maxage, uint16_t *length )
+{
+    return( _enmx_read( handle, SOCKET_CMD_READ_CACHED, knxaddress, maxage, length ));
+}
 /*! @} */
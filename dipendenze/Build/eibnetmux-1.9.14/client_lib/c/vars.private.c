@@ -32,9 +32,21 @@
  * \cond DeveloperDocs
  */
 /*!
- * \brief Linked-list of currently active connections
+ * \brief Table of currently active connections, indexed by socket descriptor
  */
-sConnectionInfo *enmx_connections = 0;
+sHandleSlot     *enmx_handles = 0;
+
+/*!
+ * \brief Number of entries in handle table
+ */
+int             enmx_handles_size = 0;
+
+#ifdef ENMX_THREADSAFE
+/*!
+ * \brief Protects handle table against concurrent open/close
+ */
+pthread_rwlock_t enmx_handles_lock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
 
 /*!
  * \if DeveloperDocs
@@ -65,11 +65,7 @@ int enmx_write( ENMX_HANDLE handle, ENMX_ADDRESS knxaddress, uint16_t length, un
     uint16_t                data_len;
     
     // get connection info block
-    for( connInfo = enmx_connections; connInfo != NULL; connInfo = connInfo->next ) {
-        if( connInfo->socket == handle ) {
-            break;
-        }
-    }
+    connInfo = _enmx_connectionGet( handle );
     if( connInfo == NULL ) {
         return( ENMX_E_NO_CONNECTION );
     }
@@ -35,6 +35,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <sys/time.h>
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -73,6 +74,12 @@ static uint32_t         statsTotalSent = 0;                     // statistics
 static uint32_t         statsTotalReceived = 0;
 static uint16_t         statsHeartbeatsMissed = 0;
 static time_t           statsUptime = 0;
+static uint32_t         statsPrioSent[BUS_PRIORITIES];          // per cEMI priority: requests taken from queue
+static uint64_t         statsPrioDelay[BUS_PRIORITIES];         //                    total queueing delay in ms
+static uint32_t         statsPrioDelayMax[BUS_PRIORITIES];      //                    longest queueing delay in ms
+static long             busTokens = 0;                          // bus budget, in 1/1000 telegrams
+static struct timeval   busTokensUpdated;
+static const uint8_t    busPrioRank[BUS_PRIORITIES] = { 0, 2, 1, 3 };  // send order: system, alarm, high, low
 
 
 /*
@@ -325,11 +332,127 @@ void EIBnetClientSwitchConnectionType( uint8_t type )
 }
 
 
+/*
+ * elapsed
+ * 
+ * milliseconds between two points in time
+ */
+static long elapsed( struct timeval *from, struct timeval *to )
+{
+    return( (to->tv_sec - from->tv_sec) * 1000 + (to->tv_usec - from->tv_usec) / 1000 );
+}
+
+
+/*
+ * busPriority
+ * 
+ * cEMI priority of queued tunneling request, used as index into per-priority statistics
+ */
+static int busPriority( EIBNETIP_QUEUE *queue )
+{
+    CEMIFRAME   *cemiframe;
+    
+    cemiframe = (CEMIFRAME *) &queue->data[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER )];
+    return( (cemiframe->ctrl & EIB_CTRL_PRIO_LOW) >> 2 );
+}
+
+
+/*
+ * busSelectRequest
+ * 
+ * move oldest request of highest priority to top of client queue
+ * requests of equal priority keep their order, so the queue remains
+ * fifo for each priority and only its first entry is ever removed
+ */
+static void busSelectRequest( void )
+{
+    EIBNETIP_QUEUE  **queue;
+    EIBNETIP_QUEUE  **best;
+    EIBNETIP_QUEUE  *entry;
+    int             rank;
+    
+    best = &eibQueueClient;
+    rank = busPrioRank[busPriority( eibQueueClient )];
+    for( queue = &eibQueueClient->next; *queue != NULL && rank > 0; queue = &(*queue)->next ) {
+        if( busPrioRank[busPriority( *queue )] < rank ) {
+            best = queue;
+            rank = busPrioRank[busPriority( *queue )];
+        }
+    }
+    if( best != &eibQueueClient ) {
+        entry = *best;
+        *best = entry->next;
+        entry->next = eibQueueClient;
+        eibQueueClient = entry;
+        logDebug( THIS_MODULE, "Request %d with priority %d moved to top of forwarder queue", entry->nr, busPriority( entry ));
+    }
+}
+
+
+/*
+ * busBudget
+ * 
+ * token bucket limiting the telegrams sent to the bus to config.bus_rate per second
+ * the bucket holds one second's worth of telegrams, so short bursts are not delayed
+ * 
+ * Returns:     0 if a telegram may be sent now
+ *              otherwise number of milliseconds until next telegram may be sent
+ */
+static long busBudget( void )
+{
+    struct timeval  now;
+    
+    if( config.bus_rate == 0 ) {
+        return( 0 );
+    }
+    gettimeofday( &now, NULL );
+    if( busTokensUpdated.tv_sec == 0 ) {
+        busTokens = 1000 * config.bus_rate;
+    } else {
+        busTokens += elapsed( &busTokensUpdated, &now ) * config.bus_rate;
+        if( busTokens > 1000 * config.bus_rate ) {
+            busTokens = 1000 * config.bus_rate;
+        }
+    }
+    busTokensUpdated = now;
+    if( busTokens >= 1000 ) {
+        return( 0 );
+    }
+    return( (1000 - busTokens + config.bus_rate - 1) / config.bus_rate );
+}
+
+
+/*
+ * busStatistics
+ * 
+ * account queueing delay of request about to be removed from client queue
+ */
+static void busStatistics( EIBNETIP_QUEUE *queue )
+{
+    struct timeval  now;
+    long            delay;
+    int             prio;
+    
+    gettimeofday( &now, NULL );
+    delay = elapsed( &queue->queued, &now );
+    if( delay < 0 ) {
+        delay = 0;
+    }
+    prio = busPriority( queue );
+    statsPrioSent[prio]++;
+    statsPrioDelay[prio] += delay;
+    if( delay > statsPrioDelayMax[prio] ) {
+        statsPrioDelayMax[prio] = delay;
+    }
+}
+
+
 /*
  * EIBnetTunnelForward thread
  * 
  * our eibnet/ip server puts tunneling requests it receives on the client queue
  * this thread forwards them to the remote server and removes them from the queue
+ * requests are sent by priority and at most config.bus_rate per second
  */
 void *EIBnetTunnelForward( void *arg )
 {
@@ -340,6 +463,7 @@ void *EIBnetTunnelForward( void *arg )
     unsigned char                           *request;
     unsigned char                           *data_buffer;
     int                                     length;
+    long                                    wait;
     time_t                                  secs;
 
     logDebug( THIS_MODULE, "EIBnetTunnelForward" );
@@ -367,9 +491,30 @@ void *EIBnetTunnelForward( void *arg )
         pth_event_free( ev_wakeup, PTH_FREE_ALL );
         
         while( eibQueueClient != NULL ) {
+            busSelectRequest();
             if( eibcon[0].channelid != 0 ) {
                 // we have an established connection to the remote server
-                if( eibcon[0].loopback == loopbackOn ) {
+                if( eibcon[0].loopback != loopbackOn && (wait = busBudget()) > 0 ) {
+                    // bus budget exhausted - wait, meanwhile requests of higher priority may arrive
+                    logDebug( THIS_MODULE, "Bus budget exhausted - delaying request %d by %ld ms", eibQueueClient->nr, wait );
+                    pth_nap( pth_time( wait / 1000, (wait % 1000) * 1000 ));
+                    continue;
+                }
+                cemiframe = (CEMIFRAME *) &eibQueueClient->data[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER )];
+                if( cemiframe->code == L_DATA_REQ && (cemiframe->ntwrk & EIB_DAF_GROUP) != 0 &&
+                    (((cemiframe->tpci & 0x03) << 8) | (cemiframe->apci & 0xc0)) == A_READ_VALUE_REQ &&
+                    groupCacheReadPending( cemiframe->daddr ) != 0 ) {
+                    // the same group is already being read by another client (socket, eibd or eibnet/ip)
+                    // don't load the bus with a duplicate - the response will be forwarded to all clients anyway
+                    // eibnet/ip clients still expect a confirmation of their request
+                    logDebug( THIS_MODULE, "Group read already outstanding - request dropped" );
+                    data_buffer = allocMemory( THIS_MODULE, eibQueueClient->len );
+                    memcpy( data_buffer, eibQueueClient->data, eibQueueClient->len );
+                    cemiframe = (CEMIFRAME *) &data_buffer[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER )];
+                    cemiframe->code = L_DATA_CON;
+                    addRequestToQueue( THIS_MODULE, &eibQueueServer, data_buffer, eibQueueClient->len );
+                    pth_cond_notify( &condQueueServer, TRUE );
+                } else if( eibcon[0].loopback == loopbackOn ) {
                     // in loopback mode, there is no need to forward request
                     // it would go to our own server which forwards it to this thread, creating an endless loop
                     // instead, simply assume it was received from the upstream server and forward it accordingly
@@ -410,6 +555,9 @@ void *EIBnetTunnelForward( void *arg )
                     pth_mutex_acquire( &mtxClientInUse, FALSE, NULL );
                     eibcon[0].statsPacketsSent++;
                     statsTotalSent++;
+                    if( config.bus_rate ) {
+                        busTokens -= 1000;
+                    }
                     if( eibNetIpSendData( EIBNETIP_CLIENT, &eibcon[0], &eibcon[0].hpai, TUNNELLING_REQUEST, request, length ) != 0 ) {
                         clientDisconnect( "forwarder" );
                     }
@@ -417,6 +565,7 @@ void *EIBnetTunnelForward( void *arg )
                 }
             }
             
+            busStatistics( eibQueueClient );
             eibQueueClient = removeRequestFromQueue( THIS_MODULE, eibQueueClient );                // assumes that only first queue entry can ever be removed
             pth_yield( NULL );
         }
@@ -591,14 +740,15 @@ char *EIBnetClientStatus( void )
     uint16_t        tmp16;
     uint16_t        idx;
     uint8_t         namelength;
+    int             prio;
     
     statsQueueWaiting = 0;
     for( queue = eibQueueClient; queue != NULL; queue = queue->next ) {
         statsQueueWaiting++;
     }
     
-#define STATUS_CLIENT_VERSION     4
-#define STATUS_CLIENT_BASE_LENGTH   41
+#define STATUS_CLIENT_VERSION     5
+#define STATUS_CLIENT_BASE_LENGTH   (43 + BUS_PRIORITIES * 12)
     namelength = strlen( config.eibConnectionParam );
     tmp16 = STATUS_CLIENT_BASE_LENGTH + namelength;
     status = allocMemory( THIS_MODULE, 2 + tmp16 );
@@ -621,6 +771,12 @@ char *EIBnetClientStatus( void )
     idx = AppendBytes( idx, status, sizeof( uint16_t ), eibcon[0].hpai.port );
     idx = AppendBytes( idx, status, sizeof( uint32_t ), eibcon[0].ipSource );
     idx = AppendBytes( idx, status, sizeof( uint8_t ), eibcon[0].loopback );
+    idx = AppendBytes( idx, status, sizeof( uint16_t ), htons( config.bus_rate ));
+    for( prio = 0; prio < BUS_PRIORITIES; prio++ ) {
+        idx = AppendBytes( idx, status, sizeof( uint32_t ), htonl( statsPrioSent[prio] ));
+        idx = AppendBytes( idx, status, sizeof( uint32_t ), htonl( (statsPrioSent[prio] > 0) ? statsPrioDelay[prio] / statsPrioSent[prio] : 0 ));
+        idx = AppendBytes( idx, status, sizeof( uint32_t ), htonl( statsPrioDelayMax[prio] ));
+    }
     logDebug( THIS_MODULE, "Client status: %s", hexdump( THIS_MODULE, status +2, STATUS_CLIENT_BASE_LENGTH + namelength ));
     return( status );
 }
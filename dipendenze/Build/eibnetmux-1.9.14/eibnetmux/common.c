@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/time.h>
 #include <arpa/inet.h>
 
 #include <pth.h>
@@ -34,6 +35,18 @@
 #include "include/eibnetip_private.h"
 
 
+/*
+ * Globals
+ */
+pth_cond_t              condGroupCache;                 // signals update of group value cache
+
+
+/*
+ * Local variables
+ */
+static GROUP_CACHE_ENTRY *groupCache = NULL;            // last value of every group address
+
+
 /*
  * local functions
  */
@@ -336,8 +349,137 @@ void addRequestToQueue( void *module, EIBNETIP_QUEUE **top, unsigned char *buf,
     (*queue)->len            = len;
     (*queue)->pending_eibnet = pending_eibnet;
     (*queue)->pending_others = pending_others;
+    gettimeofday( &(*queue)->queued, NULL );
     
     // determine queue name
     queue_name = (*top == eibQueueServer) ? "server" : "client";
     logDebug( module, "Add tunneling request %d to %s queue: %08x, queue len = %d, pending eibnet = %08x, others = %08x", (*queue)->nr, queue_name, *queue, loop, pending_eibnet, pending_others );
 }
+
+
+/*
+ * group value cache
+ * 
+ * keeps the last value written to or returned by every group address seen on the bus
+ * updated by the eibnet/ip client for every request received from the remote server,
+ * used by the socket and eibd servers to answer reads without a bus round trip
+ */
+void groupCacheInit( void )
+{
+    groupCache = allocMemory( logModuleMain, GROUP_CACHE_ENTRIES * sizeof( GROUP_CACHE_ENTRY ));
+    memset( groupCache, 0, GROUP_CACHE_ENTRIES * sizeof( GROUP_CACHE_ENTRY ));
+    pth_cond_init( &condGroupCache );
+}
+
+
+/*
+ * store group value write or response
+ * buf is a tunneling request as put on the server queue
+ */
+void groupCacheUpdate( unsigned char *buf, int len )
+{
+    CEMIFRAME           *cemiframe;
+    GROUP_CACHE_ENTRY   *entry;
+    uint16_t            apci;
+    int                 length;
+    
+    if( groupCache == NULL ) {
+        return;
+    }
+    
+    cemiframe = (CEMIFRAME *) &buf[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER )];
+    length = len - (sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) +9);
+    if( cemiframe->code != L_DATA_IND || (cemiframe->ntwrk & EIB_DAF_GROUP) == 0 ||
+        length < 2 || length > GROUP_CACHE_APDU_MAX ) {
+        return;
+    }
+    
+    // group value read requests don't carry a value
+    apci = ((cemiframe->tpci & 0x03) << 8) | (cemiframe->apci & 0xc0);
+    if( apci != A_WRITE_VALUE_REQ && apci != A_RESPONSE_VALUE_REQ ) {
+        return;
+    }
+    
+    entry = &groupCache[ntohs( cemiframe->daddr )];
+    entry->timestamp = time( NULL );
+    entry->requested = 0;
+    entry->source = cemiframe->saddr;
+    entry->length = length;
+    memcpy( entry->apdu, &cemiframe->tpci, length );
+    
+    pth_cond_notify( &condGroupCache, TRUE );
+}
+
+
+/*
+ * return cache entry of group address daddr (network order)
+ * if its value is not older than maxage seconds (any age if maxage < 0), NULL otherwise
+ */
+GROUP_CACHE_ENTRY *groupCacheLookup( uint16_t daddr, int maxage )
+{
+    GROUP_CACHE_ENTRY   *entry;
+    
+    if( groupCache == NULL ) {
+        return( NULL );
+    }
+    
+    entry = &groupCache[ntohs( daddr )];
+    if( entry->timestamp == 0 || (maxage >= 0 && time( NULL ) - entry->timestamp > maxage) ) {
+        return( NULL );
+    }
+    return( entry );
+}
+
+
+/*
+ * check if a group read for daddr (network order) has been sent to the bus
+ * less than config.read_window seconds ago and is still unanswered
+ * if not, remember that the caller is about to send one
+ * 
+ * returns 1 if caller can drop its read and wait for the outstanding response, 0 if it must send the read itself
+ */
+int groupCacheReadPending( uint16_t daddr )
+{
+    GROUP_CACHE_ENTRY   *entry;
+    time_t              now;
+    
+    if( groupCache == NULL || config.read_window == 0 ) {
+        return( 0 );
+    }
+    
+    entry = &groupCache[ntohs( daddr )];
+    now = time( NULL );
+    if( entry->requested != 0 && now - entry->requested <= config.read_window ) {
+        return( 1 );
+    }
+    entry->requested = now;
+    return( 0 );
+}
+
+
+/*
+ * forget value of group address daddr (network order)
+ */
+void groupCacheInvalidate( uint16_t daddr )
+{
+    if( groupCache != NULL ) {
+        groupCache[ntohs( daddr )].timestamp = 0;
+    }
+}
+
+
+/*
+ * forget all cached values
+ */
+void groupCacheClear( void )
+{
+    GROUP_CACHE_ENTRY   *entry;
+    
+    if( groupCache == NULL ) {
+        return;
+    }
+    
+    for( entry = groupCache; entry < groupCache + GROUP_CACHE_ENTRIES; entry++ ) {
+        entry->timestamp = 0;
+    }
+}
@@ -41,6 +41,7 @@
  *                                      set log destination (protocol, host:port, filename)
  * -r --ring_level=level                set levels logged to ring buffer default: 128
  * -R --ring_size=kilobytes             set size of debug ring buffer   default: 32
+ *    --ring_file=file                  keep debug ring buffer in file  default: -
  * 
  * <behaviour>
  * -d --daemon                          run as daemon                   default: no
@@ -138,10 +139,13 @@ static struct option option_list[] = {
     { "log_dest",   1, NULL, 'L' },
     { "ring_level", 1, NULL, 'r' },
     { "ring_size",  1, NULL, 'R' },
+    { "ring_file",  1, NULL, 'F' },
     { "pidfile",    1, NULL, 'p' },
     { "security",   1, NULL, 'S' },
     { "address",    1, NULL, 'A' },
     { "maxsocketclients", 1, NULL, 'c' },
+    { "read_window", 1, NULL, 'w' },
+    { "bus_rate",   1, NULL, 'b' },
     { "dump",       0, NULL, 'Q' },
     { 0, 0, 0, 0 },                         // must be last entry, marks end of array
 };
@@ -193,6 +197,7 @@ void Usage( char *progname )
                      "  -L --log_dest=syslog:facility        send log to syslog using facility\n"
                      "  -r --ring_level=level                set levels logged to ring buffer default: 128\n"
                      "  -R --ring_size=kilobytes             set size of debug ring buffer   default: 32\n"
+                     "     --ring_file=file                  keep debug ring buffer in file  default: -\n"
                      "\n"
                      "<behaviour>\n"
                      "  -d --daemon                          run as daemon                   default: no\n"
@@ -201,6 +206,10 @@ void Usage( char *progname )
                      "  -p --pidfile=file                    file to write pid to            default: -\n"
                      "  -S --security=file                   file with security restrictions default: -\n"
                      "  -A --address=ip-address              fixed IP address to use         default: -\n"
+                     "  -w --read_window=seconds             combine identical group reads   default: 3\n"
+                     "                                       sent within this interval (0=off)\n"
+                     "  -b --bus_rate=telegrams              max. telegrams per second sent  default: 0\n"
+                     "                                       to the bus (0=unlimited)\n"
                      "  -T --testmode                        run in testmode                 default: no\n"
                      "\n", basename( progname ));
 }
@@ -228,6 +237,7 @@ int ConfigLoad( int argc, char **argv )
     config.log_dest           = strdup( "file:/var/log/eibnetmux.log" );
     config.ring_size          = 32;
     config.ring_level         = zlogLevelDebug;
+    config.ring_file          = NULL;
     config.unix_path          = NULL;
     config.pidfile            = NULL;
     config.user               = 0;
@@ -249,11 +259,13 @@ int ConfigLoad( int argc, char **argv )
     config.eibd_anonymous     = 0;
     config.socketclients      = SOCKETS_MAX;
     config.eibdclients        = EIBDCLIENTS_MAX;
+    config.read_window        = GROUP_CACHE_READ_WINDOW;
+    config.bus_rate           = BUS_RATE_DEFAULT;
     config.dump               = FALSE;
     
     
     opterr = 0;
-    while( ( c = getopt_long( argc, argv, "Vs::t::u::e::p:di:g:l:L:r:R:c:S:A:Q", option_list, NULL )) != -1 ) {
+    while( ( c = getopt_long( argc, argv, "Vs::t::u::e::p:di:g:l:L:r:R:c:S:A:w:b:Q", option_list, NULL )) != -1 ) {
         switch( c ) {
             case 'V':
                 printf( "eibnetmux version %s", VERSION );
@@ -336,6 +348,10 @@ int ConfigLoad( int argc, char **argv )
             case 'R':
                 config.ring_size = atoi( optarg );
                 break;
+            case 'F':
+                if( config.ring_file != NULL ) free( config.ring_file );
+                config.ring_file = strdup( optarg );
+                break;
             case 'S':
                 if( config.security_file != NULL ) free( config.security_file );
                 config.security_file = strdup( optarg );
@@ -353,6 +369,18 @@ int ConfigLoad( int argc, char **argv )
                     config.ip = fixed_address.s_addr;
                 } 
                 break;
+            case 'w':
+                config.read_window = atoi( optarg );
+                if( config.read_window < 0 ) {
+                    config.read_window = 0;
+                }
+                break;
+            case 'b':
+                config.bus_rate = atoi( optarg );
+                if( config.bus_rate < 0 ) {
+                    config.bus_rate = 0;
+                }
+                break;
             case 'Q':
                 config.dump = TRUE;
                 break;
@@ -857,7 +885,7 @@ sSecurityConfig *configReadSecurity( void )
             } else {
                 if( secConf->dhm == NULL ) {
                     secConf->dhm = allocMemory( THIS_MODULE, sizeof( dhm_context ));
-                    memset( &secConf->dhm, 0, sizeof( dhm_context ));
+                    memset( secConf->dhm, 0, sizeof( dhm_context ));
                 }
                 if( (result = mpi_read_file( &(secConf->dhm->P), 16, fp )) != 0 ||
                     (result = mpi_read_file( &(secConf->dhm->G), 16, fp )) != 0 ) {
@@ -868,6 +896,16 @@ sSecurityConfig *configReadSecurity( void )
             }
             free( dhm_file );
         }
+        
+        /*
+         * G and P are fixed for all connections, pre-compute powers of G once
+         */
+        if( secConf->dhm != NULL && error == 0 ) {
+            if( (result = dhm_precompute( secConf->dhm )) != 0 ) {
+                logError( THIS_MODULE, msgConfigDHMPrecompute, result );
+                error = 1;
+            }
+        }
 #endif
     }
     if( error != 0 ) {
@@ -915,6 +953,7 @@ void configSecurityReleaseMemory( sSecurityConfig *secConf )
 #ifdef WITH_AUTHENTICATION
     if( secConf->dhm != NULL ) {
         dhm_free( secConf->dhm );
+        free( secConf->dhm );
     }
 #endif
     free( secConf );
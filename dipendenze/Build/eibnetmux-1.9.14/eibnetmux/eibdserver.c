@@ -44,6 +44,8 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <stddef.h>
 
 #include <pth.h>
 
@@ -87,6 +89,8 @@ static pth_t            tid_forward = 0;
 static pth_mutex_t      mtxQueueEIBD;
 static uint32_t         statsTotalSent = 0;                     // statistics
 static uint32_t         statsTotalReceived = 0;
+static int              eibdCacheEnabled = false;               // group cache commands allowed
+static pth_mutex_t      mtxCache;
 
 static sCmdNames        eibdCmdNames[] = {
                                             { EIB_INVALID_REQUEST, "EIB_INVALID_REQUEST" },
@@ -155,8 +159,11 @@ static void     eibdTerminateConnection( int clientid );
 static int      eibdGetUsedIds( void *system, uint32_t **array, int entries, uint32_t threshold );
 static void     eibdSendResponse( int clientid, uint16_t code );
 static void     eibdSendPacket( int clientid, unsigned char *buf, int length );
+static void     eibdSendPacketv( int clientid, struct iovec *iov, int iovcnt );
 static void     eibdFlushRest( int clientid, int length );
 static char     *eibdGetCommandName( int command );
+static void     eibdCacheRead( int clientid, uint16_t cmd, int length );
+static void     eibdSendGroupRead( uint16_t dst_addr );
 static void     serverShutdown( void );
 
 
@@ -275,9 +282,11 @@ static void eibdSendResponse( int clientid, uint16_t code )
     response[1] = 2;
     response[2] = (code >> 8) & 0xff;
     response[3] = code & 0xff;
-    hdump = hexdump( THIS_MODULE, response, 4 );
-    logTraceEIBD( THIS_MODULE, msgEIBDResponse, clientid, hdump );
-    free( hdump );
+    if( (logGetLevel() | logGetRingLevel()) & zlogLevelCustom2 ) {
+        hdump = hexdump( THIS_MODULE, response, 4 );
+        logTraceEIBD( THIS_MODULE, msgEIBDResponse, clientid, hdump );
+        free( hdump );
+    }
     (void) pth_write( eibdcon[clientid].socket, response, 4 );
 }
 
@@ -286,22 +295,49 @@ static void eibdSendResponse( int clientid, uint16_t code )
  * send data packet to client
  */
 static void eibdSendPacket( int clientid, unsigned char *buf, int length )
+{
+    struct iovec    iov;
+    
+    iov.iov_base = buf;
+    iov.iov_len  = length;
+    eibdSendPacketv( clientid, &iov, 1 );
+}
+
+
+/**
+ * send data packet made up of several parts to client
+ * 
+ * all parts are sent with a single system call, header and data
+ * can thus be taken from different buffers without copying them
+ */
+static void eibdSendPacketv( int clientid, struct iovec *iov, int iovcnt )
 {
     char        *hdump;
+    ssize_t     length;
+    int         loop;
     
     if( clientid >= config.eibdclients ) {
         return;
     }
     
-    if( pth_write( eibdcon[clientid].socket, buf, length ) != length ) {
+    length = 0;
+    for( loop = 0; loop < iovcnt; loop++ ) {
+        length += iov[loop].iov_len;
+    }
+    if( pth_writev( eibdcon[clientid].socket, iov, iovcnt ) != length ) {
         logError( THIS_MODULE, msgEIBDSendAborted, clientid, strerror( errno ));
         close( eibdcon[clientid].socket );
         if( eibdcon[clientid].threadid != 0 ) pth_abort( eibdcon[clientid].threadid );
         eibdClearConnection( clientid );
     }
-    hdump = hexdump( THIS_MODULE, buf, length );
-    logTraceEIBD( THIS_MODULE, msgSocketForward, clientid, hdump );
-    free( hdump );
+    // hexdump is expensive, only create it if anybody is listening
+    if( (logGetLevel() | logGetRingLevel()) & zlogLevelCustom2 ) {
+        for( loop = 0; loop < iovcnt; loop++ ) {
+            hdump = hexdump( THIS_MODULE, iov[loop].iov_base, iov[loop].iov_len );
+            logTraceEIBD( THIS_MODULE, msgSocketForward, clientid, hdump );
+            free( hdump );
+        }
+    }
     eibdcon[clientid].statsPacketsSent++;
     statsTotalSent++;
 }
@@ -442,6 +478,105 @@ static void eibdFlushRest( int clientid, int length )
 }
 
 
+/*
+ * eibdSendGroupRead
+ * 
+ * put group value read request for dst_addr on eibnet/ip client queue
+ * memory will be freed by eibnet/ip client when it releases the queued entry
+ */
+static void eibdSendGroupRead( uint16_t dst_addr )
+{
+    CEMIFRAME       *cemiframe;
+    unsigned char   *buf;
+    
+    buf = allocMemory( THIS_MODULE, sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) + 6 );
+    memset( buf, '\0', sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) + 6 );
+    cemiframe = (CEMIFRAME *) &buf[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER )];
+    cemiframe->code   = L_DATA_REQ;
+    cemiframe->zero   = 0;
+    cemiframe->ctrl   = EIB_CTRL_DATA | EIB_CTRL_LENGTHBYTE | EIB_CTRL_NOREPEAT | EIB_CTRL_NONACK | EIB_CTRL_PRIO_LOW;
+    cemiframe->ntwrk  = EIB_DAF_GROUP | EIB_NETWORK_HOPCOUNT;
+    cemiframe->saddr  = 0;
+    cemiframe->daddr  = dst_addr;
+    cemiframe->length = 1;
+    cemiframe->tpci   = T_GROUPDATA_REQ | ((A_READ_VALUE_REQ >> 8) & 0x03);
+    cemiframe->apci   = (A_READ_VALUE_REQ & 0xff);
+    
+    logDebug( THIS_MODULE, "Add group read request for cache to client queue" );
+    addRequestToQueue( THIS_MODULE, &eibQueueClient, buf, sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) -17 + cemiframe->length );
+    pth_cond_notify( &condQueueClient, TRUE );
+}
+
+
+/*
+ * eibdCacheRead
+ * 
+ * handle EIB_CACHE_READ and EIB_CACHE_READ_NOWAIT
+ *   request:   destination address     16 bit
+ *   response:  source address          16 bit
+ *              destination address     16 bit
+ *              apdu                    x bytes, missing if group address is not cached
+ * 
+ * EIB_CACHE_READ sends a group read to the bus on a cache miss
+ * and waits up to EIBD_CACHE_TIMEOUT seconds for the answer
+ * 
+ * the cache itself is shared with the other servers and always kept up-to-date,
+ * EIB_CACHE_ENABLE/DISABLE only control access by eibd clients
+ */
+static void eibdCacheRead( int clientid, uint16_t cmd, int length )
+{
+    EIBD_RESP_GROUP     response;
+    GROUP_CACHE_ENTRY   *entry;
+    pth_event_t         ev_timeout;
+    uint16_t            dst_addr;
+    char                *hdump;
+    
+    if( length < (int)sizeof( dst_addr )) {
+        eibdFlushRest( clientid, length );
+        eibdSendResponse( clientid, EIB_INVALID_REQUEST );
+        return;
+    }
+    if( readFromSocket( THIS_MODULE, eibdcon[clientid].socket, clientid, &dst_addr, sizeof( dst_addr ), sizeof( dst_addr ), EIBD_REQ_TIMEOUT ) != 0 ) {
+        eibdTerminateConnection( clientid );        // never returns
+    }
+    eibdFlushRest( clientid, length - sizeof( dst_addr ));
+    
+    if( eibdCacheEnabled == false ) {
+        eibdSendResponse( clientid, EIB_PROCESSING_ERROR );
+        return;
+    }
+    
+    entry = groupCacheLookup( dst_addr, -1 );
+    if( entry == NULL && cmd == EIB_CACHE_READ ) {
+        eibdSendGroupRead( dst_addr );
+        ev_timeout = pth_event( PTH_EVENT_TIME, pth_timeout( EIBD_CACHE_TIMEOUT, 0 ));
+        while( (entry = groupCacheLookup( dst_addr, -1 )) == NULL &&
+               pth_event_status( ev_timeout ) != PTH_STATUS_OCCURRED ) {
+            pth_mutex_acquire( &mtxCache, FALSE, NULL );
+            pth_cond_await( &condGroupCache, &mtxCache, ev_timeout );
+            pth_mutex_release( &mtxCache );
+        }
+        pth_event_free( ev_timeout, PTH_FREE_THIS );
+    }
+    
+    hdump = knx_group( THIS_MODULE, dst_addr );
+    response.command = htons( cmd );
+    response.destination = dst_addr;
+    if( entry != NULL ) {
+        logVerbose( THIS_MODULE, msgEIBDCacheRead, clientid, hdump, "hit" );
+        response.size = htons( 6 + entry->length );
+        response.source = entry->source;
+        memcpy( response.data, entry->apdu, entry->length );
+    } else {
+        logVerbose( THIS_MODULE, msgEIBDCacheRead, clientid, hdump, "miss" );
+        response.size = htons( 6 );
+        response.source = 0;
+    }
+    free( hdump );
+    eibdSendPacket( clientid, (unsigned char *)&response, ntohs( response.size ) +2 );
+}
+
+
 static int eibdCheckConnectionType( int clientid, int type )
 {
     if( clientid >= config.eibdclients ) {
@@ -474,6 +609,14 @@ static int eibdCheckConnectionType( int clientid, int type )
  *   EIB_OPEN_T_BROADCAST           yes (flag)              EIB_APDU_PACKET
  *   EIB_OPEN_VBUSMONITOR           no                      EIB_BUSMONITOR_PACKET   (receive only)
  * 
+ * group cache commands, connection stays unopened
+ *   EIB_CACHE_ENABLE               no
+ *   EIB_CACHE_DISABLE              no
+ *   EIB_CACHE_CLEAR                no
+ *   EIB_CACHE_REMOVE               yes (address)
+ *   EIB_CACHE_READ                 yes (address)           EIB_CACHE_READ
+ *   EIB_CACHE_READ_NOWAIT          yes (address)           EIB_CACHE_READ_NOWAIT
+ * 
  * not supported
  *   EIB_OPEN_T_CONNECTION          yes         EIB_APDU_PACKET
  *   EIB_OPEN_T_INDIVIDUAL          yes         EIB_APDU_PACKET
@@ -487,12 +630,6 @@ static int eibdCheckConnectionType( int clientid, int type )
  *   EIB_M_INDIVIDUAL_ADDRESS_WRITE
  *   EIB_MC_CONNECTION
  *   EIB_LOAD_IMAGE
- *   EIB_CACHE_ENABLE
- *   EIB_CACHE_DISABLE
- *   EIB_CACHE_CLEAR
- *   EIB_CACHE_REMOVE
- *   EIB_CACHE_READ
- *   EIB_CACHE_READ_NOWAIT
  */
 void *EIBDHandler( void *arg )
 {
@@ -581,6 +718,48 @@ void *EIBDHandler( void *arg )
             eibdSendResponse( clientid, cmd );
             eibdcon[clientid].type = EIBD_VIRGIN_CONNECTION;
             logVerbose( THIS_MODULE, msgEIBDReset, clientid );
+        } else if( cmd >= EIB_CACHE_ENABLE && cmd <= EIB_CACHE_READ_NOWAIT && eibdCheckConnectionType( clientid, EIBD_VIRGIN_CONNECTION ) == 0 ) {
+            /*
+             * group cache
+             * shared by all clients, does not change connection type
+             */
+            switch( cmd ) {
+                case EIB_CACHE_ENABLE:
+                    eibdFlushRest( clientid, req_header.size );
+                    eibdCacheEnabled = true;
+                    logVerbose( THIS_MODULE, msgEIBDCache, clientid, "enabled" );
+                    eibdSendResponse( clientid, cmd );
+                    break;
+                case EIB_CACHE_DISABLE:
+                    eibdFlushRest( clientid, req_header.size );
+                    eibdCacheEnabled = false;
+                    logVerbose( THIS_MODULE, msgEIBDCache, clientid, "disabled" );
+                    eibdSendResponse( clientid, cmd );
+                    break;
+                case EIB_CACHE_CLEAR:
+                    eibdFlushRest( clientid, req_header.size );
+                    groupCacheClear();
+                    logVerbose( THIS_MODULE, msgEIBDCache, clientid, "cleared" );
+                    eibdSendResponse( clientid, cmd );
+                    break;
+                case EIB_CACHE_REMOVE:
+                    if( req_header.size < sizeof( dst_addr )) {
+                        eibdFlushRest( clientid, req_header.size );
+                        eibdSendResponse( clientid, EIB_INVALID_REQUEST );
+                        break;
+                    }
+                    if( readFromSocket( THIS_MODULE, eibdcon[clientid].socket, clientid, &dst_addr, sizeof( dst_addr ), sizeof( dst_addr ), EIBD_REQ_TIMEOUT ) != 0 ) {
+                        eibdTerminateConnection( clientid );        // never returns
+                    }
+                    eibdFlushRest( clientid, req_header.size - sizeof( dst_addr ));
+                    groupCacheInvalidate( dst_addr );
+                    eibdSendResponse( clientid, cmd );
+                    break;
+                case EIB_CACHE_READ:
+                case EIB_CACHE_READ_NOWAIT:
+                    eibdCacheRead( clientid, cmd, req_header.size );
+                    break;
+            }
         } else if( eibdCheckConnectionType( clientid, EIBD_VIRGIN_CONNECTION ) == 0 ) {
             switch( cmd ) {
                 case EIB_OPEN_GROUPCON:
@@ -627,12 +806,6 @@ void *EIBDHandler( void *arg )
                 case EIB_M_INDIVIDUAL_ADDRESS_WRITE:
                 case EIB_MC_CONNECTION:
                 case EIB_LOAD_IMAGE:
-                case EIB_CACHE_ENABLE:
-                case EIB_CACHE_DISABLE:
-                case EIB_CACHE_CLEAR:
-                case EIB_CACHE_REMOVE:
-                case EIB_CACHE_READ:
-                case EIB_CACHE_READ_NOWAIT:
                     eibdFlushRest( clientid, req_header.size -2 );
                     logVerbose( THIS_MODULE, msgEIBDNotImplemented, clientid, cmd );
                     cmd = EIB_PROCESSING_ERROR;
@@ -746,6 +919,9 @@ void *eibdFromBusForward( void *arg )
     EIBD_RESP_GROUP         resp_group;
     EIBD_RESP_BUSMON_SMALL  resp_busmon_small;
     EIBD_RESP_BUSMON_LARGE  resp_busmon_large;
+    struct iovec            iov_apdu[2];
+    struct iovec            iov_group[2];
+    struct iovec            iov_busmon[2];
     pth_event_t             ev_wakeup;
     sigset_t                signal_set;
     uint8_t                 loop;
@@ -800,20 +976,27 @@ void *eibdFromBusForward( void *arg )
                     // our eibd-compatible server does not support requests addressed to physical devices
                     
                     // prepare data structure to send to clients
+                    // only headers are built here, data is sent straight from the queue entry
                     data_length = queue->len - (sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) +9);
                     
                     // apdu
                     resp_apdu.size = htons( 4 + data_length );
                     resp_apdu.command = htons( EIB_APDU_PACKET );
                     resp_apdu.source = cemiframe->saddr;
-                    memcpy( &resp_apdu.data, &cemiframe->tpci, data_length );
+                    iov_apdu[0].iov_base = &resp_apdu;
+                    iov_apdu[0].iov_len  = offsetof( EIBD_RESP_APDU, data );
+                    iov_apdu[1].iov_base = &cemiframe->tpci;
+                    iov_apdu[1].iov_len  = data_length;
                     
                     // group
                     resp_group.size = htons( 6 + data_length );
                     resp_group.command = htons( EIB_GROUP_PACKET );
                     resp_group.source = cemiframe->saddr;
                     resp_group.destination = cemiframe->daddr;
-                    memcpy( &resp_group.data, &cemiframe->tpci, data_length );
+                    iov_group[0].iov_base = &resp_group;
+                    iov_group[0].iov_len  = offsetof( EIBD_RESP_GROUP, data );
+                    iov_group[1].iov_base = &cemiframe->tpci;
+                    iov_group[1].iov_len  = data_length;
                     
                     // busmonitor
                     if( cemiframe->length <= 15 ) {
@@ -823,7 +1006,10 @@ void *eibdFromBusForward( void *arg )
                         resp_busmon_small.source = cemiframe->saddr;
                         resp_busmon_small.dest = cemiframe->daddr;
                         resp_busmon_small.network = (cemiframe->ntwrk & 0xf0) | (cemiframe->length & 0x0f);
-                        memcpy( &resp_busmon_small.data, &cemiframe->tpci, cemiframe->length +2 );
+                        iov_busmon[0].iov_base = &resp_busmon_small;
+                        iov_busmon[0].iov_len  = offsetof( EIBD_RESP_BUSMON_SMALL, data );
+                        iov_busmon[1].iov_base = &cemiframe->tpci;
+                        iov_busmon[1].iov_len  = cemiframe->length +2;
                     } else {
                         resp_busmon_large.size = htons( 2 + 7 + cemiframe->length +2 );
                         resp_busmon_large.command = htons( EIB_BUSMONITOR_PACKET );
@@ -832,6 +1018,10 @@ void *eibdFromBusForward( void *arg )
                         resp_busmon_large.dest = cemiframe->daddr;
                         resp_busmon_large.network = (cemiframe->ntwrk & 0xf0);
                         resp_busmon_large.length = cemiframe->length;
+                        iov_busmon[0].iov_base = &resp_busmon_large;
+                        iov_busmon[0].iov_len  = sizeof( resp_busmon_large );
+                        iov_busmon[1].iov_base = &cemiframe->apci;
+                        iov_busmon[1].iov_len  = cemiframe->length +2;
                     }
                     
                     // send request to all active, read-write connections
@@ -852,16 +1042,11 @@ void *eibdFromBusForward( void *arg )
                              */
                             if( (eibdcon[loop].type == EIB_OPEN_T_BROADCAST && cemiframe->daddr == 0) ||
                                 (eibdcon[loop].type == EIB_OPEN_T_GROUP && eibdcon[loop].knxaddress == cemiframe->daddr) ) {
-                                eibdSendPacket( loop, (unsigned char *)&resp_apdu, ntohs( resp_apdu.size ) +2 );
+                                eibdSendPacketv( loop, iov_apdu, 2 );
                             } else if( eibdcon[loop].type == EIB_OPEN_GROUPCON ) {
-                                eibdSendPacket( loop, (unsigned char *)&resp_group, ntohs( resp_group.size ) +2 );
+                                eibdSendPacketv( loop, iov_group, 2 );
                             } else if( eibdcon[loop].type == EIB_OPEN_VBUSMONITOR ) {
-                                if( cemiframe->length <= 15 ) {
-                                    eibdSendPacket( loop, (unsigned char *)&resp_busmon_small, ntohs( resp_busmon_small.size ) +2 );
-                                } else {
-                                    eibdSendPacket( loop, (unsigned char *)&resp_busmon_large, 2 + sizeof( resp_busmon_large ) );
-                                    eibdSendPacket( loop, (unsigned char *)&cemiframe->apci, cemiframe->length +2 );
-                                }
+                                eibdSendPacketv( loop, iov_busmon, 2 );
                             }
                             pth_yield( NULL );
                         }
@@ -929,6 +1114,7 @@ void *EIBDListener( void *arg )
     for( tmp = 0; tmp < config.eibdclients; tmp++ ) {
         eibdClearConnection( tmp );
     }
+    pth_mutex_init( &mtxCache );
     
     /*
      * register shutdown callback handler to clean up
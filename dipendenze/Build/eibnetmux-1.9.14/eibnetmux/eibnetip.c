@@ -331,6 +331,7 @@ static int handleTunneling( void *system, uint8_t *rcvdata, uint16_t rcvdatalen,
             
             // add to forwarding queue and signal all waiting threads
             if( system == EIBNETIP_CLIENT ) {
+                groupCacheUpdate( rcvdata, rcvdatalen );
                 addRequestToQueue( system, &eibQueueServer, rcvdata, rcvdatalen );
                 pth_cond_notify( &condQueueServer, TRUE );
             } else {
@@ -173,6 +173,7 @@ typedef struct {
     char            *log_dest;
     unsigned int    ring_level;
     int             ring_size;
+    char            *ring_file;
     uint8_t         servers;
     uint32_t        eib_ip;
     uint16_t        eib_port;
@@ -203,6 +204,8 @@ typedef struct {
     int             dump;
     uint16_t        socketclients;
     uint16_t        eibdclients;
+    int             read_window;                // seconds a group read is considered outstanding, 0 = no coalescing
+    int             bus_rate;                   // telegrams per second sent to the bus, 0 = unlimited
 } sConfig;
 
 #include "include/declarations.h"
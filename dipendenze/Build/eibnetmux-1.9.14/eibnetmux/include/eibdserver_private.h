@@ -41,6 +41,7 @@
  **/
 #define EIBD_REQ_TIMEOUT                15
 #define EIBD_READ_TIMEOUT               30
+#define EIBD_CACHE_TIMEOUT              2           // EIB_CACHE_READ: wait for response to bus read
 
 
 /*
@@ -67,6 +67,7 @@ typedef uint32_t                                connmask_t;             // must
 #define EIB_LL_NETWORK                          0x70
 #define T_GROUPDATA_REQ                         0x00
 #define A_READ_VALUE_REQ                        0x0000
+#define A_RESPONSE_VALUE_REQ                    0x0040
 #define A_WRITE_VALUE_REQ                       0x0080
 
 /*
@@ -118,6 +119,25 @@ typedef uint32_t                                connmask_t;             // must
 #define QUEUE_PENDING_EIBD                      0x02
 
 
+/**
+ * group value cache
+ *   one entry per group address, indexed by host-order address
+ *   apdu is stored as received: tpci, apci, data
+ */
+#define GROUP_CACHE_ENTRIES                     65536
+#define GROUP_CACHE_APDU_MAX                    18
+#define GROUP_CACHE_READ_WINDOW                 3       // default seconds a group read sent to the bus is considered outstanding
+
+
+/**
+ * bus write scheduler
+ *   requests on the client queue are sent by cEMI priority (system, alarm, high, low)
+ *   and limited to config.bus_rate telegrams per second (0 = unlimited)
+ */
+#define BUS_PRIORITIES                          4       // indexed by (ctrl & EIB_CTRL_PRIO_LOW) >> 2
+#define BUS_RATE_DEFAULT                        0
+
+
 typedef enum _eLoopback {
     loopbackUndefined,
     loopbackOff,
@@ -158,11 +178,21 @@ typedef struct _EIBNETIP_QUEUE {
         uint16_t        len;                // length of tunneldata
         connmask_t      pending_eibnet;
         uint32_t        pending_others;
+        struct timeval  queued;             // time request was added to queue
         // uint16_t        servicetype;
         struct _EIBNETIP_QUEUE  *next;      // pointer to next tunnel request packet
 } EIBNETIP_QUEUE;
 
 
+typedef struct {
+        time_t          timestamp;          // time of last update, 0 if entry is empty
+        time_t          requested;          // time group read was sent to bus, 0 if none outstanding
+        uint16_t        source;             // knx address of sender (network order)
+        uint8_t         length;             // length of apdu
+        unsigned char   apdu[GROUP_CACHE_APDU_MAX];     // last group value write or response
+} GROUP_CACHE_ENTRY;
+
+
 /*
  * EIBnet/IP tunneling client state
  */
@@ -189,6 +219,12 @@ extern int              eibNetIpSendControl( void *system, EIBNETIP_CONNECTION *
 extern int              eibNetIpSendData( void *system, EIBNETIP_CONNECTION *conn, EIBNETIP_HPAI *receiver, uint16_t service_type, uint8_t *senddata, uint16_t data_size );
 extern EIBNETIP_QUEUE * removeRequestFromQueue( void *module, EIBNETIP_QUEUE *queue );
 extern void             addRequestToQueue( void *system, EIBNETIP_QUEUE **top, unsigned char *buf, int len );
+extern void             groupCacheInit( void );
+extern void             groupCacheUpdate( unsigned char *buf, int len );
+extern GROUP_CACHE_ENTRY *groupCacheLookup( uint16_t daddr, int maxage );
+extern int              groupCacheReadPending( uint16_t daddr );
+extern void             groupCacheInvalidate( uint16_t daddr );
+extern void             groupCacheClear( void );
 
 // eibnetip.c
 extern int              EIBnetIPProtocolHandler( void *system, uint8_t *rcvdata, uint16_t rcvdatalen, eSecAddrType secType );
@@ -203,5 +239,6 @@ extern EIBNETIP_CONNECTION     eibcon[];
 extern int                     sock_eibclient_control;
 extern int                     sock_eibclient_data;
 extern int                     sock_eibserver;
+extern pth_cond_t              condGroupCache;
 
 #endif /*EIBNETIP_H_*/
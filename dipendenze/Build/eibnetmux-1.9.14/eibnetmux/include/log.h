@@ -46,6 +46,7 @@ typedef enum _eLogMsgId {
     msgConfigHashInvalid,
     msgConfigDHMRead,
     msgConfigDHM_MPI,
+    msgConfigDHMPrecompute,
     msgConfigSecurity,
     msgConfigSecurityError,
     msgConfigNoAuth,
@@ -114,6 +115,8 @@ typedef enum _eLogMsgId {
     msgEIBDBadCommand,
     msgEIBDBadPacket,
     msgEIBDResponse,
+    msgEIBDCache,
+    msgEIBDCacheRead,
     msgTCPNoListener,
     msgTCPConnection,
     msgUnixFileExists,
@@ -141,7 +144,7 @@ extern void         *logModuleSocketServer;
 extern char         *logInit( void );
 extern void         logSetLevel( unsigned int level );
 extern void         logSetRingLevel( unsigned int level );
-extern char         *logSetDest( char *destination, int ringsize );
+extern char         *logSetDest( char *destination, int ringsize, char *ringfile );
 extern unsigned int logGetLevel( void );
 extern unsigned int logGetRingLevel( void );
 extern void         log_message( void *l, unsigned int level, int msgid, ... );
@@ -70,17 +70,19 @@ typedef struct __attribute__((packed)) {
 /*
  * Socket commands
  */
-#define SOCKET_API_VERSION      3               // increase if you change any of the socket commands or status
+#define SOCKET_API_VERSION      5               // increase if you change any of the socket commands or status
 
-// used:        Aa Bb Cc D  E                 K  Ll M         p    Rr S        V  Ww X
-// available:             d  e Ff Gg Hh Ii Jj  k     m Nn Oo P Qq     s Tt Uu  v     x Yy Zz 1234567890
+// used:        Aa Bb Cc D  Ee       G        K  Ll M         p    Rr S        V  Ww X
+// available:             d    Ff  g Hh Ii Jj  k     m Nn Oo P Qq     s Tt Uu  v     x Yy Zz 1234567890
 #define SOCKET_CMD_KEY          'K'
 #define SOCKET_CMD_DHM          'D'
 #define SOCKET_CMD_AUTH         'A'
+#define SOCKET_CMD_ENCRYPT      'e'
 #define SOCKET_CMD_NAME         'a'
 #define SOCKET_CMD_VERSION      'V'
 #define SOCKET_CMD_READ         'R'
 #define SOCKET_CMD_READ_ONCE    'r'
+#define SOCKET_CMD_READ_CACHED  'G'
 #define SOCKET_CMD_WRITE        'W'
 #define SOCKET_CMD_WRITE_ONCE   'w'
 #define SOCKET_CMD_MONITOR      'M'
@@ -109,6 +111,7 @@ typedef struct __attribute__((packed)) {
 #define SOCKET_STAT_KEY         'K'
 #define SOCKET_STAT_DHM         'D'
 #define SOCKET_STAT_AUTH        'A'
+#define SOCKET_STAT_ENCRYPT     'e'
 #define SOCKET_STAT_NAME        'a'
 #define SOCKET_STAT_VERSION     'V'
 #define SOCKET_STAT_READ        'R'
@@ -22,6 +22,7 @@
 
 #ifdef WITH_AUTHENTICATION
 #include <polarssl/dhm.h>
+#include <polarssl/aes.h>
 #endif
 
 #include "socketserver.h"
@@ -46,6 +47,19 @@
 /**
  * structures
  **/
+#ifdef WITH_AUTHENTICATION
+typedef struct _SOCKET_CRYPT {
+    aes_context     enc;                            // expanded encryption key schedule (ecb encrypt, cfb both ways)
+    aes_context     dec;                            // expanded decryption key schedule (ecb decrypt)
+    uint8_t         stream;                         // true if all traffic on the connection is encrypted
+    int             rx_off;                         // cfb128 state for data received from client
+    unsigned char   rx_iv[16];
+    int             tx_off;                         // cfb128 state for data sent to client
+    unsigned char   tx_iv[16];
+    pth_mutex_t     mtxWrite;                       // keeps keystream and write order identical between threads
+} SOCKET_CRYPT;
+#endif
+
 typedef struct _SOCKET_INFO {
     uint32_t        connectionid;                   // unique connection id
     int             socket;                         // if no connection, socket = 0
@@ -63,8 +77,8 @@ typedef struct _SOCKET_INFO {
     auth_t          authorisation;                  // current user's function mask for authorisation
 #ifdef WITH_AUTHENTICATION
     dhm_context     *p_dhm;                         // diffie-hellman-merkle information
+    SOCKET_CRYPT    *crypt;                         // key schedules derived from the DHM secret
 #endif
-    unsigned char   *key;                           // encryption key used for this connection
     struct _SOCKET_INFO     *next;                  // pointer to next socket in list
 } SOCKET_INFO;
 
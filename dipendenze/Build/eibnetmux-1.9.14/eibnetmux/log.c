@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <string.h>
+#include <limits.h>
 
 #include "eibnetmux.h"
 #include "include/log.h"
@@ -78,6 +79,7 @@ static char *messages[] = {
     /* msgConfigHashInvalid */      "Password hash on line %d contains invalid characters",
     /* msgConfigDHMRead     */      "Unable to read DHM parameter file '%s': %s",
     /* msgConfigDHM_MPI     */      "Error parsing DHM value in file '%s': %x",
+    /* msgConfigDHMPrecompute */    "Unable to pre-compute DHM tables: %x",
     /* msgConfigSecurity    */      "New security definitions loaded and activated",
     /* msgConfigSecurityError */    "Error in new security definitions - keeping current set",
     /* msgConfigNoAuth      */      "eibnetmux compiled without authentication support - section %s unsupported - line %d skipped",
@@ -146,6 +148,8 @@ static char *messages[] = {
     /* msgEIBDBadCommand    */      "Connection %d: Bad command %s (%04x) received",
     /* msgEIBDBadPacket     */      "Connection %d: Request header too short - %d bytes",
     /* msgEIBDResponse      */      "Connection %d: Response: %s",
+    /* msgEIBDCache         */      "Connection %d: Group cache %s",
+    /* msgEIBDCacheRead     */      "Connection %d: Group cache read %s - %s",
     /* msgTCPNoListener     */      "Unable to start TCP listener: %s",
     /* msgTCPConnection     */      "Unable to accept TCP connection: %s",
     /* msgUnixFileExists    */      "'%s' already exists - unable to create listening socket (%d - %s)",
@@ -220,13 +224,18 @@ void logSetRingLevel( unsigned int level )
 }
 
 
-char *logSetDest( char *dest, int ringsize )
+char *logSetDest( char *dest, int ringsize, char *ringfile )
 {
-    char    ring[20];
+    char    ring[PATH_MAX +20];
     
     if( (appender_standard = zlogAppenderSimple( "eibnetmux", dest )) == NULL ) return( zlogErrorString( zlogErrno ));
     if( ringsize > 0 ) {
-        sprintf( ring, "ring:%d", ringsize );
+        if( ringfile != NULL ) {
+            // ring buffer survives a crash, inspect it after restart
+            snprintf( ring, sizeof( ring ), "ring:%d,%s", ringsize, ringfile );
+        } else {
+            sprintf( ring, "ring:%d", ringsize );
+        }
         appender_ring = zlogAppenderSimple( "eibnetmux_ring", ring );
     }
     return( NULL );
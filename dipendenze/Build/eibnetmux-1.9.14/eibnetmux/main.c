@@ -109,7 +109,7 @@ int main(int argc, char **argv )
     logSetLevel( config.log_level );
     logSetRingLevel( config.ring_level );
     if( config.log_level != 0 ) {
-        if( (errmsg = logSetDest( config.log_dest, config.ring_size )) != NULL ) {
+        if( (errmsg = logSetDest( config.log_dest, config.ring_size, config.ring_file )) != NULL ) {
             fprintf( stderr, "Unable to setup logging - aborting: %s: %s\n", errmsg, config.log_dest );
             exit( -1 );
         }
@@ -176,6 +176,7 @@ int main(int argc, char **argv )
         printf( "    level: %d\n", config.log_level );
         printf( "     ring: %d\n", config.ring_level );
         printf( "     size: %d\n", config.ring_size );
+        printf( "     file: %s\n", (config.ring_file != NULL) ? config.ring_file : "-" );
         printf( "     dest: %s\n", config.log_dest );
         
         printf( "  mode:\n" );
@@ -340,6 +341,11 @@ int main(int argc, char **argv )
     pth_mutex_init( &mtxQueueServer );
     pth_cond_init( &condQueueServer );
     
+    /*
+     * group value cache, shared by all servers
+     */
+    groupCacheInit();
+    
     /*
      * setup thread attributes
      */
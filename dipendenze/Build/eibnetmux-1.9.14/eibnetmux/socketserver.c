@@ -26,10 +26,13 @@
  *   key exchange       K                       request key exchange using Diffie-Hellman-Merkle algorithm
  *   diffie-hellman     Dparam                  receive clients DHM public value (Yc)
  *   authenticate       Auser password          authentication
+ *   encrypt            eiv-in iv-out           encrypt all further traffic on this connection (aes cfb128)
  *   name               aidentifier             set value as the client identifier (usually used as type of client)
  *   version            V                       get API version
  *   read               Raddress                value is read from knx group address and returned
  *   read once          raddress                value is read from knx group address and returned, close connection after returning result
+ *   read cached        Gaddress max-age        value is returned from group value cache if not older than max-age,
+ *                                              otherwise read from knx group address like R
  *   write              Waddress length value   value is sent to knx group address
  *   write once         waddress length value   value is sent to knx group address, close connection after sending
  *   monitor            Maddress-mask           all requests addressed to masked knx group address are forwarded
@@ -55,11 +58,14 @@
  * 
  *   parameters
  *     address                                  knx group address in network byte order
+ *     max-age                                  maximum age of cached value in seconds (16 bit), in network byte order
  *     address-mask                             mask of knx group address with allowable bits set, in network byte order
  *     length                                   number of bytes of value, in network byte order
  *     value                                    byte stream
  *     user                                     username as ASCII string
  *     password                                 user's password as ASCII string
+ *     iv-in / iv-out                           initialisation vectors (16 bytes each) for client->server
+ *                                              and server->client traffic, each aes ecb encrypted with session key
  *     identifier                               connection identifier (ASCII string)
  *     params / param                           DHM parameters (P,G,Ys) for server, (Yc) for client
  *     version                                  API version id
@@ -127,11 +133,11 @@
  * command verbs
  */
 #ifdef WITH_AUTHENTICATION
-#define COMMAND_VERBS   "KDAaVRrWwpMXClLbBcS"
+#define COMMAND_VERBS   "KDAeaVRrGWwpMXClLbBcS"
 #else
-#define COMMAND_VERBS   "aVRrWwpMXClLbBcS"
+#define COMMAND_VERBS   "aVRrGWwpMXClLbBcS"
 #endif
-#define COMMAND_VERBS_STANDARD      "RrWw"
+#define COMMAND_VERBS_STANDARD      "RrGWw"
 
 
 /*
@@ -175,6 +181,8 @@ static void     socketClearConnection( uint8_t socketid );
 static void     terminateConnection( int socketid );
 static int      checkAuthorisation( int socketid, int requestedAuthorisation );
 static int      returnResult( int socketid, uint8_t status, uint16_t code );
+static int      socketWrite( int socketid, void *ptr, int bytes );
+static int      socketRead( int socketid, void *ptr, uint16_t bytes, uint16_t maxbytes, unsigned int timeout );
 static void     serverShutdown( void );
 static char     *SocketServerStatus( void );
 // static int      socketGetUsedIds( uint8_t system, uint32_t **array, uint32_t threshold );
@@ -201,16 +209,19 @@ static void socketClearConnection( uint8_t socketid )
     socketcon[socketid].statsPacketsSent     = 0;
     socketcon[socketid].statsPacketsReceived = 0;
     if( socketcon[socketid].name != NULL ) free( socketcon[socketid].name );
-    if( socketcon[socketid].key  != NULL ) free( socketcon[socketid].key );
 #ifdef WITH_AUTHENTICATION
     if( socketcon[socketid].p_dhm != NULL ) {
         dhm_free( socketcon[socketid].p_dhm );
         free( socketcon[socketid].p_dhm );
     }
+    if( socketcon[socketid].crypt != NULL ) {
+        memset( socketcon[socketid].crypt, 0, sizeof( SOCKET_CRYPT ));
+        free( socketcon[socketid].crypt );
+    }
     socketcon[socketid].p_dhm                = NULL;
+    socketcon[socketid].crypt                = NULL;
 #endif
     socketcon[socketid].name                 = NULL;
-    socketcon[socketid].key                  = NULL;
     socketcon[socketid].user                 = NULL;
 }
 
@@ -299,14 +310,12 @@ static int checkAuthorisation( int socketid, int requestedAuthorisation )
 static int returnResult( int socketid, uint8_t status, uint16_t code )
 {
     SOCKET_RSP_HEAD     rsp_header;
-    int                 sock;
     char                *hdump;
     
     if( socketid >= config.socketclients ) {
         return( -1 );
     }
     
-    sock = socketcon[socketid].socket;
     rsp_header.status = status;
     rsp_header.size   = htons( code );
     hdump = hexdump( THIS_MODULE, &rsp_header, sizeof( rsp_header ));
@@ -317,7 +326,7 @@ static int returnResult( int socketid, uint8_t status, uint16_t code )
     }
     free( hdump );
     // socketcon[socketid].statsPacketsSent++;         // should acknowledgements be counted ?
-    if( pth_write( sock, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header )) {
+    if( socketWrite( socketid, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header )) {
         return( -1 );
     } else {
         return( 0 );
@@ -325,6 +334,70 @@ static int returnResult( int socketid, uint8_t status, uint16_t code )
 }
 
 
+/*
+ * socketWrite
+ * 
+ * send data to socket client
+ * if stream encryption has been enabled, the data is encrypted with the connection's
+ * cached key schedule; the caller's buffer is left untouched as it may be shared
+ * 
+ * socket handler and forwarder may write to the same connection: pth_write can yield,
+ * so encryption and write are done under the connection's write mutex, otherwise
+ * the ciphertext could be sent in a different order than the keystream
+ */
+static int socketWrite( int socketid, void *ptr, int bytes )
+{
+#ifdef WITH_AUTHENTICATION
+    SOCKET_CRYPT        *crypt;
+    unsigned char       local[256];
+    unsigned char       *buf;
+    int                 result;
+    
+    crypt = socketcon[socketid].crypt;
+    if( crypt != NULL && crypt->stream == true ) {
+        buf = (bytes <= sizeof( local )) ? local : allocMemory( THIS_MODULE, bytes );
+        pth_mutex_acquire( &crypt->mtxWrite, FALSE, NULL );
+        aes_crypt_cfb128( &crypt->enc, AES_ENCRYPT, bytes, &crypt->tx_off, crypt->tx_iv, ptr, buf );
+        result = pth_write( socketcon[socketid].socket, buf, bytes );
+        pth_mutex_release( &crypt->mtxWrite );
+        if( buf != local ) free( buf );
+        return( result );
+    }
+#endif
+    return( pth_write( socketcon[socketid].socket, ptr, bytes ));
+}
+
+
+/*
+ * socketRead
+ * 
+ * read data from socket client, decrypting it if stream encryption has been enabled
+ * 
+ * with an encrypted stream, excess bytes cannot be skipped without losing
+ * the cipher state, so requests exceeding maxbytes are rejected
+ */
+static int socketRead( int socketid, void *ptr, uint16_t bytes, uint16_t maxbytes, unsigned int timeout )
+{
+#ifdef WITH_AUTHENTICATION
+    SOCKET_CRYPT        *crypt;
+    
+    crypt = socketcon[socketid].crypt;
+    if( crypt != NULL && crypt->stream == true ) {
+        if( bytes > maxbytes ) {
+            logVerbose( THIS_MODULE, msgSocketBadPacket, socketid );
+            return( -1 );
+        }
+        if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, ptr, bytes, maxbytes, timeout ) != 0 ) {
+            return( -1 );
+        }
+        aes_crypt_cfb128( &crypt->enc, AES_DECRYPT, bytes, &crypt->rx_off, crypt->rx_iv, ptr, ptr );
+        return( 0 );
+    }
+#endif
+    return( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, ptr, bytes, maxbytes, timeout ));
+}
+
+
 /*
  * Shutdown handler
  * - close sockets
@@ -517,6 +590,8 @@ void *SocketHandler( void *arg )
     unsigned char       *buf;
     uint16_t            len;
     uint16_t            maxlen = 1;     // this value is wrong but required to keep the compiler happy
+    uint16_t            maxage;
+    GROUP_CACHE_ENTRY   *cache;
     int                 socketid;
     int                 result;
     uint32_t            connid;
@@ -534,7 +609,7 @@ void *SocketHandler( void *arg )
     int                 iv_off;
     int                 dhm_param_len;
     sSecurityUser       *p_secUser;
-    aes_context         aes;
+    SOCKET_CRYPT        *crypt;
 #endif                    
     
     logDebug( THIS_MODULE, "SocketHandler() started" );
@@ -575,9 +650,9 @@ void *SocketHandler( void *arg )
     socketcon[socketid].response_outstanding = false;
     socketcon[socketid].threadid             = pth_self();
     socketcon[socketid].name                 = NULL;
-    socketcon[socketid].key                  = NULL;
 #ifdef WITH_AUTHENTICATION
     socketcon[socketid].p_dhm                = NULL;
+    socketcon[socketid].crypt                = NULL;
 #endif
     socketcon[socketid].user                 = NULL;
     logVerbose( THIS_MODULE, msgSocketEstablished, socketid );
@@ -586,6 +661,12 @@ void *SocketHandler( void *arg )
     while( true ) {
         // get header of next request
         len = pth_read( sock, &req_header, sizeof( req_header ));
+#ifdef WITH_AUTHENTICATION
+        crypt = socketcon[socketid].crypt;
+        if( crypt != NULL && crypt->stream == true && len > 0 && len <= sizeof( req_header )) {
+            aes_crypt_cfb128( &crypt->enc, AES_DECRYPT, len, &crypt->rx_off, crypt->rx_iv, (unsigned char *)&req_header, (unsigned char *)&req_header );
+        }
+#endif
 
         if( len == 0 ) {
             // end of file means client closed connection - terminate
@@ -646,7 +727,7 @@ void *SocketHandler( void *arg )
             len = ntohs( req_header.address );
             logDebug( THIS_MODULE, "Connection %d: Name length=%d", socketid, len );
             socketcon[socketid].name = allocMemory( THIS_MODULE, min16( len +1, SOCKET_NAME_MAX_LENGTH +1 ));
-            if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, socketcon[socketid].name, len, SOCKET_NAME_MAX_LENGTH, SOCKET_REQ_TIMEOUT ) != 0 ) {
+            if( socketRead( socketid, socketcon[socketid].name, len, SOCKET_NAME_MAX_LENGTH, SOCKET_REQ_TIMEOUT ) != 0 ) {
                 terminateConnection( socketid );        // never returns
             }
             socketcon[socketid].name[min16( len, SOCKET_NAME_MAX_LENGTH )] = '\0';
@@ -670,7 +751,7 @@ void *SocketHandler( void *arg )
             len = ntohs( req_header.address );
             logDebug( THIS_MODULE, "Connection %d: Parameter length=%d", socketid, len );
             buf = allocMemory( THIS_MODULE, len +1 );
-            if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, buf, len, len, SOCKET_REQ_TIMEOUT ) != 0 ) {
+            if( socketRead( socketid, buf, len, len, SOCKET_REQ_TIMEOUT ) != 0 ) {
                 terminateConnection( socketid );        // never returns
             }
             buf[len] = '\0';
@@ -678,19 +759,14 @@ void *SocketHandler( void *arg )
             logDebug( THIS_MODULE, "Connection %d: auth parameters: %s", socketid, hdump );
             free( hdump );
             // decrypt
-            if( socketcon[socketid].key != NULL ) {
+            if( socketcon[socketid].crypt != NULL && len > 16 ) {
                 // format: aes_ecb( iv ), aes_cfb( msg )
-                hdump = hexdump( THIS_MODULE, socketcon[socketid].key, 256 / 8 );
-                logDebug( THIS_MODULE, "Connection %d: key: %s", socketid, hdump );
-                free( hdump );
-                aes_setkey_dec( &aes, socketcon[socketid].key, 256 );
-                aes_crypt_ecb( &aes, AES_DECRYPT, buf, iv );
+                aes_crypt_ecb( &socketcon[socketid].crypt->dec, AES_DECRYPT, buf, iv );
                 hdump = hexdump( THIS_MODULE, iv, 16 );
                 logDebug( THIS_MODULE, "Connection %d: decrypted iv: %s", socketid, hdump );
                 free( hdump );
                 iv_off = 0;
-                aes_setkey_enc( &aes, socketcon[socketid].key, 256 );
-                aes_crypt_cfb128( &aes, AES_ENCRYPT, len -1, &iv_off, iv, buf + 16, buf );
+                aes_crypt_cfb128( &socketcon[socketid].crypt->enc, AES_DECRYPT, len -16, &iv_off, iv, buf + 16, buf );
                 buf[len -16] = '\0';
                 hdump = hexdump( THIS_MODULE, buf, len -16 );
                 logDebug( THIS_MODULE, "Connection %d: decrypted parameters: %s", socketid, hdump );
@@ -730,6 +806,45 @@ void *SocketHandler( void *arg )
             }
             continue;
         }
+        /*
+         * switch connection to encrypted stream
+         * 
+         * format is:
+         *      aes_ecb( iv client->server ), aes_ecb( iv server->client )
+         * 
+         * the acknowledgement is still sent in clear,
+         * everything after it is aes cfb128 encrypted in both directions
+         */
+        if( req_header.cmd == SOCKET_CMD_ENCRYPT ) {
+            logVerbose( THIS_MODULE, msgSocketCommand, socketid, "encrypt", req_header.cmd );
+            len = ntohs( req_header.address );
+            buf = allocMemory( THIS_MODULE, 32 );
+            if( socketRead( socketid, buf, len, 32, SOCKET_REQ_TIMEOUT ) != 0 ) {
+                terminateConnection( socketid );        // never returns
+            }
+            crypt = socketcon[socketid].crypt;
+            if( crypt == NULL || len != 32 ) {
+                free( buf );
+                logError( THIS_MODULE, msgSocketDHMinit, socketid );
+                if( returnResult( socketid, SOCKET_STAT_ERROR, E_DHM ) != 0 ) {
+                    logError( THIS_MODULE, msgSocketSendAborted, socketid, strerror( errno ));
+                    terminateConnection( socketid );        // does not return
+                }
+                continue;
+            }
+            if( returnResult( socketid, SOCKET_STAT_ENCRYPT, 0 ) != 0 ) {
+                free( buf );
+                logError( THIS_MODULE, msgSocketSendAborted, socketid, strerror( errno ));
+                terminateConnection( socketid );        // does not return
+            }
+            aes_crypt_ecb( &crypt->dec, AES_DECRYPT, buf, crypt->rx_iv );
+            aes_crypt_ecb( &crypt->dec, AES_DECRYPT, buf + 16, crypt->tx_iv );
+            crypt->rx_off = 0;
+            crypt->tx_off = 0;
+            crypt->stream = true;
+            free( buf );
+            continue;
+        }
         /*
          * initiate key exchange
          *      send our DHM parameters to client
@@ -749,31 +864,35 @@ void *SocketHandler( void *arg )
             // create DHM parameters
             if( socketcon[socketid].p_dhm == NULL ) {
                 socketcon[socketid].p_dhm = allocMemory( THIS_MODULE, sizeof( dhm_context ));
-                memset( socketcon[socketid].p_dhm, 0, sizeof( dhm_context ));
-                logDebug( THIS_MODULE, "Connection %d: copying DHM prime to thread", socketid );
-                result = mpi_copy( &(socketcon[socketid].p_dhm->P), &(config.dhm->P) );
-                result |= mpi_copy( &(socketcon[socketid].p_dhm->G), &(config.dhm->G) );
-                if( result != 0 ) {
-                    logError( THIS_MODULE, msgSocketDHMFailure, socketid, result, "copy context" );
-                    if( returnResult( socketid, SOCKET_STAT_ERROR, E_DHM ) != 0 ) {
-                        logError( THIS_MODULE, msgSocketSendAborted, socketid, strerror( errno ));
-                        terminateConnection( socketid );        // does not return
-                    }
-                    continue;
+            } else {
+                dhm_free( socketcon[socketid].p_dhm );
+            }
+            memset( socketcon[socketid].p_dhm, 0, sizeof( dhm_context ));
+            logDebug( THIS_MODULE, "Connection %d: copying DHM prime to thread", socketid );
+            // also picks up cached R^2 mod P and the fixed-base table of G
+            result = dhm_copy_params( socketcon[socketid].p_dhm, config.dhm );
+            if( result != 0 ) {
+                logError( THIS_MODULE, msgSocketDHMFailure, socketid, result, "copy context" );
+                if( returnResult( socketid, SOCKET_STAT_ERROR, E_DHM ) != 0 ) {
+                    logError( THIS_MODULE, msgSocketSendAborted, socketid, strerror( errno ));
+                    terminateConnection( socketid );        // does not return
                 }
+                continue;
             }
             buf = allocMemory( THIS_MODULE, 1024 );
             memset( buf, '\0', 1024 );
             logDebug( THIS_MODULE, "Connection %d: create DHM parameters", socketid );
             result = dhm_make_params( socketcon[socketid].p_dhm, 256, buf, &dhm_param_len, havege_rand, polarssl_hs );
+            // fixed-base table is owned by config.dhm which a security reload may release
+            socketcon[socketid].p_dhm->FB = NULL;
             if( result == 0 ) {
                 // send to client
                 len = dhm_param_len;
                 logDebug( THIS_MODULE, "Connection %d: send DHM parameters to client", socketid );
                 rsp_header.status = SOCKET_STAT_KEY;
                 rsp_header.size = htons( len );
-                if( pth_write( socketcon[socketid].socket, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header ) || 
-                    pth_write( socketcon[socketid].socket, buf, len ) != len ) {
+                if( socketWrite( socketid, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header ) || 
+                    socketWrite( socketid, buf, len ) != len ) {
                     logError( THIS_MODULE, msgSocketSendAborted, socketid, strerror( errno ));
                     free( buf );
                     terminateConnection( socketid );        // does not return
@@ -798,7 +917,7 @@ void *SocketHandler( void *arg )
             logVerbose( THIS_MODULE, msgSocketCommand, socketid, "DHM client public value", req_header.cmd );
             len = ntohs( req_header.address );
             buf = allocMemory( THIS_MODULE, min16( len, socketcon[socketid].p_dhm->len ));
-            if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, buf, len, socketcon[socketid].p_dhm->len, SOCKET_REQ_TIMEOUT ) != 0 ) {
+            if( socketRead( socketid, buf, len, socketcon[socketid].p_dhm->len, SOCKET_REQ_TIMEOUT ) != 0 ) {
                 terminateConnection( socketid );        // never returns
             }
             if( socketcon[socketid].p_dhm == NULL ) {
@@ -814,9 +933,19 @@ void *SocketHandler( void *arg )
             if( result == 0 ) {
                 buf = allocMemory( THIS_MODULE, 512 );
                 result = dhm_calc_secret( socketcon[socketid].p_dhm, buf, &dhm_param_len );
-                if( socketcon[socketid].key != NULL ) free( socketcon[socketid].key );
-                socketcon[socketid].key = allocMemory( THIS_MODULE, dhm_param_len );
-                memcpy( socketcon[socketid].key, buf, dhm_param_len );
+                if( result == 0 && (socketcon[socketid].crypt == NULL || socketcon[socketid].crypt->stream == false) ) {
+                    // expand key schedules once, they are used for all further encryption on this connection
+                    // (an encrypted stream keeps its session key)
+                    if( socketcon[socketid].crypt == NULL ) {
+                        socketcon[socketid].crypt = allocMemory( THIS_MODULE, sizeof( SOCKET_CRYPT ));
+                    }
+                    crypt = socketcon[socketid].crypt;
+                    memset( crypt, 0, sizeof( SOCKET_CRYPT ));
+                    pth_mutex_init( &crypt->mtxWrite );
+                    aes_setkey_enc( &crypt->enc, buf, 256 );
+                    aes_setkey_dec( &crypt->dec, buf, 256 );
+                }
+                memset( buf, 0, 512 );
                 free( buf );
             }
             if( result == 0 ) {
@@ -945,7 +1074,7 @@ void *SocketHandler( void *arg )
             }
             continue;
         } else if( req_header.cmd == SOCKET_CMD_MGMT_CLOSE ) {
-            if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, &connid, sizeof( connid ), sizeof( connid ), SOCKET_REQ_TIMEOUT ) != 0 ) {
+            if( socketRead( socketid, &connid, sizeof( connid ), sizeof( connid ), SOCKET_REQ_TIMEOUT ) != 0 ) {
                 terminateConnection( socketid );        // never returns
             }
             if( checkAuthorisation( socketid, authMgmtConnection )) {
@@ -1029,8 +1158,8 @@ void *SocketHandler( void *arg )
                 socketcon[socketid].statsPacketsSent++;
                 statsTotalSent++;
                 len = ntohs( rsp_header.size );
-                if( pth_write( socketcon[socketid].socket, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header ) || 
-                    pth_write( socketcon[socketid].socket, buf, len ) != len ) {
+                if( socketWrite( socketid, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header ) || 
+                    socketWrite( socketid, buf, len ) != len ) {
                         logError( THIS_MODULE, msgSocketSendAborted, socketid, strerror( errno ));
                         close( socketcon[socketid].socket );
                         if( socketcon[socketid].threadid != 0 ) pth_abort( socketcon[socketid].threadid );
@@ -1068,7 +1197,7 @@ void *SocketHandler( void *arg )
                 case SOCKET_CMD_WRITE_ONCE:
                     if( checkAuthorisation( socketid, authWrite )) {
                         logVerbose( THIS_MODULE, msgSocketCommand, socketid, "write", ntohs( req_header.address ));
-                        if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, &len, sizeof( len ), 2, SOCKET_REQ_TIMEOUT ) != 0 ) {
+                        if( socketRead( socketid, &len, sizeof( len ), 2, SOCKET_REQ_TIMEOUT ) != 0 ) {
                             terminateConnection( socketid );        // never returns
                         }
                         len = ntohs( len );
@@ -1086,10 +1215,31 @@ void *SocketHandler( void *arg )
                     break;
                 case SOCKET_CMD_READ:
                 case SOCKET_CMD_READ_ONCE:
+                case SOCKET_CMD_READ_CACHED:
                     if( checkAuthorisation( socketid, authRead )) {
                         logVerbose( THIS_MODULE, msgSocketCommand, socketid, "read", ntohs( req_header.address ));
                         len = 0;
                         socketcon[socketid].knxaddress = req_header.address;
+                        if( req_header.cmd == SOCKET_CMD_READ_CACHED ) {
+                            if( socketRead( socketid, &maxage, sizeof( maxage ), 2, SOCKET_REQ_TIMEOUT ) != 0 ) {
+                                terminateConnection( socketid );        // never returns
+                            }
+                            cache = groupCacheLookup( req_header.address, ntohs( maxage ));
+                            if( cache != NULL ) {
+                                // fresh enough - answer immediately, value starts at apci
+                                logDebug( THIS_MODULE, "Connection %d: Read answered from cache, age %d", socketid, (int)(time( NULL ) - cache->timestamp) );
+                                rsp_header.status = SOCKET_STAT_READ;
+                                rsp_header.size = htons( cache->length -1 );
+                                if( socketWrite( socketid, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header ) ||
+                                    socketWrite( socketid, &cache->apdu[1], cache->length -1 ) != cache->length -1 ) {
+                                    logError( THIS_MODULE, msgSocketSendAborted, socketid, strerror( errno ));
+                                    terminateConnection( socketid );        // does not return
+                                }
+                                socketcon[socketid].statsPacketsSent++;
+                                statsTotalSent++;
+                                continue;
+                            }
+                        }
                     } else {
                         logVerbose( THIS_MODULE, msgSocketUnauthorised, socketid, "read" );
                         if( returnResult( socketid, SOCKET_STAT_ERROR, E_UNAUTHORISED ) != 0 ) {
@@ -1110,7 +1260,7 @@ void *SocketHandler( void *arg )
             buf = allocMemory( THIS_MODULE, sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) + 6 );
             memset( buf, '\0', sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) + 6 );
             if( req_header.cmd == SOCKET_CMD_WRITE || req_header.cmd == SOCKET_CMD_WRITE_ONCE ) {
-                if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, &buf[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + 10] /* start of apci in cemiframe */, len, maxlen, SOCKET_REQ_TIMEOUT ) != 0 ) {
+                if( socketRead( socketid, &buf[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + 10] /* start of apci in cemiframe */, len, maxlen, SOCKET_REQ_TIMEOUT ) != 0 ) {
                     terminateConnection( socketid );        // never returns
                 }
             }
@@ -1129,6 +1279,7 @@ void *SocketHandler( void *arg )
             switch( req_header.cmd ) {
                 case SOCKET_CMD_READ:
                 case SOCKET_CMD_READ_ONCE:
+                case SOCKET_CMD_READ_CACHED:
                     cemiframe->length = 1;
                     cemiframe->tpci |= (A_READ_VALUE_REQ & 0x03); // !!! maybe wrong
                     cemiframe->apci  = (A_READ_VALUE_REQ & 0xff);
@@ -1185,7 +1336,7 @@ void *SocketHandler( void *arg )
                 continue;
             }
             // read operation parameters
-            if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, &passthrough, sizeof( passthrough ), sizeof( passthrough ), SOCKET_REQ_TIMEOUT ) != 0 ) {
+            if( socketRead( socketid, &passthrough, sizeof( passthrough ), sizeof( passthrough ), SOCKET_REQ_TIMEOUT ) != 0 ) {
                 terminateConnection( socketid );        // never returns
             }
             
@@ -1195,10 +1346,11 @@ void *SocketHandler( void *arg )
             // eibnetip header and connection header will be filled in by forwarder thread, just leave enough room
             // CEMI data is read from client (length bytes)
             // memory will be freed by eibnet/ip client when it releases the queued entry
-            buf = allocMemory( THIS_MODULE, sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) + 6 );
-            memset( buf, '\0', sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) + 6 );
+            // frames with more than 15 bytes are sent as extended frames, make room for their data
+            buf = allocMemory( THIS_MODULE, sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) + 6 + passthrough.length );
+            memset( buf, '\0', sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + sizeof( CEMIFRAME ) + 6 + passthrough.length );
             if( passthrough.length > 1 ) {
-                if( readFromSocket( THIS_MODULE, socketcon[socketid].socket, socketid, &buf[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + 11] /* start of data in cemiframe */, passthrough.length -1, passthrough.length -1, SOCKET_REQ_TIMEOUT ) != 0 ) {
+                if( socketRead( socketid, &buf[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER ) + 11] /* start of data in cemiframe */, passthrough.length -1, passthrough.length -1, SOCKET_REQ_TIMEOUT ) != 0 ) {
                     terminateConnection( socketid );        // never returns
                 }
             }
@@ -1207,11 +1359,12 @@ void *SocketHandler( void *arg )
             cemiframe = (CEMIFRAME *) &buf[sizeof( EIBNETIP_HEADER ) + sizeof( EIBNETIP_COMMON_CONNECTION_HEADER )];
             cemiframe->code   = L_DATA_REQ;
             cemiframe->zero   = 0;
-            cemiframe->ctrl   = EIB_CTRL_DATA | EIB_CTRL_LENGTHBYTE | EIB_CTRL_NOREPEAT | EIB_CTRL_NONACK | ((passthrough.priority <<2) & 0x0c);
+            cemiframe->ctrl   = EIB_CTRL_DATA | EIB_CTRL_NOREPEAT | EIB_CTRL_NONACK | ((passthrough.priority <<2) & 0x0c);
+            cemiframe->ctrl  |= (passthrough.length > 15) ? EIB_CTRL_LENGTHTABLE : EIB_CTRL_LENGTHBYTE;
             cemiframe->ntwrk  = EIB_DAF_PHYSICAL | 0X60 /*  EIB_NETWORK_HOPCOUNT */;
             cemiframe->saddr  = /* htons( eibcon[0].knxaddress ) */ 0;
             cemiframe->daddr  = socketcon[socketid].knxaddress;
-            cemiframe->length = passthrough.length & 0x0f;
+            cemiframe->length = passthrough.length;
             cemiframe->tpci   = passthrough.tpci;
             if( passthrough.length > 0 ) {
                 cemiframe->apci = passthrough.apci;
@@ -1312,6 +1465,7 @@ void *SocketFromBusForward( void *arg )
                                     break;
                                 case SOCKET_CMD_READ:
                                 case SOCKET_CMD_READ_ONCE:
+                                case SOCKET_CMD_READ_CACHED:
                                     // check if knx address matches
                                     if( socketcon[loop].response_outstanding == true &&
                                         cemiframe->code == L_DATA_IND &&
@@ -1359,8 +1513,8 @@ void *SocketFromBusForward( void *arg )
                                 hdump = hexdump( THIS_MODULE, ptr, queue->len - offset );
                                 logTraceSocket( THIS_MODULE, msgSocketForward, loop, hdump );
                                 free( hdump );
-                                if( pth_write( socketcon[loop].socket, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header ) || 
-                                    pth_write( socketcon[loop].socket, ptr, queue->len - offset ) != queue->len - offset ) {
+                                if( socketWrite( loop, &rsp_header, sizeof( rsp_header )) != sizeof( rsp_header ) || 
+                                    socketWrite( loop, ptr, queue->len - offset ) != queue->len - offset ) {
                                     logError( THIS_MODULE, msgSocketSendAborted, loop, strerror( errno ));
                                     close( socketcon[loop].socket );
                                     if( socketcon[loop].threadid != 0 ) pth_abort( socketcon[loop].threadid );
@@ -116,6 +116,28 @@ void aes_crypt_cfb128( aes_context *ctx,
                        unsigned char *input,
                        unsigned char *output );
 
+/**
+ * \brief          AES-CTR buffer encryption/decryption.
+ *
+ *                 Encryption and decryption are the same operation;
+ *                 both use the encryption key schedule.
+ *
+ * \param ctx           AES context (set up with aes_setkey_enc)
+ * \param length        length of the input data
+ * \param nc_off        offset in the current stream block (updated after use)
+ * \param nonce_counter 128-bit big endian nonce and counter (updated after use)
+ * \param stream_block  saved key stream block for resuming (updated after use)
+ * \param input         buffer holding the input data
+ * \param output        buffer holding the output data
+ */
+void aes_crypt_ctr( aes_context *ctx,
+                    int length,
+                    int *nc_off,
+                    unsigned char nonce_counter[16],
+                    unsigned char stream_block[16],
+                    unsigned char *input,
+                    unsigned char *output );
+
 /**
  * \brief          Checkup routine
  *
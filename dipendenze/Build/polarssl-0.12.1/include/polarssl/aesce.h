@@ -0,0 +1,85 @@
+/**
+ * \file aesce.h
+ *
+ *  Copyright (C) 2006-2009, Paul Bakker <polarssl_maintainer at polarssl.org>
+ *  All rights reserved.
+ *
+ *  Joined copyright on original XySSL code with: Christophe Devine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef POLARSSL_AESCE_H
+#define POLARSSL_AESCE_H
+
+#include "polarssl/aes.h"
+
+#if defined(POLARSSL_HAVE_ASM) && defined(__GNUC__) &&  \
+    defined(__aarch64__) && defined(__AARCH64EL__) &&   \
+    defined(__linux__) &&                               \
+    ( defined(__clang__) || __GNUC__ >= 6 )
+
+#ifndef POLARSSL_HAVE_AESCE
+#define POLARSSL_HAVE_AESCE
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          ARMv8 Cryptography Extensions detection routine
+ *
+ * \return         1 if CPU supports the AES instructions, 0 otherwise
+ */
+int aesce_supports( void );
+
+/**
+ * \brief          ARMv8-CE AES-ECB block en(de)cryption
+ *
+ * \param ctx      AES context
+ * \param mode     AES_ENCRYPT or AES_DECRYPT
+ * \param input    16-byte input block
+ * \param output   16-byte output block
+ */
+void aesce_crypt_ecb( aes_context *ctx,
+                      int mode,
+                      unsigned char input[16],
+                      unsigned char output[16] );
+
+/**
+ * \brief          ARMv8-CE AES-CBC buffer en(de)cryption
+ *                 (decryption works on four blocks in parallel)
+ *
+ * \param ctx      AES context
+ * \param mode     AES_ENCRYPT or AES_DECRYPT
+ * \param length   length of the input data (multiple of 16)
+ * \param iv       initialization vector (updated after use)
+ * \param input    buffer holding the input data
+ * \param output   buffer holding the output data
+ */
+void aesce_crypt_cbc( aes_context *ctx,
+                      int mode,
+                      int length,
+                      unsigned char iv[16],
+                      unsigned char *input,
+                      unsigned char *output );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAVE_AESCE */
+
+#endif /* aesce.h */
@@ -0,0 +1,124 @@
+/**
+ * \file aesni.h
+ *
+ *  Copyright (C) 2006-2009, Paul Bakker <polarssl_maintainer at polarssl.org>
+ *  All rights reserved.
+ *
+ *  Joined copyright on original XySSL code with: Christophe Devine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef POLARSSL_AESNI_H
+#define POLARSSL_AESNI_H
+
+#include "polarssl/aes.h"
+
+#if defined(POLARSSL_HAVE_ASM) && defined(__GNUC__) &&  \
+    ( defined(__x86_64__) || defined(__i386__) ) &&     \
+    ( defined(__clang__) || __GNUC__ > 4 ||             \
+      ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) )
+
+#ifndef POLARSSL_HAVE_AESNI
+#define POLARSSL_HAVE_AESNI
+#endif
+
+#define AESNI_AES       0x02000000      /* CPUID.1:ECX bit 25 */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          AES-NI detection routine
+ *
+ * \param what     The feature to detect (AESNI_AES)
+ *
+ * \return         1 if CPU has support for the feature, 0 otherwise
+ */
+int aesni_supports( unsigned int what );
+
+/**
+ * \brief          AES-NI AES-ECB block en(de)cryption
+ *
+ * \param ctx      AES context
+ * \param mode     AES_ENCRYPT or AES_DECRYPT
+ * \param input    16-byte input block
+ * \param output   16-byte output block
+ */
+void aesni_crypt_ecb( aes_context *ctx,
+                      int mode,
+                      unsigned char input[16],
+                      unsigned char output[16] );
+
+/**
+ * \brief          AES-NI AES-CBC buffer en(de)cryption
+ *                 (decryption works on four blocks in parallel)
+ *
+ * \param ctx      AES context
+ * \param mode     AES_ENCRYPT or AES_DECRYPT
+ * \param length   length of the input data (multiple of 16)
+ * \param iv       initialization vector (updated after use)
+ * \param input    buffer holding the input data
+ * \param output   buffer holding the output data
+ */
+void aesni_crypt_cbc( aes_context *ctx,
+                      int mode,
+                      int length,
+                      unsigned char iv[16],
+                      unsigned char *input,
+                      unsigned char *output );
+
+/**
+ * \brief          AES-NI AES-CFB128 en(de)cryption of whole blocks,
+ *                 starting at IV offset 0
+ *                 (decryption works on four blocks in parallel)
+ *
+ * \param ctx      AES context (encryption key schedule)
+ * \param mode     AES_ENCRYPT or AES_DECRYPT
+ * \param length   length of the input data (multiple of 16)
+ * \param iv       initialization vector (updated after use)
+ * \param input    buffer holding the input data
+ * \param output   buffer holding the output data
+ */
+void aesni_crypt_cfb128( aes_context *ctx,
+                         int mode,
+                         int length,
+                         unsigned char iv[16],
+                         unsigned char *input,
+                         unsigned char *output );
+
+/**
+ * \brief          AES-NI AES-CTR en(de)cryption of whole blocks,
+ *                 four blocks in parallel
+ *
+ * \param ctx           AES context (encryption key schedule)
+ * \param length        length of the input data (multiple of 16)
+ * \param nonce_counter 128-bit big endian counter (updated after use)
+ * \param input         buffer holding the input data
+ * \param output        buffer holding the output data
+ */
+void aesni_crypt_ctr( aes_context *ctx,
+                      int length,
+                      unsigned char nonce_counter[16],
+                      unsigned char *input,
+                      unsigned char *output );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAVE_AESNI */
+
+#endif /* aesni.h */
@@ -74,6 +74,21 @@ typedef struct
 }
 mpi;
 
+/**
+ * \brief          Fixed-base exponentiation table
+ */
+typedef struct
+{
+    int w;              /*!<  window size in bits       */
+    int n;              /*!<  number of table entries   */
+    t_int mm;           /*!<  Montgomery constant       */
+    mpi A;              /*!<  base                      */
+    mpi N;              /*!<  modulus                   */
+    mpi RR;             /*!<  cached R^2 mod N          */
+    mpi *T;             /*!<  A^(2^(w*i)) * R mod N     */
+}
+mpi_fb;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -460,6 +475,45 @@ int mpi_mod_int( t_int *r, mpi *A, int b );
  */
 int mpi_exp_mod( mpi *X, mpi *A, mpi *E, mpi *N, mpi *_RR );
 
+/**
+ * \brief          Pre-compute a fixed-base table for A^E mod N
+ *
+ * \param F        Table to initialize
+ * \param A        Base MPI
+ * \param N        Modular MPI
+ * \param nbits    Largest exponent size (in bits) to cover
+ *
+ * \return         0 if successful,
+ *                 1 if memory allocation failed,
+ *                 POLARSSL_ERR_MPI_BAD_INPUT_DATA if N is negative or even
+ *
+ * \note           The table holds about nbits / 6 residues of size(N),
+ *                 so it only pays off when A and N are reused for many
+ *                 exponentiations (eg. the DHM generator).
+ */
+int mpi_fb_init( mpi_fb *F, mpi *A, mpi *N, int nbits );
+
+/**
+ * \brief          Fixed-base exponentiation: X = A^E mod N
+ *
+ * \param X        Destination MPI
+ * \param E        Exponent MPI
+ * \param F        Table pre-computed with mpi_fb_init()
+ *
+ * \return         0 if successful,
+ *                 1 if memory allocation failed,
+ *                 POLARSSL_ERR_MPI_BAD_INPUT_DATA if E is negative
+ *
+ * \note           Exponents larger than the table fall back to
+ *                 mpi_exp_mod().
+ */
+int mpi_exp_mod_fb( mpi *X, mpi *E, mpi_fb *F );
+
+/**
+ * \brief          Free a fixed-base table
+ */
+void mpi_fb_free( mpi_fb *F );
+
 /**
  * \brief          Greatest common divisor: G = gcd(A, B)
  *
@@ -57,6 +57,10 @@
  * Used in:
  *      library/timing.c
  *      library/padlock.c
+ *      library/aesni.c
+ *      library/aesce.c
+ *      library/sha2ni.c
+ *      library/bignum.c
  *      include/polarssl/bn_mul.h
  *
  */
@@ -100,6 +104,24 @@
  */
 #define POLARSSL_AES_C
 
+/*
+ * Module:  library/aesce.c
+ * Caller:  library/aes.c
+ *
+ * This module adds support for the AES instructions of the
+ * ARMv8 Cryptography Extensions (AArch64 Linux), detected at runtime.
+ */
+#define POLARSSL_AESCE_C
+
+/*
+ * Module:  library/aesni.c
+ * Caller:  library/aes.c
+ *
+ * This module adds support for the AES-NI instructions on x86,
+ * detected at runtime.
+ */
+#define POLARSSL_AESNI_C
+
 /*
  * Module:  library/arc4.c
  * Caller:  library/ssl_tls.c
@@ -261,6 +283,15 @@
  */
 #define POLARSSL_SHA2_C
 
+/*
+ * Module:  library/sha2ni.c
+ * Caller:  library/sha2.c
+ *
+ * This module adds support for the SHA extensions and for AVX2
+ * multi-buffer SHA-256 on x86, detected at runtime.
+ */
+#define POLARSSL_SHA2NI_C
+
 /*
  * Module:  library/sha4.c
  * Caller:
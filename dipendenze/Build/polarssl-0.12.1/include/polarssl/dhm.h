@@ -42,6 +42,8 @@ typedef struct
     mpi GY;     /*!<  peer = G^Y mod P  */
     mpi K;      /*!<  key = GY^X mod P  */
     mpi RP;     /*!<  cached R^2 mod P  */
+    mpi_fb *FB; /*!<  fixed-base G table */
+    int FB_shared;  /*!<  FB is borrowed */
 }
 dhm_context;
 
@@ -122,6 +124,33 @@ int dhm_make_public( dhm_context *ctx, int s_size,
 int dhm_calc_secret( dhm_context *ctx,
                      unsigned char *output, int *olen );
 
+/**
+ * \brief          Pre-compute a fixed-base table for G and cache
+ *                 R^2 mod P, so that generating G^X only costs
+ *                 multiplications
+ *
+ * \param ctx      DHM context, with P and G already set
+ *
+ * \return         0 if successful, or an POLARSSL_ERR_DHM_XXX error code
+ *
+ * \note           The table is owned by ctx and released by dhm_free().
+ */
+int dhm_precompute( dhm_context *ctx );
+
+/**
+ * \brief          Set up a context with the group parameters of src
+ *
+ * \param ctx      DHM context to set up
+ * \param src      DHM context holding P and G
+ *
+ * \return         0 if successful, or an POLARSSL_ERR_DHM_XXX error code
+ *
+ * \note           P, G and the cached R^2 mod P are copied; the
+ *                 fixed-base table of src (if any) is shared, so
+ *                 src must outlive ctx.
+ */
+int dhm_copy_params( dhm_context *ctx, dhm_context *src );
+
 /*
  * \brief          Free the components of a DHM key
  */
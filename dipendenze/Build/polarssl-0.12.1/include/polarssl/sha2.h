@@ -78,6 +78,21 @@ void sha2_finish( sha2_context *ctx, unsigned char output[32] );
 void sha2( unsigned char *input, int ilen,
            unsigned char output[32], int is224 );
 
+/**
+ * \brief          Output[i] = SHA-256( input[i] ) for several buffers
+ *
+ * \param input    buffers holding the data
+ * \param ilen     lengths of the input data
+ * \param output   SHA-224/256 checksum results
+ * \param count    number of buffers
+ * \param is224    0 = use SHA256, 1 = use SHA224
+ *
+ * \note           With AVX2 eight buffers are hashed in parallel, which
+ *                 pays off for many short inputs (eg. password checks).
+ */
+void sha2_multi( unsigned char *input[], int ilen[],
+                 unsigned char *output[], int count, int is224 );
+
 /**
  * \brief          Output = SHA-256( file contents )
  *
@@ -0,0 +1,92 @@
+/**
+ * \file sha2ni.h
+ *
+ *  Copyright (C) 2006-2009, Paul Bakker <polarssl_maintainer at polarssl.org>
+ *  All rights reserved.
+ *
+ *  Joined copyright on original XySSL code with: Christophe Devine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef POLARSSL_SHA2NI_H
+#define POLARSSL_SHA2NI_H
+
+#include "polarssl/config.h"
+
+#if defined(POLARSSL_HAVE_ASM) && defined(__GNUC__) &&  \
+    ( defined(__x86_64__) || defined(__i386__) ) &&     \
+    ( defined(__clang__) || __GNUC__ > 4 ||             \
+      ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) )
+
+#ifndef POLARSSL_HAVE_SHA2NI
+#define POLARSSL_HAVE_SHA2NI
+#endif
+
+#define SHA2NI_SHA      0x01    /* SHA extensions, CPUID.7:EBX bit 29 */
+#define SHA2NI_AVX2     0x02    /* AVX2, CPUID.7:EBX bit 5 + YMM state */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          SHA-NI / AVX2 detection routine
+ *
+ * \param what     The feature to detect (SHA2NI_SHA or SHA2NI_AVX2)
+ *
+ * \return         1 if the feature is available and selected,
+ *                 0 otherwise
+ */
+int sha2ni_supports( unsigned int what );
+
+/**
+ * \brief          Restrict the backends sha2.c dispatches to
+ *
+ * \param what     mask of SHA2NI_SHA and SHA2NI_AVX2 (0 = C only)
+ *
+ * \note           Meant for benchmarks and tests; features the CPU
+ *                 lacks stay disabled whatever the mask.
+ */
+void sha2ni_select( unsigned int what );
+
+/**
+ * \brief          SHA-256 compression of consecutive blocks
+ *                 using the SHA extensions
+ *
+ * \param state    intermediate digest state (updated)
+ * \param data     buffer holding the blocks
+ * \param blocks   number of 64-byte blocks
+ */
+void sha2ni_process( unsigned long state[8],
+                     unsigned char *data,
+                     int blocks );
+
+/**
+ * \brief          SHA-256 compression of one block in each of
+ *                 eight independent messages (AVX2, one per lane)
+ *
+ * \param state    intermediate digest states (updated)
+ * \param data     one 64-byte block per message
+ */
+void sha2ni_process_x8( unsigned long state[8][8],
+                        unsigned char *data[8] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAVE_SHA2NI */
+
+#endif /* sha2ni.h */
@@ -33,6 +33,8 @@
 
 #include "polarssl/aes.h"
 #include "polarssl/padlock.h"
+#include "polarssl/aesni.h"
+#include "polarssl/aesce.h"
 
 #include <string.h>
 
@@ -655,6 +657,22 @@ void aes_crypt_ecb( aes_context *ctx,
     int i;
     unsigned long *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
+#if defined(POLARSSL_AESNI_C) && defined(POLARSSL_HAVE_AESNI)
+    if( aesni_supports( AESNI_AES ) )
+    {
+        aesni_crypt_ecb( ctx, mode, input, output );
+        return;
+    }
+#endif
+
+#if defined(POLARSSL_AESCE_C) && defined(POLARSSL_HAVE_AESCE)
+    if( aesce_supports() )
+    {
+        aesce_crypt_ecb( ctx, mode, input, output );
+        return;
+    }
+#endif
+
 #if defined(POLARSSL_PADLOCK_C) && defined(POLARSSL_HAVE_X86)
     if( padlock_supports( PADLOCK_ACE ) )
     {
@@ -758,6 +776,22 @@ void aes_crypt_cbc( aes_context *ctx,
     int i;
     unsigned char temp[16];
 
+#if defined(POLARSSL_AESNI_C) && defined(POLARSSL_HAVE_AESNI)
+    if( aesni_supports( AESNI_AES ) )
+    {
+        aesni_crypt_cbc( ctx, mode, length, iv, input, output );
+        return;
+    }
+#endif
+
+#if defined(POLARSSL_AESCE_C) && defined(POLARSSL_HAVE_AESCE)
+    if( aesce_supports() )
+    {
+        aesce_crypt_cbc( ctx, mode, length, iv, input, output );
+        return;
+    }
+#endif
+
 #if defined(POLARSSL_PADLOCK_C) && defined(POLARSSL_HAVE_X86)
     if( padlock_supports( PADLOCK_ACE ) )
     {
@@ -813,6 +847,18 @@ void aes_crypt_cfb128( aes_context *ctx,
 {
     int c, n = *iv_off;
 
+#if defined(POLARSSL_AESNI_C) && defined(POLARSSL_HAVE_AESNI)
+    if( n == 0 && length >= 16 && aesni_supports( AESNI_AES ) )
+    {
+        c = length & ~15;
+        aesni_crypt_cfb128( ctx, mode, c, iv, input, output );
+
+        input  += c;
+        output += c;
+        length -= c;
+    }
+#endif
+
     if( mode == AES_DECRYPT )
     {
         while( length-- )
@@ -843,6 +889,51 @@ void aes_crypt_cfb128( aes_context *ctx,
     *iv_off = n;
 }
 
+/*
+ * AES-CTR buffer encryption/decryption
+ */
+void aes_crypt_ctr( aes_context *ctx,
+                    int length,
+                    int *nc_off,
+                    unsigned char nonce_counter[16],
+                    unsigned char stream_block[16],
+                    unsigned char *input,
+                    unsigned char *output )
+{
+    int c, i, n = *nc_off;
+
+#if defined(POLARSSL_AESNI_C) && defined(POLARSSL_HAVE_AESNI)
+    if( n == 0 && length >= 16 && aesni_supports( AESNI_AES ) )
+    {
+        c = length & ~15;
+        aesni_crypt_ctr( ctx, c, nonce_counter, input, output );
+
+        input  += c;
+        output += c;
+        length -= c;
+    }
+#endif
+
+    while( length-- )
+    {
+        if( n == 0 )
+        {
+            aes_crypt_ecb( ctx, AES_ENCRYPT, nonce_counter, stream_block );
+
+            for( i = 16; i > 0; i-- )
+                if( ++nonce_counter[i - 1] != 0 )
+                    break;
+        }
+
+        c = *input++;
+        *output++ = (unsigned char)( c ^ stream_block[n] );
+
+        n = (n + 1) & 0x0F;
+    }
+
+    *nc_off = n;
+}
+
 #if defined(POLARSSL_SELF_TEST)
 
 #include <stdio.h>
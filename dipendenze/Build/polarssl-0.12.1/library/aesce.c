@@ -0,0 +1,212 @@
+/*
+ *  ARMv8 Cryptography Extensions AES support functions
+ *
+ *  Copyright (C) 2006-2009, Paul Bakker <polarssl_maintainer at polarssl.org>
+ *  All rights reserved.
+ *
+ *  Joined copyright on original XySSL code with: Christophe Devine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*
+ *  This implementation is based on the ARM Architecture Reference Manual
+ *  ARMv8, section "Advanced SIMD and floating-point cryptography".
+ *
+ *  AESE/AESD include the AddRoundKey step before SubBytes/ShiftRows,
+ *  so the last round key is added separately. As with AES-NI, the
+ *  decryption schedule from aes_setkey_dec() is used unchanged.
+ */
+
+#include "polarssl/config.h"
+
+#if defined(POLARSSL_AESCE_C)
+
+#include "polarssl/aes.h"
+#include "polarssl/aesce.h"
+
+#if defined(POLARSSL_HAVE_AESCE)
+
+#include <string.h>
+#include <sys/auxv.h>
+
+#if !defined(__ARM_FEATURE_CRYPTO) && !defined(__ARM_FEATURE_AES)
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("crypto"))), apply_to = function)
+#define AESCE_POP_TARGET
+#else
+#pragma GCC push_options
+#pragma GCC target ("arch=armv8-a+crypto")
+#define AESCE_POP_TARGET
+#endif
+#endif
+
+#include <arm_neon.h>
+
+#ifndef HWCAP_AES
+#define HWCAP_AES       (1 << 3)
+#endif
+
+/*
+ * ARMv8-CE detection routine
+ */
+int aesce_supports( void )
+{
+    static int flags = -1;
+
+    if( flags == -1 )
+        flags = ( getauxval( AT_HWCAP ) & HWCAP_AES ) != 0;
+
+    return( flags );
+}
+
+/*
+ * Load the round keys (stored as 64-bit unsigned longs)
+ */
+static void aesce_load_rk( aes_context *ctx, uint8x16_t rk[15] )
+{
+    int i;
+    uint32_t w[4];
+    unsigned long *RK = ctx->rk;
+
+    for( i = 0; i <= ctx->nr; i++, RK += 4 )
+    {
+        w[0] = (uint32_t) RK[0]; w[1] = (uint32_t) RK[1];
+        w[2] = (uint32_t) RK[2]; w[3] = (uint32_t) RK[3];
+        rk[i] = vreinterpretq_u8_u32( vld1q_u32( w ) );
+    }
+}
+
+static uint8x16_t aesce_enc( uint8x16_t rk[15], int nr, uint8x16_t b )
+{
+    int i;
+
+    for( i = 0; i < nr - 1; i++ )
+        b = vaesmcq_u8( vaeseq_u8( b, rk[i] ) );
+
+    b = vaeseq_u8( b, rk[nr - 1] );
+
+    return( veorq_u8( b, rk[nr] ) );
+}
+
+static uint8x16_t aesce_dec( uint8x16_t rk[15], int nr, uint8x16_t b )
+{
+    int i;
+
+    for( i = 0; i < nr - 1; i++ )
+        b = vaesimcq_u8( vaesdq_u8( b, rk[i] ) );
+
+    b = vaesdq_u8( b, rk[nr - 1] );
+
+    return( veorq_u8( b, rk[nr] ) );
+}
+
+/*
+ * ARMv8-CE AES-ECB block en(de)cryption
+ */
+void aesce_crypt_ecb( aes_context *ctx,
+                      int mode,
+                      unsigned char input[16],
+                      unsigned char output[16] )
+{
+    uint8x16_t rk[15];
+    uint8x16_t b;
+
+    aesce_load_rk( ctx, rk );
+    b = vld1q_u8( input );
+
+    if( mode == AES_DECRYPT )
+        b = aesce_dec( rk, ctx->nr, b );
+    else
+        b = aesce_enc( rk, ctx->nr, b );
+
+    vst1q_u8( output, b );
+}
+
+/*
+ * ARMv8-CE AES-CBC buffer en(de)cryption
+ */
+void aesce_crypt_cbc( aes_context *ctx,
+                      int mode,
+                      int length,
+                      unsigned char iv[16],
+                      unsigned char *input,
+                      unsigned char *output )
+{
+    int i, nr = ctx->nr;
+    uint8x16_t rk[15];
+    uint8x16_t v, b0, b1, b2, b3, c0, c1, c2, c3;
+
+    aesce_load_rk( ctx, rk );
+    v = vld1q_u8( iv );
+
+    if( mode == AES_DECRYPT )
+    {
+        for( ; length >= 64; length -= 64, input += 64, output += 64 )
+        {
+            b0 = c0 = vld1q_u8( input );
+            b1 = c1 = vld1q_u8( input + 16 );
+            b2 = c2 = vld1q_u8( input + 32 );
+            b3 = c3 = vld1q_u8( input + 48 );
+
+            for( i = 0; i < nr - 1; i++ )
+            {
+                b0 = vaesimcq_u8( vaesdq_u8( b0, rk[i] ) );
+                b1 = vaesimcq_u8( vaesdq_u8( b1, rk[i] ) );
+                b2 = vaesimcq_u8( vaesdq_u8( b2, rk[i] ) );
+                b3 = vaesimcq_u8( vaesdq_u8( b3, rk[i] ) );
+            }
+
+            b0 = veorq_u8( vaesdq_u8( b0, rk[nr - 1] ), rk[nr] );
+            b1 = veorq_u8( vaesdq_u8( b1, rk[nr - 1] ), rk[nr] );
+            b2 = veorq_u8( vaesdq_u8( b2, rk[nr - 1] ), rk[nr] );
+            b3 = veorq_u8( vaesdq_u8( b3, rk[nr - 1] ), rk[nr] );
+
+            vst1q_u8( output,      veorq_u8( b0, v  ) );
+            vst1q_u8( output + 16, veorq_u8( b1, c0 ) );
+            vst1q_u8( output + 32, veorq_u8( b2, c1 ) );
+            vst1q_u8( output + 48, veorq_u8( b3, c2 ) );
+            v = c3;
+        }
+
+        for( ; length > 0; length -= 16, input += 16, output += 16 )
+        {
+            c0 = vld1q_u8( input );
+            vst1q_u8( output, veorq_u8( aesce_dec( rk, nr, c0 ), v ) );
+            v = c0;
+        }
+    }
+    else
+    {
+        for( ; length > 0; length -= 16, input += 16, output += 16 )
+        {
+            v = aesce_enc( rk, nr, veorq_u8( v, vld1q_u8( input ) ) );
+            vst1q_u8( output, v );
+        }
+    }
+
+    vst1q_u8( iv, v );
+}
+
+#if defined(AESCE_POP_TARGET)
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
+
+#endif /* POLARSSL_HAVE_AESCE */
+
+#endif /* POLARSSL_AESCE_C */
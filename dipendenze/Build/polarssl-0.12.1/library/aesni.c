@@ -0,0 +1,331 @@
+/*
+ *  AES-NI support functions
+ *
+ *  Copyright (C) 2006-2009, Paul Bakker <polarssl_maintainer at polarssl.org>
+ *  All rights reserved.
+ *
+ *  Joined copyright on original XySSL code with: Christophe Devine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*
+ *  This implementation is based on the Intel Advanced Encryption Standard
+ *  (AES) New Instructions Set white paper (document 323641).
+ *
+ *  The round keys are taken unchanged from the context set up by
+ *  aes_setkey_enc() / aes_setkey_dec(); the decryption schedule already
+ *  is in the "equivalent inverse cipher" form expected by AESDEC.
+ *  As no lookup tables are used, timing does not depend on key or data.
+ */
+
+#include "polarssl/config.h"
+
+#if defined(POLARSSL_AESNI_C)
+
+#include "polarssl/aes.h"
+#include "polarssl/aesni.h"
+
+#if defined(POLARSSL_HAVE_AESNI)
+
+#include <string.h>
+#include <cpuid.h>
+#include <wmmintrin.h>
+
+#define AESNI_TARGET    __attribute__((target("aes,sse2")))
+
+/*
+ * AES-NI detection routine
+ */
+int aesni_supports( unsigned int what )
+{
+    static int done = 0;
+    static unsigned int flags = 0;
+    unsigned int eax, ebx, ecx, edx;
+
+    if( done == 0 )
+    {
+        if( __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+            flags = ecx;
+
+        done = 1;
+    }
+
+    return( ( flags & what ) != 0 );
+}
+
+/*
+ * Load the round keys (stored as unsigned longs, which may be 64 bits wide)
+ */
+AESNI_TARGET
+static void aesni_load_rk( aes_context *ctx, __m128i rk[15] )
+{
+    int i;
+    unsigned long *RK = ctx->rk;
+
+    for( i = 0; i <= ctx->nr; i++, RK += 4 )
+        rk[i] = _mm_set_epi32( (int) RK[3], (int) RK[2],
+                               (int) RK[1], (int) RK[0] );
+}
+
+AESNI_TARGET
+static __m128i aesni_enc( __m128i rk[15], int nr, __m128i b )
+{
+    int i;
+
+    b = _mm_xor_si128( b, rk[0] );
+    for( i = 1; i < nr; i++ )
+        b = _mm_aesenc_si128( b, rk[i] );
+
+    return( _mm_aesenclast_si128( b, rk[nr] ) );
+}
+
+AESNI_TARGET
+static __m128i aesni_dec( __m128i rk[15], int nr, __m128i b )
+{
+    int i;
+
+    b = _mm_xor_si128( b, rk[0] );
+    for( i = 1; i < nr; i++ )
+        b = _mm_aesdec_si128( b, rk[i] );
+
+    return( _mm_aesdeclast_si128( b, rk[nr] ) );
+}
+
+/*
+ * Four independent blocks per round keep the AES unit's pipeline busy
+ */
+#define AESNI_ROUND4(OP,K)                  \
+{                                           \
+    b0 = OP( b0, K ); b1 = OP( b1, K );     \
+    b2 = OP( b2, K ); b3 = OP( b3, K );     \
+}
+
+#define AESNI_CRYPT4(OP,OPLAST)                                 \
+{                                                               \
+    AESNI_ROUND4( _mm_xor_si128, rk[0] );                       \
+    for( i = 1; i < nr; i++ )                                   \
+        AESNI_ROUND4( OP, rk[i] );                              \
+    AESNI_ROUND4( OPLAST, rk[nr] );                             \
+}
+
+/*
+ * AES-NI AES-ECB block en(de)cryption
+ */
+AESNI_TARGET
+void aesni_crypt_ecb( aes_context *ctx,
+                      int mode,
+                      unsigned char input[16],
+                      unsigned char output[16] )
+{
+    __m128i rk[15];
+    __m128i b;
+
+    aesni_load_rk( ctx, rk );
+    b = _mm_loadu_si128( (__m128i *) input );
+
+    if( mode == AES_DECRYPT )
+        b = aesni_dec( rk, ctx->nr, b );
+    else
+        b = aesni_enc( rk, ctx->nr, b );
+
+    _mm_storeu_si128( (__m128i *) output, b );
+}
+
+/*
+ * AES-NI AES-CBC buffer en(de)cryption
+ */
+AESNI_TARGET
+void aesni_crypt_cbc( aes_context *ctx,
+                      int mode,
+                      int length,
+                      unsigned char iv[16],
+                      unsigned char *input,
+                      unsigned char *output )
+{
+    int i, nr = ctx->nr;
+    __m128i rk[15];
+    __m128i v, b0, b1, b2, b3, c0, c1, c2, c3;
+
+    aesni_load_rk( ctx, rk );
+    v = _mm_loadu_si128( (__m128i *) iv );
+
+    if( mode == AES_DECRYPT )
+    {
+        for( ; length >= 64; length -= 64, input += 64, output += 64 )
+        {
+            b0 = c0 = _mm_loadu_si128( (__m128i *) input );
+            b1 = c1 = _mm_loadu_si128( (__m128i *) ( input + 16 ) );
+            b2 = c2 = _mm_loadu_si128( (__m128i *) ( input + 32 ) );
+            b3 = c3 = _mm_loadu_si128( (__m128i *) ( input + 48 ) );
+
+            AESNI_CRYPT4( _mm_aesdec_si128, _mm_aesdeclast_si128 );
+
+            _mm_storeu_si128( (__m128i *) output,
+                              _mm_xor_si128( b0, v  ) );
+            _mm_storeu_si128( (__m128i *) ( output + 16 ),
+                              _mm_xor_si128( b1, c0 ) );
+            _mm_storeu_si128( (__m128i *) ( output + 32 ),
+                              _mm_xor_si128( b2, c1 ) );
+            _mm_storeu_si128( (__m128i *) ( output + 48 ),
+                              _mm_xor_si128( b3, c2 ) );
+            v = c3;
+        }
+
+        for( ; length > 0; length -= 16, input += 16, output += 16 )
+        {
+            c0 = _mm_loadu_si128( (__m128i *) input );
+            b0 = aesni_dec( rk, nr, c0 );
+            _mm_storeu_si128( (__m128i *) output, _mm_xor_si128( b0, v ) );
+            v = c0;
+        }
+    }
+    else
+    {
+        for( ; length > 0; length -= 16, input += 16, output += 16 )
+        {
+            b0 = _mm_xor_si128( v, _mm_loadu_si128( (__m128i *) input ) );
+            v = aesni_enc( rk, nr, b0 );
+            _mm_storeu_si128( (__m128i *) output, v );
+        }
+    }
+
+    _mm_storeu_si128( (__m128i *) iv, v );
+}
+
+/*
+ * AES-NI AES-CFB128 en(de)cryption of whole blocks
+ */
+AESNI_TARGET
+void aesni_crypt_cfb128( aes_context *ctx,
+                         int mode,
+                         int length,
+                         unsigned char iv[16],
+                         unsigned char *input,
+                         unsigned char *output )
+{
+    int i, nr = ctx->nr;
+    __m128i rk[15];
+    __m128i v, b0, b1, b2, b3, c0, c1, c2, c3;
+
+    aesni_load_rk( ctx, rk );
+    v = _mm_loadu_si128( (__m128i *) iv );
+
+    if( mode == AES_DECRYPT )
+    {
+        for( ; length >= 64; length -= 64, input += 64, output += 64 )
+        {
+            b0 = v;
+            b1 = c0 = _mm_loadu_si128( (__m128i *) input );
+            b2 = c1 = _mm_loadu_si128( (__m128i *) ( input + 16 ) );
+            b3 = c2 = _mm_loadu_si128( (__m128i *) ( input + 32 ) );
+            c3 = _mm_loadu_si128( (__m128i *) ( input + 48 ) );
+
+            AESNI_CRYPT4( _mm_aesenc_si128, _mm_aesenclast_si128 );
+
+            _mm_storeu_si128( (__m128i *) output,
+                              _mm_xor_si128( b0, c0 ) );
+            _mm_storeu_si128( (__m128i *) ( output + 16 ),
+                              _mm_xor_si128( b1, c1 ) );
+            _mm_storeu_si128( (__m128i *) ( output + 32 ),
+                              _mm_xor_si128( b2, c2 ) );
+            _mm_storeu_si128( (__m128i *) ( output + 48 ),
+                              _mm_xor_si128( b3, c3 ) );
+            v = c3;
+        }
+
+        for( ; length > 0; length -= 16, input += 16, output += 16 )
+        {
+            c0 = _mm_loadu_si128( (__m128i *) input );
+            b0 = aesni_enc( rk, nr, v );
+            _mm_storeu_si128( (__m128i *) output, _mm_xor_si128( b0, c0 ) );
+            v = c0;
+        }
+    }
+    else
+    {
+        for( ; length > 0; length -= 16, input += 16, output += 16 )
+        {
+            b0 = aesni_enc( rk, nr, v );
+            v = _mm_xor_si128( b0, _mm_loadu_si128( (__m128i *) input ) );
+            _mm_storeu_si128( (__m128i *) output, v );
+        }
+    }
+
+    _mm_storeu_si128( (__m128i *) iv, v );
+}
+
+/*
+ * Increment the 128-bit big endian counter
+ */
+static void aesni_ctr_inc( unsigned char nonce_counter[16] )
+{
+    int i;
+
+    for( i = 16; i > 0; i-- )
+        if( ++nonce_counter[i - 1] != 0 )
+            break;
+}
+
+/*
+ * AES-NI AES-CTR en(de)cryption of whole blocks
+ */
+AESNI_TARGET
+void aesni_crypt_ctr( aes_context *ctx,
+                      int length,
+                      unsigned char nonce_counter[16],
+                      unsigned char *input,
+                      unsigned char *output )
+{
+    int i, nr = ctx->nr;
+    __m128i rk[15];
+    __m128i b0, b1, b2, b3;
+
+    aesni_load_rk( ctx, rk );
+
+    for( ; length >= 64; length -= 64, input += 64, output += 64 )
+    {
+        b0 = _mm_loadu_si128( (__m128i *) nonce_counter );
+        aesni_ctr_inc( nonce_counter );
+        b1 = _mm_loadu_si128( (__m128i *) nonce_counter );
+        aesni_ctr_inc( nonce_counter );
+        b2 = _mm_loadu_si128( (__m128i *) nonce_counter );
+        aesni_ctr_inc( nonce_counter );
+        b3 = _mm_loadu_si128( (__m128i *) nonce_counter );
+        aesni_ctr_inc( nonce_counter );
+
+        AESNI_CRYPT4( _mm_aesenc_si128, _mm_aesenclast_si128 );
+
+        _mm_storeu_si128( (__m128i *) output, _mm_xor_si128( b0,
+                          _mm_loadu_si128( (__m128i *) input ) ) );
+        _mm_storeu_si128( (__m128i *) ( output + 16 ), _mm_xor_si128( b1,
+                          _mm_loadu_si128( (__m128i *) ( input + 16 ) ) ) );
+        _mm_storeu_si128( (__m128i *) ( output + 32 ), _mm_xor_si128( b2,
+                          _mm_loadu_si128( (__m128i *) ( input + 32 ) ) ) );
+        _mm_storeu_si128( (__m128i *) ( output + 48 ), _mm_xor_si128( b3,
+                          _mm_loadu_si128( (__m128i *) ( input + 48 ) ) ) );
+    }
+
+    for( ; length > 0; length -= 16, input += 16, output += 16 )
+    {
+        b0 = aesni_enc( rk, nr, _mm_loadu_si128( (__m128i *) nonce_counter ) );
+        aesni_ctr_inc( nonce_counter );
+        _mm_storeu_si128( (__m128i *) output, _mm_xor_si128( b0,
+                          _mm_loadu_si128( (__m128i *) input ) ) );
+    }
+}
+
+#endif /* POLARSSL_HAVE_AESNI */
+
+#endif /* POLARSSL_AESNI_C */
@@ -881,6 +881,69 @@ int mpi_sub_int( mpi *X, mpi *A, int b )
     return( mpi_sub_mpi( X, A, &_B ) );
 }
 
+#if defined(POLARSSL_HAVE_ASM) && defined(__GNUC__) && \
+    ( defined(__amd64__) || defined(__x86_64__) )
+
+#include <cpuid.h>
+
+#define MULADDC_MULX_ADX
+
+/*
+ * -1 = not checked yet, 0 = missing, 1 = BMI2 and ADX available
+ */
+static int mpi_adx_state = -1;
+
+static int mpi_adx_check( void )
+{
+    unsigned int a, b, c, d;
+
+    mpi_adx_state = 0;
+
+    if( __get_cpuid_max( 0, NULL ) >= 7 )
+    {
+        __cpuid_count( 7, 0, a, b, c, d );
+
+        if( ( b & ( 1 << 8 ) ) != 0 && ( b & ( 1 << 19 ) ) != 0 )
+            mpi_adx_state = 1;
+    }
+
+    return( mpi_adx_state );
+}
+
+/*
+ * d[0..7] += s[0..7] * b + c, returns the carry.
+ *
+ * mulx leaves the flags alone, so the high words ride on the
+ * adcx (CF) chain while the destination words ride on the adox
+ * (OF) chain, without reloading the carry between limbs.
+ */
+#define MULX_ADX_STEP(k)                            \
+        "mulxq  " #k "*8(%2), %%r8, %%r9     \n\t"   \
+        "adcxq  %0, %%r8                    \n\t"   \
+        "adoxq  " #k "*8(%1), %%r8           \n\t"   \
+        "movq   %%r8, " #k "*8(%1)           \n\t"   \
+        "movq   %%r9, %0                    \n\t"
+
+static t_int mpi_mul_hlp_adx8( t_int *s, t_int *d, t_int b, t_int c )
+{
+    asm volatile(
+        "xorl   %%r8d, %%r8d                \n\t"
+        MULX_ADX_STEP(0) MULX_ADX_STEP(1)
+        MULX_ADX_STEP(2) MULX_ADX_STEP(3)
+        MULX_ADX_STEP(4) MULX_ADX_STEP(5)
+        MULX_ADX_STEP(6) MULX_ADX_STEP(7)
+        "movl   $0, %%r8d                   \n\t"
+        "adcxq  %%r8, %0                    \n\t"
+        "adoxq  %%r8, %0                    \n\t"
+        : "+r" (c)
+        : "r" (d), "r" (s), "d" (b)
+        : "r8", "r9", "cc", "memory"
+    );
+
+    return( c );
+}
+#endif
+
 /*
  * Helper for mpi multiplication
  */ 
@@ -888,6 +951,14 @@ static void mpi_mul_hlp( int i, t_int *s, t_int *d, t_int b )
 {
     t_int c = 0, t = 0;
 
+#if defined(MULADDC_MULX_ADX)
+    if( mpi_adx_state > 0 || ( mpi_adx_state < 0 && mpi_adx_check() ) )
+    {
+        for( ; i >= 8; i -= 8, s += 8, d += 8 )
+            c = mpi_mul_hlp_adx8( s, d, b, c );
+    }
+#endif
+
 #if defined(MULADDC_HUIT)
     for( ; i >= 8; i -= 8 )
     {
@@ -1504,6 +1575,198 @@ cleanup:
     return( ret );
 }
 
+/*
+ * Fixed-base table: T[i] = A^(2^(w*i)) * R mod N
+ */
+int mpi_fb_init( mpi_fb *F, mpi *A, mpi *N, int nbits )
+{
+    int ret, i, j, w, cost;
+    mpi T;
+
+    memset( F, 0, sizeof( mpi_fb ) );
+
+    if( mpi_cmp_int( N, 0 ) < 0 || ( N->p[0] & 1 ) == 0 || nbits < 1 )
+        return( POLARSSL_ERR_MPI_BAD_INPUT_DATA );
+
+    /*
+     * pick the window that minimizes n + 2^w multiplications
+     */
+    F->w = 1;
+    cost = nbits + 2;
+
+    for( w = 2; w <= 8; w++ )
+    {
+        if( ( nbits + w - 1 ) / w + ( 1 << w ) < cost )
+        {
+            F->w = w;
+            cost = ( nbits + w - 1 ) / w + ( 1 << w );
+        }
+    }
+
+    F->n = ( nbits + F->w - 1 ) / F->w;
+    F->T = (mpi *) malloc( F->n * sizeof( mpi ) );
+
+    if( F->T == NULL )
+        return( 1 );
+
+    memset( F->T, 0, F->n * sizeof( mpi ) );
+    mpi_montg_init( &F->mm, N );
+    mpi_init( &T, NULL );
+
+    j = N->n + 1;
+    MPI_CHK( mpi_grow( &T, j * 2 ) );
+    MPI_CHK( mpi_copy( &F->A, A ) );
+    MPI_CHK( mpi_copy( &F->N, N ) );
+
+    MPI_CHK( mpi_lset( &F->RR, 1 ) );
+    MPI_CHK( mpi_shift_l( &F->RR, N->n * 2 * biL ) );
+    MPI_CHK( mpi_mod_mpi( &F->RR, &F->RR, N ) );
+
+    /*
+     * T[0] = A * R^2 * R^-1 mod N = A * R mod N
+     */
+    MPI_CHK( mpi_grow( &F->T[0], j ) );
+    MPI_CHK( mpi_mod_mpi( &F->T[0], A, N ) );
+    mpi_montmul( &F->T[0], &F->RR, N, F->mm, &T );
+
+    for( i = 1; i < F->n; i++ )
+    {
+        MPI_CHK( mpi_grow( &F->T[i], j ) );
+        MPI_CHK( mpi_copy( &F->T[i], &F->T[i - 1] ) );
+
+        for( w = 0; w < F->w; w++ )
+            mpi_montmul( &F->T[i], &F->T[i], N, F->mm, &T );
+    }
+
+cleanup:
+
+    mpi_free( &T, NULL );
+
+    if( ret != 0 )
+        mpi_fb_free( F );
+
+    return( ret );
+}
+
+/*
+ * Fixed-base exponentiation: X = A^E mod N  (HAC 14.109)
+ *
+ * With E = sum( e_i * 2^(w*i) ), A^E = prod_j ( prod_{e_i >= j} T[i] ),
+ * which costs about n + 2^w multiplications and no squarings.
+ */
+int mpi_exp_mod_fb( mpi *X, mpi *E, mpi_fb *F )
+{
+    int ret, i, j, k, mask, has_a, has_b;
+    unsigned char *e;
+    mpi A, B, T;
+
+    if( mpi_cmp_int( E, 0 ) < 0 )
+        return( POLARSSL_ERR_MPI_BAD_INPUT_DATA );
+
+    if( F->T == NULL || mpi_msb( E ) > F->n * F->w )
+        return( mpi_exp_mod( X, &F->A, E, &F->N, &F->RR ) );
+
+    e = (unsigned char *) malloc( F->n );
+    if( e == NULL )
+        return( 1 );
+
+    /*
+     * split E into w-bit digits
+     */
+    mask = ( 1 << F->w ) - 1;
+
+    for( i = 0, k = 0; i < F->n; i++, k += F->w )
+    {
+        j = k / biL;
+        e[i] = 0;
+
+        if( j < E->n )
+        {
+            e[i] = (unsigned char)( ( E->p[j] >> ( k % biL ) ) & mask );
+
+            if( k % biL + F->w > biL && j + 1 < E->n )
+                e[i] |= (unsigned char)
+                    ( ( E->p[j + 1] << ( biL - k % biL ) ) & mask );
+        }
+    }
+
+    mpi_init( &A, &B, &T, NULL );
+
+    j = F->N.n + 1;
+    MPI_CHK( mpi_grow( &A, j ) );
+    MPI_CHK( mpi_grow( &B, j ) );
+    MPI_CHK( mpi_grow( &T, j * 2 ) );
+
+    has_a = has_b = 0;
+
+    for( k = mask; k > 0; k-- )
+    {
+        /*
+         * B = B * prod( T[i] : e_i == k ), A = A * B
+         */
+        for( i = 0; i < F->n; i++ )
+        {
+            if( e[i] != k )
+                continue;
+
+            if( has_b )
+                mpi_montmul( &B, &F->T[i], &F->N, F->mm, &T );
+            else
+                MPI_CHK( mpi_copy( &B, &F->T[i] ) );
+
+            has_b = 1;
+        }
+
+        if( ! has_b )
+            continue;
+
+        if( has_a )
+            mpi_montmul( &A, &B, &F->N, F->mm, &T );
+        else
+            MPI_CHK( mpi_copy( &A, &B ) );
+
+        has_a = 1;
+    }
+
+    if( has_a )
+    {
+        /*
+         * X = A^E * R * R^-1 mod N = A^E mod N
+         */
+        mpi_montred( &A, &F->N, F->mm, &T );
+        MPI_CHK( mpi_copy( X, &A ) );
+    }
+    else
+        MPI_CHK( mpi_lset( X, 1 ) );
+
+cleanup:
+
+    mpi_free( &T, &B, &A, NULL );
+    free( e );
+
+    return( ret );
+}
+
+/*
+ * Free a fixed-base table
+ */
+void mpi_fb_free( mpi_fb *F )
+{
+    int i;
+
+    if( F->T != NULL )
+    {
+        for( i = 0; i < F->n; i++ )
+            mpi_free( &F->T[i], NULL );
+
+        free( F->T );
+    }
+
+    mpi_free( &F->RR, &F->N, &F->A, NULL );
+
+    memset( F, 0, sizeof( mpi_fb ) );
+}
+
 /*
  * Greatest common divisor: G = gcd(A, B)  (HAC 14.54)
  */
@@ -33,6 +33,7 @@
 #include "polarssl/dhm.h"
 
 #include <string.h>
+#include <stdlib.h>
 
 /*
  * helper to validate the mpi size and import it
@@ -103,7 +104,7 @@ int dhm_make_params( dhm_context *ctx, int x_size,
     /*
      * generate X and calculate GX = G^X mod P
      */
-    n = x_size / sizeof( t_int );
+    n = ( x_size + sizeof( t_int ) - 1 ) / sizeof( t_int );
     MPI_CHK( mpi_grow( &ctx->X, n ) );
     MPI_CHK( mpi_lset( &ctx->X, 0 ) );
 
@@ -115,8 +116,15 @@ int dhm_make_params( dhm_context *ctx, int x_size,
     while( mpi_cmp_mpi( &ctx->X, &ctx->P ) >= 0 )
            mpi_shift_r( &ctx->X, 1 );
 
-    MPI_CHK( mpi_exp_mod( &ctx->GX, &ctx->G, &ctx->X,
-                          &ctx->P , &ctx->RP ) );
+    if( ctx->FB != NULL )
+    {
+        MPI_CHK( mpi_exp_mod_fb( &ctx->GX, &ctx->X, ctx->FB ) );
+    }
+    else
+    {
+        MPI_CHK( mpi_exp_mod( &ctx->GX, &ctx->G, &ctx->X,
+                              &ctx->P , &ctx->RP ) );
+    }
 
     /*
      * export P, G, GX
@@ -180,7 +188,7 @@ int dhm_make_public( dhm_context *ctx, int x_size,
     /*
      * generate X and calculate GX = G^X mod P
      */
-    n = x_size / sizeof( t_int );
+    n = ( x_size + sizeof( t_int ) - 1 ) / sizeof( t_int );
     MPI_CHK( mpi_grow( &ctx->X, n ) );
     MPI_CHK( mpi_lset( &ctx->X, 0 ) );
 
@@ -192,8 +200,15 @@ int dhm_make_public( dhm_context *ctx, int x_size,
     while( mpi_cmp_mpi( &ctx->X, &ctx->P ) >= 0 )
            mpi_shift_r( &ctx->X, 1 );
 
-    MPI_CHK( mpi_exp_mod( &ctx->GX, &ctx->G, &ctx->X,
-                          &ctx->P , &ctx->RP ) );
+    if( ctx->FB != NULL )
+    {
+        MPI_CHK( mpi_exp_mod_fb( &ctx->GX, &ctx->X, ctx->FB ) );
+    }
+    else
+    {
+        MPI_CHK( mpi_exp_mod( &ctx->GX, &ctx->G, &ctx->X,
+                              &ctx->P , &ctx->RP ) );
+    }
 
     MPI_CHK( mpi_write_binary( &ctx->GX, output, olen ) );
 
@@ -231,6 +246,74 @@ cleanup:
     return( 0 );
 }
 
+/*
+ * Pre-compute the fixed-base table for G
+ */
+int dhm_precompute( dhm_context *ctx )
+{
+    int ret;
+    mpi_fb *fb;
+
+    if( ctx == NULL || ctx->FB != NULL ||
+        mpi_cmp_int( &ctx->P, 0 ) <= 0 )
+        return( POLARSSL_ERR_DHM_BAD_INPUT_DATA );
+
+    fb = (mpi_fb *) malloc( sizeof( mpi_fb ) );
+    if( fb == NULL )
+        return( POLARSSL_ERR_DHM_MAKE_PARAMS_FAILED | 1 );
+
+    /*
+     * the private value X is always reduced below P
+     */
+    if( ( ret = mpi_fb_init( fb, &ctx->G, &ctx->P,
+                             mpi_msb( &ctx->P ) ) ) != 0 )
+    {
+        free( fb );
+        return( POLARSSL_ERR_DHM_MAKE_PARAMS_FAILED | ret );
+    }
+
+    if( ( ret = mpi_copy( &ctx->RP, &fb->RR ) ) != 0 )
+    {
+        mpi_fb_free( fb );
+        free( fb );
+        return( POLARSSL_ERR_DHM_MAKE_PARAMS_FAILED | ret );
+    }
+
+    ctx->FB = fb;
+    ctx->FB_shared = 0;
+
+    return( 0 );
+}
+
+/*
+ * Set up a context with the group parameters of src
+ */
+int dhm_copy_params( dhm_context *ctx, dhm_context *src )
+{
+    int ret;
+
+    if( ctx == NULL || src == NULL )
+        return( POLARSSL_ERR_DHM_BAD_INPUT_DATA );
+
+    MPI_CHK( mpi_copy( &ctx->P, &src->P ) );
+    MPI_CHK( mpi_copy( &ctx->G, &src->G ) );
+
+    if( src->RP.p != NULL )
+    {
+        MPI_CHK( mpi_copy( &ctx->RP, &src->RP ) );
+    }
+
+    ctx->FB = src->FB;
+    ctx->FB_shared = 1;
+
+cleanup:
+
+    if( ret != 0 )
+        return( POLARSSL_ERR_DHM_MAKE_PARAMS_FAILED | ret );
+
+    return( 0 );
+}
+
 /*
  * Free the components of a DHM key
  */
@@ -239,6 +322,14 @@ void dhm_free( dhm_context *ctx )
     mpi_free( &ctx->RP, &ctx->K, &ctx->GY,
               &ctx->GX, &ctx->X, &ctx->G,
               &ctx->P, NULL );    
+
+    if( ctx->FB != NULL && ctx->FB_shared == 0 )
+    {
+        mpi_fb_free( ctx->FB );
+        free( ctx->FB );
+    }
+
+    ctx->FB = NULL;
 }
 
 #if defined(POLARSSL_SELF_TEST)
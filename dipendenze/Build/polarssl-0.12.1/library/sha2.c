@@ -32,6 +32,10 @@
 
 #include "polarssl/sha2.h"
 
+#if defined(POLARSSL_SHA2NI_C)
+#include "polarssl/sha2ni.h"
+#endif
+
 #include <string.h>
 #include <stdio.h>
 
@@ -99,6 +103,14 @@ static void sha2_process( sha2_context *ctx, unsigned char data[64] )
     unsigned long temp1, temp2, W[64];
     unsigned long A, B, C, D, E, F, G, H;
 
+#if defined(POLARSSL_HAVE_SHA2NI)
+    if( sha2ni_supports( SHA2NI_SHA ) )
+    {
+        sha2ni_process( ctx->state, data, 1 );
+        return;
+    }
+#endif
+
     GET_ULONG_BE( W[ 0], data,  0 );
     GET_ULONG_BE( W[ 1], data,  4 );
     GET_ULONG_BE( W[ 2], data,  8 );
@@ -255,6 +267,15 @@ void sha2_update( sha2_context *ctx, unsigned char *input, int ilen )
         left = 0;
     }
 
+#if defined(POLARSSL_HAVE_SHA2NI)
+    if( ilen >= 64 && sha2ni_supports( SHA2NI_SHA ) )
+    {
+        sha2ni_process( ctx->state, input, ilen / 64 );
+        input += ilen & ~63;
+        ilen  &= 63;
+    }
+#endif
+
     while( ilen >= 64 )
     {
         sha2_process( ctx, input );
@@ -326,6 +347,96 @@ void sha2( unsigned char *input, int ilen,
     memset( &ctx, 0, sizeof( sha2_context ) );
 }
 
+/*
+ * output[i] = SHA-256( input[i] ), eight buffers at a time with AVX2
+ */
+void sha2_multi( unsigned char *input[], int ilen[],
+                 unsigned char *output[], int count, int is224 )
+{
+    int i;
+#if defined(POLARSSL_HAVE_SHA2NI)
+    int j, k, n, b, left, nblocks;
+    int full[8], blocks[8];
+    unsigned long state[8][8];
+    unsigned char tail[8][128];
+    unsigned char *data[8];
+    sha2_context ctx;
+
+    while( count > 1 && sha2ni_supports( SHA2NI_AVX2 ) )
+    {
+        n = ( count < 8 ) ? count : 8;
+        nblocks = 0;
+
+        sha2_starts( &ctx, is224 );
+
+        /*
+         * Lanes past the last message just repeat the first one.
+         * The padding goes to a per-lane tail so that all lanes
+         * can run through the last block together.
+         */
+        for( j = 0; j < 8; j++ )
+        {
+            k = ( j < n ) ? j : 0;
+            full[j] = ilen[k] / 64;
+            left = ilen[k] & 63;
+
+            memset( tail[j], 0, 128 );
+            memcpy( tail[j], input[k] + 64 * full[j], left );
+            tail[j][left] = 0x80;
+
+            b = ( left < 56 ) ? 64 : 128;
+            PUT_ULONG_BE( (unsigned long) ilen[k] >> 29, tail[j], b - 8 );
+            PUT_ULONG_BE( (unsigned long) ilen[k] <<  3, tail[j], b - 4 );
+
+            blocks[j] = full[j] + b / 64;
+            if( j == 0 || blocks[j] < nblocks )
+                nblocks = blocks[j];
+
+            memcpy( state[j], ctx.state, sizeof( ctx.state ) );
+        }
+
+        for( b = 0; b < nblocks; b++ )
+        {
+            for( j = 0; j < 8; j++ )
+            {
+                k = ( j < n ) ? j : 0;
+                data[j] = ( b < full[j] ) ? input[k] + 64 * b
+                                          : tail[j] + 64 * ( b - full[j] );
+            }
+
+            sha2ni_process_x8( state, data );
+        }
+
+        /*
+         * finish longer messages one at a time
+         */
+        for( j = 0; j < n; j++ )
+        {
+            memcpy( ctx.state, state[j], sizeof( ctx.state ) );
+
+            for( b = nblocks; b < blocks[j]; b++ )
+                sha2_process( &ctx, ( b < full[j] ) ? input[j] + 64 * b
+                                    : tail[j] + 64 * ( b - full[j] ) );
+
+            for( i = 0; i < ( is224 ? 7 : 8 ); i++ )
+                PUT_ULONG_BE( ctx.state[i], output[j], i * 4 );
+        }
+
+        input  += n;
+        ilen   += n;
+        output += n;
+        count  -= n;
+    }
+
+    memset( tail, 0, sizeof( tail ) );
+    memset( state, 0, sizeof( state ) );
+    memset( &ctx, 0, sizeof( sha2_context ) );
+#endif
+
+    for( i = 0; i < count; i++ )
+        sha2( input[i], ilen[i], output[i], is224 );
+}
+
 /*
  * output = SHA-256( file contents )
  */
@@ -0,0 +1,260 @@
+/*
+ *  SHA-256 SHA-NI and AVX2 support functions
+ *
+ *  Copyright (C) 2006-2009, Paul Bakker <polarssl_maintainer at polarssl.org>
+ *  All rights reserved.
+ *
+ *  Joined copyright on original XySSL code with: Christophe Devine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*
+ *  The SHA extensions path follows the Intel SHA Extensions white paper
+ *  (document 330127): the state is kept as ABEF / CDGH and SHA256RNDS2
+ *  performs two rounds at a time.
+ *
+ *  The AVX2 path is a multi-buffer implementation: each of the eight
+ *  32-bit lanes of a YMM register carries a different message, so eight
+ *  independent hashes (eg. a burst of password checks) progress with
+ *  the instruction count of a single scalar one.
+ */
+
+#include "polarssl/config.h"
+
+#if defined(POLARSSL_SHA2NI_C)
+
+#include "polarssl/sha2ni.h"
+
+#if defined(POLARSSL_HAVE_SHA2NI)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA2NI_TARGET   __attribute__((target("sha,sse4.1")))
+#define AVX2_TARGET     __attribute__((target("avx2")))
+
+static const unsigned int K[64] =
+{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+    0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+    0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+    0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+    0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+    0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static int sha2ni_done = 0;
+static unsigned int sha2ni_flags = 0;
+static unsigned int sha2ni_mask = SHA2NI_SHA | SHA2NI_AVX2;
+
+/*
+ * SHA-NI / AVX2 detection routine
+ */
+int sha2ni_supports( unsigned int what )
+{
+    unsigned int eax, ebx, ecx, edx, leaf7;
+
+    if( sha2ni_done == 0 )
+    {
+        if( __get_cpuid_max( 0, NULL ) >= 7 )
+        {
+            __cpuid_count( 7, 0, eax, leaf7, ecx, edx );
+
+            if( ( leaf7 & ( 1 << 29 ) ) != 0 )
+                sha2ni_flags |= SHA2NI_SHA;
+
+            /*
+             * AVX2 also needs the OS to save the YMM registers
+             * (OSXSAVE set and XCR0 bits 1-2 enabled)
+             */
+            if( ( leaf7 & ( 1 << 5 ) ) != 0 &&
+                __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) &&
+                ( ecx & ( 1 << 27 ) ) != 0 )
+            {
+                asm( "xgetbv" : "=a" (eax), "=d" (edx) : "c" (0) );
+
+                if( ( eax & 6 ) == 6 )
+                    sha2ni_flags |= SHA2NI_AVX2;
+            }
+        }
+
+        sha2ni_done = 1;
+    }
+
+    return( ( sha2ni_flags & sha2ni_mask & what ) != 0 );
+}
+
+/*
+ * Restrict the backends used by sha2.c
+ */
+void sha2ni_select( unsigned int what )
+{
+    sha2ni_mask = what;
+}
+
+/*
+ * SHA-256 compression of consecutive blocks (SHA extensions)
+ */
+SHA2NI_TARGET
+void sha2ni_process( unsigned long state[8],
+                     unsigned char *data,
+                     int blocks )
+{
+    int i;
+    unsigned int out[8];
+    __m128i S0, S1, ABEF, CDGH, M, W[4];
+    const __m128i BSWAP = _mm_set_epi8( 12, 13, 14, 15,  8,  9, 10, 11,
+                                         4,  5,  6,  7,  0,  1,  2,  3 );
+
+    S0 = _mm_set_epi32( (int) state[0], (int) state[1],
+                        (int) state[4], (int) state[5] );
+    S1 = _mm_set_epi32( (int) state[2], (int) state[3],
+                        (int) state[6], (int) state[7] );
+
+    for( ; blocks > 0; blocks--, data += 64 )
+    {
+        ABEF = S0;
+        CDGH = S1;
+
+        for( i = 0; i < 16; i++ )
+        {
+            if( i < 4 )
+                W[i] = _mm_shuffle_epi8( _mm_loadu_si128(
+                           (__m128i *) ( data + 16 * i ) ), BSWAP );
+            else
+            {
+                /*
+                 * W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16]
+                 */
+                M = _mm_sha256msg1_epu32( W[i & 3], W[(i + 1) & 3] );
+                M = _mm_add_epi32( M, _mm_alignr_epi8( W[(i - 1) & 3],
+                                                       W[(i - 2) & 3], 4 ) );
+                W[i & 3] = _mm_sha256msg2_epu32( M, W[(i - 1) & 3] );
+            }
+
+            M  = _mm_add_epi32( W[i & 3],
+                     _mm_loadu_si128( (__m128i *) ( K + 4 * i ) ) );
+            S1 = _mm_sha256rnds2_epu32( S1, S0, M );
+            M  = _mm_shuffle_epi32( M, 0x0E );
+            S0 = _mm_sha256rnds2_epu32( S0, S1, M );
+        }
+
+        S0 = _mm_add_epi32( S0, ABEF );
+        S1 = _mm_add_epi32( S1, CDGH );
+    }
+
+    /*
+     * S0 = { F, E, B, A }, S1 = { H, G, D, C } (lane 0 first)
+     */
+    _mm_storeu_si128( (__m128i *) out, S0 );
+    _mm_storeu_si128( (__m128i *) ( out + 4 ), S1 );
+
+    state[0] = out[3]; state[1] = out[2];
+    state[2] = out[7]; state[3] = out[6];
+    state[4] = out[1]; state[5] = out[0];
+    state[6] = out[5]; state[7] = out[4];
+}
+
+/*
+ * One big endian word from each of the eight messages
+ */
+#define GET_X8(t)                                               \
+    _mm256_set_epi32( (int) BE32( data[7], t ), (int) BE32( data[6], t ),  \
+                      (int) BE32( data[5], t ), (int) BE32( data[4], t ),  \
+                      (int) BE32( data[3], t ), (int) BE32( data[2], t ),  \
+                      (int) BE32( data[1], t ), (int) BE32( data[0], t ) )
+
+#define BE32(p,t)                                               \
+    ( ( (unsigned int) (p)[4 * (t)    ] << 24 ) |               \
+      ( (unsigned int) (p)[4 * (t) + 1] << 16 ) |               \
+      ( (unsigned int) (p)[4 * (t) + 2] <<  8 ) |               \
+      ( (unsigned int) (p)[4 * (t) + 3]       ) )
+
+#define  SHR(x,n) _mm256_srli_epi32( x, n )
+#define ROTR(x,n) _mm256_or_si256( SHR(x,n), _mm256_slli_epi32( x, 32 - n ) )
+#define  XOR(x,y) _mm256_xor_si256( x, y )
+#define  ADD(x,y) _mm256_add_epi32( x, y )
+
+#define S0(x) XOR( XOR( ROTR(x, 7), ROTR(x,18) ),  SHR(x, 3) )
+#define S1(x) XOR( XOR( ROTR(x,17), ROTR(x,19) ),  SHR(x,10) )
+
+#define S2(x) XOR( XOR( ROTR(x, 2), ROTR(x,13) ), ROTR(x,22) )
+#define S3(x) XOR( XOR( ROTR(x, 6), ROTR(x,11) ), ROTR(x,25) )
+
+#define F0(x,y,z) _mm256_or_si256( _mm256_and_si256( x, y ),         \
+                      _mm256_and_si256( z, _mm256_or_si256( x, y ) ) )
+#define F1(x,y,z) XOR( z, _mm256_and_si256( x, XOR( y, z ) ) )
+
+/*
+ * SHA-256 compression of one block of eight messages (AVX2)
+ */
+AVX2_TARGET
+void sha2ni_process_x8( unsigned long state[8][8],
+                        unsigned char *data[8] )
+{
+    int i, j;
+    unsigned int out[8];
+    __m256i W[16], V[8], S[8], T1, T2;
+
+    for( j = 0; j < 8; j++ )
+        V[j] = S[j] = _mm256_set_epi32(
+            (int) state[7][j], (int) state[6][j], (int) state[5][j],
+            (int) state[4][j], (int) state[3][j], (int) state[2][j],
+            (int) state[1][j], (int) state[0][j] );
+
+    for( i = 0; i < 64; i++ )
+    {
+        if( i < 16 )
+            W[i] = GET_X8( i );
+        else
+            W[i & 15] = ADD( ADD( S1( W[(i -  2) & 15] ), W[(i -  7) & 15] ),
+                             ADD( S0( W[(i - 15) & 15] ), W[i & 15] ) );
+
+        /*
+         * V[] = { a, b, c, d, e, f, g, h }
+         */
+        T1 = ADD( ADD( V[7], S3( V[4] ) ),
+                  ADD( F1( V[4], V[5], V[6] ),
+                       ADD( _mm256_set1_epi32( (int) K[i] ), W[i & 15] ) ) );
+        T2 = ADD( S2( V[0] ), F0( V[0], V[1], V[2] ) );
+
+        V[7] = V[6]; V[6] = V[5]; V[5] = V[4];
+        V[4] = ADD( V[3], T1 );
+        V[3] = V[2]; V[2] = V[1]; V[1] = V[0];
+        V[0] = ADD( T1, T2 );
+    }
+
+    for( j = 0; j < 8; j++ )
+    {
+        _mm256_storeu_si256( (__m256i *) out, ADD( S[j], V[j] ) );
+
+        for( i = 0; i < 8; i++ )
+            state[i][j] = out[i];
+    }
+}
+
+#endif /* POLARSSL_HAVE_SHA2NI */
+
+#endif /* POLARSSL_SHA2NI_C */
@@ -35,16 +35,62 @@
 #include "polarssl/md5.h"
 #include "polarssl/sha1.h"
 #include "polarssl/sha2.h"
+#include "polarssl/sha2ni.h"
 #include "polarssl/sha4.h"
 #include "polarssl/arc4.h"
 #include "polarssl/des.h"
 #include "polarssl/aes.h"
 #include "polarssl/camellia.h"
 #include "polarssl/rsa.h"
+#include "polarssl/dhm.h"
 #include "polarssl/timing.h"
 
 #define BUFSIZE 1024
 
+#if defined(POLARSSL_SHA2_C) && defined(POLARSSL_HAVE_SHA2NI)
+/*
+ * SHA-256 backends, each timed on eight 128-byte messages per call
+ */
+static const struct
+{
+    char *name;
+    unsigned int what;
+}
+sha2_backends[3] =
+{
+    { "SHA256-C  ", 0           },
+    { "SHA256-NI ", SHA2NI_SHA  },
+    { "SHA256-X8 ", SHA2NI_AVX2 }
+};
+#endif
+
+#if defined(POLARSSL_DHM_C)
+/*
+ * RFC 2409 (1024-bit) and RFC 3526 (2048-bit) MODP groups, G = 2
+ */
+static char *dhm_P[2] =
+{
+    "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD1"
+    "29024E088A67CC74020BBEA63B139B22514A08798E3404DD"
+    "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245"
+    "E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
+    "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE65381"
+    "FFFFFFFFFFFFFFFF",
+
+    "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD1"
+    "29024E088A67CC74020BBEA63B139B22514A08798E3404DD"
+    "EF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245"
+    "E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7ED"
+    "EE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3D"
+    "C2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F"
+    "83655D23DCA3AD961C62F356208552BB9ED529077096966D"
+    "670C354E4ABC9804F1746C08CA18217C32905E462E36CE3B"
+    "E39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9"
+    "DE2BCBF6955817183995497CEA956AE515D2261898FA0510"
+    "15728E5A8AACAA68FFFFFFFFFFFFFFFF"
+};
+#endif
+
 static int myrand( void *rng_state )
 {
     if( rng_state != NULL )
@@ -76,6 +122,15 @@ int main( void )
 #if defined(POLARSSL_RSA_C)
     rsa_context rsa;
 #endif
+#if defined(POLARSSL_SHA2_C) && defined(POLARSSL_HAVE_SHA2NI)
+    unsigned char *sha2_in[8], *sha2_out[8];
+    unsigned char sha2_sum[8][32];
+    int sha2_len[8], k;
+#endif
+#if defined(POLARSSL_DHM_C)
+    dhm_context dhm;
+    int olen;
+#endif
 
     memset( buf, 0xAA, sizeof( buf ) );
 
@@ -145,6 +200,40 @@ int main( void )
                     ( hardclock() - tsc ) / ( j * BUFSIZE ) );
 #endif
 
+#if defined(POLARSSL_SHA2_C) && defined(POLARSSL_HAVE_SHA2NI)
+    for( k = 0; k < 8; k++ )
+    {
+        sha2_in[k]  = buf + k * ( BUFSIZE / 8 );
+        sha2_len[k] = BUFSIZE / 8;
+        sha2_out[k] = sha2_sum[k];
+    }
+
+    for( k = 0; k < 3; k++ )
+    {
+        sha2ni_select( SHA2NI_SHA | SHA2NI_AVX2 );
+        if( k > 0 && ! sha2ni_supports( sha2_backends[k].what ) )
+            continue;
+
+        sha2ni_select( sha2_backends[k].what );
+
+        printf( "  %s:  ", sha2_backends[k].name );
+        fflush( stdout );
+
+        set_alarm( 1 );
+        for( i = 1; ! alarmed; i++ )
+            sha2_multi( sha2_in, sha2_len, sha2_out, 8, 0 );
+
+        tsc = hardclock();
+        for( j = 0; j < 1024; j++ )
+            sha2_multi( sha2_in, sha2_len, sha2_out, 8, 0 );
+
+        printf( "%9lu Kb/s,  %9lu cycles/byte\n", i * BUFSIZE / 1024,
+                        ( hardclock() - tsc ) / ( j * BUFSIZE ) );
+    }
+
+    sha2ni_select( SHA2NI_SHA | SHA2NI_AVX2 );
+#endif
+
 #if defined(POLARSSL_SHA4_C)
     printf( "  SHA-512   :  " );
     fflush( stdout );
@@ -292,6 +381,53 @@ int main( void )
     rsa_free( &rsa );
 #endif
 
+#if defined(POLARSSL_DHM_C)
+    for( keysize = 1024; keysize <= 2048; keysize += 1024 )
+    {
+        memset( &dhm, 0, sizeof( dhm_context ) );
+        mpi_read_string( &dhm.P, 16, dhm_P[keysize / 1024 - 1] );
+        mpi_read_string( &dhm.G, 16, "02" );
+
+        printf( "  DHM-%d  :  ", keysize );
+        fflush( stdout );
+        set_alarm( 3 );
+
+        for( i = 1; ! alarmed; i++ )
+            dhm_make_params( &dhm, keysize / 8, buf, &olen, myrand, NULL );
+
+        printf( "%9lu  params/s\n", i / 3 );
+
+        dhm_precompute( &dhm );
+
+        printf( "  DHM-%d  :  ", keysize );
+        fflush( stdout );
+        set_alarm( 3 );
+
+        for( i = 1; ! alarmed; i++ )
+            dhm_make_params( &dhm, keysize / 8, buf, &olen, myrand, NULL );
+
+        printf( "%9lu  params/s (fixed-base G)\n", i / 3 );
+
+        mpi_copy( &dhm.GY, &dhm.GX );
+
+        printf( "  DHM-%d  :  ", keysize );
+        fflush( stdout );
+        set_alarm( 3 );
+
+        for( i = 1; ! alarmed; i++ )
+        {
+            olen = sizeof( buf );
+            dhm_calc_secret( &dhm, buf, &olen );
+        }
+
+        printf( "%9lu  secret/s\n", i / 3 );
+
+        dhm_free( &dhm );
+    }
+
+    printf( "\n" );
+#endif
+
 #ifdef WIN32
     printf( "  Press Enter to exit this program.\n" );
     fflush( stdout ); getchar();
@@ -6604,6 +6604,561 @@ FCT_BGN()
         FCT_TEST_END();
 
 
+        FCT_TEST_BGN(aes_128_cbc_encrypt_nist_sp800_38a_f21)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_cbc( &ctx, AES_ENCRYPT, data_len, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b273bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_cbc_encrypt_5_blocks)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710000102030405060708090a0b0c0d0e0f" );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_cbc( &ctx, AES_ENCRYPT, data_len, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b273bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a73c1a0848daa6b9a59fee0e12231f67d4" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_cbc_decrypt_nist_sp800_38a_f22)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b273bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7" );
+        
+            aes_setkey_dec( &ctx, key_str, key_len * 8 );
+            aes_crypt_cbc( &ctx, AES_DECRYPT, data_len, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_cbc_decrypt_5_blocks)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b273bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a73c1a0848daa6b9a59fee0e12231f67d4" );
+        
+            aes_setkey_dec( &ctx, key_str, key_len * 8 );
+            aes_crypt_cbc( &ctx, AES_DECRYPT, data_len, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710000102030405060708090a0b0c0d0e0f" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_256_cbc_decrypt_nist_sp800_38a_f26)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "f58c4c04d6e5f1ba779eabfb5f7bfbd69cfc4e967edb808d679f777bc6702c7d39f23369a9d9bacfa530e26304231461b2eb05e2c39be9fcda6c19078c6a9d1b" );
+        
+            aes_setkey_dec( &ctx, key_str, key_len * 8 );
+            aes_crypt_cbc( &ctx, AES_DECRYPT, data_len, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_cfb128_encrypt_nist_sp800_38a_f313)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char iv_copy[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int iv_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" );
+            memcpy( iv_copy, iv_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_cfb128( &ctx, AES_ENCRYPT, data_len, &iv_offset, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( iv_str, iv_copy, 16 );
+            iv_offset = 0;
+        
+            aes_crypt_cfb128( &ctx, AES_ENCRYPT, 5, &iv_offset, iv_str, src_str, output );
+            aes_crypt_cfb128( &ctx, AES_ENCRYPT, 11, &iv_offset, iv_str, src_str + 5, output + 5 );
+            aes_crypt_cfb128( &ctx, AES_ENCRYPT, data_len - 16, &iv_offset, iv_str, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_cfb128_encrypt_5_blocks)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char iv_copy[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int iv_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710000102030405060708090a0b0c0d0e0f" );
+            memcpy( iv_copy, iv_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_cfb128( &ctx, AES_ENCRYPT, data_len, &iv_offset, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6a79533df647a81df0aad9381e319ac10" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( iv_str, iv_copy, 16 );
+            iv_offset = 0;
+        
+            aes_crypt_cfb128( &ctx, AES_ENCRYPT, 5, &iv_offset, iv_str, src_str, output );
+            aes_crypt_cfb128( &ctx, AES_ENCRYPT, 11, &iv_offset, iv_str, src_str + 5, output + 5 );
+            aes_crypt_cfb128( &ctx, AES_ENCRYPT, data_len - 16, &iv_offset, iv_str, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6a79533df647a81df0aad9381e319ac10" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_cfb128_decrypt_nist_sp800_38a_f314)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char iv_copy[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int iv_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6" );
+            memcpy( iv_copy, iv_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_cfb128( &ctx, AES_DECRYPT, data_len, &iv_offset, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( iv_str, iv_copy, 16 );
+            iv_offset = 0;
+        
+            aes_crypt_cfb128( &ctx, AES_DECRYPT, 5, &iv_offset, iv_str, src_str, output );
+            aes_crypt_cfb128( &ctx, AES_DECRYPT, 11, &iv_offset, iv_str, src_str + 5, output + 5 );
+            aes_crypt_cfb128( &ctx, AES_DECRYPT, data_len - 16, &iv_offset, iv_str, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_cfb128_decrypt_5_blocks)
+        {
+            unsigned char key_str[200];
+            unsigned char iv_str[200];
+            unsigned char iv_copy[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int iv_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(iv_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( iv_str, "000102030405060708090a0b0c0d0e0f" );
+            data_len = unhexify( src_str, "3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6a79533df647a81df0aad9381e319ac10" );
+            memcpy( iv_copy, iv_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_cfb128( &ctx, AES_DECRYPT, data_len, &iv_offset, iv_str, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710000102030405060708090a0b0c0d0e0f" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( iv_str, iv_copy, 16 );
+            iv_offset = 0;
+        
+            aes_crypt_cfb128( &ctx, AES_DECRYPT, 5, &iv_offset, iv_str, src_str, output );
+            aes_crypt_cfb128( &ctx, AES_DECRYPT, 11, &iv_offset, iv_str, src_str + 5, output + 5 );
+            aes_crypt_cfb128( &ctx, AES_DECRYPT, data_len - 16, &iv_offset, iv_str, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710000102030405060708090a0b0c0d0e0f" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_ctr_nist_sp800_38a_f51)
+        {
+            unsigned char key_str[200];
+            unsigned char nonce_str[200];
+            unsigned char nonce_copy[16];
+            unsigned char stream_block[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int nc_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(nonce_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( nonce_str, "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff" );
+            data_len = unhexify( src_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" );
+            memcpy( nonce_copy, nonce_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_ctr( &ctx, data_len, &nc_offset, nonce_str, stream_block, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( nonce_str, nonce_copy, 16 );
+            nc_offset = 0;
+        
+            aes_crypt_ctr( &ctx, 5, &nc_offset, nonce_str, stream_block, src_str, output );
+            aes_crypt_ctr( &ctx, 11, &nc_offset, nonce_str, stream_block, src_str + 5, output + 5 );
+            aes_crypt_ctr( &ctx, data_len - 16, &nc_offset, nonce_str, stream_block, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_ctr_nist_sp800_38a_f52)
+        {
+            unsigned char key_str[200];
+            unsigned char nonce_str[200];
+            unsigned char nonce_copy[16];
+            unsigned char stream_block[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int nc_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(nonce_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( nonce_str, "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff" );
+            data_len = unhexify( src_str, "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee" );
+            memcpy( nonce_copy, nonce_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_ctr( &ctx, data_len, &nc_offset, nonce_str, stream_block, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( nonce_str, nonce_copy, 16 );
+            nc_offset = 0;
+        
+            aes_crypt_ctr( &ctx, 5, &nc_offset, nonce_str, stream_block, src_str, output );
+            aes_crypt_ctr( &ctx, 11, &nc_offset, nonce_str, stream_block, src_str + 5, output + 5 );
+            aes_crypt_ctr( &ctx, data_len - 16, &nc_offset, nonce_str, stream_block, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_128_ctr_5_blocks)
+        {
+            unsigned char key_str[200];
+            unsigned char nonce_str[200];
+            unsigned char nonce_copy[16];
+            unsigned char stream_block[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int nc_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(nonce_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "2b7e151628aed2a6abf7158809cf4f3c" );
+            unhexify( nonce_str, "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff" );
+            data_len = unhexify( src_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710000102030405060708090a0b0c0d0e0f" );
+            memcpy( nonce_copy, nonce_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_ctr( &ctx, data_len, &nc_offset, nonce_str, stream_block, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009ceeb00c45fb108f9709f8613a9c9c46ab0d" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( nonce_str, nonce_copy, 16 );
+            nc_offset = 0;
+        
+            aes_crypt_ctr( &ctx, 5, &nc_offset, nonce_str, stream_block, src_str, output );
+            aes_crypt_ctr( &ctx, 11, &nc_offset, nonce_str, stream_block, src_str + 5, output + 5 );
+            aes_crypt_ctr( &ctx, data_len - 16, &nc_offset, nonce_str, stream_block, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009ceeb00c45fb108f9709f8613a9c9c46ab0d" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_192_ctr_counter_wrap)
+        {
+            unsigned char key_str[200];
+            unsigned char nonce_str[200];
+            unsigned char nonce_copy[16];
+            unsigned char stream_block[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int nc_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(nonce_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b" );
+            unhexify( nonce_str, "ffffffffffffffffffffffffffffffff" );
+            data_len = unhexify( src_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710000102030405060708090a0b0c0d0e0f" );
+            memcpy( nonce_copy, nonce_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_ctr( &ctx, data_len, &nc_offset, nonce_str, stream_block, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "5cc38fab30b6ac67dcc21e7b012ecf988c68a7d957ab090f01c44e62afc2df1ace7bdea8029039ebaa295a1424fe45d2564eee85c2fa2fd2ce79369e8d55bc73b076600e5a68e6f7eb7c964f83686ebf" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( nonce_str, nonce_copy, 16 );
+            nc_offset = 0;
+        
+            aes_crypt_ctr( &ctx, 5, &nc_offset, nonce_str, stream_block, src_str, output );
+            aes_crypt_ctr( &ctx, 11, &nc_offset, nonce_str, stream_block, src_str + 5, output + 5 );
+            aes_crypt_ctr( &ctx, data_len - 16, &nc_offset, nonce_str, stream_block, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "5cc38fab30b6ac67dcc21e7b012ecf988c68a7d957ab090f01c44e62afc2df1ace7bdea8029039ebaa295a1424fe45d2564eee85c2fa2fd2ce79369e8d55bc73b076600e5a68e6f7eb7c964f83686ebf" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(aes_256_ctr_nist_sp800_38a_f55)
+        {
+            unsigned char key_str[200];
+            unsigned char nonce_str[200];
+            unsigned char nonce_copy[16];
+            unsigned char stream_block[16];
+            unsigned char src_str[200];
+            unsigned char dst_str[200];
+            unsigned char output[200];
+            aes_context ctx;
+            int nc_offset = 0;
+            int key_len, data_len;
+        
+            memset(key_str, 0x00, 200);
+            memset(nonce_str, 0x00, 200);
+            memset(src_str, 0x00, 200);
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+        
+            key_len = unhexify( key_str, "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4" );
+            unhexify( nonce_str, "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff" );
+            data_len = unhexify( src_str, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710" );
+            memcpy( nonce_copy, nonce_str, 16 );
+        
+            aes_setkey_enc( &ctx, key_str, key_len * 8 );
+            aes_crypt_ctr( &ctx, data_len, &nc_offset, nonce_str, stream_block, src_str, output );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "601ec313775789a5b7a7f504bbf3d228f443e3ca4d62b59aca84e990cacaf5c52b0930daa23de94ce87017ba2d84988ddfc9c58db67aada613c2dd08457941a6" ) == 0 );
+        
+            /* same stream in pieces: partial block, rest of block, remaining blocks */
+            memset(dst_str, 0x00, 200);
+            memset(output, 0x00, 200);
+            memcpy( nonce_str, nonce_copy, 16 );
+            nc_offset = 0;
+        
+            aes_crypt_ctr( &ctx, 5, &nc_offset, nonce_str, stream_block, src_str, output );
+            aes_crypt_ctr( &ctx, 11, &nc_offset, nonce_str, stream_block, src_str + 5, output + 5 );
+            aes_crypt_ctr( &ctx, data_len - 16, &nc_offset, nonce_str, stream_block, src_str + 16, output + 16 );
+            hexify( dst_str, output, data_len );
+        
+            fct_chk( strcmp( (char *) dst_str, "601ec313775789a5b7a7f504bbf3d228f443e3ca4d62b59aca84e990cacaf5c52b0930daa23de94ce87017ba2d84988ddfc9c58db67aada613c2dd08457941a6" ) == 0 );
+        }
+        FCT_TEST_END();
+
+
         FCT_TEST_BGN(aes_selftest)
         {
             fct_chk( aes_self_test( 0 ) == 0 );
@@ -211,6 +211,177 @@ FCT_BGN()
         }
         FCT_TEST_END();
 
+
+        FCT_TEST_BGN(diffie_hellman_fixed_base_exchange_1)
+        {
+            dhm_context ctx_base;
+            dhm_context ctx_srv;
+            dhm_context ctx_cli;
+            unsigned char ske[1000];
+            unsigned char *p;
+            unsigned char pub_cli[1000];
+            unsigned char sec_srv[1000];
+            unsigned char sec_cli[1000];
+            int ske_len, pub_cli_len, sec_srv_len, sec_cli_len;
+            int x_size, round;
+        
+            memset( &ctx_base, 0x00, sizeof( dhm_context ) );
+        
+            fct_chk( mpi_read_string( &ctx_base.P, 10, "23" ) == 0 );
+            fct_chk( mpi_read_string( &ctx_base.G, 10, "5" ) == 0 );
+            fct_chk( dhm_precompute( &ctx_base ) == 0 );
+            x_size = mpi_size( &ctx_base.P );
+        
+            for( round = 0; round < 2; round++ )
+            {
+                memset( &ctx_srv, 0x00, sizeof( dhm_context ) );
+                memset( &ctx_cli, 0x00, sizeof( dhm_context ) );
+                memset( ske, 0x00, 1000 );
+                p = ske;
+                ske_len = 0;
+                sec_srv_len = 1000;
+                sec_cli_len = 1000;
+        
+                fct_chk( dhm_copy_params( &ctx_srv, &ctx_base ) == 0 );
+                fct_chk( dhm_make_params( &ctx_srv, x_size, ske, &ske_len, &myrand, NULL ) == 0 );
+                ske[ske_len++] = 0;
+                ske[ske_len++] = 0;
+                fct_chk( dhm_read_params( &ctx_cli, &p, ske + ske_len ) == 0 );
+        
+                pub_cli_len = x_size;
+                fct_chk( dhm_make_public( &ctx_cli, x_size, pub_cli, pub_cli_len, &myrand, NULL ) == 0 );
+        
+                fct_chk( dhm_read_public( &ctx_srv, pub_cli, pub_cli_len ) == 0 );
+        
+                fct_chk( dhm_calc_secret( &ctx_srv, sec_srv, &sec_srv_len ) == 0 );
+                fct_chk( dhm_calc_secret( &ctx_cli, sec_cli, &sec_cli_len ) == 0 );
+        
+                fct_chk( sec_srv_len == sec_cli_len );
+                fct_chk( sec_srv_len != 0 );
+                fct_chk( memcmp( sec_srv, sec_cli, sec_srv_len ) == 0 );
+        
+                dhm_free( &ctx_srv );
+                dhm_free( &ctx_cli );
+            }
+        
+            dhm_free( &ctx_base );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(diffie_hellman_fixed_base_exchange_2)
+        {
+            dhm_context ctx_base;
+            dhm_context ctx_srv;
+            dhm_context ctx_cli;
+            unsigned char ske[1000];
+            unsigned char *p;
+            unsigned char pub_cli[1000];
+            unsigned char sec_srv[1000];
+            unsigned char sec_cli[1000];
+            int ske_len, pub_cli_len, sec_srv_len, sec_cli_len;
+            int x_size, round;
+        
+            memset( &ctx_base, 0x00, sizeof( dhm_context ) );
+        
+            fct_chk( mpi_read_string( &ctx_base.P, 10, "93450983094850938450983409623982317398171298719873918739182739712938719287391879381271" ) == 0 );
+            fct_chk( mpi_read_string( &ctx_base.G, 10, "9345098309485093845098340962223981329819812792137312973297123912791271" ) == 0 );
+            fct_chk( dhm_precompute( &ctx_base ) == 0 );
+            x_size = mpi_size( &ctx_base.P );
+        
+            for( round = 0; round < 2; round++ )
+            {
+                memset( &ctx_srv, 0x00, sizeof( dhm_context ) );
+                memset( &ctx_cli, 0x00, sizeof( dhm_context ) );
+                memset( ske, 0x00, 1000 );
+                p = ske;
+                ske_len = 0;
+                sec_srv_len = 1000;
+                sec_cli_len = 1000;
+        
+                fct_chk( dhm_copy_params( &ctx_srv, &ctx_base ) == 0 );
+                fct_chk( dhm_make_params( &ctx_srv, x_size, ske, &ske_len, &myrand, NULL ) == 0 );
+                ske[ske_len++] = 0;
+                ske[ske_len++] = 0;
+                fct_chk( dhm_read_params( &ctx_cli, &p, ske + ske_len ) == 0 );
+        
+                pub_cli_len = x_size;
+                fct_chk( dhm_make_public( &ctx_cli, x_size, pub_cli, pub_cli_len, &myrand, NULL ) == 0 );
+        
+                fct_chk( dhm_read_public( &ctx_srv, pub_cli, pub_cli_len ) == 0 );
+        
+                fct_chk( dhm_calc_secret( &ctx_srv, sec_srv, &sec_srv_len ) == 0 );
+                fct_chk( dhm_calc_secret( &ctx_cli, sec_cli, &sec_cli_len ) == 0 );
+        
+                fct_chk( sec_srv_len == sec_cli_len );
+                fct_chk( sec_srv_len != 0 );
+                fct_chk( memcmp( sec_srv, sec_cli, sec_srv_len ) == 0 );
+        
+                dhm_free( &ctx_srv );
+                dhm_free( &ctx_cli );
+            }
+        
+            dhm_free( &ctx_base );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(diffie_hellman_fixed_base_exchange_3_rfc_3526_2048_bit_modp_group)
+        {
+            dhm_context ctx_base;
+            dhm_context ctx_srv;
+            dhm_context ctx_cli;
+            unsigned char ske[1000];
+            unsigned char *p;
+            unsigned char pub_cli[1000];
+            unsigned char sec_srv[1000];
+            unsigned char sec_cli[1000];
+            int ske_len, pub_cli_len, sec_srv_len, sec_cli_len;
+            int x_size, round;
+        
+            memset( &ctx_base, 0x00, sizeof( dhm_context ) );
+        
+            fct_chk( mpi_read_string( &ctx_base.P, 16, "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DDEF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7EDEE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F83655D23DCA3AD961C62F356208552BB9ED529077096966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3BE39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF6955817183995497CEA956AE515D2261898FA051015728E5A8AACAA68FFFFFFFFFFFFFFFF" ) == 0 );
+            fct_chk( mpi_read_string( &ctx_base.G, 10, "2" ) == 0 );
+            fct_chk( dhm_precompute( &ctx_base ) == 0 );
+            x_size = mpi_size( &ctx_base.P );
+        
+            for( round = 0; round < 2; round++ )
+            {
+                memset( &ctx_srv, 0x00, sizeof( dhm_context ) );
+                memset( &ctx_cli, 0x00, sizeof( dhm_context ) );
+                memset( ske, 0x00, 1000 );
+                p = ske;
+                ske_len = 0;
+                sec_srv_len = 1000;
+                sec_cli_len = 1000;
+        
+                fct_chk( dhm_copy_params( &ctx_srv, &ctx_base ) == 0 );
+                fct_chk( dhm_make_params( &ctx_srv, x_size, ske, &ske_len, &myrand, NULL ) == 0 );
+                ske[ske_len++] = 0;
+                ske[ske_len++] = 0;
+                fct_chk( dhm_read_params( &ctx_cli, &p, ske + ske_len ) == 0 );
+        
+                pub_cli_len = x_size;
+                fct_chk( dhm_make_public( &ctx_cli, x_size, pub_cli, pub_cli_len, &myrand, NULL ) == 0 );
+        
+                fct_chk( dhm_read_public( &ctx_srv, pub_cli, pub_cli_len ) == 0 );
+        
+                fct_chk( dhm_calc_secret( &ctx_srv, sec_srv, &sec_srv_len ) == 0 );
+                fct_chk( dhm_calc_secret( &ctx_cli, sec_cli, &sec_cli_len ) == 0 );
+        
+                fct_chk( sec_srv_len == sec_cli_len );
+                fct_chk( sec_srv_len != 0 );
+                fct_chk( memcmp( sec_srv, sec_cli, sec_srv_len ) == 0 );
+        
+                dhm_free( &ctx_srv );
+                dhm_free( &ctx_cli );
+            }
+        
+            dhm_free( &ctx_base );
+        }
+        FCT_TEST_END();
+
     }
     FCT_SUITE_END();
 }
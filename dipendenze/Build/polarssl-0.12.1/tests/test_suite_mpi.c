@@ -2208,6 +2208,188 @@ FCT_BGN()
         FCT_TEST_END();
 
 
+        FCT_TEST_BGN(base_test_mpi_exp_mod_fb_1)
+        {
+            mpi A, E, N, Z, X;
+            mpi_fb F;
+            int res;
+            mpi_init(&A, &E, &N, &Z, &X, NULL);
+        
+            fct_chk( mpi_read_string( &A, 10, "23" ) == 0 );
+            fct_chk( mpi_read_string( &E, 10, "13" ) == 0 );
+            fct_chk( mpi_read_string( &N, 10, "29" ) == 0 );
+            fct_chk( mpi_read_string( &X, 10, "24" ) == 0 );
+        
+            res = mpi_fb_init( &F, &A, &N, 8 );
+            if( res == 0 )
+                res = mpi_exp_mod_fb( &Z, &E, &F );
+            fct_chk( res == 0 );
+            if( res == 0 )
+            {
+                fct_chk( mpi_cmp_mpi( &Z, &X ) == 0 );
+            }
+        
+            mpi_fb_free( &F );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(base_test_mpi_exp_mod_fb_2)
+        {
+            mpi A, E, N, Z, X;
+            mpi_fb F;
+            int res;
+            mpi_init(&A, &E, &N, &Z, &X, NULL);
+        
+            fct_chk( mpi_read_string( &A, 10, "23" ) == 0 );
+            fct_chk( mpi_read_string( &E, 10, "13" ) == 0 );
+            fct_chk( mpi_read_string( &N, 10, "30" ) == 0 );
+            fct_chk( mpi_read_string( &X, 10, "0" ) == 0 );
+        
+            res = mpi_fb_init( &F, &A, &N, 8 );
+            if( res == 0 )
+                res = mpi_exp_mod_fb( &Z, &E, &F );
+            fct_chk( res == POLARSSL_ERR_MPI_BAD_INPUT_DATA );
+            if( res == 0 )
+            {
+                fct_chk( mpi_cmp_mpi( &Z, &X ) == 0 );
+            }
+        
+            mpi_fb_free( &F );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(base_test_mpi_exp_mod_fb_3)
+        {
+            mpi A, E, N, Z, X;
+            mpi_fb F;
+            int res;
+            mpi_init(&A, &E, &N, &Z, &X, NULL);
+        
+            fct_chk( mpi_read_string( &A, 10, "23" ) == 0 );
+            fct_chk( mpi_read_string( &E, 10, "13" ) == 0 );
+            fct_chk( mpi_read_string( &N, 10, "-29" ) == 0 );
+            fct_chk( mpi_read_string( &X, 10, "24" ) == 0 );
+        
+            res = mpi_fb_init( &F, &A, &N, 8 );
+            if( res == 0 )
+                res = mpi_exp_mod_fb( &Z, &E, &F );
+            fct_chk( res == POLARSSL_ERR_MPI_BAD_INPUT_DATA );
+            if( res == 0 )
+            {
+                fct_chk( mpi_cmp_mpi( &Z, &X ) == 0 );
+            }
+        
+            mpi_fb_free( &F );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(base_test_mpi_exp_mod_fb_4_e__0)
+        {
+            mpi A, E, N, Z, X;
+            mpi_fb F;
+            int res;
+            mpi_init(&A, &E, &N, &Z, &X, NULL);
+        
+            fct_chk( mpi_read_string( &A, 10, "23" ) == 0 );
+            fct_chk( mpi_read_string( &E, 10, "0" ) == 0 );
+            fct_chk( mpi_read_string( &N, 10, "29" ) == 0 );
+            fct_chk( mpi_read_string( &X, 10, "1" ) == 0 );
+        
+            res = mpi_fb_init( &F, &A, &N, 8 );
+            if( res == 0 )
+                res = mpi_exp_mod_fb( &Z, &E, &F );
+            fct_chk( res == 0 );
+            if( res == 0 )
+            {
+                fct_chk( mpi_cmp_mpi( &Z, &X ) == 0 );
+            }
+        
+            mpi_fb_free( &F );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(base_test_mpi_exp_mod_fb_5_e_larger_than_table)
+        {
+            mpi A, E, N, Z, X;
+            mpi_fb F;
+            int res;
+            mpi_init(&A, &E, &N, &Z, &X, NULL);
+        
+            fct_chk( mpi_read_string( &A, 10, "23" ) == 0 );
+            fct_chk( mpi_read_string( &E, 10, "13" ) == 0 );
+            fct_chk( mpi_read_string( &N, 10, "29" ) == 0 );
+            fct_chk( mpi_read_string( &X, 10, "24" ) == 0 );
+        
+            res = mpi_fb_init( &F, &A, &N, 2 );
+            if( res == 0 )
+                res = mpi_exp_mod_fb( &Z, &E, &F );
+            fct_chk( res == 0 );
+            if( res == 0 )
+            {
+                fct_chk( mpi_cmp_mpi( &Z, &X ) == 0 );
+            }
+        
+            mpi_fb_free( &F );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(test_mpi_exp_mod_fb_1)
+        {
+            mpi A, E, N, Z, X;
+            mpi_fb F;
+            int res;
+            mpi_init(&A, &E, &N, &Z, &X, NULL);
+        
+            fct_chk( mpi_read_string( &A, 10, "433019240910377478217373572959560109819648647016096560523769010881172869083338285573756574557395862965095016483867813043663981946477698466501451832407592327356331263124555137732393938242285782144928753919588632679050799198937132922145084847" ) == 0 );
+            fct_chk( mpi_read_string( &E, 10, "5781538327977828897150909166778407659250458379645823062042492461576758526757490910073628008613977550546382774775570888130029763571528699574717583228939535960234464230882573615930384979100379102915657483866755371559811718767760594919456971354184113721" ) == 0 );
+            fct_chk( mpi_read_string( &N, 10, "583137007797276923956891216216022144052044091311388601652961409557516421612874571554415606746479105795833145583959622117418531166391184939066520869800857530421873250114773204354963864729386957427276448683092491947566992077136553066273207777134303397724679138833126700957" ) == 0 );
+            fct_chk( mpi_read_string( &X, 10, "114597449276684355144920670007147953232659436380163461553186940113929777196018164149703566472936578890991049344459204199888254907113495794730452699842273939581048142004834330369483813876618772578869083248061616444392091693787039636316845512292127097865026290173004860736" ) == 0 );
+        
+            res = mpi_fb_init( &F, &A, &N, 1024 );
+            if( res == 0 )
+                res = mpi_exp_mod_fb( &Z, &E, &F );
+            fct_chk( res == 0 );
+            if( res == 0 )
+            {
+                fct_chk( mpi_cmp_mpi( &Z, &X ) == 0 );
+            }
+        
+            mpi_fb_free( &F );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(test_mpi_exp_mod_fb_2_e_larger_than_table)
+        {
+            mpi A, E, N, Z, X;
+            mpi_fb F;
+            int res;
+            mpi_init(&A, &E, &N, &Z, &X, NULL);
+        
+            fct_chk( mpi_read_string( &A, 10, "433019240910377478217373572959560109819648647016096560523769010881172869083338285573756574557395862965095016483867813043663981946477698466501451832407592327356331263124555137732393938242285782144928753919588632679050799198937132922145084847" ) == 0 );
+            fct_chk( mpi_read_string( &E, 10, "5781538327977828897150909166778407659250458379645823062042492461576758526757490910073628008613977550546382774775570888130029763571528699574717583228939535960234464230882573615930384979100379102915657483866755371559811718767760594919456971354184113721" ) == 0 );
+            fct_chk( mpi_read_string( &N, 10, "583137007797276923956891216216022144052044091311388601652961409557516421612874571554415606746479105795833145583959622117418531166391184939066520869800857530421873250114773204354963864729386957427276448683092491947566992077136553066273207777134303397724679138833126700957" ) == 0 );
+            fct_chk( mpi_read_string( &X, 10, "114597449276684355144920670007147953232659436380163461553186940113929777196018164149703566472936578890991049344459204199888254907113495794730452699842273939581048142004834330369483813876618772578869083248061616444392091693787039636316845512292127097865026290173004860736" ) == 0 );
+        
+            res = mpi_fb_init( &F, &A, &N, 256 );
+            if( res == 0 )
+                res = mpi_exp_mod_fb( &Z, &E, &F );
+            fct_chk( res == 0 );
+            if( res == 0 )
+            {
+                fct_chk( mpi_cmp_mpi( &Z, &X ) == 0 );
+            }
+        
+            mpi_fb_free( &F );
+        }
+        FCT_TEST_END();
+
+
         FCT_TEST_BGN(base_test_gcd_1)
         {
             mpi A, X, Y, Z;
@@ -2,6 +2,7 @@
 #include <polarssl/sha1.h>
 #include <polarssl/sha2.h>
 #include <polarssl/sha4.h>
+#include <polarssl/sha2ni.h>
 
 int unhexify(unsigned char *obuf, const char *ibuf)
 {
@@ -571,6 +572,221 @@ FCT_BGN()
         FCT_TEST_END();
 
 
+        FCT_TEST_BGN(sha_256_multi_buffer_1_single_buffer)
+        {
+            unsigned char src_str[20][1000];
+            unsigned char ref[20][32];
+            unsigned char out[20][32];
+            unsigned char *input[20];
+            unsigned char *output[20];
+            int ilen[20];
+            int i, j;
+        
+            for( i = 0; i < 1; i++ )
+            {
+                for( j = 0; j < 1000; j++ )
+                    src_str[i][j] = (unsigned char)( i * 31 + j * 7 );
+        
+                input[i] = src_str[i];
+                output[i] = out[i];
+                ilen[i] = ( i * 5 ) % 1000;
+            }
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( 0 );
+        #endif
+            for( i = 0; i < 1; i++ )
+                sha2( input[i], ilen[i], ref[i], 0 );
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( SHA2NI_SHA );
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 1, 0 );
+            for( i = 0; i < 1; i++ )
+                fct_chk( memcmp( out[i], ref[i], 0 ? 28 : 32 ) == 0 );
+        
+            sha2ni_select( SHA2NI_SHA | SHA2NI_AVX2 );
+        #endif
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 1, 0 );
+            for( i = 0; i < 1; i++ )
+                fct_chk( memcmp( out[i], ref[i], 0 ? 28 : 32 ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(sha_256_multi_buffer_2_empty_buffers)
+        {
+            unsigned char src_str[20][1000];
+            unsigned char ref[20][32];
+            unsigned char out[20][32];
+            unsigned char *input[20];
+            unsigned char *output[20];
+            int ilen[20];
+            int i, j;
+        
+            for( i = 0; i < 8; i++ )
+            {
+                for( j = 0; j < 1000; j++ )
+                    src_str[i][j] = (unsigned char)( i * 31 + j * 7 );
+        
+                input[i] = src_str[i];
+                output[i] = out[i];
+                ilen[i] = ( i * 0 ) % 1000;
+            }
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( 0 );
+        #endif
+            for( i = 0; i < 8; i++ )
+                sha2( input[i], ilen[i], ref[i], 0 );
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( SHA2NI_SHA );
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 8, 0 );
+            for( i = 0; i < 8; i++ )
+                fct_chk( memcmp( out[i], ref[i], 0 ? 28 : 32 ) == 0 );
+        
+            sha2ni_select( SHA2NI_SHA | SHA2NI_AVX2 );
+        #endif
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 8, 0 );
+            for( i = 0; i < 8; i++ )
+                fct_chk( memcmp( out[i], ref[i], 0 ? 28 : 32 ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(sha_256_multi_buffer_3_padding_in_one_or_two_blocks)
+        {
+            unsigned char src_str[20][1000];
+            unsigned char ref[20][32];
+            unsigned char out[20][32];
+            unsigned char *input[20];
+            unsigned char *output[20];
+            int ilen[20];
+            int i, j;
+        
+            for( i = 0; i < 16; i++ )
+            {
+                for( j = 0; j < 1000; j++ )
+                    src_str[i][j] = (unsigned char)( i * 31 + j * 7 );
+        
+                input[i] = src_str[i];
+                output[i] = out[i];
+                ilen[i] = ( i * 4 ) % 1000;
+            }
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( 0 );
+        #endif
+            for( i = 0; i < 16; i++ )
+                sha2( input[i], ilen[i], ref[i], 0 );
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( SHA2NI_SHA );
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 16, 0 );
+            for( i = 0; i < 16; i++ )
+                fct_chk( memcmp( out[i], ref[i], 0 ? 28 : 32 ) == 0 );
+        
+            sha2ni_select( SHA2NI_SHA | SHA2NI_AVX2 );
+        #endif
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 16, 0 );
+            for( i = 0; i < 16; i++ )
+                fct_chk( memcmp( out[i], ref[i], 0 ? 28 : 32 ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(sha_256_multi_buffer_4_partial_group_mixed_lengths)
+        {
+            unsigned char src_str[20][1000];
+            unsigned char ref[20][32];
+            unsigned char out[20][32];
+            unsigned char *input[20];
+            unsigned char *output[20];
+            int ilen[20];
+            int i, j;
+        
+            for( i = 0; i < 13; i++ )
+            {
+                for( j = 0; j < 1000; j++ )
+                    src_str[i][j] = (unsigned char)( i * 31 + j * 7 );
+        
+                input[i] = src_str[i];
+                output[i] = out[i];
+                ilen[i] = ( i * 37 ) % 1000;
+            }
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( 0 );
+        #endif
+            for( i = 0; i < 13; i++ )
+                sha2( input[i], ilen[i], ref[i], 0 );
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( SHA2NI_SHA );
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 13, 0 );
+            for( i = 0; i < 13; i++ )
+                fct_chk( memcmp( out[i], ref[i], 0 ? 28 : 32 ) == 0 );
+        
+            sha2ni_select( SHA2NI_SHA | SHA2NI_AVX2 );
+        #endif
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 13, 0 );
+            for( i = 0; i < 13; i++ )
+                fct_chk( memcmp( out[i], ref[i], 0 ? 28 : 32 ) == 0 );
+        }
+        FCT_TEST_END();
+
+
+        FCT_TEST_BGN(sha_224_multi_buffer_1_mixed_lengths)
+        {
+            unsigned char src_str[20][1000];
+            unsigned char ref[20][32];
+            unsigned char out[20][32];
+            unsigned char *input[20];
+            unsigned char *output[20];
+            int ilen[20];
+            int i, j;
+        
+            for( i = 0; i < 20; i++ )
+            {
+                for( j = 0; j < 1000; j++ )
+                    src_str[i][j] = (unsigned char)( i * 31 + j * 7 );
+        
+                input[i] = src_str[i];
+                output[i] = out[i];
+                ilen[i] = ( i * 61 ) % 1000;
+            }
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( 0 );
+        #endif
+            for( i = 0; i < 20; i++ )
+                sha2( input[i], ilen[i], ref[i], 1 );
+        
+        #if defined(POLARSSL_HAVE_SHA2NI)
+            sha2ni_select( SHA2NI_SHA );
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 20, 1 );
+            for( i = 0; i < 20; i++ )
+                fct_chk( memcmp( out[i], ref[i], 1 ? 28 : 32 ) == 0 );
+        
+            sha2ni_select( SHA2NI_SHA | SHA2NI_AVX2 );
+        #endif
+            memset( out, 0x00, sizeof( out ) );
+            sha2_multi( input, ilen, output, 20, 1 );
+            for( i = 0; i < 20; i++ )
+                fct_chk( memcmp( out[i], ref[i], 1 ? 28 : 32 ) == 0 );
+        }
+        FCT_TEST_END();
+
+
         FCT_TEST_BGN(sha_384_test_vector_nist_cavs_1)
         {
             unsigned char src_str[10000];
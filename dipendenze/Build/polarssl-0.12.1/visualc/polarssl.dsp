@@ -89,6 +89,14 @@ SOURCE=..\library\aes.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\library\aesce.c
+# End Source File
+# Begin Source File
+
+SOURCE=..\library\aesni.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\library\arc4.c
 # End Source File
 # Begin Source File
@@ -157,6 +165,10 @@ SOURCE=..\library\sha2.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\library\sha2ni.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\library\sha4.c
 # End Source File
 # Begin Source File
@@ -193,6 +205,14 @@ SOURCE=..\include\polarssl\aes.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\include\polarssl\aesce.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\include\polarssl\aesni.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\include\polarssl\arc4.h
 # End Source File
 # Begin Source File
@@ -269,6 +289,10 @@ SOURCE=..\include\polarssl\sha2.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\include\polarssl\sha2ni.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\include\polarssl\sha4.h
 # End Source File
 # Begin Source File
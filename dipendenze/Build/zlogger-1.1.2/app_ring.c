@@ -17,7 +17,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  * 
  * \if DeveloperDocs
- *   \brief Ring buffer appender - log messages are kept in memory
+ *   \brief Ring buffer appender - log messages are kept in memory or a memory-mapped file
  * \endif
  */
  
@@ -28,6 +28,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "zlogger.private.h"
 
@@ -37,7 +43,11 @@
  * @{
  */
 #define MAGIC_RINGBUFFER_TAG_1      "zLogRingBuffer_1"
-#define MAGIC_RINGBUFFER_TAG_2      "zLogRingBuffer_2"
+
+#define RING_FILE_VERSION           2
+#define RING_SLOT_SIZE              128         //!< bytes per slot, including slot header
+#define RING_SLOT_TEXT              (RING_SLOT_SIZE - 8)
+#define RING_MAX_RECORD             1024        //!< longest log line kept in ring, including '\0'
 
 
 /*!
@@ -46,14 +56,44 @@
 
 /*
  * Local structures
+ *
+ * The ring is an array of fixed-size slots, addressed by a free-running
+ * sequence number modulo the (power of 2) number of slots. A log line
+ * longer than one slot occupies consecutive slots (fragments).
+ * Writers reserve their slots with a single atomic add on 'next', so
+ * eviction of the oldest entries is implicit and O(1).
+ * A slot's 'seq' is cleared while it is being written and set to its
+ * sequence number +1 when complete, which lets readers detect torn or
+ * overwritten entries without taking a lock.
+ * 
+ * If a file name is given, header and slots are mmap'ed from that file.
+ * Its contents survive a crash and are kept when the ring is re-opened.
  */
+typedef struct _sRingHeader {
+    char                magic[16];          //!< MAGIC_RINGBUFFER_TAG_1, without '\0'
+    uint32_t            version;
+    uint32_t            slotsize;           //!< RING_SLOT_SIZE
+    uint32_t            slots;              //!< number of slots, power of 2
+    volatile uint32_t   next;               //!< sequence number of next slot to write
+    volatile uint32_t   dumped;             //!< first sequence number not yet dumped
+    uint32_t            _reserved[3];
+} sRingHeader;
+
+typedef struct _sRingSlot {
+    volatile uint32_t   seq;                //!< sequence number +1, 0 while slot is being written
+    uint8_t             fragment;           //!< index of this fragment within log line
+    uint8_t             fragments;          //!< number of slots used by log line
+    uint16_t            len;                //!< bytes of text in this slot
+    char                text[RING_SLOT_TEXT];
+} sRingSlot;
+
 typedef struct _sRing {
     char        _magic[MAGIC_MAX_LENGTH];
-    char        *tail;              //!< Where to put next log entry. Always points to first byte after '\0'
-    char        *head;              //!< Oldest full log line
-    char        *end;               //!< Last byte of ringbuffer
-    int         size;               //!< In bytes
-    char        *buffer;            //!< Pointer to ring buffer
+    sRingHeader *header;            //!< Shared ring control, followed by slots
+    sRingSlot   *slot;              //!< First slot
+    uint32_t    mask;               //!< Number of slots -1
+    size_t      size;               //!< Size of header and slots, in bytes
+    int         mapped;             //!< 1: header is mmap'ed from file, 0: malloc'ed
     char        _magic2[MAGIC_MAX_LENGTH];
 } sRing;
 
@@ -65,6 +105,7 @@ static int ringOpen( sAppender *pApp );
 static int ringClose( sAppender *pApp );
 static int ringLog( sAppender *pApp, unsigned int level, char *message );
 static int ringCheck( char *params );
+static int ringHeaderValid( sRingHeader *pHeader, uint32_t slots );
 
 
 /*
@@ -89,19 +130,43 @@ sAppenderPlugin *zlogRing_Init( void )
 /*!
  * \brief check parameters for ring appender
  * 
+ * Parameters are "kilobytes[,file]".
+ * 
  * \param   params          parameter string
  * 
  * \return                  error code: 0=ok, <0=error
  */
 static int ringCheck( char *params )
 {
+    char    *file;
+    
     if( params == NULL || *params == '\0' || atoi( params ) <= 0 ) {
         return( ZLOG_E_PARAMETERS );
     }
+    if( (file = strchr( params, ',' )) != NULL && file[1] == '\0' ) {
+        return( ZLOG_E_PARAMETERS );
+    }
     return( ZLOG_NO_ERROR );
 }
 
 
+/*!
+ * \brief check if existing ring header can be re-used
+ * 
+ * \param   pHeader         pointer to ring header
+ * \param   slots           expected number of slots
+ * 
+ * \return                  1: valid, 0: must be initialised
+ */
+static int ringHeaderValid( sRingHeader *pHeader, uint32_t slots )
+{
+    return( memcmp( pHeader->magic, MAGIC_RINGBUFFER_TAG_1, sizeof( pHeader->magic )) == 0 &&
+            pHeader->version == RING_FILE_VERSION &&
+            pHeader->slotsize == RING_SLOT_SIZE &&
+            pHeader->slots == slots );
+}
+
+
 /*!
  * \brief open ring appender
  * 
@@ -112,41 +177,77 @@ static int ringCheck( char *params )
  */
 static int ringOpen( sAppender *pApp )
 {
-    sRing   *pRing;
-    char    *ptr;
-    int     size;
+    sRing       *pRing;
+    sRingHeader *pHeader;
+    char        *file;
+    uint32_t    slots;
+    size_t      size;
+    struct stat st;
+    int         fd;
+    int         keep = 0;
     
     // destroy ring if it already exists (re-open)
     if( pApp->channel != NULL ) {
         ringClose( pApp );
     }
     
-    size = atoi( pApp->parameters ) << 10;      // size is in kilobytes
+    // size is in kilobytes, rounded down to a power of 2 number of slots
+    size = (size_t)atoi( pApp->parameters ) << 10;
+    for( slots = 1; ((size_t)slots << 1) * RING_SLOT_SIZE <= size; slots <<= 1 ) ;
+    size = sizeof( sRingHeader ) + (size_t)slots * RING_SLOT_SIZE;
     
     // allocate memory for control structure and ring buffer
     pRing = malloc( sizeof( sRing ));
     if( pRing == NULL ) {
         return(  ZLOG_E_CHANNEL );
     }
-    ptr = malloc( size + strlen( MAGIC_RINGBUFFER_TAG_1 ) + strlen( MAGIC_RINGBUFFER_TAG_2 ) +1 );
-    if( ptr == NULL ) {
-        free( pRing );
-        return(  ZLOG_E_CHANNEL );
+    
+    file = strchr( pApp->parameters, ',' );
+    if( file != NULL ) {
+        // ring is backed by file
+        fd = open( file +1, O_RDWR | O_CREAT, 0640 );
+        if( fd < 0 ) {
+            free( pRing );
+            return( ZLOG_E_CHANNEL );
+        }
+        if( fstat( fd, &st ) == 0 && (size_t)st.st_size == size ) {
+            keep = 1;
+        } else if( ftruncate( fd, size ) != 0 ) {
+            close( fd );
+            free( pRing );
+            return( ZLOG_E_CHANNEL );
+        }
+        pHeader = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        close( fd );
+        if( pHeader == MAP_FAILED ) {
+            free( pRing );
+            return( ZLOG_E_CHANNEL );
+        }
+        pRing->mapped = 1;
+    } else {
+        pHeader = malloc( size );
+        if( pHeader == NULL ) {
+            free( pRing );
+            return( ZLOG_E_CHANNEL );
+        }
+        pRing->mapped = 0;
     }
     
-    // initialise structure
-    pRing->buffer = ptr + strlen( MAGIC_RINGBUFFER_TAG_1 );
-    pRing->head = pRing->buffer;
-    pRing->tail = pRing->buffer;
-    pRing->end  = pRing->buffer + size;
+    // initialise structure, keeping entries of a previous run
+    if( keep == 0 || ringHeaderValid( pHeader, slots ) == 0 ) {
+        memset( pHeader, 0, size );
+        memcpy( pHeader->magic, MAGIC_RINGBUFFER_TAG_1, sizeof( pHeader->magic ));
+        pHeader->version = RING_FILE_VERSION;
+        pHeader->slotsize = RING_SLOT_SIZE;
+        pHeader->slots = slots;
+    }
+    pRing->header = pHeader;
+    pRing->slot = (sRingSlot *)(pHeader +1);
+    pRing->mask = slots -1;
     pRing->size = size;
-    *(pRing->end) = '\0';
         
     memcpy( pRing->_magic, MAGIC_RING, MAGIC_MAX_LENGTH );
     memcpy( pRing->_magic2, MAGIC_RING, MAGIC_MAX_LENGTH );
-    memcpy( ptr, MAGIC_RINGBUFFER_TAG_1, strlen( MAGIC_RINGBUFFER_TAG_1 ));
-    memcpy( pRing->end +1, MAGIC_RINGBUFFER_TAG_2, strlen( MAGIC_RINGBUFFER_TAG_2 ));
-    memset( pRing->buffer, 0xff, size );
     
     pApp->channel = (void *)pRing;
     
@@ -160,7 +261,11 @@ static int ringClose( sAppender *pApp )
     
     pRing = (sRing *)pApp->channel;
     if( pRing != NULL ) {
-        free( pRing->buffer - strlen( MAGIC_RINGBUFFER_TAG_1 ));
+        if( pRing->mapped ) {
+            munmap( pRing->header, pRing->size );
+        } else {
+            free( pRing->header );
+        }
         free( pRing );
         pApp->channel = NULL;
     }
@@ -170,37 +275,41 @@ static int ringClose( sAppender *pApp )
 
 static int ringLog( sAppender *pApp, unsigned int level, char *message )
 {
-    sRing   *pRing;
-    int     len;
-    int     wraparound;
+    sRing       *pRing;
+    sRingSlot   *pSlot;
+    uint32_t    seq;
+    int         len;
+    int         chunk;
+    int         fragments;
+    int         idx;
     
     if( (pRing = pApp->channel) != NULL ) {
-        len = strlen( message ) +1;         // include '\0'
-        wraparound = ((pRing->tail + len) >= pRing->end) ? 1 : 0;
+        len = strlen( message );
+        if( len > RING_MAX_RECORD -1 ) len = RING_MAX_RECORD -1;
+        fragments = (len > 0) ? (len + RING_SLOT_TEXT -1) / RING_SLOT_TEXT : 1;
+        if( (uint32_t)fragments > pRing->mask +1 ) {
+            fragments = (int)(pRing->mask +1);
+            len = fragments * RING_SLOT_TEXT;
+        }
         
-        if( pRing->tail >= pRing->head && wraparound == 0 ) {
-            memcpy( pRing->tail, message, len );
-            pRing->tail += len;
-        } else {
-            if( wraparound == 1 ) {
-                memcpy( pRing->tail, message, pRing->end - pRing->tail );
-                memcpy( pRing->buffer, &message[pRing->end - pRing->tail], len - (pRing->end - pRing->tail) );
-                pRing->tail = pRing->buffer + len - (pRing->end - pRing->tail);
-                pRing->head = pRing->buffer;
-            } else {
-                memcpy( pRing->tail, message, len );     // include '\0'
-                pRing->tail += len;
-            }
-            if( pRing->tail >= pRing->head ) {
-                // advance head if old entry partly overwritten
-                pRing->head = (pRing->tail < (pRing->end -1)) ? pRing->tail +1 : pRing->buffer;
-                while( *pRing->head != '\0' ) {
-                    pRing->head++;
-                    if( pRing->head >= pRing->end ) pRing->head = pRing->buffer;
-                }
-                pRing->head++;
-                if( pRing->head >= pRing->end ) pRing->head = pRing->buffer;
-            }
+        // reserve slots - oldest entries are overwritten
+        seq = __sync_fetch_and_add( &pRing->header->next, fragments );
+        
+        for( idx = 0; idx < fragments; idx++ ) {
+            pSlot = &pRing->slot[(seq + idx) & pRing->mask];
+            chunk = (len > RING_SLOT_TEXT) ? RING_SLOT_TEXT : len;
+            
+            pSlot->seq = 0;
+            __sync_synchronize();
+            pSlot->fragment = idx;
+            pSlot->fragments = fragments;
+            pSlot->len = chunk;
+            memcpy( pSlot->text, message, chunk );
+            __sync_synchronize();
+            pSlot->seq = seq + idx +1;
+            
+            message += chunk;
+            len -= chunk;
         }
         return( ZLOG_NO_ERROR );
     }
@@ -212,6 +321,8 @@ static int ringLog( sAppender *pApp, unsigned int level, char *message )
 /*!
  * \brief Dump contents of ring to appender
  * 
+ * Entries which have been partly overwritten or are still being written are skipped.
+ * 
  * \param       aRing               pointer to ring appender
  * \param       aOut                pointer to output appender
  * 
@@ -219,25 +330,48 @@ static int ringLog( sAppender *pApp, unsigned int level, char *message )
  */
 void ringDump( sAppender *aRing, sAppender *aOut )
 {
-    sRing   *pRing;
-    char    *line;
+    sRing       *pRing;
+    sRingSlot   *pSlot;
+    char        line[RING_MAX_RECORD];
+    uint32_t    seq;
+    uint32_t    end;
+    int         fragments;
+    int         len;
+    int         idx;
     
     if( (pRing = aRing->channel) != NULL ) {
-        line = pRing->head;
-        if( pRing->tail < pRing->head ) {
-            // must wraparound
-            while( line < pRing->end ) {
+        end = pRing->header->next;
+        seq = pRing->header->dumped;
+        if( end - seq > pRing->mask +1 ) {
+            seq = end - (pRing->mask +1);
+        }
+        while( seq != end ) {
+            pSlot = &pRing->slot[seq & pRing->mask];
+            if( pSlot->seq != seq +1 || pSlot->fragment != 0 ) {
+                // overwritten, in progress, or start of entry already evicted
+                seq++;
+                continue;
+            }
+            fragments = pSlot->fragments;
+            len = 0;
+            for( idx = 0; idx < fragments && seq + idx != end; idx++ ) {
+                pSlot = &pRing->slot[(seq + idx) & pRing->mask];
+                if( pSlot->seq != seq + idx +1 || pSlot->fragment != idx ) break;
+                if( len + pSlot->len >= RING_MAX_RECORD ) break;
+                memcpy( &line[len], pSlot->text, pSlot->len );
+                len += pSlot->len;
+                __sync_synchronize();
+                if( pSlot->seq != seq + idx +1 ) break;
+            }
+            if( idx == fragments ) {
+                line[len] = '\0';
                 (*aOut->plugin->log)( aOut, zlogLevelDebug, line );
-                line += strlen( line ) +1;
+                seq += fragments;
+            } else {
+                seq++;
             }
-            line = pRing->buffer;
-        }
-        while( line < pRing->tail ) {
-            (*aOut->plugin->log)( aOut, zlogLevelDebug, line );
-            line += strlen( line ) +1;
         }
-        pRing->head = pRing->buffer;
-        pRing->tail = pRing->buffer;
+        pRing->header->dumped = end;
     }
 }
 
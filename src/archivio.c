@@ -0,0 +1,445 @@
+/*
+ * File:   archivio.c
+ *
+ * Archivio compresso dei telegrammi grezzi (vedi archivio.h per il formato).
+ * La scrittura e' la sink "raw:<dir>", la lettura archivio_read().
+ */
+
+#include "archivio.h"
+#include "sink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <lz4.h>
+
+
+typedef struct
+{
+    char dir[256];
+    int fd;
+    int64_t giornoInizio;                   // ms, giorno (ora locale) del file aperto
+    int64_t giornoFine;
+    time_t inizio;                          // quando e' stato aggiunto il primo record del blocco
+    ArchivioIndice indice;                  // indice del blocco in costruzione
+    uint32_t len;
+    unsigned char buf[ARCHIVIO_BLOCCO];
+    unsigned char *uscita;                  // indice + payload compresso
+} Archivio;
+
+
+unsigned int archivio_bit(uint16_t destinatario, int group)
+{
+    uint32_t chiave = ((uint32_t)(group != 0) << 16) | destinatario;
+
+    return ((chiave * 2654435761u) >> 20) % ARCHIVIO_BITMAP;
+}
+
+
+static int archivio_write_all(int fd, unsigned char *buf, size_t len)
+{
+    ssize_t n;
+
+    while( len > 0 )
+    {
+        n = write(fd, buf, len);
+        if( n < 0 )
+        {
+            if( errno == EINTR ) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+
+static int archivio_scrivi_blocco(Archivio *a)
+{
+    ArchivioIndice *indice = (ArchivioIndice*) a->uscita;
+    unsigned char *payload = a->uscita + sizeof(ArchivioIndice);
+    int n;
+    int ret;
+
+    if( a->indice.record == 0 )
+    {
+        return 0;
+    }
+
+    n = LZ4_compress_default((char*) a->buf, (char*) payload, a->len, LZ4_compressBound(ARCHIVIO_BLOCCO));
+    if( n <= 0 || (uint32_t) n >= a->len )
+    {
+        memcpy(payload, a->buf, a->len);
+        n = a->len;
+    }
+    a->indice.compresso = n;
+    a->indice.originale = a->len;
+    memcpy(indice, &a->indice, sizeof(ArchivioIndice));
+
+    ret = archivio_write_all(a->fd, a->uscita, sizeof(ArchivioIndice) + n);
+
+    memset(&a->indice, 0, sizeof(ArchivioIndice));
+    a->len = 0;
+    return ret;
+}
+
+
+static int archivio_recupera(int fd, off_t size)
+{
+    /*
+     *  scorre gli indici dei blocchi e tronca un eventuale blocco incompleto in coda
+     */
+    ArchivioIndice indice;
+    off_t offset = ARCHIVIO_HEADER_SIZE;
+
+    while( offset + (off_t) sizeof(ArchivioIndice) <= size )
+    {
+        if( pread(fd, &indice, sizeof(indice), offset) != sizeof(indice) ||
+            memcmp(indice.magic, ARCHIVIO_BLOCCO_MAGIC, 4) != 0 ||
+            offset + (off_t) sizeof(indice) + indice.compresso > size )
+        {
+            break;
+        }
+        offset += sizeof(indice) + indice.compresso;
+    }
+    if( offset != size )
+    {
+        return ftruncate(fd, offset);
+    }
+    return 0;
+}
+
+
+static int archivio_apri_giorno(Archivio *a, int64_t tempo)
+{
+    char path[300];
+    struct tm local;
+    struct stat st;
+    time_t secondi = tempo / 1000;
+
+    if( a->fd >= 0 )
+    {
+        archivio_scrivi_blocco(a);
+        close(a->fd);
+        a->fd = -1;
+    }
+
+    localtime_r(&secondi, &local);
+    snprintf(path, sizeof(path), "%s/%04d%02d%02d.knx", a->dir,
+             local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+    local.tm_hour = 0;
+    local.tm_min = 0;
+    local.tm_sec = 0;
+    local.tm_isdst = -1;
+    a->giornoInizio = (int64_t) mktime(&local) * 1000;
+    local.tm_mday++;
+    local.tm_isdst = -1;
+    a->giornoFine = (int64_t) mktime(&local) * 1000;
+
+    a->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if( a->fd < 0 || fstat(a->fd, &st) != 0 )
+    {
+        fprintf(stderr, "Cannot open raw archive %s: %s\n", path, strerror(errno));
+        if( a->fd >= 0 ) close(a->fd);
+        a->fd = -1;
+        return 1;
+    }
+    if( st.st_size < ARCHIVIO_HEADER_SIZE )
+    {
+        if( ftruncate(a->fd, 0) != 0 ||
+            archivio_write_all(a->fd, (unsigned char*) ARCHIVIO_MAGIC, ARCHIVIO_HEADER_SIZE) != 0 )
+        {
+            close(a->fd);
+            a->fd = -1;
+            return 1;
+        }
+    }
+    else if( archivio_recupera(a->fd, st.st_size) != 0 )
+    {
+        close(a->fd);
+        a->fd = -1;
+        return 1;
+    }
+    return 0;
+}
+
+
+static int archivio_aggiungi(Archivio *a, SinkRecord *record)
+{
+    unsigned char *p;
+    uint32_t delta;
+    unsigned int bit;
+    int lunghezza = (record->lunghezza <= SINK_CEMI_MAX) ? record->lunghezza : SINK_CEMI_MAX;
+
+    if( a->fd < 0 || record->tempo < a->giornoInizio || record->tempo >= a->giornoFine )
+    {
+        if( archivio_apri_giorno(a, record->tempo) != 0 )
+        {
+            return 1;
+        }
+    }
+    if( a->len + ARCHIVIO_RECORD_HEADER + lunghezza > ARCHIVIO_BLOCCO )
+    {
+        if( archivio_scrivi_blocco(a) != 0 )
+        {
+            return 1;
+        }
+    }
+
+    if( a->indice.record == 0 )
+    {
+        memcpy(a->indice.magic, ARCHIVIO_BLOCCO_MAGIC, 4);
+        a->indice.tempoMin = record->tempo;
+        a->indice.tempoMax = record->tempo;
+        a->inizio = time(NULL);
+    }
+    //se l'orologio torna indietro il record resta nel blocco con il tempo minimo
+    delta = (record->tempo > a->indice.tempoMin) ? (uint32_t)(record->tempo - a->indice.tempoMin) : 0;
+    if( record->tempo > a->indice.tempoMax )
+    {
+        a->indice.tempoMax = record->tempo;
+    }
+    bit = archivio_bit(record->destinatario, record->group);
+    a->indice.indirizzi[bit / 8] |= 1 << (bit % 8);
+    a->indice.record++;
+
+    p = a->buf + a->len;
+    memcpy(p, &delta, 4);
+    memcpy(p + 4, &record->destinatario, 2);
+    p[6] = record->group;
+    p[7] = lunghezza;
+    memcpy(p + ARCHIVIO_RECORD_HEADER, record->cemi, lunghezza);
+    a->len += ARCHIVIO_RECORD_HEADER + lunghezza;
+    return 0;
+}
+
+
+static int sink_raw_open(Sink *sink, char *opzioni, SinkConfig *config)
+{
+    Archivio *a;
+
+    a = (Archivio*) calloc(1, sizeof(Archivio));
+    if( a == NULL )
+    {
+        return 1;
+    }
+    a->uscita = (unsigned char*) malloc(sizeof(ArchivioIndice) + LZ4_compressBound(ARCHIVIO_BLOCCO));
+    if( a->uscita == NULL )
+    {
+        free(a);
+        return 1;
+    }
+    snprintf(a->dir, sizeof(a->dir), "%s", (opzioni[0] != 0) ? opzioni : "edc_raw");
+    if( mkdir(a->dir, 0755) != 0 && errno != EEXIST )
+    {
+        free(a->uscita);
+        free(a);
+        return 1;
+    }
+    a->fd = -1;
+    sink->dati = a;
+    return 0;
+}
+
+
+static int sink_raw_write_batch(Sink *sink, SinkRecord *records, int n)
+{
+    Archivio *a = (Archivio*) sink->dati;
+    int errori = 0;
+    int i;
+
+    for( i = 0; i < n; i++ )
+    {
+        errori += archivio_aggiungi(a, &records[i]);
+    }
+    //con traffico continuo flush non viene chiamata
+    if( a->indice.record > 0 && time(NULL) - a->inizio >= ARCHIVIO_FLUSH )
+    {
+        errori += archivio_scrivi_blocco(a);
+    }
+    return (errori > 0);
+}
+
+
+static int sink_raw_flush(Sink *sink)
+{
+    //i blocchi parziali comprimono male: si scrivono solo dopo ARCHIVIO_FLUSH secondi
+    Archivio *a = (Archivio*) sink->dati;
+
+    if( a->indice.record > 0 && time(NULL) - a->inizio >= ARCHIVIO_FLUSH )
+    {
+        return archivio_scrivi_blocco(a);
+    }
+    return 0;
+}
+
+
+static void sink_raw_close(Sink *sink)
+{
+    Archivio *a = (Archivio*) sink->dati;
+
+    if( a->fd >= 0 )
+    {
+        archivio_scrivi_blocco(a);
+        close(a->fd);
+    }
+    free(a->uscita);
+    free(a);
+    sink->dati = NULL;
+}
+
+
+int archivio_read(char *file, int64_t from, int64_t to, int filtraIndirizzo,
+                  uint16_t destinatario, int group, ArchivioCallback callback, void *arg)
+{
+    /*
+     *  legge i telegrammi con from <= tempo <= to (ms) e, se filtraIndirizzo,
+     *  diretti a destinatario / group
+     *  return >= 0: numero di telegrammi passati alla callback
+     *  return -1: file non leggibile o intestazione non valida
+     */
+    ArchivioIndice indice;
+    unsigned char header[ARCHIVIO_HEADER_SIZE];
+    unsigned char *payload;
+    unsigned char *blocco;
+    unsigned char *p;
+    unsigned char *fine;
+    off_t offset = ARCHIVIO_HEADER_SIZE;
+    unsigned int bit = archivio_bit(destinatario, group);
+    uint32_t delta;
+    uint16_t dst;
+    int64_t tempo;
+    int letti = 0;
+    int stop = 0;
+    int fd;
+
+    fd = open(file, O_RDONLY);
+    if( fd < 0 )
+    {
+        return -1;
+    }
+    if( pread(fd, header, ARCHIVIO_HEADER_SIZE, 0) != ARCHIVIO_HEADER_SIZE ||
+        memcmp(header, ARCHIVIO_MAGIC, ARCHIVIO_HEADER_SIZE) != 0 )
+    {
+        close(fd);
+        return -1;
+    }
+
+    payload = (unsigned char*) malloc(LZ4_compressBound(ARCHIVIO_BLOCCO));
+    blocco = (unsigned char*) malloc(ARCHIVIO_BLOCCO);
+    if( payload == NULL || blocco == NULL )
+    {
+        free(payload);
+        free(blocco);
+        close(fd);
+        return -1;
+    }
+
+    while( !stop && pread(fd, &indice, sizeof(indice), offset) == sizeof(indice) &&
+           memcmp(indice.magic, ARCHIVIO_BLOCCO_MAGIC, 4) == 0 &&
+           indice.originale <= ARCHIVIO_BLOCCO && indice.compresso <= (uint32_t) LZ4_compressBound(ARCHIVIO_BLOCCO) )
+    {
+        offset += sizeof(indice);
+
+        //solo l'indice: il blocco viene letto e decompresso se puo' contenere telegrammi richiesti
+        if( indice.tempoMax < from || indice.tempoMin > to ||
+            (filtraIndirizzo && !(indice.indirizzi[bit / 8] & (1 << (bit % 8)))) )
+        {
+            offset += indice.compresso;
+            continue;
+        }
+
+        if( pread(fd, payload, indice.compresso, offset) != (ssize_t) indice.compresso )
+        {
+            break;
+        }
+        offset += indice.compresso;
+        if( indice.compresso == indice.originale )
+        {
+            memcpy(blocco, payload, indice.originale);
+        }
+        else if( LZ4_decompress_safe((char*) payload, (char*) blocco, indice.compresso, ARCHIVIO_BLOCCO) != (int) indice.originale )
+        {
+            fprintf(stderr, "Raw archive %s: corrupted block at %lld\n", file, (long long) offset);
+            continue;
+        }
+
+        p = blocco;
+        fine = blocco + indice.originale;
+        while( p + ARCHIVIO_RECORD_HEADER <= fine && p + ARCHIVIO_RECORD_HEADER + p[7] <= fine )
+        {
+            memcpy(&delta, p, 4);
+            memcpy(&dst, p + 4, 2);
+            tempo = indice.tempoMin + delta;
+            if( tempo >= from && tempo <= to &&
+                (!filtraIndirizzo || (dst == destinatario && p[6] == (group != 0))) )
+            {
+                letti++;
+                if( callback(tempo, dst, p[6], p + ARCHIVIO_RECORD_HEADER, p[7], arg) != 0 )
+                {
+                    stop = 1;
+                    break;
+                }
+            }
+            p += ARCHIVIO_RECORD_HEADER + p[7];
+        }
+    }
+
+    free(payload);
+    free(blocco);
+    close(fd);
+    return letti;
+}
+
+
+int archivio_read_range(char *dir, int64_t from, int64_t to, int filtraIndirizzo,
+                        uint16_t destinatario, int group, ArchivioCallback callback, void *arg)
+{
+    /*
+     *  come archivio_read su tutti i file giornalieri della directory tra from e to
+     *  (i giorni senza file vengono saltati)
+     *  return: numero di telegrammi passati alla callback
+     */
+    char path[300];
+    struct tm local;
+    time_t giorno = from / 1000;
+    int letti = 0;
+    int n;
+
+    localtime_r(&giorno, &local);
+    local.tm_hour = 0;
+    local.tm_min = 0;
+    local.tm_sec = 0;
+    local.tm_isdst = -1;
+    for( giorno = mktime(&local); (int64_t) giorno * 1000 <= to; giorno = mktime(&local) )
+    {
+        snprintf(path, sizeof(path), "%s/%04d%02d%02d.knx", dir,
+                 local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+        n = archivio_read(path, from, to, filtraIndirizzo, destinatario, group, callback, arg);
+        if( n > 0 )
+        {
+            letti += n;
+        }
+        local.tm_mday++;
+        local.tm_hour = 0;
+        local.tm_isdst = -1;
+    }
+    return letti;
+}
+
+
+const SinkOps sink_raw_ops =
+{
+    "raw",
+    sink_raw_open,
+    sink_raw_write_batch,
+    sink_raw_flush,
+    sink_raw_close
+};
@@ -0,0 +1,71 @@
+/*
+ * File:   archivio.h
+ *
+ * Archivio compresso di lungo periodo dei telegrammi grezzi (CEMI), per
+ * poterli rileggere e ridecodificare in seguito.
+ *
+ * Un file per giorno, <dir>/<AAAAMMGG>.knx: intestazione ARCHIVIO_MAGIC
+ * seguita da blocchi. Ogni blocco raccoglie fino a ARCHIVIO_BLOCCO byte di
+ * record, compressi con LZ4, preceduti dal loro indice:
+ *
+ *   indice:   ArchivioIndice (host order) - dimensioni, numero di record,
+ *             tempo minimo e massimo, mappa degli indirizzi destinatari
+ *   payload:  record compressi (non compressi se LZ4 non riduce il blocco)
+ *   record:   uint32 ms dal tempoMin del blocco, uint16 destinatario,
+ *             uint8 gruppo, uint8 lunghezza, <lunghezza> byte di telegramma
+ *
+ * In lettura si scorrono solo gli indici (lseek sul payload): un blocco
+ * viene decompresso soltanto se l'intervallo di tempo si sovrappone a quello
+ * richiesto e la mappa contiene l'indirizzo cercato. La mappa e' un insieme
+ * di bit indicizzato da un hash dell'indirizzo, quindi puo' dare falsi
+ * positivi, che vengono scartati dopo la decompressione.
+ *
+ * Un blocco parziale viene scritto dopo ARCHIVIO_FLUSH secondi, cosi' un
+ * arresto anomalo perde al piu' quell'intervallo; un blocco incompleto in
+ * coda al file viene troncato alla riapertura.
+ */
+
+#ifndef _ARCHIVIO_H
+#define	_ARCHIVIO_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define ARCHIVIO_MAGIC          "EDCRAW01"
+#define ARCHIVIO_HEADER_SIZE    8
+#define ARCHIVIO_BLOCCO_MAGIC   "BLK1"
+#define ARCHIVIO_BLOCCO         65536       // byte di record per blocco, prima della compressione
+#define ARCHIVIO_BITMAP         4096        // bit della mappa degli indirizzi
+#define ARCHIVIO_FLUSH          60          // secondi massimi di permanenza di un blocco in memoria
+#define ARCHIVIO_RECORD_HEADER  8
+
+typedef struct __attribute__((packed))
+{
+    char magic[4];
+    uint32_t compresso;                     // byte di payload nel file
+    uint32_t originale;                     // byte dei record; == compresso se non compresso
+    uint32_t record;
+    int64_t tempoMin;                       // ms dal 1970
+    int64_t tempoMax;
+    uint8_t indirizzi[ARCHIVIO_BITMAP / 8];
+} ArchivioIndice;
+
+/* chiamata per ogni telegramma letto, un valore diverso da 0 interrompe la lettura */
+typedef int (*ArchivioCallback)(int64_t tempo, uint16_t destinatario, int group,
+                                unsigned char *cemi, int lunghezza, void *arg);
+
+
+unsigned int archivio_bit(uint16_t destinatario, int group);
+int archivio_read(char *file, int64_t from, int64_t to, int filtraIndirizzo,
+                  uint16_t destinatario, int group, ArchivioCallback callback, void *arg);
+int archivio_read_range(char *dir, int64_t from, int64_t to, int filtraIndirizzo,
+                        uint16_t destinatario, int group, ArchivioCallback callback, void *arg);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _ARCHIVIO_H */
@@ -9,7 +9,7 @@ static int ask_password = 0; /* whether to solicit password */
 //static MYSQL *conn; /* pointer to connection handler */
 
 
-int start_db_connection(MYSQL **conn, char* user, char* pwd, char* ip, int porta, char* dbname)
+static int db_connect(MYSQL **conn, char* user, char* pwd, char* ip, int porta, char* dbname, int localInfile)
 {
     /*
      *  returned value:
@@ -17,6 +17,8 @@ int start_db_connection(MYSQL **conn, char* user, char* pwd, char* ip, int porta
      *  1: connection failed
      *  2: mysql init failed
      */
+    unsigned int abilita = 1;
+    unsigned int timeout = DB_CONNECT_TIMEOUT;
 
     /* initialize connection handler */
     *conn = mysql_init(NULL);
@@ -26,14 +28,36 @@ int start_db_connection(MYSQL **conn, char* user, char* pwd, char* ip, int porta
         return 2;
     }
 
+    //un server irraggiungibile non deve fermare a lungo il ciclo di cattura
+    mysql_options(*conn, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+    if( localInfile )
+    {
+        mysql_options(*conn, MYSQL_OPT_LOCAL_INFILE, &abilita);
+    }
+
     if (mysql_real_connect(*conn, ip, user, pwd, dbname, porta, "/var/run/mysqld/mysqld.sock", 0) == NULL)
     {
         printf("mysql_real_connect() failed");
         mysql_close(*conn);
+        *conn = NULL;
         return 1;
     }
 
+    return 0;
+}
+
+int start_db_connection(MYSQL **conn, char* user, char* pwd, char* ip, int porta, char* dbname)
+{
+    return db_connect(conn, user, pwd, ip, porta, dbname, 0);
+}
 
+int start_db_connection_infile(MYSQL **conn, char* user, char* pwd, char* ip, int porta, char* dbname)
+{
+    /*
+     *  come start_db_connection, abilitando LOAD DATA LOCAL INFILE; il contenuto
+     *  viene fornito dal gestore impostato con mysql_set_local_infile_handler()
+     */
+    return db_connect(conn, user, pwd, ip, porta, dbname, 1);
 }
 //    process_prepared_statements(conn, energia);
 
@@ -49,6 +73,7 @@ int close_db_connection(MYSQL **conn)
     if( *conn != NULL )
     {
         mysql_close(*conn);
+        *conn = NULL;
         return 0;
     }
     return 1;
@@ -23,6 +23,7 @@
 extern "C" {
 #endif
 
+#define DB_CONNECT_TIMEOUT  5       // secondi massimi di attesa del server alla connessione
     
 void print_stmt_error(MYSQL_STMT *stmt, char *message);
 void print_error(MYSQL *conn, char *message);
@@ -30,6 +31,7 @@ void str_unfill(char* str, char toDelete);
 
 
 int start_db_connection(MYSQL **conn, char* user, char* pwd, char* ip, int porta, char* dbname);
+int start_db_connection_infile(MYSQL **conn, char* user, char* pwd, char* ip, int porta, char* dbname);
 int close_db_connection(MYSQL **conn);
 
 
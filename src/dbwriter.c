@@ -0,0 +1,241 @@
+/*
+ * File:   dbwriter.c
+ *
+ * Thread di scrittura dei rollup e di stato_corrente (vedi dbwriter.h).
+ */
+
+#include "dbwriter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+
+
+static int dbwriter_attendi(DbWriter *w, int secondi)
+{
+    /*
+     *  pausa prima di un nuovo tentativo, interrotta dalla chiusura
+     *  return 1: chiusura richiesta
+     */
+    struct timeval now;
+    struct timespec scadenza;
+    int stop;
+
+    gettimeofday(&now, NULL);
+    scadenza.tv_sec = now.tv_sec + secondi;
+    scadenza.tv_nsec = now.tv_usec * 1000;
+
+    pthread_mutex_lock(&w->mutex);
+    while( !w->stop )
+    {
+        if( pthread_cond_timedwait(&w->cond, &w->mutex, &scadenza) == ETIMEDOUT )
+        {
+            break;
+        }
+    }
+    stop = w->stop;
+    pthread_mutex_unlock(&w->mutex);
+    return stop;
+}
+
+
+static void *dbwriter_thread(void *arg)
+{
+    DbWriter *w = (DbWriter*) arg;
+    MYSQL *conn = NULL;
+    DbWriterJob *job;
+    int abbandona = 0;              // in chiusura con il database irraggiungibile
+    int attesa;
+    int ret;
+
+    mysql_thread_init();
+
+    pthread_mutex_lock(&w->mutex);
+    for( ;; )
+    {
+        while( w->testa == NULL && !w->stop )
+        {
+            pthread_cond_wait(&w->cond, &w->mutex);
+        }
+        if( w->testa == NULL )
+        {
+            break;
+        }
+        job = w->testa;
+        w->testa = job->next;
+        if( w->testa == NULL )
+        {
+            w->coda = NULL;
+        }
+        w->conteggio--;
+        pthread_mutex_unlock(&w->mutex);
+
+        //le righe restano in memoria finche' il database non risponde
+        ret = 3;
+        for( attesa = 1; !abbandona; attesa = (attesa * 2 < SINK_RETRY_MAX) ? attesa * 2 : SINK_RETRY_MAX )
+        {
+            if( conn == NULL )
+            {
+                start_db_connection(&conn, w->dbUser, w->dbPwd, w->dbIP, w->dbPort, w->dbDatabase);
+            }
+            ret = 3;
+            if( conn != NULL )
+            {
+                ret = (job->tabella != NULL) ? insert_rollup(conn, job->tabella, (RollupRow*) job->rows, job->n) :
+                                               upsert_stato(conn, (StatoRow*) job->rows, job->n);
+            }
+            if( ret != 3 )
+            {
+                break;
+            }
+
+            close_db_connection(&conn);
+            if( attesa == 1 )
+            {
+                fprintf(stderr, "Rollup / stato_corrente: database unavailable, retrying\n");
+            }
+            if( dbwriter_attendi(w, attesa) )
+            {
+                abbandona = 1;
+            }
+        }
+
+        pthread_mutex_lock(&w->mutex);
+        if( !abbandona && ret == 0 )
+        {
+            w->scritte += job->n;
+        }
+        else
+        {
+            w->perse += job->n;
+        }
+        free(job->rows);
+        free(job);
+    }
+    pthread_mutex_unlock(&w->mutex);
+
+    close_db_connection(&conn);
+    mysql_thread_end();
+    return NULL;
+}
+
+
+DbWriter *dbwriter_create(char *user, char *pwd, char *ip, int porta, char *dbname)
+{
+    /*
+     *  avvia il thread di scrittura; la connessione viene aperta dal thread
+     *  return NULL: memoria insufficiente o thread non avviato
+     */
+    DbWriter *w;
+
+    w = (DbWriter*) calloc(1, sizeof(DbWriter));
+    if( w == NULL )
+    {
+        return NULL;
+    }
+    w->dbUser = user;
+    w->dbPwd = pwd;
+    w->dbIP = ip;
+    w->dbPort = porta;
+    w->dbDatabase = dbname;
+    pthread_mutex_init(&w->mutex, NULL);
+    pthread_cond_init(&w->cond, NULL);
+    if( pthread_create(&w->thread, NULL, dbwriter_thread, w) != 0 )
+    {
+        pthread_mutex_destroy(&w->mutex);
+        pthread_cond_destroy(&w->cond);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+
+static int dbwriter_accoda(DbWriter *w, char *tabella, void *rows, size_t size, int n)
+{
+    /*
+     *  copia le righe in coda senza attendere la scrittura
+     *  return 1: memoria insufficiente, le righe non sono state accodate
+     */
+    DbWriterJob *job;
+    DbWriterJob *vecchio;
+
+    job = (DbWriterJob*) malloc(sizeof(DbWriterJob));
+    if( job == NULL )
+    {
+        return 1;
+    }
+    job->rows = malloc(n * size + 1);
+    if( job->rows == NULL )
+    {
+        free(job);
+        return 1;
+    }
+    memcpy(job->rows, rows, n * size);
+    job->tabella = tabella;
+    job->n = n;
+    job->next = NULL;
+
+    pthread_mutex_lock(&w->mutex);
+    if( w->conteggio >= DBWRITER_CODA )
+    {
+        vecchio = w->testa;
+        w->testa = vecchio->next;
+        w->conteggio--;
+        w->perse += vecchio->n;
+        fprintf(stderr, "Rollup / stato_corrente: queue full, %d rows lost\n", vecchio->n);
+        free(vecchio->rows);
+        free(vecchio);
+    }
+    if( w->coda != NULL )
+    {
+        w->coda->next = job;
+    }
+    else
+    {
+        w->testa = job;
+    }
+    w->coda = job;
+    w->conteggio++;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+    return 0;
+}
+
+
+int dbwriter_rollup(DbWriter *w, char *tabella, RollupRow *rows, int n)
+{
+    return dbwriter_accoda(w, tabella, rows, sizeof(RollupRow), n);
+}
+
+
+int dbwriter_stato(DbWriter *w, StatoRow *rows, int n)
+{
+    return dbwriter_accoda(w, NULL, rows, sizeof(StatoRow), n);
+}
+
+
+void dbwriter_destroy(DbWriter *w)
+{
+    /*
+     *  scrive quanto e' ancora in coda; se il database non risponde le righe
+     *  rimaste vengono scartate senza ulteriori tentativi
+     */
+    if( w == NULL )
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&w->mutex);
+    w->stop = 1;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+    pthread_join(w->thread, NULL);
+
+    printf("Rollup / stato_corrente: %lu rows written, %lu lost\n", w->scritte, w->perse);
+    pthread_mutex_destroy(&w->mutex);
+    pthread_cond_destroy(&w->cond);
+    free(w);
+}
@@ -0,0 +1,64 @@
+/*
+ * File:   dbwriter.h
+ *
+ * Scrittura in MySQL dei rollup e di stato_corrente fuori dal ciclo di
+ * cattura. Le righe vengono accodate e scritte da un thread con una propria
+ * connessione; se il database non risponde il thread riprova con attese
+ * crescenti fino a SINK_RETRY_MAX secondi tenendo le righe in coda, cosi'
+ * la decodifica dei telegrammi non si ferma mai ad aspettare il server.
+ * Oltre DBWRITER_CODA scritture in attesa si scartano le piu' vecchie.
+ */
+
+#ifndef _DBWRITER_H
+#define	_DBWRITER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+
+#include "dbconnection.h"
+
+#define DBWRITER_CODA       256         // scritture in attesa al massimo
+
+typedef struct DbWriterJob
+{
+    char *tabella;                      // rollup: tabella del livello, NULL = stato_corrente
+    void *rows;                         // RollupRow o StatoRow, di proprieta' della coda
+    int n;
+    struct DbWriterJob *next;
+} DbWriterJob;
+
+typedef struct
+{
+    char *dbUser;
+    char *dbPwd;
+    char *dbIP;
+    int dbPort;
+    char *dbDatabase;
+
+    //coda FIFO, protetta da mutex
+    DbWriterJob *testa;
+    DbWriterJob *coda;
+    int conteggio;
+    int stop;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+
+    unsigned long scritte;
+    unsigned long perse;                // righe scartate: coda piena o database irraggiungibile in chiusura
+} DbWriter;
+
+
+DbWriter *dbwriter_create(char *user, char *pwd, char *ip, int porta, char *dbname);
+int dbwriter_rollup(DbWriter *writer, char *tabella, RollupRow *rows, int n);
+int dbwriter_stato(DbWriter *writer, StatoRow *rows, int n);
+void dbwriter_destroy(DbWriter *writer);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _DBWRITER_H */
@@ -0,0 +1,337 @@
+/*
+ * File:   filtro.c
+ *
+ * Tabella in memoria dei filtri per indirizzo KNX (hash a liste concatenate).
+ */
+
+#include "filtro.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+static unsigned int filtro_hash(uint16_t indirizzo, int group)
+{
+    return (indirizzo ^ (indirizzo >> 10) ^ (group ? 0x200 : 0)) % FILTRO_BUCKETS;
+}
+
+
+void filtro_table_init(FiltroTable *table)
+{
+    memset(table, 0, sizeof(FiltroTable));
+}
+
+
+void filtro_table_clear(FiltroTable *table)
+{
+    int i;
+    FiltroEntry *entry;
+
+    for( i = 0; i < FILTRO_BUCKETS; i++ )
+    {
+        while( table->bucket[i] != NULL )
+        {
+            entry = table->bucket[i];
+            table->bucket[i] = entry->next;
+            free(entry);
+        }
+    }
+    table->count = 0;
+}
+
+
+void filtro_table_invalidate(FiltroTable *table)
+{
+    /*
+     *  prima di un ricaricamento: gli indirizzi non piu' presenti restano in
+     *  tabella ma non vengono registrati; l'ultimo valore registrato e' mantenuto
+     */
+    int i;
+    FiltroEntry *entry;
+
+    for( i = 0; i < FILTRO_BUCKETS; i++ )
+    {
+        for( entry = table->bucket[i]; entry != NULL; entry = entry->next )
+        {
+            entry->filtro.valid = 0;
+            entry->filtro.writable = 0;
+            entry->filtro.EIS = 0;
+            entry->filtro.pollInterval = 0;
+        }
+    }
+}
+
+
+Filtro *filtro_table_get(FiltroTable *table, uint16_t indirizzo, int group)
+{
+    FiltroEntry *entry;
+
+    group = (group != 0);
+    for( entry = table->bucket[filtro_hash(indirizzo, group)]; entry != NULL; entry = entry->next )
+    {
+        if( entry->indirizzo == indirizzo && entry->group == group )
+        {
+            return &entry->filtro;
+        }
+    }
+    return NULL;
+}
+
+
+Filtro *filtro_table_add(FiltroTable *table, uint16_t indirizzo, int group)
+{
+    /*
+     *  restituisce il filtro esistente per l'indirizzo oppure ne crea uno nuovo
+     *  inizializzato con initFiltro(). NULL se manca memoria.
+     */
+    FiltroEntry *entry;
+    Filtro *filtro;
+    unsigned int h;
+
+    group = (group != 0);
+    filtro = filtro_table_get(table, indirizzo, group);
+    if( filtro != NULL )
+    {
+        return filtro;
+    }
+
+    entry = (FiltroEntry*) malloc(sizeof(FiltroEntry));
+    if( entry == NULL )
+    {
+        return NULL;
+    }
+    entry->indirizzo = indirizzo;
+    entry->group = group;
+    initFiltro(&entry->filtro);
+    entry->filtro.valid = 1;
+
+    h = filtro_hash(indirizzo, group);
+    entry->next = table->bucket[h];
+    table->bucket[h] = entry;
+    table->count++;
+    return &entry->filtro;
+}
+
+
+int filtro_parse_address(char *text, uint16_t *indirizzo, int *group)
+{
+    /*
+     *  "1/2/3" -> indirizzo di gruppo, "1.1.1" -> indirizzo fisico
+     *  return 0: ok
+     *  return 1: formato non valido
+     */
+    unsigned int a, b, c;
+
+    if( sscanf(text, "%u/%u/%u", &a, &b, &c) == 3 && a < 16 && b < 8 && c < 256 )
+    {
+        *indirizzo = (a << 11) | (b << 8) | c;
+        *group = 1;
+        return 0;
+    }
+    if( sscanf(text, "%u.%u.%u", &a, &b, &c) == 3 && a < 16 && b < 16 && c < 256 )
+    {
+        *indirizzo = (a << 12) | (b << 8) | c;
+        *group = 0;
+        return 0;
+    }
+    return 1;
+}
+
+
+int filtro_table_load_file(FiltroTable *table, char *path)
+{
+    /*
+     *  formato del file, una riga per indirizzo:
+     *      <destinatario> <EIS> <writable> [<deadband> [<deadband%> [<minInterval> [<heartbeat> [<poll>]]]]]
+     *  es. "1/2/3 5 1 0.5 -1 0 900 300" (letto ogni 300 s se non trasmette da solo). Le righe che iniziano con # vengono ignorate.
+     *
+     *  return >= 0: numero di indirizzi caricati
+     *  return -1: impossibile aprire il file
+     */
+    FILE *file;
+    char line[256];
+    char destinatario[32];
+    long eis;
+    int writable;
+    float deadband, deadbandPerc;
+    int minInterval, heartbeat, pollInterval;
+    int campi;
+    uint16_t indirizzo;
+    int group;
+    int loaded = 0;
+    Filtro *filtro;
+
+    file = fopen(path, "r");
+    if( file == NULL )
+    {
+        return -1;
+    }
+
+    while( fgets(line, sizeof(line), file) != NULL )
+    {
+        deadband = -1;
+        deadbandPerc = -1;
+        minInterval = 0;
+        heartbeat = 0;
+        pollInterval = 0;
+        campi = sscanf(line, "%31s %ld %d %f %f %d %d %d", destinatario, &eis, &writable,
+                       &deadband, &deadbandPerc, &minInterval, &heartbeat, &pollInterval);
+        if( line[0] == '#' || campi < 3 )
+        {
+            continue;
+        }
+        if( filtro_parse_address(destinatario, &indirizzo, &group) != 0 )
+        {
+            printf("Indirizzo non valido nel file dei filtri: %s\n", destinatario);
+            continue;
+        }
+        filtro = filtro_table_add(table, indirizzo, group);
+        if( filtro == NULL )
+        {
+            break;
+        }
+        filtro->EIS = eis;
+        filtro->writable = (writable != 0);
+        filtro->deadband = deadband;
+        filtro->deadbandPerc = deadbandPerc;
+        filtro->minInterval = minInterval;
+        filtro->heartbeat = heartbeat;
+        filtro->pollInterval = pollInterval;
+        loaded++;
+    }
+
+    fclose(file);
+    return loaded;
+}
+
+
+int filtro_registra(Filtro *filtro, float valore, int64_t tempo)
+{
+    /*
+     *  decide se un valore va registrato secondo la politica dell'indirizzo,
+     *  confrontandolo con l'ultimo valore registrato
+     *  return 1: da registrare (lo stato in memoria viene aggiornato)
+     *  return 0: scartato
+     */
+    int64_t trascorso;
+    float diff;
+    int registra = 0;
+
+    if( !filtro->hasLast )
+    {
+        registra = 1;
+    }
+    else
+    {
+        trascorso = tempo - filtro->lastWrite;
+        diff = fabsf(valore - filtro->lastValue);
+
+        if( filtro->heartbeat > 0 && trascorso >= (int64_t)filtro->heartbeat * 1000 )
+        {
+            registra = 1;
+        }
+        else if( filtro->minInterval > 0 && trascorso < (int64_t)filtro->minInterval * 1000 )
+        {
+            registra = 0;
+        }
+        else if( filtro->deadband < 0 && filtro->deadbandPerc < 0 )
+        {
+            registra = 1;
+        }
+        else if( filtro->deadband >= 0 && diff > filtro->deadband )
+        {
+            registra = 1;
+        }
+        else if( filtro->deadbandPerc >= 0 && diff > fabsf(filtro->lastValue) * filtro->deadbandPerc / 100 )
+        {
+            registra = 1;
+        }
+    }
+
+    if( registra )
+    {
+        filtro->hasLast = 1;
+        filtro->lastValue = valore;
+        filtro->lastWrite = tempo;
+    }
+    return registra;
+}
+
+
+void filtro_format_address(uint16_t indirizzo, int group, char *text, int size)
+{
+    if( group )
+    {
+        snprintf(text, size, "%u/%u/%u", (indirizzo >> 11) & 0x0f, (indirizzo >> 8) & 0x07, indirizzo & 0xff);
+    }
+    else
+    {
+        snprintf(text, size, "%u.%u.%u", (indirizzo >> 12) & 0x0f, (indirizzo >> 8) & 0x0f, indirizzo & 0xff);
+    }
+}
+
+
+void filtro_stato_aggiorna(Filtro *filtro, float valore, int64_t tempo, uint16_t mittente)
+{
+    if( !isfinite(valore) )
+    {
+        return;
+    }
+    filtro->statoValore = valore;
+    filtro->statoTempo = tempo;
+    filtro->statoMittente = mittente;
+    filtro->statoDirty = 1;
+}
+
+
+int filtro_table_stato(FiltroTable *table, StatoRow **rows)
+{
+    /*
+     *  raccoglie gli indirizzi con stato modificato dall'ultima scrittura
+     *  return >= 0: numero di righe in *rows (da liberare con free)
+     *  return -1: memoria insufficiente
+     */
+    int i;
+    int n = 0;
+    FiltroEntry *entry;
+
+    *rows = (StatoRow*) malloc(table->count * sizeof(StatoRow) + 1);
+    if( *rows == NULL )
+    {
+        return -1;
+    }
+
+    for( i = 0; i < FILTRO_BUCKETS; i++ )
+    {
+        for( entry = table->bucket[i]; entry != NULL; entry = entry->next )
+        {
+            if( !entry->filtro.statoDirty )
+            {
+                continue;
+            }
+            filtro_format_address(entry->indirizzo, entry->group, (*rows)[n].destinatario, sizeof((*rows)[n].destinatario));
+            filtro_format_address(entry->filtro.statoMittente, 0, (*rows)[n].mittente, sizeof((*rows)[n].mittente));
+            (*rows)[n].tempo = entry->filtro.statoTempo;
+            (*rows)[n].valore = entry->filtro.statoValore;
+            n++;
+        }
+    }
+    return n;
+}
+
+
+void filtro_table_stato_scritto(FiltroTable *table)
+{
+    int i;
+    FiltroEntry *entry;
+
+    for( i = 0; i < FILTRO_BUCKETS; i++ )
+    {
+        for( entry = table->bucket[i]; entry != NULL; entry = entry->next )
+        {
+            entry->filtro.statoDirty = 0;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * File:   filtro.h
+ *
+ * Tabella in memoria dei filtri per indirizzo KNX.
+ * Sostituisce la SELECT sulla tabella filtro eseguita per ogni telegramma:
+ * la tabella viene caricata all'avvio (dal database o da file) e ricaricata
+ * periodicamente.
+ */
+
+#ifndef _FILTRO_H
+#define	_FILTRO_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "statement.h"
+
+#define FILTRO_BUCKETS      1024
+#define FILTRO_RELOAD       60      // secondi tra due ricaricamenti della tabella dal database
+
+typedef struct FiltroEntry
+{
+    uint16_t indirizzo;             // indirizzo KNX (host order)
+    my_bool group;                  // 1 = indirizzo di gruppo, 0 = indirizzo fisico
+    Filtro filtro;
+    struct FiltroEntry *next;
+} FiltroEntry;
+
+typedef struct
+{
+    FiltroEntry *bucket[FILTRO_BUCKETS];
+    int count;
+} FiltroTable;
+
+
+void filtro_table_init(FiltroTable *table);
+void filtro_table_clear(FiltroTable *table);
+void filtro_table_invalidate(FiltroTable *table);
+Filtro *filtro_table_get(FiltroTable *table, uint16_t indirizzo, int group);
+Filtro *filtro_table_add(FiltroTable *table, uint16_t indirizzo, int group);
+int filtro_table_load_file(FiltroTable *table, char *path);
+int load_filtro(MYSQL *conn, FiltroTable *table);
+int filtro_parse_address(char *text, uint16_t *indirizzo, int *group);
+int filtro_registra(Filtro *filtro, float valore, int64_t tempo);
+void filtro_format_address(uint16_t indirizzo, int group, char *text, int size);
+void filtro_stato_aggiorna(Filtro *filtro, float valore, int64_t tempo, uint16_t mittente);
+int filtro_table_stato(FiltroTable *table, StatoRow **rows);
+void filtro_table_stato_scritto(FiltroTable *table);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _FILTRO_H */
@@ -1,6 +1,13 @@
 
+#include "archivio.h"
 #include "dbconnection.h"
+#include "dbwriter.h"
 #include "eibtrace.h"
+#include "filtro.h"
+#include "rollup.h"
+#include "sink.h"
+#include "poll.h"
+#include "tsstore.h"
 
 
 #include <stdio.h>
@@ -15,6 +22,8 @@
 #include <math.h>
 #include <arpa/inet.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/poll.h>
 #include <pthread.h>
 #include <semaphore.h>
 
@@ -33,11 +42,47 @@ typedef struct
     char dbUser[50];
     char dbPwd[50];
     char dbDatabase[50];
+    char backend[16];       // "mysql" oppure "tsstore"
+    char tsDir[256];        // directory dell'archivio locale
+    int tsPerAddress;       // 1 = un segmento per indirizzo, 0 = un segmento per giorno
+    char filtroFile[256];   // se impostato i filtri vengono letti da file invece che dal database
+    int rollup;             // 1 = aggregati per minuto/quarto d'ora/ora/giorno nelle tabelle rollup_*
+    int statoFlush;         // secondi tra due aggiornamenti di stato_corrente, 0 = disattivato
+    int schema;             // 1 = tabella dati, 2 = tabella dati_v2 partizionata
+    int partizioniMese;     // partizioni di dati_v2: 0 = giornaliere, 1 = mensili
+    int retention;          // giorni di dati_v2 da conservare, 0 = tutti
+    char sink[SINK_MAX][300];   // destinazioni dei valori, "tipo[:opzioni]" (vedi sink.h), contiene anche "tsstore:" + tsDir
+    int nSink;
+    char sqliteSync[16];    // PRAGMA synchronous delle sink sqlite
+    long sqliteMmap;        // PRAGMA mmap_size in byte, 0 = default di SQLite
+    int sqliteBatch;        // righe per transazione
+    int sqliteCheckpoint;   // secondi tra due checkpoint del WAL, 0 = checkpoint automatico
+    char archivio[256];     // directory dell'archivio compresso dei telegrammi grezzi, "" = disattivato
+    char import[256];       // spool da importare nelle sink prima di uscire, "" = cattura normale
+    char tsRead[256];       // segmento tsstore da stampare prima di uscire, "" = cattura normale
+    char archivioRead[256]; // file o directory dell'archivio grezzo da stampare, "" = cattura normale
+    int64_t da;             // intervallo delle letture (-tsread, -archivioread), ms dal 1970
+    int64_t a;
+    int filtraIndirizzo;    // -archivioread solo per l'indirizzo indicato
+    uint16_t indirizzo;
+    int group;
+    int pollConnessioni;    // connessioni (letture contemporanee) per il polling, 0 = disattivato
+    int pollBudget;         // letture al secondo al massimo, 0 = nessun limite
+    int pollJitter;         // variazione casuale degli intervalli di polling, in %
 
 }EDC_Parameter;
 
+typedef struct
+{
+    MYSQL **conn;
+    EDC_Parameter *param;
+    DbWriter *writer;       // rollup e stato_corrente
+}EDC_Db;
+
 void init_EDC_Parameter(EDC_Parameter *param)
 {
+    //i campi copiati con strncpy restano sempre terminati
+    memset(param, 0, sizeof(EDC_Parameter));
     strcpy(param->eibID, "");
     strcpy(param->dbDatabase, "");
     param->dbPort = 0;
@@ -47,6 +92,483 @@ void init_EDC_Parameter(EDC_Parameter *param)
     strcpy(param->eibPwd, "");
     strcpy(param->eibTarget, "");
     strcpy(param->eibUser, "");
+    strcpy(param->backend, "mysql");
+    strcpy(param->tsDir, "edc_data");
+    param->tsPerAddress = 1;
+    strcpy(param->filtroFile, "");
+    param->rollup = 0;
+    param->statoFlush = 0;
+    param->schema = 1;
+    param->partizioniMese = 0;
+    param->retention = 0;
+    param->nSink = 0;
+    strcpy(param->sqliteSync, "NORMAL");
+    param->sqliteMmap = 0;
+    param->sqliteBatch = 1000;
+    param->sqliteCheckpoint = 30;
+    strcpy(param->archivio, "");
+    strcpy(param->import, "");
+    strcpy(param->tsRead, "");
+    strcpy(param->archivioRead, "");
+    param->da = 0;
+    param->a = INT64_MAX;
+    param->pollConnessioni = 0;
+    param->pollBudget = 5;
+    param->pollJitter = 10;
+}
+
+static volatile sig_atomic_t edc_stop = 0;
+
+static void edc_signal(int sig)
+{
+    edc_stop = 1;
+}
+
+static void edc_reconnect(EDC_Db *db)
+{
+    close_db_connection(db->conn);
+    start_db_connection(db->conn, db->param->dbUser, db->param->dbPwd, db->param->dbIP, db->param->dbPort, db->param->dbDatabase);
+}
+
+static int edc_rollup_writer(char *tabella, RollupRow *rows, int n, void *arg)
+{
+    //la scrittura avviene nel thread di dbwriter, il ciclo di cattura non attende il database
+    EDC_Db *db = (EDC_Db*) arg;
+
+    return dbwriter_rollup(db->writer, tabella, rows, n);
+}
+
+static void edc_stato_flush(FiltroTable *filtri, EDC_Db *db)
+{
+    //gli indirizzi non accodati restano modificati e vengono ripresi al prossimo giro
+    StatoRow *rows;
+    int n;
+
+    n = filtro_table_stato(filtri, &rows);
+    if( n < 0 )
+    {
+        return;
+    }
+    if( n > 0 && dbwriter_stato(db->writer, rows, n) == 0 )
+    {
+        filtro_table_stato_scritto(filtri);
+    }
+    free(rows);
+}
+
+static Sink *edc_create_sinks(EDC_Parameter *param, SinkConfig *sinkConfig)
+{
+    /*
+     *  crea le sink configurate, nell'ordine del file di configurazione
+     *  return NULL: una delle sink non e' stata aperta (le altre vengono chiuse)
+     */
+    Sink *sinks = NULL;
+    Sink *sink;
+    int i;
+
+    //senza sink configurate si usa il backend (compatibilita' con le versioni precedenti)
+    if( param->nSink == 0 )
+    {
+        if( strcmp(param->backend, "tsstore") == 0 )
+        {
+            snprintf(param->sink[0], sizeof(param->sink[0]), "tsstore:%s", param->tsDir);
+        }
+        else
+        {
+            strcpy(param->sink[0], "mysql");
+        }
+        param->nSink = 1;
+    }
+
+    sinkConfig->dbUser = param->dbUser;
+    sinkConfig->dbPwd = param->dbPwd;
+    sinkConfig->dbIP = param->dbIP;
+    sinkConfig->dbPort = param->dbPort;
+    sinkConfig->dbDatabase = param->dbDatabase;
+    sinkConfig->schema = param->schema;
+    sinkConfig->partizioniMese = param->partizioniMese;
+    sinkConfig->retention = param->retention;
+    sinkConfig->tsPerAddress = param->tsPerAddress;
+    sinkConfig->sqliteSynchronous = param->sqliteSync;
+    sinkConfig->sqliteMmap = param->sqliteMmap;
+    sinkConfig->sqliteBatch = param->sqliteBatch;
+    sinkConfig->sqliteCheckpoint = param->sqliteCheckpoint;
+    for( i = param->nSink - 1; i >= 0; i-- )
+    {
+        sink = sink_create(param->sink[i], sinkConfig);
+        if( sink == NULL )
+        {
+            sink_destroy_all(sinks);
+            return NULL;
+        }
+        printf( "Writing to sink '%s'\n", param->sink[i] );
+        sink->next = sinks;
+        sinks = sink;
+    }
+    return sinks;
+}
+
+typedef struct
+{
+    Sink *sinks;
+    SinkRecord lotto[SINK_BATCH];
+    int nLotto;
+}EDC_Import;
+
+static void edc_import_lotto(EDC_Import *import)
+{
+    Sink *sink;
+
+    //a differenza della cattura si attende la sink: nessun record deve andare perso
+    for( sink = import->sinks; sink != NULL; sink = sink->next )
+    {
+        sink_push_attendi(sink, import->lotto, import->nLotto);
+    }
+    import->nLotto = 0;
+}
+
+static int edc_import_record(SinkRecord *record, void *arg)
+{
+    EDC_Import *import = (EDC_Import*) arg;
+
+    import->lotto[import->nLotto++] = *record;
+    if( import->nLotto == SINK_BATCH )
+    {
+        edc_import_lotto(import);
+    }
+    return edc_stop;
+}
+
+static int edc_import(EDC_Parameter *param)
+{
+    /*
+     *  scrive nelle sink il contenuto di uno spool (sink spool:), per esempio
+     *  dopo un'interruzione del database; la sink mysql passa da sola a
+     *  LOAD DATA quando la coda supera SINK_BULK_SOGLIA record
+     */
+    static EDC_Import import;
+    SinkConfig sinkConfig;
+    int letti;
+
+    import.sinks = edc_create_sinks(param, &sinkConfig);
+    if( import.sinks == NULL )
+    {
+        return -3;
+    }
+    import.nLotto = 0;
+
+    signal(SIGINT, edc_signal);
+    signal(SIGTERM, edc_signal);
+    letti = spool_read(param->import, edc_import_record, &import);
+    if( import.nLotto > 0 )
+    {
+        edc_import_lotto(&import);
+    }
+    sink_destroy_all(import.sinks);
+
+    if( letti < 0 )
+    {
+        fprintf( stderr, "Cannot read spool file '%s'\n", param->import );
+        return -3;
+    }
+    printf( "Imported %d records from '%s'\n", letti, param->import );
+    return 0;
+}
+
+static int64_t edc_giorno(char *testo, int fine)
+{
+    /*
+     *  AAAAMMGG -> ms dal 1970 all'inizio del giorno, o all'ultimo ms del giorno se fine
+     *  return -1: data non valida
+     */
+    struct tm giorno;
+
+    memset(&giorno, 0, sizeof(giorno));
+    if( sscanf(testo, "%4d%2d%2d", &giorno.tm_year, &giorno.tm_mon, &giorno.tm_mday) != 3 )
+    {
+        return -1;
+    }
+    giorno.tm_year -= 1900;
+    giorno.tm_mon -= 1;
+    giorno.tm_mday += (fine != 0);
+    giorno.tm_isdst = -1;
+    return (int64_t) mktime(&giorno) * 1000 - (fine != 0);
+}
+
+static void edc_stampa_tempo(int64_t tempo)
+{
+    char testo[32];
+    time_t secondi = tempo / 1000;
+    struct tm locale;
+
+    localtime_r(&secondi, &locale);
+    strftime(testo, sizeof(testo), "%Y-%m-%d %H:%M:%S", &locale);
+    printf("%s.%03d", testo, (int)(tempo % 1000));
+}
+
+static int edc_ts_record(int64_t tempo, uint16_t mittente, uint16_t destinatario, int group, float valore, void *arg)
+{
+    char da[16];
+    char a[16];
+
+    filtro_format_address(mittente, 0, da, sizeof(da));
+    filtro_format_address(destinatario, group, a, sizeof(a));
+    edc_stampa_tempo(tempo);
+    printf(" %s %s %g\n", da, a, valore);
+    return edc_stop;
+}
+
+static int edc_ts_export(EDC_Parameter *param)
+{
+    /*
+     *  stampa un segmento dell'archivio tsstore, una riga per valore:
+     *  tempo, mittente, destinatario, valore
+     */
+    int letti;
+
+    signal(SIGINT, edc_signal);
+    signal(SIGTERM, edc_signal);
+    letti = ts_read(param->tsRead, param->da, param->a, edc_ts_record, NULL);
+    if( letti < 0 )
+    {
+        fprintf( stderr, "Cannot read segment '%s'\n", param->tsRead );
+        return -3;
+    }
+    fprintf( stderr, "%d records read from '%s'\n", letti, param->tsRead );
+    return 0;
+}
+
+static int edc_archivio_record(int64_t tempo, uint16_t destinatario, int group,
+                               unsigned char *cemi, int lunghezza, void *arg)
+{
+    char a[16];
+    int i;
+
+    filtro_format_address(destinatario, group, a, sizeof(a));
+    edc_stampa_tempo(tempo);
+    printf(" %s", a);
+    for( i = 0; i < lunghezza; i++ )
+    {
+        printf(" %02x", cemi[i]);
+    }
+    printf("\n");
+    return edc_stop;
+}
+
+static int edc_archivio_export(EDC_Parameter *param)
+{
+    /*
+     *  stampa i telegrammi dell'archivio grezzo (sink raw:), una riga per
+     *  telegramma: tempo, destinatario, byte CEMI in esadecimale. Con una
+     *  directory si leggono i file giornalieri da -da a -a (default: le
+     *  ultime 24 ore).
+     */
+    struct stat st;
+    int64_t a = param->a;
+    int letti;
+
+    signal(SIGINT, edc_signal);
+    signal(SIGTERM, edc_signal);
+    if( stat(param->archivioRead, &st) == 0 && S_ISDIR(st.st_mode) )
+    {
+        //senza -a ci si ferma a oggi: archivio_read_range scorre un giorno alla volta
+        if( a > (int64_t) time(NULL) * 1000 )
+        {
+            a = (int64_t) time(NULL) * 1000;
+        }
+        letti = archivio_read_range(param->archivioRead, param->da ? param->da : a - 86400000 + 1, a,
+                                    param->filtraIndirizzo, param->indirizzo, param->group, edc_archivio_record, NULL);
+    }
+    else
+    {
+        letti = archivio_read(param->archivioRead, param->da, param->a,
+                              param->filtraIndirizzo, param->indirizzo, param->group, edc_archivio_record, NULL);
+    }
+    if( letti < 0 )
+    {
+        fprintf( stderr, "Cannot read raw archive '%s'\n", param->archivioRead );
+        return -3;
+    }
+    fprintf( stderr, "%d telegrams read from '%s'\n", letti, param->archivioRead );
+    return 0;
+}
+
+int edc_frame2value( CEMIFRAME *cemiframe, long eis, float *returned );
+
+typedef struct
+{
+    //stato del ciclo di cattura, condiviso con i thread di polling
+    EDC_Parameter *param;
+    EDC_Db *db;
+    FiltroTable filtri;
+    Filtro nessunFiltro;
+    time_t lastReload;
+    Sink *sinks;
+    Sink *archivio;
+    SinkRecord lotto[SINK_BATCH];
+    int nLotto;
+    int64_t inizioLotto;
+    Rollup rollup;
+    unsigned long scartati;
+    unsigned long ignorati;    // telegrammi senza valore (letture, altri servizi)
+    time_t lastStato;
+    PollScheduler *poll;
+    pthread_mutex_t mutex;  // un solo telegramma alla volta viene decodificato
+}EDC_Cattura;
+
+static void edc_cattura_frame(EDC_Cattura *c, CEMIFRAME *cemiframe, uint16_t value_size, int letto)
+{
+    /*
+     *  decodifica e registra un telegramma, dal monitor (letto = 0) oppure
+     *  costruito da una risposta di enmx_read() (letto = 1); con il mutex
+     */
+    EDC_Parameter *param = c->param;
+    MYSQL **conn = c->db->conn;
+    struct timeval tv;
+    SinkRecord telegramma;
+    Filtro *filtro;
+    int64_t tempo;
+    uint16_t destinatario;
+    int group;
+    int caricati;
+    int servizio;
+    float fl;
+
+    gettimeofday( &tv, NULL );
+
+    //filtri in memoria, ricaricati periodicamente dal database; se il database
+    //non risponde si tiene la tabella attuale e si riprova dopo FILTRO_RELOAD secondi
+    if( strcmp(param->filtroFile, "") == 0 && tv.tv_sec - c->lastReload >= FILTRO_RELOAD )
+    {
+        c->lastReload = tv.tv_sec;
+        caricati = (*conn != NULL) ? load_filtro(*conn, &c->filtri) : -1;
+        if( caricati < 0 )
+        {
+            edc_reconnect(c->db);
+            caricati = (*conn != NULL) ? load_filtro(*conn, &c->filtri) : -1;
+        }
+        if( caricati < 0 )
+        {
+            fprintf( stderr, "Cannot load filtro table, retrying in %d s\n", FILTRO_RELOAD );
+        }
+        else if( c->poll != NULL )
+        {
+            poll_aggiorna(c->poll, &c->filtri);
+        }
+    }
+
+    destinatario = ntohs( cemiframe->daddr );
+    group = (cemiframe->ntwrk & EIB_DAF_GROUP) != 0;
+    filtro = filtro_table_get(&c->filtri, destinatario, group);
+    if( filtro == NULL )
+    {
+        filtro = &c->nessunFiltro;
+    }
+
+    tempo = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    telegramma.tempo = tempo;
+    telegramma.mittente = ntohs( cemiframe->saddr );
+    telegramma.destinatario = destinatario;
+    telegramma.group = group;
+    telegramma.valore = NAN;
+    telegramma.lunghezza = (value_size < SINK_CEMI_MAX) ? value_size : SINK_CEMI_MAX;
+    memset(telegramma.cemi, 0, SINK_CEMI_MAX);
+    memcpy(telegramma.cemi, cemiframe, telegramma.lunghezza);
+
+    //tutti i telegrammi del bus, anche quelli non decodificati, vanno nell'archivio grezzo
+    if( c->archivio != NULL && !letto )
+    {
+        sink_push(c->archivio, &telegramma, 1);
+    }
+
+    //la risposta a una lettura arriva anche dal monitor: la seconda copia si scarta
+    if( c->poll != NULL && group && filtro->pollInterval > 0 &&
+        poll_duplicato(c->poll, destinatario, letto, &cemiframe->apci, cemiframe->length, tempo) )
+    {
+        return;
+    }
+
+    //conversione dei dati, solo per i telegrammi che portano un valore:
+    //le richieste di lettura (anche le conferme L_Data.con delle nostre) no
+    servizio = ((cemiframe->tpci & 0x03) << 8) | (cemiframe->apci & 0xc0);
+    if( servizio != A_WRITE_VALUE_REQ && servizio != A_RESPONSE_VALUE_REQ )
+    {
+        c->ignorati++;
+    }
+    else if( edc_frame2value( cemiframe, filtro->EIS, &fl ) == 0 )
+    {
+        if( filtro->writable )
+        {
+            if( param->rollup )
+            {
+                rollup_add(&c->rollup, tv.tv_sec, destinatario, group, fl);
+            }
+            if( param->statoFlush > 0 )
+            {
+                filtro_stato_aggiorna(filtro, fl, tempo, ntohs( cemiframe->saddr ));
+            }
+
+            //deadband, intervallo minimo e heartbeat dell'indirizzo
+            if( !filtro_registra(filtro, fl, tempo) )
+            {
+                c->scartati++;
+            }
+            else
+            {
+                if( c->nLotto == 0 )
+                {
+                    c->inizioLotto = tempo;
+                }
+                c->lotto[c->nLotto] = telegramma;
+                c->lotto[c->nLotto++].valore = fl;
+            }
+        }
+    }
+    else
+    {
+        printf("Conversione valore impossibile**\n");
+    }
+
+    //lotto pieno: passa subito alle sink; le scadenze sono in edc_cattura_tick()
+    if( c->nLotto == SINK_BATCH )
+    {
+        sink_fanout(c->sinks, c->lotto, c->nLotto);
+        c->nLotto = 0;
+    }
+}
+
+static void edc_cattura_tick(EDC_Cattura *c)
+{
+    /*
+     *  chiamata a ogni risveglio del ciclo di cattura, con o senza telegrammi,
+     *  e almeno ogni SINK_LOTTO_MS; con il mutex
+     */
+    struct timeval tv;
+    int64_t tempo;
+
+    gettimeofday(&tv, NULL);
+    tempo = (int64_t) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+
+    if( c->nLotto > 0 && tempo - c->inizioLotto >= SINK_LOTTO_MS )
+    {
+        sink_fanout(c->sinks, c->lotto, c->nLotto);
+        c->nLotto = 0;
+    }
+    if( c->param->rollup ) rollup_tick(&c->rollup, tv.tv_sec);
+    if( c->param->statoFlush > 0 && tv.tv_sec - c->lastStato >= c->param->statoFlush )
+    {
+        edc_stato_flush(&c->filtri, c->db);
+        c->lastStato = tv.tv_sec;
+    }
+}
+
+static void edc_poll_risposta(CEMIFRAME *cemiframe, uint16_t lunghezza, void *arg)
+{
+    EDC_Cattura *c = (EDC_Cattura*) arg;
+
+    pthread_mutex_lock(&c->mutex);
+    edc_cattura_frame(c, cemiframe, lunghezza, 1);
+    pthread_mutex_unlock(&c->mutex);
 }
 
 void processParameterHelp();
@@ -55,25 +577,30 @@ EDC_Parameter processParameterFile(char* path);
 
 int main(int argc, char **argv)
 {
-    Energia energia;
 
 
     ENMX_HANDLE sock_con = 0;
     //unsigned char   conn_state = 0;
 
     uint16_t value_size;
-    struct timeval tv;
-    struct tm *ltime;
     uint16_t buflen;
     unsigned char *buf;
     CEMIFRAME *cemiframe;
     int enmx_version;
+    struct pollfd attesa;
+    int pronto;
 
     int total = -1;
     int count = 0;
     int spaces = 1;
     EDC_Parameter param;
 
+    static EDC_Cattura cattura;
+    SinkConfig sinkConfig;
+    char spec[300];
+    int i;
+    EDC_Db db;
+
     
 
 
@@ -85,12 +612,30 @@ int main(int argc, char **argv)
     }
 
 
+    //lettura di un segmento tsstore o dell'archivio grezzo: non servono ne' eibnetmux ne' il database
+    if( strcmp(param.tsRead, "") != 0 )
+    {
+        return edc_ts_export(&param);
+    }
+    if( strcmp(param.archivioRead, "") != 0 )
+    {
+        return edc_archivio_export(&param);
+    }
+
     if (mysql_library_init(0, NULL, NULL)) //inizializza la CLI di mysql
     {
         printf(NULL, "mysql_library_init() failed");
         return 3;
     }
 
+    //importazione di uno spool: non serve eibnetmux
+    if( strcmp(param.import, "") != 0 )
+    {
+        i = edc_import(&param);
+        mysql_library_end();
+        return i;
+    }
+
 
 
 
@@ -124,106 +669,186 @@ int main(int argc, char **argv)
     }
 
 
-    Filtro filtro ;
     MYSQL *conn = NULL;
 
-    initFiltro(&filtro);
-
-
-
-    //start_db_connection(&conn, param.dbUser,param.dbPwd,param.dbIP, param.dbPort, param.dbDatabase);
-    start_db_connection(&conn, param.dbUser,param.dbPwd,param.dbIP, param.dbPort, param.dbDatabase);
+    cattura.param = &param;
+    cattura.db = &db;
+    initFiltro(&cattura.nessunFiltro);
+    filtro_table_init(&cattura.filtri);
+    pthread_mutex_init(&cattura.mutex, NULL);
 
+    if( strcmp(param.filtroFile, "") != 0 )
+    {
+        if( filtro_table_load_file(&cattura.filtri, param.filtroFile) < 0 )
+        {
+            fprintf( stderr, "Cannot read filter file '%s'\n", param.filtroFile );
+            return -3;
+        }
+    }
 
+    cattura.sinks = edc_create_sinks(&param, &sinkConfig);
+    if( cattura.sinks == NULL )
+    {
+        return -3;
+    }
 
-    while(1)
+    if( strcmp(param.archivio, "") != 0 )
     {
+        snprintf(spec, sizeof(spec), "raw:%s", param.archivio);
+        cattura.archivio = sink_create(spec, &sinkConfig);
+        if( cattura.archivio == NULL )
+        {
+            sink_destroy_all(cattura.sinks);
+            return -3;
+        }
+        printf( "Archiving raw telegrams to '%s'\n", param.archivio );
+    }
 
-        buf = enmx_monitor( sock_con, 0xffff, buf, &buflen, &value_size );
+    //la connessione del ciclo di cattura serve per i filtri, i rollup e stato_corrente;
+    //ogni sink mysql ha la propria
+    if( strcmp(param.filtroFile, "") == 0 || param.rollup || param.statoFlush > 0 )
+    {
+        start_db_connection(&conn, param.dbUser,param.dbPwd,param.dbIP, param.dbPort, param.dbDatabase);
+    }
 
-        if( buf == NULL )
+    db.conn = &conn;
+    db.param = &param;
+    db.writer = NULL;
+    if( param.rollup )
+    {
+        if( conn == NULL || create_rollup_tables(conn) != 0 )
         {
-            switch( enmx_geterror( sock_con ))
-            {
-                case ENMX_E_COMMUNICATION:
-                case ENMX_E_NO_CONNECTION:
-                case ENMX_E_WRONG_USAGE:
-                case ENMX_E_NO_MEMORY:
-                    fprintf( stderr, "Error on write: %s\n", enmx_errormessage( sock_con ));
-                    enmx_close( sock_con );
-                    exit( -4 );
-                    break;
-                case ENMX_E_INTERNAL:
-                    fprintf( stderr, "Bad status returned\n" );
-                    break;
-                case ENMX_E_SERVER_ABORTED:
-                    fprintf( stderr, "EOF reached: %s\n", enmx_errormessage( sock_con ));
-                    enmx_close( sock_con );
-                    exit( -4 );
-                    break;
-                case ENMX_E_TIMEOUT:
-                    fprintf( stderr, "No value received\n" );
-                    break;
-            }
+            fprintf( stderr, "Rollup needs the database, disabled\n" );
+            param.rollup = 0;
         }
-        else
+        rollup_init(&cattura.rollup, edc_rollup_writer, &db);
+    }
+    if( param.statoFlush > 0 )
+    {
+        if( conn == NULL || create_stato_table(conn) != 0 )
         {
-            count++;
-            cemiframe = (CEMIFRAME *) buf;
-
-            gettimeofday( &tv, NULL );
-            ltime = localtime( &tv.tv_sec );
-
-            if( total != -1 )
-            {
-                printf( "%*d: ", spaces, count );
-            }
-            energia.data.day            = ltime->tm_mday;
-            energia.data.year           = ltime->tm_year + 1900;
-            energia.data.month          = ltime->tm_mon +1;
-
-
-
-            sprintf( energia.timestamp, "%02d:%02d:%02d:%03d", ltime->tm_hour, ltime->tm_min, ltime->tm_sec, (uint32_t)tv.tv_usec / 1000 );
-            sprintf( energia.mittente, "%8s  ", knx_physical( cemiframe->saddr ));
-            sprintf( energia.destinatario, "%8s", (cemiframe->ntwrk & EIB_DAF_GROUP) ? knx_group( cemiframe->daddr ) : knx_physical( cemiframe->daddr ));
-
-            str_unfill(energia.destinatario, ' ');
-
+            fprintf( stderr, "stato_corrente needs the database, disabled\n" );
+            param.statoFlush = 0;
+        }
+    }
+    if( param.rollup || param.statoFlush > 0 )
+    {
+        db.writer = dbwriter_create(param.dbUser, param.dbPwd, param.dbIP, param.dbPort, param.dbDatabase);
+        if( db.writer == NULL )
+        {
+            fprintf( stderr, "Cannot start the database writer, rollup and stato_corrente disabled\n" );
+            param.rollup = 0;
+            param.statoFlush = 0;
+        }
+    }
 
+    //lettura periodica degli indirizzi con un intervallo di polling nel filtro
+    if( param.pollConnessioni > 0 )
+    {
+        cattura.poll = poll_create(param.eibTarget, param.pollConnessioni, param.pollBudget, param.pollJitter,
+                                   edc_poll_risposta, &cattura);
+        if( cattura.poll == NULL )
+        {
+            fprintf( stderr, "Polling disabled\n" );
+        }
+        else if( strcmp(param.filtroFile, "") != 0 )
+        {
+            poll_aggiorna(cattura.poll, &cattura.filtri);
+        }
+    }
 
-            while( select_filtro(conn, energia.destinatario, &filtro) > 0 )
-            {
+    signal( SIGINT, edc_signal );
+    signal( SIGTERM, edc_signal );
 
-                close_db_connection(&conn);
-                start_db_connection(&conn, "root","labdomvinci","10.0.0.55", 3306, "konnex");
-            }
+    //il monitor viene avviato una volta sola: enmx_monitor() legge poi un telegramma
+    //alla volta e l'attesa sul socket resta a poll(), con un timeout
+    if( enmx_monitor_start( sock_con, 0xffff ) != 0 )
+    {
+        fprintf( stderr, "Monitor request failed: %s\n", enmx_errormessage( sock_con ));
+        enmx_close( sock_con );
+        exit( -4 );
+    }
+    attesa.fd = enmx_getfd( sock_con );
+    attesa.events = POLLIN;
 
-            //conversione dei dati:
+    while( !edc_stop )
+    {
+        //SIGINT / SIGTERM interrompono poll(): edc_stop viene ricontrollato a ogni risveglio
+        pronto = (enmx_pending( sock_con ) > 0) ? 1 : poll( &attesa, 1, SINK_LOTTO_MS );
+        if( pronto > 0 )
+        {
+            buf = enmx_monitor( sock_con, 0xffff, buf, &buflen, &value_size );
 
-            float fl;
-            if( edc_frame2value( cemiframe, filtro.EIS, &fl ) == 0 )
+            if( buf == NULL )
             {
-                energia.valore = fl;
-
-                if( filtro.writable )
+                switch( enmx_geterror( sock_con ))
                 {
-                    while( insert_dati(conn, energia) > 0 )
-                    {
-                         close_db_connection(&conn);
-                         start_db_connection(&conn, "root","labdomvinci","10.0.0.55", 3306, "konnex");
-                    }
+                    case ENMX_E_COMMUNICATION:
+                    case ENMX_E_NO_CONNECTION:
+                    case ENMX_E_WRONG_USAGE:
+                    case ENMX_E_NO_MEMORY:
+                        fprintf( stderr, "Error on write: %s\n", enmx_errormessage( sock_con ));
+                        enmx_close( sock_con );
+                        exit( -4 );
+                        break;
+                    case ENMX_E_INTERNAL:
+                        fprintf( stderr, "Bad status returned\n" );
+                        break;
+                    case ENMX_E_SERVER_ABORTED:
+                        fprintf( stderr, "EOF reached: %s\n", enmx_errormessage( sock_con ));
+                        enmx_close( sock_con );
+                        exit( -4 );
+                        break;
+                    case ENMX_E_TIMEOUT:
+                        fprintf( stderr, "No value received\n" );
+                        break;
                 }
             }
             else
             {
-                printf("Conversione valore impossibile**\n");
-            }
+                count++;
+                cemiframe = (CEMIFRAME *) buf;
 
+                if( total != -1 )
+                {
+                    printf( "%*d: ", spaces, count );
+                }
+
+                pthread_mutex_lock(&cattura.mutex);
+                edc_cattura_frame(&cattura, cemiframe, value_size, 0);
+                pthread_mutex_unlock(&cattura.mutex);
+            }
         }
 
+        //scadenze del lotto, dei rollup e di stato_corrente: a ogni risveglio, non solo con i telegrammi
+        pthread_mutex_lock(&cattura.mutex);
+        edc_cattura_tick(&cattura);
+        pthread_mutex_unlock(&cattura.mutex);
+
+        //fuori da enmx_monitor(): le connessioni di polling perse si riaprono qui
+        poll_riconnetti(cattura.poll);
+
         //prepared( "root", "labdomvinci", "10.0.0.55", 3306, "konnex", energia);
     }
+    //prima i thread di polling, che scrivono ancora nel lotto
+    poll_destroy(cattura.poll);
+    printf( "%lu values not recorded (deadband / interval)\n", cattura.scartati );
+    printf( "%lu telegrams without a value (read requests, other services)\n", cattura.ignorati );
+    sink_fanout(cattura.sinks, cattura.lotto, cattura.nLotto);
+    sink_destroy_all(cattura.sinks);
+    sink_destroy_all(cattura.archivio);
+    if( param.rollup )
+    {
+        rollup_flush_all(&cattura.rollup);
+        rollup_free(&cattura.rollup);
+    }
+    if( param.statoFlush > 0 )
+    {
+        edc_stato_flush(&cattura.filtri, &db);
+    }
+    dbwriter_destroy(db.writer);
+    filtro_table_clear(&cattura.filtri);
+    pthread_mutex_destroy(&cattura.mutex);
     close_db_connection(&conn);
 
     mysql_library_end();//termina la libreria mysql
@@ -257,10 +882,11 @@ int edc_frame2value( CEMIFRAME *cemiframe, long eis, float *returned )
         case 7:
         case 8:
         {
-            if( cemiframe->apci == 128 ) *returned = 0.0;
+            //scrittura (0x80) o risposta a una lettura (0x40): il valore e' nei 6 bit bassi
+            if( (cemiframe->apci & 0x3f) == 0 ) *returned = 0.0;
             else *returned = 1.0;
 
-            printf("APCI = %d\n", cemiframe->apci -128 );
+            printf("APCI = %d\n", cemiframe->apci & 0x3f );
             printf("valore = %f\n", *returned );
             return 0;
         }
@@ -336,6 +962,25 @@ void processParameterHelp()
     puts("-pwd    dbPassword");
     puts("-db     databaseName");
     puts("-eid    eibnetmux_identifier [default = EDC]");
+    puts("-backend mysql|tsstore [default = mysql]");
+    puts("-tsdir  timeSeriesStoreDirectory [default = edc_data]");
+    puts("-filtro filterFilePath (<destinatario> <EIS> <writable> [<deadband> [<deadband%> [<minInterval> [<heartbeat> [<poll>]]]]] per line)");
+    puts("-rollup write 1 min / 15 min / hourly / daily aggregates");
+    puts("-stato  seconds between updates of stato_corrente [default = 0, off]");
+    puts("-schema 1 = table dati, 2 = partitioned table dati_v2 [default = 1]");
+    puts("-partizioni day|month partitioning of dati_v2 [default = day]");
+    puts("-retention days of dati_v2 to keep, older partitions are dropped [default = 0, all]");
+    puts("-sink   mysql|tsstore:<dir>|sqlite:<file>|spool:<file>|udp:<host>:<port>|unix:<path>, repeatable [default = backend]");
+    puts("-archivio rawArchiveDirectory, every telegram compressed with LZ4 [default = off]");
+    puts("-import spoolFile, write a spool to the sinks and exit (bulk loaded into mysql)");
+    puts("-tsread segmentFile, print the values of a tsstore segment and exit");
+    puts("-archivioread rawArchiveFile|rawArchiveDirectory, print the archived telegrams and exit");
+    puts("-da     AAAAMMGG, first day read by -tsread / -archivioread [default = all, for a directory 24 hours before -a]");
+    puts("-a      AAAAMMGG, last day read by -tsread / -archivioread [default = all, for a directory now]");
+    puts("-ga     address, -archivioread only telegrams to this group (1/2/3) or physical (1.1.1) address");
+    puts("-pollconn   eibnetmux connections for polling group addresses, 0 = off [default = 0]");
+    puts("-pollbudget max group reads per second [default = 5, 0 = unlimited]");
+    puts("-polljitter random variation of polling intervals in % [default = 10]");
     puts("-?      Show Help and exit");
     puts("-f -?   Show Config file help and exit");
 
@@ -390,6 +1035,24 @@ EDC_Parameter processParameter(int argc, char** argv)
                     puts("eibpwd:  <eibnetmuxPwd>");
                     puts("eibuser: <eibnetmuxUser>");
                     puts("eibtarget:   <eibHost:eibPort>");
+                    puts("backend: <mysql|tsstore>");
+                    puts("tsdir:   <timeSeriesStoreDirectory>");
+                    puts("tssegment:   <address|day>");
+                    puts("filtrofile:  <filterFilePath>");
+                    puts("rollup:  <0|1>");
+                    puts("stato:   <seconds>");
+                    puts("schema:  <1|2>");
+                    puts("partizioni:  <day|month>");
+                    puts("retention:   <days>");
+                    puts("sink:    <type[:options]>  (one line per sink)");
+                    puts("sqlitesync:  <OFF|NORMAL|FULL>");
+                    puts("sqlitemmap:  <bytes>");
+                    puts("sqlitebatch: <rows per transaction>");
+                    puts("sqlitecheckpoint:    <seconds, 0 = automatic>");
+                    puts("archivio:    <rawArchiveDirectory>");
+                    puts("pollconn:    <connections, 0 = no polling>");
+                    puts("pollbudget:  <reads per second>");
+                    puts("polljitter:  <percent>");
                     puts("\n\nFile example:\n\n");
                     puts("EDC_CONFIG_FILE 0.1");
                     puts("dbname:  mydatabase");
@@ -460,6 +1123,136 @@ EDC_Parameter processParameter(int argc, char** argv)
                 strcpy(param.eibID, argv[i]);
             }
 
+            else if( strcmp(argv[i], "-backend") == 0)
+            {
+                i++;
+                if( strcmp(argv[i], "mysql") == 0 || strcmp(argv[i], "tsstore") == 0 )
+                {
+                    strcpy(param.backend, argv[i]);
+                }
+                else
+                {
+                    fprintf(stderr, "Unknown backend '%s', using %s\n", argv[i], param.backend);
+                }
+            }
+
+            else if( strcmp(argv[i], "-tsdir") == 0)
+            {
+                i++;
+                strncpy(param.tsDir, argv[i], sizeof(param.tsDir) - 1);
+            }
+
+            else if( strcmp(argv[i], "-filtro") == 0)
+            {
+                i++;
+                strncpy(param.filtroFile, argv[i], sizeof(param.filtroFile) - 1);
+            }
+
+            else if( strcmp(argv[i], "-rollup") == 0)
+            {
+                param.rollup = 1;
+            }
+
+            else if( strcmp(argv[i], "-stato") == 0)
+            {
+                i++;
+                param.statoFlush = atoi(argv[i]);
+            }
+
+            else if( strcmp(argv[i], "-schema") == 0)
+            {
+                i++;
+                param.schema = atoi(argv[i]);
+            }
+
+            else if( strcmp(argv[i], "-partizioni") == 0)
+            {
+                i++;
+                param.partizioniMese = (strcmp(argv[i], "month") == 0);
+            }
+
+            else if( strcmp(argv[i], "-retention") == 0)
+            {
+                i++;
+                param.retention = atoi(argv[i]);
+            }
+
+            else if( strcmp(argv[i], "-sink") == 0)
+            {
+                i++;
+                if( param.nSink < SINK_MAX )
+                {
+                    strncpy(param.sink[param.nSink], argv[i], sizeof(param.sink[0]) - 1);
+                    param.sink[param.nSink++][sizeof(param.sink[0]) - 1] = 0;
+                }
+            }
+
+            else if( strcmp(argv[i], "-archivio") == 0)
+            {
+                i++;
+                strncpy(param.archivio, argv[i], sizeof(param.archivio) - 1);
+            }
+
+            else if( strcmp(argv[i], "-pollconn") == 0)
+            {
+                i++;
+                param.pollConnessioni = atoi(argv[i]);
+            }
+
+            else if( strcmp(argv[i], "-pollbudget") == 0)
+            {
+                i++;
+                param.pollBudget = atoi(argv[i]);
+            }
+
+            else if( strcmp(argv[i], "-polljitter") == 0)
+            {
+                i++;
+                param.pollJitter = atoi(argv[i]);
+            }
+
+            else if( strcmp(argv[i], "-import") == 0)
+            {
+                i++;
+                strncpy(param.import, argv[i], sizeof(param.import) - 1);
+            }
+
+            else if( strcmp(argv[i], "-tsread") == 0)
+            {
+                i++;
+                strncpy(param.tsRead, argv[i], sizeof(param.tsRead) - 1);
+            }
+
+            else if( strcmp(argv[i], "-archivioread") == 0)
+            {
+                i++;
+                strncpy(param.archivioRead, argv[i], sizeof(param.archivioRead) - 1);
+            }
+
+            else if( strcmp(argv[i], "-ga") == 0)
+            {
+                i++;
+                if( filtro_parse_address(argv[i], &param.indirizzo, &param.group) != 0 )
+                {
+                    fprintf(stderr, "Invalid address '%s'\n", argv[i]);
+                    exit(1);
+                }
+                param.filtraIndirizzo = 1;
+            }
+
+            else if( strcmp(argv[i], "-da") == 0 || strcmp(argv[i], "-a") == 0)
+            {
+                int64_t giorno = edc_giorno(argv[i + 1], strcmp(argv[i], "-a") == 0);
+
+                if( giorno < 0 )
+                {
+                    fprintf(stderr, "Invalid date '%s', expected AAAAMMGG\n", argv[i + 1]);
+                    exit(1);
+                }
+                if( strcmp(argv[i], "-a") == 0 ) param.a = giorno; else param.da = giorno;
+                i++;
+            }
+
             else if( strcmp(argv[i], "-?") == 0)
             {
                 processParameterHelp();
@@ -488,6 +1281,25 @@ EDC_Parameter processParameterFile(char* path)
      eibuser: <eibnetmuxUser>
      eibtarget:   <eibHost:eibPort>
 
+     backend: <mysql|tsstore>
+     tsdir:   <timeSeriesStoreDirectory>
+     tssegment:   <address|day>
+     filtrofile:  <filterFilePath>
+     rollup:  <0|1>
+     stato:   <seconds>
+     schema:  <1|2>
+     partizioni:  <day|month>
+     retention:   <days>
+     sink:    <type[:options]>
+     sqlitesync:  <OFF|NORMAL|FULL>
+     sqlitemmap:  <bytes>
+     sqlitebatch: <rows>
+     sqlitecheckpoint:    <seconds>
+     archivio:    <rawArchiveDirectory>
+     pollconn:    <connections>
+     pollbudget:  <reads per second>
+     polljitter:  <percent>
+
      * le righe possono essere inserite in qualsiasi ordine, ma il file deve iniziarecon EDC_CONFIG_FILE versione
      */
     EDC_Parameter param;
@@ -556,6 +1368,90 @@ EDC_Parameter processParameterFile(char* path)
             {
                 strcpy( param.eibID, buf2);
             }
+            else if( strcmp(buf, "backend:") == 0)
+            {
+                if( strcmp(buf2, "mysql") != 0 && strcmp(buf2, "tsstore") != 0 )
+                {
+                    printf("ERROR WHILE PARSING FILE");
+                    exit(1);
+                }
+                strcpy( param.backend, (strcmp(buf2, "mysql") == 0) ? "mysql" : "tsstore");
+            }
+            else if( strcmp(buf, "tsdir:") == 0)
+            {
+                strncpy( param.tsDir, buf2, sizeof(param.tsDir) - 1);
+            }
+            else if( strcmp(buf, "tssegment:") == 0)
+            {
+                param.tsPerAddress = (strcmp(buf2, "day") != 0);
+            }
+            else if( strcmp(buf, "filtrofile:") == 0)
+            {
+                strncpy( param.filtroFile, buf2, sizeof(param.filtroFile) - 1);
+            }
+            else if( strcmp(buf, "rollup:") == 0)
+            {
+                param.rollup = atoi(buf2);
+            }
+            else if( strcmp(buf, "stato:") == 0)
+            {
+                param.statoFlush = atoi(buf2);
+            }
+            else if( strcmp(buf, "schema:") == 0)
+            {
+                param.schema = atoi(buf2);
+            }
+            else if( strcmp(buf, "partizioni:") == 0)
+            {
+                param.partizioniMese = (strcmp(buf2, "month") == 0);
+            }
+            else if( strcmp(buf, "retention:") == 0)
+            {
+                param.retention = atoi(buf2);
+            }
+            else if( strcmp(buf, "sqlitesync:") == 0)
+            {
+                if( strcmp(buf2, "OFF") == 0 || strcmp(buf2, "NORMAL") == 0 || strcmp(buf2, "FULL") == 0 )
+                {
+                    strcpy(param.sqliteSync, buf2);
+                }
+            }
+            else if( strcmp(buf, "sqlitemmap:") == 0)
+            {
+                param.sqliteMmap = atol(buf2);
+            }
+            else if( strcmp(buf, "sqlitebatch:") == 0)
+            {
+                param.sqliteBatch = atoi(buf2);
+            }
+            else if( strcmp(buf, "sqlitecheckpoint:") == 0)
+            {
+                param.sqliteCheckpoint = atoi(buf2);
+            }
+            else if( strcmp(buf, "pollconn:") == 0)
+            {
+                param.pollConnessioni = atoi(buf2);
+            }
+            else if( strcmp(buf, "pollbudget:") == 0)
+            {
+                param.pollBudget = atoi(buf2);
+            }
+            else if( strcmp(buf, "polljitter:") == 0)
+            {
+                param.pollJitter = atoi(buf2);
+            }
+            else if( strcmp(buf, "archivio:") == 0)
+            {
+                strncpy( param.archivio, buf2, sizeof(param.archivio) - 1);
+            }
+            else if( strcmp(buf, "sink:") == 0)
+            {
+                if( param.nSink < SINK_MAX )
+                {
+                    strncpy(param.sink[param.nSink], buf2, sizeof(param.sink[0]) - 1);
+                    param.sink[param.nSink++][sizeof(param.sink[0]) - 1] = 0;
+                }
+            }
             else
             {
                 printf("ERROR WHILE PARSING FILE");
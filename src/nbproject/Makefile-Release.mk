@@ -31,10 +31,22 @@ OBJECTDIR=build/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/archivio.o \
 	${OBJECTDIR}/dbconnection.o \
+	${OBJECTDIR}/dbwriter.o \
 	${OBJECTDIR}/eibtrace.o \
+	${OBJECTDIR}/filtro.o \
 	${OBJECTDIR}/main.o \
-	${OBJECTDIR}/statement.o
+	${OBJECTDIR}/poll.o \
+	${OBJECTDIR}/rollup.o \
+	${OBJECTDIR}/sink.o \
+	${OBJECTDIR}/sink_line.o \
+	${OBJECTDIR}/sink_mysql.o \
+	${OBJECTDIR}/sink_spool.o \
+	${OBJECTDIR}/sink_sqlite.o \
+	${OBJECTDIR}/sink_tsstore.o \
+	${OBJECTDIR}/statement.o \
+	${OBJECTDIR}/tsstore.o
 
 # C Compiler Flags
 CFLAGS=
@@ -60,26 +72,86 @@ dist/Release/GNU-Linux-x86/src: ${OBJECTFILES}
 	${MKDIR} -p dist/Release/GNU-Linux-x86
 	${LINK.c} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/src ${OBJECTFILES} ${LDLIBSOPTIONS} 
 
+${OBJECTDIR}/archivio.o: nbproject/Makefile-${CND_CONF}.mk archivio.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/archivio.o archivio.c
+
 ${OBJECTDIR}/dbconnection.o: nbproject/Makefile-${CND_CONF}.mk dbconnection.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} $@.d
 	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/dbconnection.o dbconnection.c
 
+${OBJECTDIR}/dbwriter.o: nbproject/Makefile-${CND_CONF}.mk dbwriter.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/dbwriter.o dbwriter.c
+
 ${OBJECTDIR}/eibtrace.o: nbproject/Makefile-${CND_CONF}.mk eibtrace.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} $@.d
 	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/eibtrace.o eibtrace.c
 
+${OBJECTDIR}/filtro.o: nbproject/Makefile-${CND_CONF}.mk filtro.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/filtro.o filtro.c
+
 ${OBJECTDIR}/main.o: nbproject/Makefile-${CND_CONF}.mk main.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} $@.d
 	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/main.o main.c
 
+${OBJECTDIR}/poll.o: nbproject/Makefile-${CND_CONF}.mk poll.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/poll.o poll.c
+
+${OBJECTDIR}/rollup.o: nbproject/Makefile-${CND_CONF}.mk rollup.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/rollup.o rollup.c
+
+${OBJECTDIR}/sink.o: nbproject/Makefile-${CND_CONF}.mk sink.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/sink.o sink.c
+
+${OBJECTDIR}/sink_line.o: nbproject/Makefile-${CND_CONF}.mk sink_line.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/sink_line.o sink_line.c
+
+${OBJECTDIR}/sink_mysql.o: nbproject/Makefile-${CND_CONF}.mk sink_mysql.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/sink_mysql.o sink_mysql.c
+
+${OBJECTDIR}/sink_spool.o: nbproject/Makefile-${CND_CONF}.mk sink_spool.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/sink_spool.o sink_spool.c
+
+${OBJECTDIR}/sink_sqlite.o: nbproject/Makefile-${CND_CONF}.mk sink_sqlite.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/sink_sqlite.o sink_sqlite.c
+
+${OBJECTDIR}/sink_tsstore.o: nbproject/Makefile-${CND_CONF}.mk sink_tsstore.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/sink_tsstore.o sink_tsstore.c
+
 ${OBJECTDIR}/statement.o: nbproject/Makefile-${CND_CONF}.mk statement.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} $@.d
 	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/statement.o statement.c
 
+${OBJECTDIR}/tsstore.o: nbproject/Makefile-${CND_CONF}.mk tsstore.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} $@.d
+	$(COMPILE.c) -O2 -MMD -MP -MF $@.d -o ${OBJECTDIR}/tsstore.o tsstore.c
+
 # Subprojects
 .build-subprojects:
 
@@ -0,0 +1,548 @@
+/*
+ * File:   poll.c
+ *
+ * Thread di lettura periodica degli indirizzi di gruppo (vedi poll.h).
+ */
+
+#include "poll.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+
+
+static int64_t poll_ms(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+
+static int64_t poll_intervallo(PollScheduler *s, int intervallo)
+{
+    //intervallo in ms variato a caso di +/- jitter %, da chiamare con il mutex
+    int64_t ms = (int64_t)intervallo * 1000;
+
+    if( s->jitter > 0 )
+    {
+        ms += ms * ((int)(rand_r(&s->seme) % (2 * s->jitter + 1)) - s->jitter) / 100;
+    }
+    return ms;
+}
+
+
+static PollEntry *poll_cerca(PollScheduler *s, uint16_t indirizzo)
+{
+    int i;
+
+    for( i = 0; i < s->n; i++ )
+    {
+        if( s->entries[i].indirizzo == indirizzo )
+        {
+            return &s->entries[i];
+        }
+    }
+    return NULL;
+}
+
+
+static void poll_attendi(PollScheduler *s, int64_t fino)
+{
+    struct timespec scadenza;
+
+    scadenza.tv_sec = fino / 1000;
+    scadenza.tv_nsec = (fino % 1000) * 1000000L;
+    pthread_cond_timedwait(&s->cond, &s->mutex, &scadenza);
+}
+
+
+static void poll_risposta(PollScheduler *s, uint16_t indirizzo, unsigned char *dati, uint16_t lunghezza)
+{
+    //la risposta di enmx_read() comincia dall'apci, come i dati passati a enmx_frame2value()
+    CEMIFRAME cemiframe;
+    int n;
+
+    n = (lunghezza < POLL_DATI) ? lunghezza : POLL_DATI;
+    memset(&cemiframe, 0, sizeof(cemiframe));
+    cemiframe.code = 0x29;                              // L_Data.ind
+    cemiframe.ctrl = 0xbc;
+    cemiframe.ntwrk = EIB_DAF_GROUP | 0x60;
+    cemiframe.saddr = 0;
+    cemiframe.daddr = htons(indirizzo);
+    cemiframe.length = n;
+    memcpy(&cemiframe.apci, dati, n);
+
+    s->callback(&cemiframe, offsetof(CEMIFRAME, apci) + n, s->arg);
+}
+
+
+static int poll_consegna(PollScheduler *s, int64_t now, int64_t *prossima)
+{
+    /*
+     *  con il mutex: passa alla callback la prima risposta trattenuta per la
+     *  quale la copia del monitor non e' arrivata entro POLL_ATTESA
+     *  prossima: scadenza della risposta trattenuta successiva, 0 = nessuna
+     *  return 1: risposta consegnata, il mutex e' stato rilasciato nel frattempo
+     */
+    PollEntry *entry = NULL;
+    unsigned char dati[POLL_DATI];
+    uint16_t indirizzo;
+    int n;
+    int i;
+
+    *prossima = 0;
+    for( i = 0; i < s->n; i++ )
+    {
+        if( s->entries[i].rispostaScadenza == 0 )
+        {
+            continue;
+        }
+        if( entry == NULL && s->entries[i].rispostaScadenza <= now )
+        {
+            entry = &s->entries[i];
+        }
+        else if( *prossima == 0 || s->entries[i].rispostaScadenza < *prossima )
+        {
+            *prossima = s->entries[i].rispostaScadenza;
+        }
+    }
+    if( entry == NULL )
+    {
+        return 0;
+    }
+
+    indirizzo = entry->indirizzo;
+    n = entry->rispostaLunghezza;
+    memcpy(dati, entry->rispostaDati, n);
+    entry->rispostaScadenza = 0;
+
+    pthread_mutex_unlock(&s->mutex);
+    poll_risposta(s, indirizzo, dati, n);
+    pthread_mutex_lock(&s->mutex);
+    return 1;
+}
+
+
+static void poll_trattieni(PollEntry *entry, unsigned char *dati, uint16_t lunghezza, int64_t now)
+{
+    /*
+     *  con il mutex: la risposta di enmx_read() non ha il mittente, quella
+     *  vista dal monitor si'; la risposta viene registrata solo se la copia
+     *  del monitor non arriva entro POLL_ATTESA (vedi poll_duplicato)
+     */
+    int n = (lunghezza < POLL_DATI) ? lunghezza : POLL_DATI;
+
+    if( !entry->ultimoLetto && now - entry->ultimoTempo < POLL_ECO &&
+        entry->ultimaLunghezza == n && memcmp(entry->ultimiDati, dati, n) == 0 )
+    {
+        //la copia del monitor e' gia' stata registrata
+        entry->ultimoTempo = 0;
+        return;
+    }
+    entry->rispostaScadenza = now + POLL_ATTESA;
+    entry->rispostaLunghezza = n;
+    memcpy(entry->rispostaDati, dati, n);
+}
+
+
+static void *poll_thread(void *arg)
+{
+    PollWorker *worker = (PollWorker*) arg;
+    PollScheduler *s = worker->scheduler;
+    PollEntry *entry;
+    unsigned char *dati;
+    uint16_t lunghezza;
+    uint16_t indirizzo;
+    int64_t now;
+    int64_t quando;
+    int64_t consegna;
+    int errore;
+    int i;
+
+    pthread_mutex_lock(&s->mutex);
+    while( !s->stop )
+    {
+        if( worker->riconnetti || s->pausa )
+        {
+            //la connessione viene riaperta dal thread del monitor, vedi poll_riconnetti()
+            poll_attendi(s, poll_ms() + 1000);
+            continue;
+        }
+
+        now = poll_ms();
+        if( poll_consegna(s, now, &consegna) )
+        {
+            continue;
+        }
+
+        //l'indirizzo libero con la lettura piu' vicina
+        entry = NULL;
+        for( i = 0; i < s->n; i++ )
+        {
+            if( !s->entries[i].inCorso && (entry == NULL || s->entries[i].prossimo < entry->prossimo) )
+            {
+                entry = &s->entries[i];
+            }
+        }
+        quando = (entry == NULL) ? now + 1000 :
+                 (entry->prossimo > s->prossimoToken) ? entry->prossimo : s->prossimoToken;
+        if( consegna != 0 && consegna < quando )
+        {
+            quando = consegna;
+        }
+        if( entry == NULL || quando > now )
+        {
+            //la tabella o le scadenze possono cambiare nel frattempo: si ricomincia
+            poll_attendi(s, quando);
+            continue;
+        }
+
+        entry->inCorso = 1;
+        indirizzo = entry->indirizzo;
+        if( s->budget > 0 )
+        {
+            s->prossimoToken = ((s->prossimoToken > now) ? s->prossimoToken : now) + 1000 / s->budget;
+        }
+        s->inLettura++;
+        pthread_mutex_unlock(&s->mutex);
+
+        dati = enmx_read(worker->handle, indirizzo, &lunghezza);
+        errore = (dati == NULL) ? enmx_geterror(worker->handle) : ENMX_E_NO_ERROR;
+
+        pthread_mutex_lock(&s->mutex);
+        s->inLettura--;
+        if( s->pausa && s->inLettura == 0 )
+        {
+            pthread_cond_broadcast(&s->cond);
+        }
+        //la tabella puo' essere stata ricostruita durante la lettura
+        now = poll_ms();
+        entry = poll_cerca(s, indirizzo);
+        if( entry != NULL )
+        {
+            entry->inCorso = 0;
+            entry->prossimo = now + poll_intervallo(s, entry->intervallo);
+        }
+        if( dati != NULL )
+        {
+            s->letture++;
+            if( entry != NULL )
+            {
+                poll_trattieni(entry, dati, lunghezza, now);
+            }
+            else
+            {
+                //indirizzo tolto durante la lettura: nessuna copia da attendere
+                pthread_mutex_unlock(&s->mutex);
+                poll_risposta(s, indirizzo, dati, lunghezza);
+                pthread_mutex_lock(&s->mutex);
+            }
+            free(dati);
+            continue;
+        }
+
+        s->errori++;
+        if( errore == ENMX_E_COMMUNICATION || errore == ENMX_E_NO_CONNECTION || errore == ENMX_E_SERVER_ABORTED )
+        {
+            fprintf(stderr, "Polling: connection lost (%s), reconnecting\n", enmx_errormessage(worker->handle));
+            worker->riconnetti = 1;
+            worker->prossimoTentativo = 0;
+        }
+    }
+    pthread_mutex_unlock(&s->mutex);
+    return NULL;
+}
+
+
+static void poll_libera(PollScheduler *s)
+{
+    //a thread fermi
+    int i;
+
+    for( i = 0; i < s->connessioni; i++ )
+    {
+        if( s->worker[i].handle >= 0 )
+        {
+            enmx_close(s->worker[i].handle);
+        }
+    }
+    pthread_mutex_destroy(&s->mutex);
+    pthread_cond_destroy(&s->cond);
+    free(s->entries);
+    free(s);
+}
+
+
+PollScheduler *poll_create(char *target, int connessioni, int budget, int jitter,
+                           PollCallback callback, void *arg)
+{
+    /*
+     *  apre le connessioni a eibnetmux e avvia un thread per connessione;
+     *  gli indirizzi da leggere si impostano con poll_aggiorna()
+     *  return NULL: connessione fallita o memoria insufficiente
+     */
+    PollScheduler *s;
+    int i, n;
+
+    s = (PollScheduler*) calloc(1, sizeof(PollScheduler));
+    if( s == NULL )
+    {
+        return NULL;
+    }
+    snprintf(s->target, sizeof(s->target), "%s", target);
+    s->connessioni = (connessioni < POLL_CONNESSIONI_MAX) ? connessioni : POLL_CONNESSIONI_MAX;
+    s->budget = budget;
+    s->jitter = (jitter < 100) ? jitter : 99;
+    s->seme = (unsigned int) poll_ms();
+    s->callback = callback;
+    s->arg = arg;
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->cond, NULL);
+
+    for( i = 0; i < s->connessioni; i++ )
+    {
+        s->worker[i].scheduler = s;
+        s->worker[i].handle = enmx_open(s->target, "EDC-poll");
+        if( s->worker[i].handle < 0 )
+        {
+            fprintf(stderr, "Polling: connect to eibnetmux failed (%d): %s\n",
+                    s->worker[i].handle, enmx_errormessage(s->worker[i].handle));
+            s->connessioni = i;
+            poll_libera(s);
+            return NULL;
+        }
+    }
+
+    for( i = 0; i < s->connessioni; i++ )
+    {
+        if( pthread_create(&s->worker[i].thread, NULL, poll_thread, &s->worker[i]) != 0 )
+        {
+            //i thread gia' avviati vengono fermati, le connessioni restanti chiuse
+            n = i;
+            for( ; i < s->connessioni; i++ )
+            {
+                enmx_close(s->worker[i].handle);
+            }
+            s->connessioni = n;
+            poll_destroy(s);
+            return NULL;
+        }
+    }
+    return s;
+}
+
+
+void poll_riconnetti(PollScheduler *s)
+{
+    /*
+     *  da chiamare dal thread del monitor quando enmx_monitor() e' tornata:
+     *  ferma i thread di lettura, attende la fine delle enmx_read() in corso e
+     *  poi chiude e riapre le connessioni perse, cosi' la tabella delle
+     *  connessioni di libeibnetmux non cambia mai sotto un'altra chiamata;
+     *  un tentativo fallito si ripete dopo 5 s
+     */
+    ENMX_HANDLE handle;
+    int64_t now;
+    int riapri[POLL_CONNESSIONI_MAX];
+    int n = 0;
+    int i;
+
+    if( s == NULL )
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    now = poll_ms();
+    for( i = 0; i < s->connessioni; i++ )
+    {
+        riapri[i] = s->worker[i].riconnetti && now >= s->worker[i].prossimoTentativo;
+        n += riapri[i];
+    }
+    if( n == 0 )
+    {
+        pthread_mutex_unlock(&s->mutex);
+        return;
+    }
+    s->pausa = 1;
+    while( s->inLettura > 0 )
+    {
+        pthread_cond_wait(&s->cond, &s->mutex);
+    }
+    pthread_mutex_unlock(&s->mutex);
+
+    //nessun thread usa libeibnetmux: le connessioni segnate sono solo di questo thread
+    for( i = 0; i < s->connessioni; i++ )
+    {
+        if( !riapri[i] )
+        {
+            continue;
+        }
+        if( s->worker[i].handle >= 0 )
+        {
+            enmx_close(s->worker[i].handle);
+        }
+        handle = enmx_open(s->target, "EDC-poll");
+
+        pthread_mutex_lock(&s->mutex);
+        s->worker[i].handle = handle;
+        if( handle >= 0 )
+        {
+            s->worker[i].riconnetti = 0;
+        }
+        else
+        {
+            s->worker[i].prossimoTentativo = poll_ms() + 5000;
+        }
+        pthread_mutex_unlock(&s->mutex);
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    s->pausa = 0;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+}
+
+
+void poll_aggiorna(PollScheduler *s, FiltroTable *table)
+{
+    /*
+     *  ricostruisce l'elenco degli indirizzi da leggere dai filtri validi con
+     *  intervallo > 0; gli indirizzi gia' presenti mantengono le loro scadenze,
+     *  i nuovi vengono distribuiti a caso nel primo intervallo
+     */
+    PollEntry *entries;
+    PollEntry *vecchio;
+    FiltroEntry *f;
+    int64_t now;
+    int n = 0;
+    int i;
+
+    pthread_mutex_lock(&s->mutex);
+    entries = (PollEntry*) calloc(table->count + 1, sizeof(PollEntry));
+    if( entries == NULL )
+    {
+        pthread_mutex_unlock(&s->mutex);
+        return;
+    }
+
+    now = poll_ms();
+    for( i = 0; i < FILTRO_BUCKETS; i++ )
+    {
+        for( f = table->bucket[i]; f != NULL; f = f->next )
+        {
+            if( !f->filtro.valid || !f->group || f->filtro.pollInterval <= 0 )
+            {
+                continue;
+            }
+            vecchio = poll_cerca(s, f->indirizzo);
+            if( vecchio != NULL )
+            {
+                entries[n] = *vecchio;
+            }
+            else
+            {
+                entries[n].indirizzo = f->indirizzo;
+                entries[n].prossimo = now + rand_r(&s->seme) % ((unsigned int)f->filtro.pollInterval * 1000 + 1);
+            }
+            entries[n].intervallo = f->filtro.pollInterval;
+            n++;
+        }
+    }
+
+    free(s->entries);
+    s->entries = entries;
+    s->n = n;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+}
+
+
+int poll_duplicato(PollScheduler *s, uint16_t indirizzo, int letto,
+                   unsigned char *dati, int lunghezza, int64_t tempo)
+{
+    /*
+     *  da chiamare per ogni telegramma di un indirizzo letto periodicamente,
+     *  sia del monitor (letto = 0) sia di enmx_read() (letto = 1): il valore
+     *  e' appena stato visto, quindi la lettura successiva viene rimandata;
+     *  la copia del monitor di una risposta trattenuta prende il suo posto
+     *  perche' ha il mittente reale
+     *  return 1: stessa risposta gia' vista dall'altra parte, da scartare
+     *  return 0: telegramma nuovo
+     */
+    PollEntry *entry;
+    int duplicato = 0;
+
+    if( lunghezza > POLL_DATI )
+    {
+        lunghezza = POLL_DATI;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    entry = poll_cerca(s, indirizzo);
+    if( entry != NULL )
+    {
+        if( !letto && entry->rispostaScadenza != 0 &&
+            entry->rispostaLunghezza == lunghezza && memcmp(entry->rispostaDati, dati, lunghezza) == 0 )
+        {
+            //la risposta trattenuta non viene piu' registrata, resta questa copia
+            entry->rispostaScadenza = 0;
+            entry->ultimoTempo = tempo;
+            entry->ultimoLetto = 0;
+            entry->ultimaLunghezza = lunghezza;
+            memcpy(entry->ultimiDati, dati, lunghezza);
+        }
+        else if( entry->ultimoLetto != (letto != 0) && tempo - entry->ultimoTempo < POLL_ECO &&
+            entry->ultimaLunghezza == lunghezza && memcmp(entry->ultimiDati, dati, lunghezza) == 0 )
+        {
+            duplicato = 1;
+            //la copia seguente non e' piu' un doppione
+            entry->ultimoTempo = 0;
+        }
+        else
+        {
+            entry->ultimoTempo = tempo;
+            entry->ultimoLetto = (letto != 0);
+            entry->ultimaLunghezza = lunghezza;
+            memcpy(entry->ultimiDati, dati, lunghezza);
+        }
+        if( !entry->inCorso )
+        {
+            entry->prossimo = tempo + poll_intervallo(s, entry->intervallo);
+        }
+    }
+    pthread_mutex_unlock(&s->mutex);
+    return duplicato;
+}
+
+
+void poll_destroy(PollScheduler *s)
+{
+    /*
+     *  ferma i thread (una lettura in corso termina con il timeout di
+     *  eibnetmux) e chiude le connessioni
+     */
+    int i;
+
+    if( s == NULL )
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    s->stop = 1;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+
+    for( i = 0; i < s->connessioni; i++ )
+    {
+        pthread_join(s->worker[i].thread, NULL);
+    }
+    printf("Polling: %lu reads, %lu failed\n", s->letture, s->errori);
+    poll_libera(s);
+}
@@ -0,0 +1,121 @@
+/*
+ * File:   poll.h
+ *
+ * Lettura periodica (polling) degli indirizzi di gruppo che non inviano
+ * valori ciclici, come alcuni contatori di energia. L'intervallo e' quello
+ * del filtro dell'indirizzo (colonna <poll> del file, PollInterval nel
+ * database); 0 = solo ascolto.
+ *
+ * Ogni thread di lettura ha una propria connessione a eibnetmux, separata da
+ * quella del monitor, e ha al piu' una enmx_read() in corso: il numero di
+ * connessioni limita le letture contemporanee. Le letture di tutti i thread
+ * rispettano un unico budget di telegrammi al secondo e ogni intervallo viene
+ * variato a caso di +/- jitter % perche' le letture non si concentrino.
+ * Un indirizzo non viene letto se un suo telegramma e' gia' passato sul bus
+ * nell'ultimo intervallo.
+ *
+ * La risposta viene vista anche dal monitor, con il mittente reale: quella di
+ * enmx_read() viene trattenuta per POLL_ATTESA ms e scartata se nel frattempo
+ * arriva la copia del monitor (poll_duplicato). Altrimenti viene trasformata
+ * in un CEMIFRAME (mittente 0.0.0, non noto) e passata alla callback, che la
+ * inserisce nella stessa decodifica dei telegrammi del monitor.
+ *
+ * La tabella delle connessioni di libeibnetmux non e' protetta se la libreria
+ * non e' compilata con ENMX_THREADSAFE e puo' essere riallocata da
+ * enmx_open(): enmx_open() e enmx_close() vengono chiamate solo dal thread
+ * del monitor, prima di avviare i thread e poi da poll_riconnetti() per le
+ * connessioni perse, fuori da enmx_monitor() e con tutti i thread di lettura
+ * fermi e nessuna enmx_read() in corso.
+ */
+
+#ifndef _POLL_H
+#define	_POLL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "eibtrace.h"
+#include "filtro.h"
+
+#define POLL_CONNESSIONI_MAX    8
+#define POLL_ECO                2000        // ms entro cui due telegrammi uguali sono la stessa risposta
+#define POLL_DATI               17          // byte confrontati, apci + data
+#define POLL_ATTESA             500         // ms di attesa della copia del monitor di una risposta
+
+/* chiamata dal thread di lettura per ogni risposta */
+typedef void (*PollCallback)(CEMIFRAME *cemiframe, uint16_t lunghezza, void *arg);
+
+typedef struct
+{
+    uint16_t indirizzo;                     // indirizzo di gruppo (host order)
+    int intervallo;                         // secondi
+    int64_t prossimo;                       // ms della prossima lettura
+    my_bool inCorso;
+
+    //ultimo telegramma visto, per scartare la seconda copia di una risposta
+    int64_t ultimoTempo;
+    my_bool ultimoLetto;                    // 1 = da enmx_read, 0 = dal monitor
+    uint8_t ultimaLunghezza;
+    unsigned char ultimiDati[POLL_DATI];
+
+    //risposta di enmx_read() in attesa della copia del monitor
+    int64_t rispostaScadenza;               // ms, 0 = nessuna
+    uint8_t rispostaLunghezza;
+    unsigned char rispostaDati[POLL_DATI];
+} PollEntry;
+
+typedef struct PollScheduler PollScheduler;
+
+typedef struct
+{
+    PollScheduler *scheduler;
+    ENMX_HANDLE handle;
+    pthread_t thread;
+    int riconnetti;                         // connessione persa, la riapre poll_riconnetti()
+    int64_t prossimoTentativo;              // ms
+} PollWorker;
+
+struct PollScheduler
+{
+    char target[64];
+    PollEntry *entries;
+    int n;
+
+    PollWorker worker[POLL_CONNESSIONI_MAX];
+    int connessioni;
+    int budget;                             // letture al secondo, 0 = nessun limite
+    int jitter;                             // % dell'intervallo
+    int64_t prossimoToken;                  // ms dal quale e' consentita la prossima lettura
+    unsigned int seme;
+
+    PollCallback callback;
+    void *arg;
+
+    int stop;
+    int pausa;                              // poll_riconnetti() in corso, nessuna nuova lettura
+    int inLettura;                          // enmx_read() in corso
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    unsigned long letture;
+    unsigned long errori;
+};
+
+
+PollScheduler *poll_create(char *target, int connessioni, int budget, int jitter,
+                           PollCallback callback, void *arg);
+void poll_aggiorna(PollScheduler *scheduler, FiltroTable *table);
+void poll_riconnetti(PollScheduler *scheduler);
+int poll_duplicato(PollScheduler *scheduler, uint16_t indirizzo, int letto,
+                   unsigned char *dati, int lunghezza, int64_t tempo);
+void poll_destroy(PollScheduler *scheduler);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _POLL_H */
@@ -0,0 +1,199 @@
+/*
+ * File:   rollup.c
+ *
+ * Aggregazione incrementale per Destinatario (vedi rollup.h).
+ * Gli intervalli sono allineati all'ora locale, cosi' il giorno va da
+ * mezzanotte a mezzanotte.
+ */
+
+#include "rollup.h"
+#include "filtro.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+const int rollup_durata[ROLLUP_LEVELS] = { 60, 900, 3600, 86400 };
+char *rollup_tabella[ROLLUP_LEVELS] = { "rollup_1m", "rollup_15m", "rollup_1h", "rollup_1d" };
+
+
+static unsigned int rollup_hash(uint16_t indirizzo, int group)
+{
+    return (indirizzo ^ (indirizzo >> 10) ^ (group ? 0x200 : 0)) % ROLLUP_BUCKETS;
+}
+
+
+static time_t rollup_allinea(time_t tempo, int durata)
+{
+    struct tm local;
+    long offset;
+
+    localtime_r(&tempo, &local);
+    offset = local.tm_gmtoff;
+    return ((tempo + offset) / durata) * durata - offset;
+}
+
+
+static void rollup_scrivi(Rollup *rollup, int level)
+{
+    /*
+     *  scrive una riga per ogni indirizzo con valori nell'intervallo del livello
+     *  e azzera gli aggregati
+     */
+    RollupRow *rows;
+    RollupEntry *entry;
+    RollupStat *stat;
+    int n = 0;
+    int i;
+
+    rows = (RollupRow*) malloc(rollup->count * sizeof(RollupRow) + 1);
+    if( rows == NULL )
+    {
+        return;
+    }
+
+    for( i = 0; i < ROLLUP_BUCKETS; i++ )
+    {
+        for( entry = rollup->bucket[i]; entry != NULL; entry = entry->next )
+        {
+            stat = &entry->stat[level];
+            if( stat->conteggio == 0 )
+            {
+                continue;
+            }
+            rows[n].inizio = rollup->inizio[level];
+            filtro_format_address(entry->indirizzo, entry->group, rows[n].destinatario, sizeof(rows[n].destinatario));
+            rows[n].conteggio = stat->conteggio;
+            rows[n].minimo = stat->minimo;
+            rows[n].massimo = stat->massimo;
+            rows[n].somma = stat->somma;
+            rows[n].ultimo = stat->ultimo;
+            rows[n].delta = stat->ultimo - stat->inizio;
+            n++;
+            stat->conteggio = 0;
+        }
+    }
+
+    if( n > 0 && rollup->writer(rollup_tabella[level], rows, n, rollup->arg) != 0 )
+    {
+        fprintf(stderr, "Rollup: %d rows for %s lost\n", n, rollup_tabella[level]);
+    }
+    free(rows);
+}
+
+
+void rollup_init(Rollup *rollup, RollupWriter writer, void *arg)
+{
+    memset(rollup, 0, sizeof(Rollup));
+    rollup->writer = writer;
+    rollup->arg = arg;
+}
+
+
+void rollup_tick(Rollup *rollup, time_t now)
+{
+    int level;
+
+    for( level = 0; level < ROLLUP_LEVELS; level++ )
+    {
+        if( rollup->inizio[level] == 0 )
+        {
+            rollup->inizio[level] = rollup_allinea(now, rollup_durata[level]);
+        }
+        else if( now >= rollup->inizio[level] + rollup_durata[level] || now < rollup->inizio[level] )
+        {
+            rollup_scrivi(rollup, level);
+            rollup->inizio[level] = rollup_allinea(now, rollup_durata[level]);
+        }
+    }
+}
+
+
+void rollup_add(Rollup *rollup, time_t tempo, uint16_t indirizzo, int group, float valore)
+{
+    RollupEntry *entry;
+    RollupStat *stat;
+    unsigned int h;
+    int level;
+
+    rollup_tick(rollup, tempo);
+    if( !isfinite(valore) )
+    {
+        return;
+    }
+
+    group = (group != 0);
+    h = rollup_hash(indirizzo, group);
+    for( entry = rollup->bucket[h]; entry != NULL; entry = entry->next )
+    {
+        if( entry->indirizzo == indirizzo && entry->group == group ) break;
+    }
+    if( entry == NULL )
+    {
+        entry = (RollupEntry*) malloc(sizeof(RollupEntry));
+        if( entry == NULL ) return;
+        memset(entry, 0, sizeof(RollupEntry));
+        entry->indirizzo = indirizzo;
+        entry->group = group;
+        entry->next = rollup->bucket[h];
+        rollup->bucket[h] = entry;
+        rollup->count++;
+    }
+
+    for( level = 0; level < ROLLUP_LEVELS; level++ )
+    {
+        stat = &entry->stat[level];
+        if( stat->conteggio == 0 )
+        {
+            stat->minimo = valore;
+            stat->massimo = valore;
+            stat->somma = 0;
+            stat->inizio = entry->hasLast ? entry->last : valore;
+        }
+        stat->conteggio++;
+        if( valore < stat->minimo ) stat->minimo = valore;
+        if( valore > stat->massimo ) stat->massimo = valore;
+        stat->somma += valore;
+        stat->ultimo = valore;
+    }
+    entry->last = valore;
+    entry->hasLast = 1;
+}
+
+
+void rollup_flush_all(Rollup *rollup)
+{
+    /*
+     *  scrive gli intervalli in corso (es. all'uscita); le righe parziali vengono
+     *  unite a quelle gia' presenti dall'INSERT ... ON DUPLICATE KEY UPDATE
+     */
+    int level;
+
+    for( level = 0; level < ROLLUP_LEVELS; level++ )
+    {
+        if( rollup->inizio[level] != 0 )
+        {
+            rollup_scrivi(rollup, level);
+        }
+    }
+}
+
+
+void rollup_free(Rollup *rollup)
+{
+    int i;
+    RollupEntry *entry;
+
+    for( i = 0; i < ROLLUP_BUCKETS; i++ )
+    {
+        while( rollup->bucket[i] != NULL )
+        {
+            entry = rollup->bucket[i];
+            rollup->bucket[i] = entry->next;
+            free(entry);
+        }
+    }
+    rollup->count = 0;
+}
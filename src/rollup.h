@@ -0,0 +1,82 @@
+/*
+ * File:   rollup.h
+ *
+ * Aggregazione incrementale dei valori per Destinatario su intervalli di
+ * 1 minuto, 15 minuti, 1 ora e 1 giorno. Gli aggregati vengono mantenuti in
+ * memoria mentre i telegrammi vengono decodificati e, alla fine di ogni
+ * intervallo, scritti come una riga per indirizzo nella tabella del livello
+ * (rollup_1m, rollup_15m, rollup_1h, rollup_1d).
+ */
+
+#ifndef _ROLLUP_H
+#define	_ROLLUP_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <time.h>
+
+#define ROLLUP_LEVELS       4
+#define ROLLUP_BUCKETS      1024
+
+typedef struct
+{
+    uint32_t conteggio;
+    float minimo;
+    float massimo;
+    double somma;
+    float ultimo;
+    float inizio;               // ultimo valore prima dell'intervallo, per il delta dei contatori
+} RollupStat;
+
+typedef struct RollupEntry
+{
+    uint16_t indirizzo;
+    int group;
+    int hasLast;
+    float last;
+    RollupStat stat[ROLLUP_LEVELS];
+    struct RollupEntry *next;
+} RollupEntry;
+
+typedef struct
+{
+    time_t inizio;
+    char destinatario[10];
+    uint32_t conteggio;
+    float minimo;
+    float massimo;
+    double somma;
+    float ultimo;
+    float delta;                // ultimo - valore prima dell'intervallo (consumo per i contatori)
+} RollupRow;
+
+/* scrive n righe nella tabella, return 0 se ok */
+typedef int (*RollupWriter)(char *tabella, RollupRow *rows, int n, void *arg);
+
+typedef struct
+{
+    RollupEntry *bucket[ROLLUP_BUCKETS];
+    int count;
+    time_t inizio[ROLLUP_LEVELS];       // inizio dell'intervallo corrente per livello
+    RollupWriter writer;
+    void *arg;
+} Rollup;
+
+extern const int rollup_durata[ROLLUP_LEVELS];
+extern char *rollup_tabella[ROLLUP_LEVELS];
+
+
+void rollup_init(Rollup *rollup, RollupWriter writer, void *arg);
+void rollup_add(Rollup *rollup, time_t tempo, uint16_t indirizzo, int group, float valore);
+void rollup_tick(Rollup *rollup, time_t now);
+void rollup_flush_all(Rollup *rollup);
+void rollup_free(Rollup *rollup);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _ROLLUP_H */
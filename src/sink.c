@@ -0,0 +1,333 @@
+/*
+ * File:   sink.c
+ *
+ * Code e thread di scrittura delle sink (vedi sink.h).
+ */
+
+#include "sink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+
+
+static const SinkOps *sink_tipi[] =
+{
+    &sink_mysql_ops,
+    &sink_tsstore_ops,
+    &sink_sqlite_ops,
+    &sink_spool_ops,
+    &sink_raw_ops,
+    &sink_udp_ops,
+    &sink_unix_ops,
+    NULL
+};
+
+
+static void *sink_thread(void *arg)
+{
+    Sink *sink = (Sink*) arg;
+    SinkRecord *batch;
+    struct timeval now;
+    struct timespec scadenza;
+    int n, i;
+    int daScaricare = 0;
+
+    batch = (SinkRecord*) malloc(SINK_BATCH * sizeof(SinkRecord));
+    if( batch == NULL )
+    {
+        fprintf(stderr, "Sink %s: out of memory\n", sink->nome);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&sink->mutex);
+    for( ;; )
+    {
+        while( sink->conteggio == 0 && !sink->stop )
+        {
+            gettimeofday(&now, NULL);
+            scadenza.tv_sec = now.tv_sec + SINK_FLUSH / 1000;
+            scadenza.tv_nsec = now.tv_usec * 1000 + (SINK_FLUSH % 1000) * 1000000L;
+            if( scadenza.tv_nsec >= 1000000000L )
+            {
+                scadenza.tv_sec++;
+                scadenza.tv_nsec -= 1000000000L;
+            }
+            if( pthread_cond_timedwait(&sink->cond, &sink->mutex, &scadenza) == ETIMEDOUT && daScaricare )
+            {
+                pthread_mutex_unlock(&sink->mutex);
+                sink->ops->flush(sink);
+                daScaricare = 0;
+                pthread_mutex_lock(&sink->mutex);
+            }
+        }
+        if( sink->conteggio == 0 )
+        {
+            break;
+        }
+
+        n = (sink->conteggio < SINK_BATCH) ? sink->conteggio : SINK_BATCH;
+        for( i = 0; i < n; i++ )
+        {
+            batch[i] = sink->coda[(sink->testa + i) % SINK_CODA];
+        }
+        sink->testa = (sink->testa + n) % SINK_CODA;
+        sink->conteggio -= n;
+        pthread_cond_broadcast(&sink->spazio);
+        pthread_mutex_unlock(&sink->mutex);
+
+        i = sink->ops->write_batch(sink, batch, n);
+        daScaricare = 1;
+
+        pthread_mutex_lock(&sink->mutex);
+        if( i == 0 )
+        {
+            sink->scritti += n;
+        }
+        else if( i != SINK_RINVIATO )
+        {
+            sink->errori += n;
+        }
+    }
+    pthread_mutex_unlock(&sink->mutex);
+
+    sink->ops->flush(sink);
+    sink->ops->close(sink);
+    free(batch);
+    return NULL;
+}
+
+
+Sink *sink_create(char *spec, SinkConfig *config)
+{
+    /*
+     *  spec = "tipo[:opzioni]"
+     *  return NULL: tipo sconosciuto, apertura fallita o memoria insufficiente
+     */
+    Sink *sink;
+    char tipo[32];
+    char *opzioni;
+    size_t len;
+    int i;
+
+    opzioni = strchr(spec, ':');
+    len = (opzioni != NULL) ? (size_t)(opzioni - spec) : strlen(spec);
+    if( len >= sizeof(tipo) )
+    {
+        return NULL;
+    }
+    memcpy(tipo, spec, len);
+    tipo[len] = 0;
+    opzioni = (opzioni != NULL) ? opzioni + 1 : "";
+
+    for( i = 0; sink_tipi[i] != NULL; i++ )
+    {
+        if( strcmp(sink_tipi[i]->tipo, tipo) == 0 ) break;
+    }
+    if( sink_tipi[i] == NULL )
+    {
+        fprintf(stderr, "Unknown sink type '%s'\n", tipo);
+        return NULL;
+    }
+
+    sink = (Sink*) calloc(1, sizeof(Sink));
+    if( sink == NULL )
+    {
+        return NULL;
+    }
+    sink->coda = (SinkRecord*) malloc(SINK_CODA * sizeof(SinkRecord));
+    if( sink->coda == NULL )
+    {
+        free(sink);
+        return NULL;
+    }
+    sink->ops = sink_tipi[i];
+    snprintf(sink->nome, sizeof(sink->nome), "%s", spec);
+
+    if( sink->ops->open(sink, opzioni, config) != 0 )
+    {
+        fprintf(stderr, "Cannot open sink '%s'\n", spec);
+        free(sink->coda);
+        free(sink);
+        return NULL;
+    }
+
+    pthread_mutex_init(&sink->mutex, NULL);
+    pthread_cond_init(&sink->cond, NULL);
+    pthread_cond_init(&sink->spazio, NULL);
+    if( pthread_create(&sink->thread, NULL, sink_thread, sink) != 0 )
+    {
+        sink->ops->close(sink);
+        pthread_mutex_destroy(&sink->mutex);
+        pthread_cond_destroy(&sink->cond);
+        pthread_cond_destroy(&sink->spazio);
+        free(sink->coda);
+        free(sink);
+        return NULL;
+    }
+    return sink;
+}
+
+
+int sink_push(Sink *sink, SinkRecord *records, int n)
+{
+    /*
+     *  copia i record in coda senza attendere la scrittura
+     *  return: numero di record scartati perche' la coda e' piena
+     */
+    int i;
+    int liberi;
+    int persi = 0;
+
+    pthread_mutex_lock(&sink->mutex);
+    liberi = SINK_CODA - sink->conteggio;
+    if( n > liberi )
+    {
+        persi = n - liberi;
+        n = liberi;
+        sink->persi += persi;
+    }
+    for( i = 0; i < n; i++ )
+    {
+        sink->coda[(sink->testa + sink->conteggio + i) % SINK_CODA] = records[i];
+    }
+    sink->conteggio += n;
+    pthread_cond_signal(&sink->cond);
+    pthread_mutex_unlock(&sink->mutex);
+    return persi;
+}
+
+
+void sink_push_attendi(Sink *sink, SinkRecord *records, int n)
+{
+    /*
+     *  come sink_push, ma se la coda e' piena attende che il thread la svuoti
+     *  (importazioni, dove nessun record deve andare perso)
+     */
+    int i;
+    int liberi;
+
+    pthread_mutex_lock(&sink->mutex);
+    while( n > 0 )
+    {
+        while( sink->conteggio == SINK_CODA )
+        {
+            pthread_cond_wait(&sink->spazio, &sink->mutex);
+        }
+        liberi = SINK_CODA - sink->conteggio;
+        if( liberi > n )
+        {
+            liberi = n;
+        }
+        for( i = 0; i < liberi; i++ )
+        {
+            sink->coda[(sink->testa + sink->conteggio + i) % SINK_CODA] = records[i];
+        }
+        sink->conteggio += liberi;
+        records += liberi;
+        n -= liberi;
+        pthread_cond_signal(&sink->cond);
+    }
+    pthread_mutex_unlock(&sink->mutex);
+}
+
+
+int sink_arretrati(Sink *sink)
+{
+    //record ancora in coda, usato dalle sink per scegliere come scrivere
+    int n;
+
+    pthread_mutex_lock(&sink->mutex);
+    n = sink->conteggio;
+    pthread_mutex_unlock(&sink->mutex);
+    return n;
+}
+
+
+int sink_attendi(Sink *sink, int secondi)
+{
+    /*
+     *  pausa del thread di scrittura prima di un nuovo tentativo; nel frattempo
+     *  i record restano in coda
+     *  return 1: chiusura richiesta, non si deve piu' attendere
+     *  return 0: pausa terminata
+     */
+    struct timeval now;
+    struct timespec scadenza;
+
+    gettimeofday(&now, NULL);
+    scadenza.tv_sec = now.tv_sec + secondi;
+    scadenza.tv_nsec = now.tv_usec * 1000;
+
+    pthread_mutex_lock(&sink->mutex);
+    while( !sink->stop )
+    {
+        //anche sink_push segnala cond: si attende fino alla scadenza
+        if( pthread_cond_timedwait(&sink->cond, &sink->mutex, &scadenza) == ETIMEDOUT )
+        {
+            break;
+        }
+    }
+    secondi = sink->stop;
+    pthread_mutex_unlock(&sink->mutex);
+    return secondi;
+}
+
+
+void sink_conta(Sink *sink, unsigned long scritti, unsigned long errori)
+{
+    //per le sink che scrivono i record dopo averli trattenuti (write_batch = SINK_RINVIATO)
+    pthread_mutex_lock(&sink->mutex);
+    sink->scritti += scritti;
+    sink->errori += errori;
+    pthread_mutex_unlock(&sink->mutex);
+}
+
+
+void sink_fanout(Sink *sinks, SinkRecord *records, int n)
+{
+    Sink *sink;
+
+    if( n <= 0 )
+    {
+        return;
+    }
+    for( sink = sinks; sink != NULL; sink = sink->next )
+    {
+        sink_push(sink, records, n);
+    }
+}
+
+
+void sink_destroy_all(Sink *sinks)
+{
+    /*
+     *  svuota le code, chiude le sink e ne libera la memoria
+     */
+    Sink *sink;
+    Sink *next;
+
+    for( sink = sinks; sink != NULL; sink = sink->next )
+    {
+        pthread_mutex_lock(&sink->mutex);
+        sink->stop = 1;
+        pthread_cond_signal(&sink->cond);
+        pthread_mutex_unlock(&sink->mutex);
+    }
+
+    for( sink = sinks; sink != NULL; sink = next )
+    {
+        next = sink->next;
+        pthread_join(sink->thread, NULL);
+        printf("Sink %s: %lu written, %lu dropped (queue full), %lu failed\n",
+               sink->nome, sink->scritti, sink->persi, sink->errori);
+        pthread_mutex_destroy(&sink->mutex);
+        pthread_cond_destroy(&sink->cond);
+        pthread_cond_destroy(&sink->spazio);
+        free(sink->coda);
+        free(sink);
+    }
+}
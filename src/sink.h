@@ -0,0 +1,137 @@
+/*
+ * File:   sink.h
+ *
+ * Destinazioni dei valori decodificati. Ogni sink ha le operazioni
+ * open / write_batch / flush / close, una propria coda in memoria e un
+ * proprio thread di scrittura: il ciclo di cattura copia ogni lotto di
+ * record nelle code di tutte le sink configurate (sink_fanout) senza mai
+ * aspettare la scrittura, cosi' una sink lenta non blocca le altre.
+ *
+ * Le sink si configurano con una stringa "tipo[:opzioni]":
+ *
+ *   mysql                  tabella dati (o dati_v2 con schema: 2)
+ *   tsstore:<dir>          archivio locale (vedi tsstore.h)
+ *   sqlite:<file>          database SQLite in modalita' WAL
+ *   spool:<file>           file binario di record, vedi SPOOL_MAGIC
+ *   raw:<dir>              archivio compresso dei telegrammi (vedi archivio.h)
+ *   udp:<host>:<porta>     line protocol (InfluxDB) su datagrammi UDP
+ *   unix:<path>            line protocol su socket UNIX datagram
+ */
+
+#ifndef _SINK_H
+#define	_SINK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define SINK_MAX            8
+#define SINK_CEMI_MAX       27          // sizeof(CEMIFRAME)
+#define SINK_BATCH          512         // record scritti al massimo per chiamata a write_batch
+#define SINK_CODA           65536       // record in coda per sink, oltre vengono scartati
+#define SINK_FLUSH          1000        // ms senza nuovi record dopo i quali viene chiamata flush
+#define SINK_LOTTO_MS       200         // ms massimi di attesa di un lotto nel ciclo di cattura
+#define SINK_RETRY_MAX      60          // secondi massimi tra due tentativi di una sink che non riesce a scrivere
+#define SINK_BULK_SOGLIA    8192        // record in coda oltre i quali la sink mysql passa a LOAD DATA
+#define SINK_BULK_RIGHE     50000       // righe massime per ogni LOAD DATA
+
+#define SINK_RINVIATO       -1          // write_batch: record trattenuti dalla sink, li conta lei con sink_conta
+
+#define SPOOL_MAGIC         "EDCSP001"
+#define SPOOL_HEADER_SIZE   8
+#define SPOOL_RECORD_SIZE   (18 + SINK_CEMI_MAX)
+
+typedef struct
+{
+    int64_t tempo;                      // ms dal 1970
+    uint16_t mittente;                  // indirizzi in host order
+    uint16_t destinatario;
+    uint8_t group;
+    uint8_t lunghezza;                  // byte validi in cemi
+    float valore;
+    unsigned char cemi[SINK_CEMI_MAX];  // telegramma originale
+} SinkRecord;
+
+/* parametri comuni passati a tutte le sink alla creazione */
+typedef struct
+{
+    char *dbUser;
+    char *dbPwd;
+    char *dbIP;
+    int dbPort;
+    char *dbDatabase;
+    int schema;
+    int partizioniMese;
+    int retention;
+    int tsPerAddress;
+    char *sqliteSynchronous;            // PRAGMA synchronous
+    long sqliteMmap;                    // PRAGMA mmap_size, 0 = non impostato
+    int sqliteBatch;                    // righe per transazione
+    int sqliteCheckpoint;               // secondi tra due checkpoint, 0 = automatico di SQLite
+} SinkConfig;
+
+typedef struct Sink Sink;
+
+typedef struct
+{
+    char *tipo;
+    int (*open)(Sink *sink, char *opzioni, SinkConfig *config);    // 0 = ok
+    int (*write_batch)(Sink *sink, SinkRecord *records, int n);     // 0 = ok, SINK_RINVIATO
+    int (*flush)(Sink *sink);
+    void (*close)(Sink *sink);
+} SinkOps;
+
+struct Sink
+{
+    const SinkOps *ops;
+    void *dati;                         // stato privato della sink
+    char nome[64];
+
+    //coda circolare, protetta da mutex
+    SinkRecord *coda;
+    int testa;
+    int conteggio;
+    int stop;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_cond_t spazio;              // segnalata quando il thread svuota la coda
+    pthread_t thread;
+
+    unsigned long scritti;
+    unsigned long persi;                // coda piena
+    unsigned long errori;               // write_batch fallita
+
+    Sink *next;
+};
+
+/* chiamata per ogni record letto da uno spool, un valore diverso da 0 interrompe la lettura */
+typedef int (*SpoolCallback)(SinkRecord *record, void *arg);
+
+
+Sink *sink_create(char *spec, SinkConfig *config);
+int sink_push(Sink *sink, SinkRecord *records, int n);
+void sink_push_attendi(Sink *sink, SinkRecord *records, int n);
+int sink_arretrati(Sink *sink);
+int sink_attendi(Sink *sink, int secondi);
+void sink_conta(Sink *sink, unsigned long scritti, unsigned long errori);
+void sink_fanout(Sink *sinks, SinkRecord *records, int n);
+void sink_destroy_all(Sink *sinks);
+
+int spool_read(char *path, SpoolCallback callback, void *arg);
+
+extern const SinkOps sink_mysql_ops;
+extern const SinkOps sink_tsstore_ops;
+extern const SinkOps sink_sqlite_ops;
+extern const SinkOps sink_spool_ops;
+extern const SinkOps sink_raw_ops;
+extern const SinkOps sink_udp_ops;
+extern const SinkOps sink_unix_ops;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _SINK_H */
@@ -0,0 +1,195 @@
+/*
+ * File:   sink_line.c
+ *
+ * Sink in line protocol (InfluxDB, Telegraf, ...) su datagrammi UDP o UNIX:
+ *
+ *   knx,dst=1/2/3,src=1.1.1 value=21.5 1287482112123000000
+ *
+ * Piu' righe vengono raccolte nello stesso datagramma fino a LINE_DATAGRAM byte.
+ * L'invio non blocca mai: se il ricevitore non c'e' i dati vengono persi.
+ *
+ * Opzioni: udp:<host>:<porta>, unix:<path>
+ */
+
+#include "sink.h"
+#include "filtro.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define LINE_DATAGRAM       1400
+#define LINE_MAX_LEN        128
+
+
+typedef struct
+{
+    int fd;
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+} SinkLine;
+
+
+static int sink_line_invia(SinkLine *line, char *buf, size_t len)
+{
+    if( len == 0 )
+    {
+        return 0;
+    }
+    if( sendto(line->fd, buf, len, MSG_DONTWAIT, (struct sockaddr*) &line->addr, line->addrlen) < 0 )
+    {
+        return 1;
+    }
+    return 0;
+}
+
+
+static int sink_udp_open(Sink *sink, char *opzioni, SinkConfig *config)
+{
+    SinkLine *line;
+    struct addrinfo hints;
+    struct addrinfo *res;
+    char host[256];
+    char *porta;
+
+    porta = strrchr(opzioni, ':');
+    if( porta == NULL || (size_t)(porta - opzioni) >= sizeof(host) )
+    {
+        return 1;
+    }
+    memcpy(host, opzioni, porta - opzioni);
+    host[porta - opzioni] = 0;
+    porta++;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    if( getaddrinfo(host, porta, &hints, &res) != 0 )
+    {
+        return 1;
+    }
+
+    line = (SinkLine*) calloc(1, sizeof(SinkLine));
+    if( line == NULL )
+    {
+        freeaddrinfo(res);
+        return 1;
+    }
+    line->fd = socket(res->ai_family, SOCK_DGRAM, 0);
+    memcpy(&line->addr, res->ai_addr, res->ai_addrlen);
+    line->addrlen = res->ai_addrlen;
+    freeaddrinfo(res);
+    if( line->fd < 0 )
+    {
+        free(line);
+        return 1;
+    }
+    sink->dati = line;
+    return 0;
+}
+
+
+static int sink_unix_open(Sink *sink, char *opzioni, SinkConfig *config)
+{
+    SinkLine *line;
+    struct sockaddr_un *un;
+
+    if( opzioni[0] == 0 || strlen(opzioni) >= sizeof(un->sun_path) )
+    {
+        return 1;
+    }
+    line = (SinkLine*) calloc(1, sizeof(SinkLine));
+    if( line == NULL )
+    {
+        return 1;
+    }
+    line->fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if( line->fd < 0 )
+    {
+        free(line);
+        return 1;
+    }
+    un = (struct sockaddr_un*) &line->addr;
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, opzioni);
+    line->addrlen = sizeof(struct sockaddr_un);
+    sink->dati = line;
+    return 0;
+}
+
+
+static int sink_line_write_batch(Sink *sink, SinkRecord *records, int n)
+{
+    SinkLine *line = (SinkLine*) sink->dati;
+    char buf[LINE_DATAGRAM + LINE_MAX_LEN];
+    char mittente[16];
+    char destinatario[16];
+    size_t len = 0;
+    size_t riga;
+    int errori = 0;
+    int i;
+
+    for( i = 0; i < n; i++ )
+    {
+        if( !isfinite(records[i].valore) )
+        {
+            continue;
+        }
+        filtro_format_address(records[i].mittente, 0, mittente, sizeof(mittente));
+        filtro_format_address(records[i].destinatario, records[i].group, destinatario, sizeof(destinatario));
+        riga = snprintf(buf + len, LINE_MAX_LEN, "knx,dst=%s,src=%s value=%.7g %lld000000\n",
+                        destinatario, mittente, records[i].valore, (long long) records[i].tempo);
+        if( len + riga > LINE_DATAGRAM )
+        {
+            //la riga appena scritta va all'inizio del prossimo datagramma
+            errori += sink_line_invia(line, buf, len);
+            memmove(buf, buf + len, riga);
+            len = 0;
+        }
+        len += riga;
+    }
+    errori += sink_line_invia(line, buf, len);
+    return (errori > 0);
+}
+
+
+static int sink_line_flush(Sink *sink)
+{
+    return 0;
+}
+
+
+static void sink_line_close(Sink *sink)
+{
+    SinkLine *line = (SinkLine*) sink->dati;
+
+    close(line->fd);
+    free(line);
+    sink->dati = NULL;
+}
+
+
+const SinkOps sink_udp_ops =
+{
+    "udp",
+    sink_udp_open,
+    sink_line_write_batch,
+    sink_line_flush,
+    sink_line_close
+};
+
+const SinkOps sink_unix_ops =
+{
+    "unix",
+    sink_unix_open,
+    sink_line_write_batch,
+    sink_line_flush,
+    sink_line_close
+};
@@ -0,0 +1,250 @@
+/*
+ * File:   sink_mysql.c
+ *
+ * Sink MySQL: scrive ogni lotto con un'unica INSERT multi-riga nella tabella
+ * dati, oppure in dati_v2 (con la gestione delle partizioni) se schema = 2.
+ * La connessione e' propria della sink e viene aperta dal suo thread.
+ * Se il database non e' raggiungibile il lotto viene riprovato con attese
+ * crescenti fino a SINK_RETRY_MAX secondi: intanto la coda si riempie e i
+ * record vengono scartati solo quando e' piena.
+ *
+ * Quando la coda accumula almeno SINK_BULK_SOGLIA record (ripresa dopo
+ * un'interruzione, importazione di uno spool) i lotti vengono raccolti e
+ * scritti con LOAD DATA LOCAL INFILE, fino a SINK_BULK_RIGHE righe alla
+ * volta; se il server non consente LOCAL INFILE si torna alle INSERT.
+ */
+
+#include "sink.h"
+#include "dbconnection.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+typedef struct
+{
+    SinkConfig config;
+    MYSQL *conn;
+    int threadInit;
+    time_t lastPartizioni;
+
+    //LOAD DATA
+    SinkRecord *bulk;
+    int nBulk;
+    int bulkNo;                     // LOCAL INFILE rifiutato, solo INSERT
+
+    int abbandona;                  // in chiusura con il database irraggiungibile: nessun nuovo tentativo
+} SinkMysql;
+
+
+static int sink_mysql_connetti(SinkMysql *db)
+{
+    if( !db->threadInit )
+    {
+        mysql_thread_init();
+        db->threadInit = 1;
+    }
+    if( start_db_connection_infile(&db->conn, db->config.dbUser, db->config.dbPwd, db->config.dbIP,
+                                   db->config.dbPort, db->config.dbDatabase) != 0 )
+    {
+        return 1;
+    }
+
+    if( db->config.schema == 2 )
+    {
+        if( create_dati_v2(db->conn, db->config.partizioniMese, time(NULL)) != 0 ||
+            partizioni_dati_v2(db->conn, db->config.partizioniMese, db->config.retention, time(NULL)) != 0 )
+        {
+            close_db_connection(&db->conn);
+            return 1;
+        }
+        db->lastPartizioni = time(NULL);
+    }
+    return 0;
+}
+
+
+static int sink_mysql_open(Sink *sink, char *opzioni, SinkConfig *config)
+{
+    SinkMysql *db;
+
+    db = (SinkMysql*) calloc(1, sizeof(SinkMysql));
+    if( db == NULL )
+    {
+        return 1;
+    }
+    db->config = *config;
+    sink->dati = db;
+    return 0;
+}
+
+
+static int sink_mysql_scrivi(Sink *sink, SinkRecord *records, int n, int bulk)
+{
+    /*
+     *  bulk = 1: LOAD DATA, altrimenti INSERT multi-riga; in caso di errore
+     *  di connessione o di esecuzione riprova finche' la sink non viene chiusa
+     *  return: come insert_dati_batch / load_dati_bulk
+     */
+    SinkMysql *db = (SinkMysql*) sink->dati;
+    int attesa = 1;
+    int ret = 3;
+
+    for( ;; )
+    {
+        if( db->conn == NULL && !db->abbandona )
+        {
+            sink_mysql_connetti(db);
+        }
+        if( db->conn != NULL )
+        {
+            if( db->config.schema == 2 && time(NULL) - db->lastPartizioni >= PARTIZIONI_CHECK )
+            {
+                partizioni_dati_v2(db->conn, db->config.partizioniMese, db->config.retention, time(NULL));
+                db->lastPartizioni = time(NULL);
+            }
+
+            if( bulk )
+            {
+                ret = load_dati_bulk(db->conn, db->config.schema, records, n);
+            }
+            else if( db->config.schema == 2 )
+            {
+                ret = insert_dati_v2_batch(db->conn, records, n);
+            }
+            else
+            {
+                ret = insert_dati_batch(db->conn, records, n);
+            }
+            if( ret != 3 )
+            {
+                return ret;
+            }
+
+            //connessione persa oppure partizione mancante: si riparte da zero
+            close_db_connection(&db->conn);
+        }
+
+        //il lotto resta in memoria e intanto la coda si riempie: si riprova con attese crescenti
+        if( attesa == 1 && !db->abbandona )
+        {
+            fprintf(stderr, "Sink %s: database unavailable, retrying\n", sink->nome);
+        }
+        if( db->abbandona || sink_attendi(sink, attesa) )
+        {
+            db->abbandona = 1;
+            return 3;
+        }
+        attesa = (attesa * 2 < SINK_RETRY_MAX) ? attesa * 2 : SINK_RETRY_MAX;
+    }
+}
+
+
+static int sink_mysql_scarica(Sink *sink)
+{
+    //scrive le righe raccolte per LOAD DATA e le conta nelle statistiche della sink
+    SinkMysql *db = (SinkMysql*) sink->dati;
+    int ret;
+    int i, n;
+
+    if( db->nBulk == 0 )
+    {
+        return 0;
+    }
+
+    ret = db->bulkNo ? 4 : sink_mysql_scrivi(sink, db->bulk, db->nBulk, 1);
+    if( ret == 4 && !db->bulkNo )
+    {
+        fprintf(stderr, "LOAD DATA LOCAL INFILE not allowed, using INSERT\n");
+        db->bulkNo = 1;
+    }
+    if( ret == 0 )
+    {
+        sink_conta(sink, db->nBulk, 0);
+    }
+    else
+    {
+        ret = 0;
+        for( i = 0; i < db->nBulk; i += n )
+        {
+            n = (db->nBulk - i < SINK_BATCH) ? db->nBulk - i : SINK_BATCH;
+            if( sink_mysql_scrivi(sink, db->bulk + i, n, 0) != 0 )
+            {
+                sink_conta(sink, 0, n);
+                ret = 3;
+            }
+            else
+            {
+                sink_conta(sink, n, 0);
+            }
+        }
+    }
+    db->nBulk = 0;
+    return ret;
+}
+
+
+static int sink_mysql_write_batch(Sink *sink, SinkRecord *records, int n)
+{
+    SinkMysql *db = (SinkMysql*) sink->dati;
+    int arretrati;
+
+    arretrati = sink_arretrati(sink);
+    if( db->nBulk == 0 && (db->bulkNo || arretrati < SINK_BULK_SOGLIA) )
+    {
+        return sink_mysql_scrivi(sink, records, n, 0);
+    }
+
+    if( db->bulk == NULL )
+    {
+        db->bulk = (SinkRecord*) malloc((SINK_BULK_RIGHE + SINK_BATCH) * sizeof(SinkRecord));
+        if( db->bulk == NULL )
+        {
+            return sink_mysql_scrivi(sink, records, n, 0);
+        }
+    }
+    memcpy(db->bulk + db->nBulk, records, n * sizeof(SinkRecord));
+    db->nBulk += n;
+
+    //si scrive quando il blocco e' pieno o quando la coda si e' svuotata
+    if( db->nBulk >= SINK_BULK_RIGHE || arretrati < SINK_BULK_SOGLIA )
+    {
+        sink_mysql_scarica(sink);
+    }
+    //il lotto e' ora nel blocco: viene contato quando il blocco e' scritto
+    return SINK_RINVIATO;
+}
+
+
+static int sink_mysql_flush(Sink *sink)
+{
+    return sink_mysql_scarica(sink);
+}
+
+
+static void sink_mysql_close(Sink *sink)
+{
+    SinkMysql *db = (SinkMysql*) sink->dati;
+
+    sink_mysql_scarica(sink);
+    free(db->bulk);
+    close_db_connection(&db->conn);
+    if( db->threadInit )
+    {
+        mysql_thread_end();
+    }
+    free(db);
+    sink->dati = NULL;
+}
+
+
+const SinkOps sink_mysql_ops =
+{
+    "mysql",
+    sink_mysql_open,
+    sink_mysql_write_batch,
+    sink_mysql_flush,
+    sink_mysql_close
+};
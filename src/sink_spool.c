@@ -0,0 +1,236 @@
+/*
+ * File:   sink_spool.c
+ *
+ * Sink su file di spool binario: tutti i record, telegramma compreso, in
+ * coda a un unico file. Serve per ricaricare i dati quando la destinazione
+ * principale non era raggiungibile.
+ *
+ *   intestazione:  SPOOL_MAGIC
+ *   record:        int64 tempo, uint16 mittente, uint16 destinatario,
+ *                  uint8 gruppo, uint8 lunghezza, float valore,
+ *                  SINK_CEMI_MAX byte di telegramma (little endian, SPOOL_RECORD_SIZE byte)
+ *
+ * Opzioni: percorso del file, default "edc.spool".
+ */
+
+#include "sink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+typedef struct
+{
+    int fd;
+    int daSincronizzare;
+} SinkSpool;
+
+
+static int spool_write_all(int fd, unsigned char *buf, size_t len)
+{
+    ssize_t n;
+
+    while( len > 0 )
+    {
+        n = write(fd, buf, len);
+        if( n < 0 )
+        {
+            if( errno == EINTR ) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+
+static void spool_encode(unsigned char *p, SinkRecord *record)
+{
+    uint64_t tempo = (uint64_t) record->tempo;
+    uint32_t bits;
+    int i;
+
+    for( i = 0; i < 8; i++ )
+    {
+        p[i] = (tempo >> (8 * i)) & 0xff;
+    }
+    p[8] = record->mittente & 0xff;
+    p[9] = record->mittente >> 8;
+    p[10] = record->destinatario & 0xff;
+    p[11] = record->destinatario >> 8;
+    p[12] = record->group;
+    p[13] = record->lunghezza;
+    memcpy(&bits, &record->valore, sizeof(float));
+    for( i = 0; i < 4; i++ )
+    {
+        p[14 + i] = (bits >> (8 * i)) & 0xff;
+    }
+    memcpy(p + 18, record->cemi, SINK_CEMI_MAX);
+}
+
+
+static void spool_decode(unsigned char *p, SinkRecord *record)
+{
+    uint64_t tempo = 0;
+    uint32_t bits = 0;
+    int i;
+
+    for( i = 7; i >= 0; i-- )
+    {
+        tempo = (tempo << 8) | p[i];
+    }
+    record->tempo = (int64_t) tempo;
+    record->mittente = p[8] | (p[9] << 8);
+    record->destinatario = p[10] | (p[11] << 8);
+    record->group = p[12];
+    record->lunghezza = (p[13] <= SINK_CEMI_MAX) ? p[13] : SINK_CEMI_MAX;
+    for( i = 3; i >= 0; i-- )
+    {
+        bits = (bits << 8) | p[14 + i];
+    }
+    memcpy(&record->valore, &bits, sizeof(float));
+    memcpy(record->cemi, p + 18, SINK_CEMI_MAX);
+}
+
+
+static int sink_spool_open(Sink *sink, char *opzioni, SinkConfig *config)
+{
+    /*
+     *  un eventuale record incompleto in coda (scrittura interrotta) viene troncato
+     */
+    SinkSpool *spool;
+    struct stat st;
+    off_t validi;
+
+    spool = (SinkSpool*) calloc(1, sizeof(SinkSpool));
+    if( spool == NULL )
+    {
+        return 1;
+    }
+    spool->fd = open((opzioni[0] != 0) ? opzioni : "edc.spool", O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if( spool->fd < 0 || fstat(spool->fd, &st) != 0 )
+    {
+        if( spool->fd >= 0 ) close(spool->fd);
+        free(spool);
+        return 1;
+    }
+
+    if( st.st_size < SPOOL_HEADER_SIZE )
+    {
+        if( ftruncate(spool->fd, 0) != 0 ||
+            spool_write_all(spool->fd, (unsigned char*) SPOOL_MAGIC, SPOOL_HEADER_SIZE) != 0 )
+        {
+            close(spool->fd);
+            free(spool);
+            return 1;
+        }
+    }
+    else
+    {
+        validi = SPOOL_HEADER_SIZE + ((st.st_size - SPOOL_HEADER_SIZE) / SPOOL_RECORD_SIZE) * SPOOL_RECORD_SIZE;
+        if( validi != st.st_size && ftruncate(spool->fd, validi) != 0 )
+        {
+            close(spool->fd);
+            free(spool);
+            return 1;
+        }
+    }
+    sink->dati = spool;
+    return 0;
+}
+
+
+static int sink_spool_write_batch(Sink *sink, SinkRecord *records, int n)
+{
+    SinkSpool *spool = (SinkSpool*) sink->dati;
+    unsigned char *buf;
+    int i;
+    int ret;
+
+    buf = (unsigned char*) malloc((size_t) n * SPOOL_RECORD_SIZE);
+    if( buf == NULL )
+    {
+        return 1;
+    }
+    for( i = 0; i < n; i++ )
+    {
+        spool_encode(buf + i * SPOOL_RECORD_SIZE, &records[i]);
+    }
+    ret = spool_write_all(spool->fd, buf, (size_t) n * SPOOL_RECORD_SIZE);
+    free(buf);
+    spool->daSincronizzare = 1;
+    return (ret != 0);
+}
+
+
+static int sink_spool_flush(Sink *sink)
+{
+    SinkSpool *spool = (SinkSpool*) sink->dati;
+
+    if( !spool->daSincronizzare )
+    {
+        return 0;
+    }
+    spool->daSincronizzare = 0;
+    return fdatasync(spool->fd);
+}
+
+
+static void sink_spool_close(Sink *sink)
+{
+    SinkSpool *spool = (SinkSpool*) sink->dati;
+
+    close(spool->fd);
+    free(spool);
+    sink->dati = NULL;
+}
+
+
+int spool_read(char *path, SpoolCallback callback, void *arg)
+{
+    /*
+     *  return >= 0: numero di record letti
+     *  return -1: file non leggibile o intestazione non valida
+     */
+    FILE *file;
+    unsigned char p[SPOOL_RECORD_SIZE];
+    SinkRecord record;
+    int letti = 0;
+
+    file = fopen(path, "rb");
+    if( file == NULL )
+    {
+        return -1;
+    }
+    if( fread(p, 1, SPOOL_HEADER_SIZE, file) != SPOOL_HEADER_SIZE || memcmp(p, SPOOL_MAGIC, SPOOL_HEADER_SIZE) != 0 )
+    {
+        fclose(file);
+        return -1;
+    }
+
+    while( fread(p, 1, SPOOL_RECORD_SIZE, file) == SPOOL_RECORD_SIZE )
+    {
+        spool_decode(p, &record);
+        letti++;
+        if( callback(&record, arg) != 0 ) break;
+    }
+    fclose(file);
+    return letti;
+}
+
+
+const SinkOps sink_spool_ops =
+{
+    "spool",
+    sink_spool_open,
+    sink_spool_write_batch,
+    sink_spool_flush,
+    sink_spool_close
+};
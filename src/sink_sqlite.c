@@ -0,0 +1,315 @@
+/*
+ * File:   sink_sqlite.c
+ *
+ * Sink SQLite per le installazioni senza server MySQL. Il database e' in
+ * modalita' WAL; l'INSERT e le istruzioni di transazione vengono preparate
+ * una sola volta all'apertura e le righe sono scritte in transazioni di
+ * sqliteBatch righe (o al piu' ogni SINK_FLUSH ms).
+ *
+ * Con sqliteCheckpoint > 0 il checkpoint automatico viene disattivato e un
+ * thread separato, con una propria connessione, esegue un checkpoint PASSIVE
+ * ogni sqliteCheckpoint secondi, cosi' gli inserimenti non si fermano mai
+ * per copiare il WAL nel database.
+ *
+ *   CREATE TABLE dati (Tempo INTEGER, Mittente INTEGER, Destinatario INTEGER,
+ *                      Gruppo INTEGER, Valore REAL)
+ *
+ * Tempo in ms dal 1970, indirizzi numerici come in dati_v2.
+ * Opzioni: percorso del database, default "edc.db".
+ */
+
+#include "sink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sqlite3.h>
+
+
+typedef struct
+{
+    sqlite3 *db;
+    sqlite3_stmt *insert;
+    sqlite3_stmt *begin;
+    sqlite3_stmt *commit;
+    int batch;
+    int inTransazione;              // righe nella transazione aperta
+    int64_t inizioTransazione;
+
+    //checkpoint
+    char path[256];
+    int checkpoint;
+    int stop;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} SinkSqlite;
+
+
+static int64_t sqlite_ms(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+
+static int sqlite_exec(sqlite3 *db, char *sql)
+{
+    char *errore = NULL;
+
+    if( sqlite3_exec(db, sql, NULL, NULL, &errore) != SQLITE_OK )
+    {
+        fprintf(stderr, "SQLite: %s: %s\n", sql, (errore != NULL) ? errore : sqlite3_errmsg(db));
+        sqlite3_free(errore);
+        return 1;
+    }
+    return 0;
+}
+
+
+static int sqlite_step(sqlite3 *db, sqlite3_stmt *stmt)
+{
+    int ret = sqlite3_step(stmt);
+
+    sqlite3_reset(stmt);
+    if( ret != SQLITE_DONE )
+    {
+        fprintf(stderr, "SQLite: %s\n", sqlite3_errmsg(db));
+        return 1;
+    }
+    return 0;
+}
+
+
+static void *sqlite_checkpoint_thread(void *arg)
+{
+    SinkSqlite *sq = (SinkSqlite*) arg;
+    sqlite3 *db;
+    struct timeval now;
+    struct timespec scadenza;
+
+    if( sqlite3_open_v2(sq->path, &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK )
+    {
+        fprintf(stderr, "SQLite: cannot open %s for checkpoints\n", sq->path);
+        sqlite3_close(db);
+        return NULL;
+    }
+    sqlite3_busy_timeout(db, 1000);
+
+    pthread_mutex_lock(&sq->mutex);
+    while( !sq->stop )
+    {
+        gettimeofday(&now, NULL);
+        scadenza.tv_sec = now.tv_sec + sq->checkpoint;
+        scadenza.tv_nsec = now.tv_usec * 1000;
+        if( pthread_cond_timedwait(&sq->cond, &sq->mutex, &scadenza) == ETIMEDOUT )
+        {
+            pthread_mutex_unlock(&sq->mutex);
+            sqlite3_wal_checkpoint_v2(db, NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL);
+            pthread_mutex_lock(&sq->mutex);
+        }
+    }
+    pthread_mutex_unlock(&sq->mutex);
+
+    sqlite3_close(db);
+    return NULL;
+}
+
+
+static int sink_sqlite_commit(SinkSqlite *sq)
+{
+    /*
+     *  se COMMIT fallisce (es. SQLITE_BUSY) la transazione resta aperta con le
+     *  sue righe e viene riprovata alla prossima chiamata; se SQLite l'ha gia'
+     *  annullata si riparte con una nuova
+     */
+    int ret;
+
+    if( sq->inTransazione == 0 )
+    {
+        return 0;
+    }
+    ret = sqlite_step(sq->db, sq->commit);
+    if( ret == 0 || sqlite3_get_autocommit(sq->db) )
+    {
+        sq->inTransazione = 0;
+    }
+    return ret;
+}
+
+
+static void sink_sqlite_free(SinkSqlite *sq)
+{
+    sqlite3_finalize(sq->insert);
+    sqlite3_finalize(sq->begin);
+    sqlite3_finalize(sq->commit);
+    sqlite3_close(sq->db);
+    free(sq);
+}
+
+
+static int sink_sqlite_open(Sink *sink, char *opzioni, SinkConfig *config)
+{
+    SinkSqlite *sq;
+    char pragma[128];
+
+    sq = (SinkSqlite*) calloc(1, sizeof(SinkSqlite));
+    if( sq == NULL )
+    {
+        return 1;
+    }
+    snprintf(sq->path, sizeof(sq->path), "%s", (opzioni[0] != 0) ? opzioni : "edc.db");
+    sq->batch = (config->sqliteBatch > 0) ? config->sqliteBatch : 1;
+    sq->checkpoint = config->sqliteCheckpoint;
+
+    if( sqlite3_open_v2(sq->path, &sq->db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK )
+    {
+        fprintf(stderr, "SQLite: cannot open %s: %s\n", sq->path, sqlite3_errmsg(sq->db));
+        sink_sqlite_free(sq);
+        return 1;
+    }
+    sqlite3_busy_timeout(sq->db, 5000);
+
+    snprintf(pragma, sizeof(pragma), "PRAGMA synchronous=%s", config->sqliteSynchronous);
+    if( sqlite_exec(sq->db, "PRAGMA journal_mode=WAL") != 0 ||
+        sqlite_exec(sq->db, pragma) != 0 )
+    {
+        sink_sqlite_free(sq);
+        return 1;
+    }
+    if( config->sqliteMmap > 0 )
+    {
+        snprintf(pragma, sizeof(pragma), "PRAGMA mmap_size=%ld", config->sqliteMmap);
+        sqlite_exec(sq->db, pragma);
+    }
+    if( sq->checkpoint > 0 )
+    {
+        sqlite_exec(sq->db, "PRAGMA wal_autocheckpoint=0");
+    }
+
+    if( sqlite_exec(sq->db, "CREATE TABLE IF NOT EXISTS dati ("
+                            "Tempo INTEGER NOT NULL,"
+                            "Mittente INTEGER NOT NULL,"
+                            "Destinatario INTEGER NOT NULL,"
+                            "Gruppo INTEGER NOT NULL,"
+                            "Valore REAL)") != 0 ||
+        sqlite_exec(sq->db, "CREATE INDEX IF NOT EXISTS dati_destinatario ON dati (Destinatario,Tempo)") != 0 )
+    {
+        sink_sqlite_free(sq);
+        return 1;
+    }
+
+    if( sqlite3_prepare_v2(sq->db, "INSERT INTO dati (Tempo,Mittente,Destinatario,Gruppo,Valore) VALUES (?,?,?,?,?)",
+                           -1, &sq->insert, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(sq->db, "BEGIN", -1, &sq->begin, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(sq->db, "COMMIT", -1, &sq->commit, NULL) != SQLITE_OK )
+    {
+        fprintf(stderr, "SQLite: %s\n", sqlite3_errmsg(sq->db));
+        sink_sqlite_free(sq);
+        return 1;
+    }
+
+    if( sq->checkpoint > 0 )
+    {
+        pthread_mutex_init(&sq->mutex, NULL);
+        pthread_cond_init(&sq->cond, NULL);
+        if( pthread_create(&sq->thread, NULL, sqlite_checkpoint_thread, sq) != 0 )
+        {
+            pthread_mutex_destroy(&sq->mutex);
+            pthread_cond_destroy(&sq->cond);
+            sink_sqlite_free(sq);
+            return 1;
+        }
+    }
+
+    sink->dati = sq;
+    return 0;
+}
+
+
+static int sink_sqlite_write_batch(Sink *sink, SinkRecord *records, int n)
+{
+    SinkSqlite *sq = (SinkSqlite*) sink->dati;
+    int errori = 0;
+    int i;
+
+    for( i = 0; i < n; i++ )
+    {
+        if( sq->inTransazione == 0 )
+        {
+            if( sqlite_step(sq->db, sq->begin) != 0 )
+            {
+                return 1;
+            }
+            sq->inizioTransazione = sqlite_ms();
+        }
+
+        sqlite3_bind_int64(sq->insert, 1, records[i].tempo);
+        sqlite3_bind_int(sq->insert, 2, records[i].mittente);
+        sqlite3_bind_int(sq->insert, 3, records[i].destinatario);
+        sqlite3_bind_int(sq->insert, 4, records[i].group);
+        sqlite3_bind_double(sq->insert, 5, records[i].valore);
+        errori += sqlite_step(sq->db, sq->insert);
+        sq->inTransazione++;
+
+        if( sq->inTransazione >= sq->batch )
+        {
+            errori += sink_sqlite_commit(sq);
+        }
+    }
+
+    //sotto carico continuo flush non viene chiamata: si chiude comunque ogni SINK_FLUSH ms
+    if( sq->inTransazione > 0 && sqlite_ms() - sq->inizioTransazione >= SINK_FLUSH )
+    {
+        errori += sink_sqlite_commit(sq);
+    }
+    return (errori > 0);
+}
+
+
+static int sink_sqlite_flush(Sink *sink)
+{
+    return sink_sqlite_commit((SinkSqlite*) sink->dati);
+}
+
+
+static void sink_sqlite_close(Sink *sink)
+{
+    SinkSqlite *sq = (SinkSqlite*) sink->dati;
+
+    if( sink_sqlite_commit(sq) != 0 && sq->inTransazione > 0 )
+    {
+        fprintf(stderr, "SQLite: %d rows rolled back\n", sq->inTransazione);
+        sqlite_exec(sq->db, "ROLLBACK");
+        sq->inTransazione = 0;
+    }
+    if( sq->checkpoint > 0 )
+    {
+        pthread_mutex_lock(&sq->mutex);
+        sq->stop = 1;
+        pthread_cond_signal(&sq->cond);
+        pthread_mutex_unlock(&sq->mutex);
+        pthread_join(sq->thread, NULL);
+        pthread_mutex_destroy(&sq->mutex);
+        pthread_cond_destroy(&sq->cond);
+
+        //all'uscita il WAL viene riportato interamente nel database
+        sqlite3_wal_checkpoint_v2(sq->db, NULL, SQLITE_CHECKPOINT_TRUNCATE, NULL, NULL);
+    }
+    sink_sqlite_free(sq);
+    sink->dati = NULL;
+}
+
+
+const SinkOps sink_sqlite_ops =
+{
+    "sqlite",
+    sink_sqlite_open,
+    sink_sqlite_write_batch,
+    sink_sqlite_flush,
+    sink_sqlite_close
+};
@@ -0,0 +1,66 @@
+/*
+ * File:   sink_tsstore.c
+ *
+ * Sink verso l'archivio locale append-only (vedi tsstore.h).
+ * Opzioni: directory dell'archivio, default "edc_data".
+ */
+
+#include "sink.h"
+#include "tsstore.h"
+
+#include <stdio.h>
+
+
+static int sink_tsstore_open(Sink *sink, char *opzioni, SinkConfig *config)
+{
+    TS_Store *ts;
+
+    ts = ts_open((opzioni[0] != 0) ? opzioni : "edc_data", config->tsPerAddress);
+    if( ts == NULL )
+    {
+        return 1;
+    }
+    sink->dati = ts;
+    return 0;
+}
+
+
+static int sink_tsstore_write_batch(Sink *sink, SinkRecord *records, int n)
+{
+    TS_Store *ts = (TS_Store*) sink->dati;
+    int errori = 0;
+    int i;
+
+    for( i = 0; i < n; i++ )
+    {
+        if( ts_append(ts, records[i].tempo, records[i].mittente, records[i].destinatario,
+                      records[i].group, records[i].valore) != 0 )
+        {
+            errori++;
+        }
+    }
+    return (errori > 0);
+}
+
+
+static int sink_tsstore_flush(Sink *sink)
+{
+    return ts_flush((TS_Store*) sink->dati);
+}
+
+
+static void sink_tsstore_close(Sink *sink)
+{
+    ts_close((TS_Store*) sink->dati);
+    sink->dati = NULL;
+}
+
+
+const SinkOps sink_tsstore_ops =
+{
+    "tsstore",
+    sink_tsstore_open,
+    sink_tsstore_write_batch,
+    sink_tsstore_flush,
+    sink_tsstore_close
+};
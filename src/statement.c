@@ -1,12 +1,27 @@
 /* #@ _INSERT_RECORDS_ */
 
 #include "statement.h"
+#include "filtro.h"
+
+#include <math.h>
 
 
 void initFiltro(Filtro *toInit)
 {
     toInit->EIS = 0;
     toInit->writable = 0;
+    toInit->deadband = -1;
+    toInit->deadbandPerc = -1;
+    toInit->minInterval = 0;
+    toInit->heartbeat = 0;
+    toInit->pollInterval = 0;
+    toInit->hasLast = 0;
+    toInit->lastValue = 0;
+    toInit->lastWrite = 0;
+    toInit->statoDirty = 0;
+    toInit->statoValore = 0;
+    toInit->statoTempo = 0;
+    toInit->statoMittente = 0;
 }
 
 
@@ -137,6 +152,663 @@ int insert_dati( MYSQL *conn, Energia toWrite )
 }
 
 
+int load_filtro( MYSQL *conn, FiltroTable *table )
+{
+    /*
+     *  carica l'intera tabella filtro in memoria con una sola query.
+     *  Le colonne della politica di registrazione sono facoltative:
+     *
+     *    ALTER TABLE filtro ADD Deadband FLOAT NULL, ADD DeadbandPerc FLOAT NULL,
+     *                       ADD MinInterval INT NULL, ADD Heartbeat INT NULL;
+     *    ALTER TABLE filtro ADD PollInterval INT NULL;
+     *
+     *  NULL = controllo disattivato. Lo stato in memoria (ultimo valore registrato)
+     *  degli indirizzi gia' presenti viene mantenuto.
+     *
+     *  return >= 0: numero di indirizzi caricati
+     *  return -1: errore nella query
+     */
+    MYSQL_RES *res_set;
+    MYSQL_ROW row;
+    uint16_t indirizzo;
+    int group;
+    int loaded = 0;
+    Filtro *filtro;
+    unsigned int fields;
+
+    if (mysql_query (conn, "SELECT Destinatario,Writable+0,EIS,Deadband,DeadbandPerc,MinInterval,Heartbeat,PollInterval FROM filtro") != 0 &&
+        mysql_query (conn, "SELECT Destinatario,Writable+0,EIS,Deadband,DeadbandPerc,MinInterval,Heartbeat FROM filtro") != 0 &&
+        mysql_query (conn, "SELECT Destinatario,Writable+0,EIS FROM filtro") != 0)
+    {
+        print_error (conn, "Could not load filtro table");
+        return -1;
+    }
+    res_set = mysql_store_result (conn);
+    if (res_set == NULL)
+    {
+        print_error (conn, "Could not buffer filtro table");
+        return -1;
+    }
+
+    fields = mysql_num_fields (res_set);
+    filtro_table_invalidate(table);
+    while ((row = mysql_fetch_row (res_set)) != NULL)
+    {
+        if( row[0] == NULL || filtro_parse_address(row[0], &indirizzo, &group) != 0 )
+        {
+            continue;
+        }
+        filtro = filtro_table_add(table, indirizzo, group);
+        if( filtro == NULL )
+        {
+            break;
+        }
+        filtro->writable = (row[1] != NULL && atoi(row[1]) != 0);
+        filtro->EIS = (row[2] != NULL) ? atol(row[2]) : 0;
+        if( fields >= 7 )
+        {
+            filtro->deadband = (row[3] != NULL) ? atof(row[3]) : -1;
+            filtro->deadbandPerc = (row[4] != NULL) ? atof(row[4]) : -1;
+            filtro->minInterval = (row[5] != NULL) ? atoi(row[5]) : 0;
+            filtro->heartbeat = (row[6] != NULL) ? atoi(row[6]) : 0;
+        }
+        if( fields >= 8 )
+        {
+            filtro->pollInterval = (row[7] != NULL) ? atoi(row[7]) : 0;
+        }
+        filtro->valid = 1;
+        loaded++;
+    }
+
+    mysql_free_result (res_set);
+    return loaded;
+}
+
+
+int create_rollup_tables( MYSQL *conn )
+{
+    /*
+     *  crea le tabelle degli aggregati, una per livello (rollup_1m, rollup_15m, ...)
+     *  return 0: ok
+     *  return 1: errore
+     */
+    char stmt_str[1024];
+    int level;
+
+    for( level = 0; level < ROLLUP_LEVELS; level++ )
+    {
+        snprintf(stmt_str, sizeof(stmt_str),
+                 "CREATE TABLE IF NOT EXISTS %s ("
+                 "Inizio DATETIME NOT NULL,"
+                 "Destinatario VARCHAR(10) NOT NULL,"
+                 "Conteggio INT UNSIGNED NOT NULL,"
+                 "Minimo FLOAT NOT NULL,"
+                 "Massimo FLOAT NOT NULL,"
+                 "Somma DOUBLE NOT NULL,"
+                 "Ultimo FLOAT NOT NULL,"
+                 "Delta FLOAT NOT NULL,"
+                 "PRIMARY KEY (Destinatario, Inizio),"
+                 "KEY (Inizio))",
+                 rollup_tabella[level]);
+        if (mysql_query (conn, stmt_str) != 0)
+        {
+            print_error (conn, "Could not create rollup table");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+int insert_rollup( MYSQL *conn, char* tabella, RollupRow *rows, int n )
+{
+    /*
+     *  scrive tutte le righe con un'unica INSERT; se la riga esiste gia'
+     *  (intervallo scritto in parte prima di un riavvio) gli aggregati vengono uniti
+     *  return 0: ok
+     *  return 1: memoria insufficiente
+     *  return 3: errore nell'esecuzione
+     */
+    char *stmt_str;
+    char data[24];
+    struct tm local;
+    size_t len;
+    int i;
+
+    stmt_str = (char*) malloc(n * 200 + 512);
+    if( stmt_str == NULL )
+    {
+        return 1;
+    }
+
+    len = sprintf(stmt_str, "INSERT INTO %s (Inizio,Destinatario,Conteggio,Minimo,Massimo,Somma,Ultimo,Delta) VALUES ", tabella);
+    for( i = 0; i < n; i++ )
+    {
+        localtime_r(&rows[i].inizio, &local);
+        strftime(data, sizeof(data), "%Y-%m-%d %H:%M:%S", &local);
+        len += sprintf(stmt_str + len, "%s('%s','%s',%u,%.7g,%.7g,%.15g,%.7g,%.7g)",
+                       (i > 0) ? "," : "", data, rows[i].destinatario, rows[i].conteggio,
+                       rows[i].minimo, rows[i].massimo, rows[i].somma, rows[i].ultimo, rows[i].delta);
+    }
+    strcpy(stmt_str + len, " ON DUPLICATE KEY UPDATE "
+                           "Conteggio=Conteggio+VALUES(Conteggio),"
+                           "Minimo=LEAST(Minimo,VALUES(Minimo)),"
+                           "Massimo=GREATEST(Massimo,VALUES(Massimo)),"
+                           "Somma=Somma+VALUES(Somma),"
+                           "Ultimo=VALUES(Ultimo),"
+                           "Delta=Delta+VALUES(Delta)");
+
+    if (mysql_query (conn, stmt_str) != 0)
+    {
+        print_error (conn, "Could not insert rollup rows");
+        free(stmt_str);
+        return 3;
+    }
+    free(stmt_str);
+    return 0;
+}
+
+
+int create_stato_table( MYSQL *conn )
+{
+    /*
+     *  ultimo valore di ogni indirizzo: una riga per Destinatario
+     *  return 0: ok
+     *  return 1: errore
+     */
+    if (mysql_query (conn, "CREATE TABLE IF NOT EXISTS stato_corrente ("
+                           "Destinatario VARCHAR(10) NOT NULL PRIMARY KEY,"
+                           "Aggiornato DATETIME NOT NULL,"
+                           "Mittente VARCHAR(10) NOT NULL,"
+                           "Valore FLOAT NOT NULL)") != 0)
+    {
+        print_error (conn, "Could not create stato_corrente table");
+        return 1;
+    }
+    return 0;
+}
+
+
+int upsert_stato( MYSQL *conn, StatoRow *rows, int n )
+{
+    /*
+     *  aggiorna tutti gli indirizzi modificati con un'unica INSERT ... ON DUPLICATE KEY UPDATE
+     *  return 0: ok
+     *  return 1: memoria insufficiente
+     *  return 3: errore nell'esecuzione
+     */
+    char *stmt_str;
+    char data[24];
+    struct tm local;
+    time_t secondi;
+    size_t len;
+    int i;
+
+    stmt_str = (char*) malloc(n * 100 + 256);
+    if( stmt_str == NULL )
+    {
+        return 1;
+    }
+
+    len = sprintf(stmt_str, "INSERT INTO stato_corrente (Destinatario,Aggiornato,Mittente,Valore) VALUES ");
+    for( i = 0; i < n; i++ )
+    {
+        secondi = rows[i].tempo / 1000;
+        localtime_r(&secondi, &local);
+        strftime(data, sizeof(data), "%Y-%m-%d %H:%M:%S", &local);
+        len += sprintf(stmt_str + len, "%s('%s','%s','%s',%.7g)",
+                       (i > 0) ? "," : "", rows[i].destinatario, data, rows[i].mittente, rows[i].valore);
+    }
+    strcpy(stmt_str + len, " ON DUPLICATE KEY UPDATE "
+                           "Aggiornato=VALUES(Aggiornato),"
+                           "Mittente=VALUES(Mittente),"
+                           "Valore=VALUES(Valore)");
+
+    if (mysql_query (conn, stmt_str) != 0)
+    {
+        print_error (conn, "Could not update stato_corrente");
+        free(stmt_str);
+        return 3;
+    }
+    free(stmt_str);
+    return 0;
+}
+
+
+static long to_days( int anno, int mese, int giorno )
+{
+    /*
+     *  equivalente di TO_DAYS() di MySQL; mese e giorno fuori intervallo
+     *  vengono normalizzati (es. mese 13 = gennaio dell'anno successivo)
+     */
+    struct tm data;
+
+    memset(&data, 0, sizeof(data));
+    data.tm_year = anno - 1900;
+    data.tm_mon = mese - 1;
+    data.tm_mday = giorno;
+    return (long)(timegm(&data) / 86400) + 719528;
+}
+
+
+static long periodo_dati_v2( long giorni, int perMese, char *nome, size_t size )
+{
+    /*
+     *  nome della partizione che contiene il giorno (in TO_DAYS)
+     *  return: limite superiore della partizione (escluso)
+     */
+    struct tm data;
+    time_t secondi = (time_t)(giorni - 719528) * 86400;
+    unsigned int anno, mese, giorno;
+
+    gmtime_r(&secondi, &data);
+    //DATETIME va dall'anno 1000 al 9999: il nome resta sempre di 8 o 6 cifre
+    anno = (data.tm_year < 1000 - 1900) ? 1000 : (data.tm_year > 9999 - 1900) ? 9999 : data.tm_year + 1900;
+    mese = (unsigned int)data.tm_mon % 12 + 1;
+    giorno = (unsigned int)data.tm_mday % 32;
+    if( perMese )
+    {
+        snprintf(nome, size, "p%04u%02u", anno, mese);
+        return to_days(anno, mese + 1, 1);
+    }
+    snprintf(nome, size, "p%04u%02u%02u", anno, mese, giorno);
+    return giorni + 1;
+}
+
+
+static long to_days_mese( long giorni )
+{
+    //primo giorno del mese che contiene il giorno (in TO_DAYS)
+    struct tm data;
+    time_t secondi = (time_t)(giorni - 719528) * 86400;
+
+    gmtime_r(&secondi, &data);
+    return to_days(data.tm_year + 1900, data.tm_mon + 1, 1);
+}
+
+
+static long oggi_dati_v2( time_t now )
+{
+    struct tm local;
+
+    localtime_r(&now, &local);
+    return to_days(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+
+int create_dati_v2( MYSQL *conn, int perMese, time_t now )
+{
+    /*
+     *  schema v2 di dati: tempo al millisecondo e indirizzi numerici, partizionato
+     *  per giorno o per mese su TO_DAYS(Tempo) (richiede MySQL >= 5.6.4).
+     *  Nessuna partizione MAXVALUE: quelle future vengono aggiunte da partizioni_dati_v2().
+     *  return 0: ok
+     *  return 1: errore
+     */
+    char stmt_str[512];
+    char nome[16];
+    long limite;
+
+    limite = periodo_dati_v2(oggi_dati_v2(now), perMese, nome, sizeof(nome));
+    snprintf(stmt_str, sizeof(stmt_str),
+             "CREATE TABLE IF NOT EXISTS dati_v2 ("
+             "Tempo DATETIME(3) NOT NULL,"
+             "Mittente SMALLINT UNSIGNED NOT NULL,"
+             "Destinatario SMALLINT UNSIGNED NOT NULL,"
+             "Gruppo TINYINT UNSIGNED NOT NULL,"
+             "Valore FLOAT NOT NULL,"
+             "KEY (Destinatario,Tempo))"
+             " PARTITION BY RANGE (TO_DAYS(Tempo)) (PARTITION %s VALUES LESS THAN (%ld))",
+             nome, limite);
+
+    if (mysql_query (conn, stmt_str) != 0)
+    {
+        print_error (conn, "Could not create dati_v2 table");
+        return 1;
+    }
+    return 0;
+}
+
+
+int partizioni_dati_v2( MYSQL *conn, int perMese, int retention, time_t now )
+{
+    /*
+     *  aggiunge le partizioni che coprono i prossimi PARTIZIONI_AVANTI giorni ed
+     *  elimina quelle interamente piu' vecchie di retention giorni (0 = mai)
+     *  return 0: ok
+     *  return 1: memoria insufficiente
+     *  return 3: errore nell'esecuzione
+     */
+    MYSQL_RES *res_set;
+    MYSQL_ROW row;
+    char *aggiungi;
+    char *elimina;
+    size_t lenAggiungi, lenElimina;
+    char nome[16];
+    long oggi, inizio, obiettivo, massimo = 0, limite;
+    int n = 0;
+    int ret = 0;
+
+    if (mysql_query (conn, "SELECT PARTITION_NAME,PARTITION_DESCRIPTION FROM INFORMATION_SCHEMA.PARTITIONS "
+                           "WHERE TABLE_SCHEMA=DATABASE() AND TABLE_NAME='dati_v2' AND PARTITION_NAME IS NOT NULL") != 0)
+    {
+        print_error (conn, "Could not read dati_v2 partitions");
+        return 3;
+    }
+    res_set = mysql_store_result (conn);
+    if( res_set == NULL )
+    {
+        print_error (conn, "Could not read dati_v2 partitions");
+        return 3;
+    }
+
+    aggiungi = (char*) malloc(PARTIZIONI_MAX * 64 + 64);
+    elimina = (char*) malloc(mysql_num_rows(res_set) * 24 + 64);
+    if( aggiungi == NULL || elimina == NULL )
+    {
+        free(aggiungi);
+        free(elimina);
+        mysql_free_result (res_set);
+        return 1;
+    }
+
+    oggi = oggi_dati_v2(now);
+    lenElimina = sprintf(elimina, "ALTER TABLE dati_v2 DROP PARTITION ");
+    while ((row = mysql_fetch_row (res_set)) != NULL)
+    {
+        if( row[1] == NULL || strcmp(row[1], "MAXVALUE") == 0 )
+        {
+            fprintf(stderr, "dati_v2: partition %s has no upper bound, cannot add partitions\n", row[0]);
+            massimo = -1;
+            break;
+        }
+        limite = atol(row[1]);
+        if( limite > massimo )
+        {
+            massimo = limite;
+        }
+        if( retention > 0 && limite <= oggi - retention )
+        {
+            lenElimina += sprintf(elimina + lenElimina, "%s%s", (n > 0) ? "," : "", row[0]);
+            n++;
+        }
+    }
+    mysql_free_result (res_set);
+
+    //partizioni future; dopo un fermo il buco fino ad oggi va in una sola partizione
+    if( massimo > 0 )
+    {
+        inizio = perMese ? to_days_mese(oggi) : oggi;
+        obiettivo = oggi + PARTIZIONI_AVANTI;
+        lenAggiungi = sprintf(aggiungi, "ALTER TABLE dati_v2 ADD PARTITION (");
+        if( massimo < inizio )
+        {
+            periodo_dati_v2(massimo, perMese, nome, sizeof(nome));
+            lenAggiungi += sprintf(aggiungi + lenAggiungi, "PARTITION %s VALUES LESS THAN (%ld)", nome, inizio);
+            massimo = inizio;
+        }
+        while( massimo <= obiettivo && lenAggiungi < PARTIZIONI_MAX * 64 )
+        {
+            limite = periodo_dati_v2(massimo, perMese, nome, sizeof(nome));
+            lenAggiungi += sprintf(aggiungi + lenAggiungi, "%sPARTITION %s VALUES LESS THAN (%ld)",
+                                   (aggiungi[lenAggiungi - 1] == '(') ? "" : ",", nome, limite);
+            massimo = limite;
+        }
+        strcpy(aggiungi + lenAggiungi, ")");
+        if( aggiungi[lenAggiungi - 1] != '(' && mysql_query (conn, aggiungi) != 0 )
+        {
+            print_error (conn, "Could not add dati_v2 partitions");
+            ret = 3;
+        }
+    }
+
+    //la partizione corrente non viene mai eliminata, quindi ne resta sempre almeno una
+    if( n > 0 && mysql_query (conn, elimina) != 0 )
+    {
+        print_error (conn, "Could not drop expired dati_v2 partitions");
+        ret = 3;
+    }
+    else if( n > 0 )
+    {
+        printf("dati_v2: %d expired partitions dropped\n", n);
+    }
+
+    free(aggiungi);
+    free(elimina);
+    return ret;
+}
+
+
+int insert_dati_batch( MYSQL *conn, SinkRecord *records, int n )
+{
+    /*
+     *  stessi valori di insert_dati, n righe con un'unica INSERT
+     *  return 0: ok
+     *  return 1: memoria insufficiente
+     *  return 3: errore nell'esecuzione
+     */
+    char *stmt_str;
+    char mittente[16];
+    char destinatario[16];
+    struct tm local;
+    time_t secondi;
+    size_t len;
+    int i;
+    int righe = 0;
+
+    stmt_str = (char*) malloc(n * 80 + 128);
+    if( stmt_str == NULL )
+    {
+        return 1;
+    }
+
+    len = sprintf(stmt_str, "INSERT INTO dati (Data,Timestamp,Mittente,Destinatario,Valore) VALUES ");
+    for( i = 0; i < n; i++ )
+    {
+        if( !isfinite(records[i].valore) )
+        {
+            continue;       // MySQL non accetta NaN e infinito
+        }
+        secondi = records[i].tempo / 1000;
+        localtime_r(&secondi, &local);
+        filtro_format_address(records[i].mittente, 0, mittente, sizeof(mittente));
+        filtro_format_address(records[i].destinatario, records[i].group, destinatario, sizeof(destinatario));
+        //il mittente mantiene il riempimento di insert_dati ("%8s  ")
+        len += sprintf(stmt_str + len, "%s('%04d-%02d-%02d','%02d:%02d:%02d:%03d','%8s  ','%s',%.7g)",
+                       (righe++ > 0) ? "," : "",
+                       local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                       local.tm_hour, local.tm_min, local.tm_sec, (int)(records[i].tempo % 1000),
+                       mittente, destinatario, records[i].valore);
+    }
+
+    if( righe > 0 && mysql_real_query (conn, stmt_str, len) != 0 )
+    {
+        print_error (conn, "Could not insert into dati");
+        free(stmt_str);
+        return 3;
+    }
+    free(stmt_str);
+    return 0;
+}
+
+
+int insert_dati_v2_batch( MYSQL *conn, SinkRecord *records, int n )
+{
+    /*
+     *  return 0: ok
+     *  return 1: memoria insufficiente
+     *  return 3: errore nell'esecuzione
+     */
+    char *stmt_str;
+    struct tm local;
+    time_t secondi;
+    size_t len;
+    int i;
+    int righe = 0;
+
+    stmt_str = (char*) malloc(n * 64 + 128);
+    if( stmt_str == NULL )
+    {
+        return 1;
+    }
+
+    len = sprintf(stmt_str, "INSERT INTO dati_v2 (Tempo,Mittente,Destinatario,Gruppo,Valore) VALUES ");
+    for( i = 0; i < n; i++ )
+    {
+        if( !isfinite(records[i].valore) )
+        {
+            continue;       // MySQL non accetta NaN e infinito
+        }
+        secondi = records[i].tempo / 1000;
+        localtime_r(&secondi, &local);
+        len += sprintf(stmt_str + len, "%s('%04d-%02d-%02d %02d:%02d:%02d.%03d',%u,%u,%u,%.7g)",
+                       (righe++ > 0) ? "," : "",
+                       local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                       local.tm_hour, local.tm_min, local.tm_sec, (int)(records[i].tempo % 1000),
+                       records[i].mittente, records[i].destinatario, records[i].group, records[i].valore);
+    }
+
+    if( righe > 0 && mysql_real_query (conn, stmt_str, len) != 0 )
+    {
+        print_error (conn, "Could not insert into dati_v2");
+        free(stmt_str);
+        return 3;
+    }
+    free(stmt_str);
+    return 0;
+}
+
+
+typedef struct
+{
+    char *buf;
+    size_t len;
+    size_t pos;
+} BulkStream;
+
+
+static int bulk_init( void **ptr, const char *filename, void *userdata )
+{
+    BulkStream *stream = (BulkStream*) userdata;
+
+    stream->pos = 0;
+    *ptr = stream;
+    return 0;
+}
+
+
+static int bulk_read( void *ptr, char *buf, unsigned int len )
+{
+    BulkStream *stream = (BulkStream*) ptr;
+    size_t n = stream->len - stream->pos;
+
+    if( n > len )
+    {
+        n = len;
+    }
+    memcpy(buf, stream->buf + stream->pos, n);
+    stream->pos += n;
+    return (int) n;
+}
+
+
+static void bulk_end( void *ptr )
+{
+}
+
+
+static int bulk_error( void *ptr, char *msg, unsigned int len )
+{
+    snprintf(msg, len, "EDC bulk stream error");
+    return 1;
+}
+
+
+int load_dati_bulk( MYSQL *conn, int schema, SinkRecord *records, int n )
+{
+    /*
+     *  scrive n righe in dati (schema 1) o dati_v2 (schema 2) con un'unica
+     *  LOAD DATA LOCAL INFILE; le righe, separate da tab, vengono preparate in
+     *  memoria e passate al client dal gestore local infile, senza file temporanei.
+     *  La connessione deve essere aperta con start_db_connection_infile().
+     *  return 0: ok
+     *  return 1: memoria insufficiente
+     *  return 3: errore nell'esecuzione
+     *  return 4: LOCAL INFILE non consentito dal server o dal client
+     */
+    BulkStream stream;
+    char mittente[16];
+    char destinatario[16];
+    struct tm local;
+    time_t secondi;
+    unsigned int errore;
+    int i;
+
+    stream.buf = (char*) malloc((size_t) n * 80 + 1);
+    if( stream.buf == NULL )
+    {
+        return 1;
+    }
+    stream.len = 0;
+
+    for( i = 0; i < n; i++ )
+    {
+        if( !isfinite(records[i].valore) )
+        {
+            continue;
+        }
+        secondi = records[i].tempo / 1000;
+        localtime_r(&secondi, &local);
+        if( schema == 2 )
+        {
+            stream.len += sprintf(stream.buf + stream.len, "%04d-%02d-%02d %02d:%02d:%02d.%03d\t%u\t%u\t%u\t%.7g\n",
+                                  local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                                  local.tm_hour, local.tm_min, local.tm_sec, (int)(records[i].tempo % 1000),
+                                  records[i].mittente, records[i].destinatario, records[i].group, records[i].valore);
+        }
+        else
+        {
+            filtro_format_address(records[i].mittente, 0, mittente, sizeof(mittente));
+            filtro_format_address(records[i].destinatario, records[i].group, destinatario, sizeof(destinatario));
+            stream.len += sprintf(stream.buf + stream.len, "%04d-%02d-%02d\t%02d:%02d:%02d:%03d\t%8s  \t%s\t%.7g\n",
+                                  local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                                  local.tm_hour, local.tm_min, local.tm_sec, (int)(records[i].tempo % 1000),
+                                  mittente, destinatario, records[i].valore);
+        }
+    }
+    if( stream.len == 0 )
+    {
+        free(stream.buf);
+        return 0;
+    }
+
+    mysql_set_local_infile_handler(conn, bulk_init, bulk_read, bulk_end, bulk_error, &stream);
+    if (mysql_query (conn, (schema == 2) ?
+                     "LOAD DATA LOCAL INFILE 'edc_bulk' INTO TABLE dati_v2 "
+                     "FIELDS TERMINATED BY '\\t' LINES TERMINATED BY '\\n' "
+                     "(Tempo,Mittente,Destinatario,Gruppo,Valore)" :
+                     "LOAD DATA LOCAL INFILE 'edc_bulk' INTO TABLE dati "
+                     "FIELDS TERMINATED BY '\\t' LINES TERMINATED BY '\\n' "
+                     "(Data,Timestamp,Mittente,Destinatario,Valore)") != 0)
+    {
+        print_error (conn, "Could not bulk load dati");
+        errore = mysql_errno(conn);
+        //l'handler punta a stream, che non esiste piu' dopo il return
+        mysql_set_local_infile_default(conn);
+        free(stream.buf);
+        //ER_NOT_ALLOWED_COMMAND, CR_LOAD_DATA_LOCAL_INFILE_REJECTED, ER_CLIENT_LOCAL_FILES_DISABLED
+        if( errore == 1148 || errore == 2068 || errore == 3948 )
+        {
+            return 4;
+        }
+        return 3;
+    }
+    mysql_set_local_infile_default(conn);
+    free(stream.buf);
+    return 0;
+}
+
+
 void free_filtro( Filtro* filtro)
 {
     if( filtro != NULL )free(filtro);
@@ -14,8 +14,17 @@ extern "C" {
 
 #include <mysql/mysql.h>
 #include <string.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>//per funzione free
+#include <time.h>
+
+#include "rollup.h"
+#include "sink.h"
+
+#define PARTIZIONI_AVANTI   7       // giorni per cui le partizioni di dati_v2 esistono in anticipo
+#define PARTIZIONI_MAX      400     // partizioni aggiunte al massimo per ogni controllo
+#define PARTIZIONI_CHECK    3600    // secondi tra due controlli delle partizioni
     
 void print_stmt_error (MYSQL_STMT *stmt, char *message);
 void print_error(MYSQL *conn, char *msg);
@@ -26,8 +35,34 @@ typedef struct
     my_bool valid;
     long EIS;
     my_bool writable;
+
+    //politica di registrazione (valori negativi = disattivata)
+    float deadband;         // variazione assoluta minima, 0 = solo i cambiamenti
+    float deadbandPerc;     // variazione minima in % dell'ultimo valore registrato
+    int minInterval;        // secondi minimi tra due registrazioni
+    int heartbeat;          // secondi dopo i quali il valore viene registrato comunque
+    int pollInterval;       // secondi tra due letture dell'indirizzo di gruppo, 0 = solo ascolto (vedi poll.h)
+
+    //stato in memoria
+    my_bool hasLast;
+    float lastValue;        // ultimo valore registrato
+    int64_t lastWrite;      // ms dell'ultima registrazione
+
+    //stato corrente, scritto periodicamente in stato_corrente se modificato
+    my_bool statoDirty;
+    float statoValore;
+    int64_t statoTempo;
+    uint16_t statoMittente; // indirizzo fisico (host order)
 } Filtro;
 
+typedef struct
+{
+    char destinatario[10];
+    char mittente[10];
+    int64_t tempo;
+    float valore;
+} StatoRow;
+
 
 
 
@@ -46,6 +81,15 @@ void initFiltro(Filtro *toInit);
 int insert_filtro( MYSQL *conn, char* destinatario);
 int insert_dati( MYSQL *conn, Energia toWrite );
 int select_filtro ( MYSQL *conn, char* destinatario, Filtro* filtro);
+int create_rollup_tables( MYSQL *conn );
+int insert_rollup( MYSQL *conn, char* tabella, RollupRow *rows, int n );
+int create_stato_table( MYSQL *conn );
+int upsert_stato( MYSQL *conn, StatoRow *rows, int n );
+int create_dati_v2( MYSQL *conn, int perMese, time_t now );
+int partizioni_dati_v2( MYSQL *conn, int perMese, int retention, time_t now );
+int insert_dati_batch( MYSQL *conn, SinkRecord *records, int n );
+int insert_dati_v2_batch( MYSQL *conn, SinkRecord *records, int n );
+int load_dati_bulk( MYSQL *conn, int schema, SinkRecord *records, int n );
 void free_filtro( Filtro* filtro);
 int process_prepared_statements(MYSQL *conn, MYSQL_STMT **stmt);
 
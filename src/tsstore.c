@@ -0,0 +1,583 @@
+/*
+ * File:   tsstore.c
+ *
+ * Archivio locale append-only per serie temporali (vedi tsstore.h per il formato).
+ *
+ * I record vengono accumulati in un buffer per segmento e scritti con una sola
+ * write() quando il buffer e' pieno o al piu' ogni TS_FLUSH_INTERVAL ms.
+ * Alla riapertura di un segmento esistente (riavvio nello stesso giorno) si
+ * riparte dall'ultima voce di indice valida per ricostruire il tempo
+ * dell'ultimo record; un eventuale record incompleto in coda viene troncato.
+ */
+
+#include "tsstore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+
+#define TS_DAILY_KEY        0xffffffff
+
+typedef struct TS_Segment
+{
+    uint32_t key;                   // (gruppo << 16) | destinatario, TS_DAILY_KEY per il segmento giornaliero
+    int fd;
+    int idxfd;
+    int64_t last;                   // tempo dell'ultimo record scritto
+    uint32_t records;               // record dall'ultima voce di indice
+    uint64_t offset;                // offset del prossimo record nel file
+    uint64_t uso;                   // ultimo accesso, per chiudere il meno usato di recente
+    uint32_t buflen;
+    unsigned char buf[TS_BUFSIZE];
+    struct TS_Segment *next;
+} TS_Segment;
+
+struct TS_Store
+{
+    char dir[256];
+    int per_address;
+    char day[16];                   // AAAAMMGG dei segmenti aperti
+    int64_t day_start;
+    int64_t day_end;
+    int64_t last_flush;
+    int open;
+    int max_open;                   // segmenti aperti al massimo, due descrittori ciascuno
+    uint64_t uso;                   // contatore degli accessi ai segmenti
+    TS_Segment *bucket[TS_BUCKETS];
+};
+
+
+static int ts_write_all(int fd, unsigned char *buf, size_t len)
+{
+    ssize_t n;
+
+    while( len > 0 )
+    {
+        n = write(fd, buf, len);
+        if( n < 0 )
+        {
+            if( errno == EINTR ) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+
+static int ts_varint_put(unsigned char *p, uint64_t v)
+{
+    int n = 0;
+
+    while( v >= 0x80 )
+    {
+        p[n++] = (v & 0x7f) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = v;
+    return n;
+}
+
+
+static int ts_decode(unsigned char *p, unsigned char *end, uint64_t *delta, int *group,
+                     uint16_t *mittente, uint16_t *destinatario, float *valore)
+{
+    /*
+     *  decodifica un record, restituisce la sua lunghezza o 0 se incompleto
+     */
+    uint64_t v = 0;
+    uint32_t bits;
+    int shift = 0;
+    int n = 0;
+
+    do
+    {
+        if( p + n >= end || shift > 63 ) return 0;
+        v |= (uint64_t)(p[n] & 0x7f) << shift;
+        shift += 7;
+    } while( p[n++] & 0x80 );
+
+    if( p + n + 8 > end ) return 0;
+    *delta = v >> 1;
+    *group = v & 1;
+    *mittente = p[n] | (p[n+1] << 8);
+    *destinatario = p[n+2] | (p[n+3] << 8);
+    bits = p[n+4] | (p[n+5] << 8) | (p[n+6] << 16) | ((uint32_t)p[n+7] << 24);
+    memcpy(valore, &bits, sizeof(float));
+    return n + 8;
+}
+
+
+static void ts_set_day(TS_Store *ts, int64_t tempo)
+{
+    time_t secs = tempo / 1000;
+    struct tm day;
+
+    localtime_r(&secs, &day);
+    strftime(ts->day, sizeof(ts->day), "%Y%m%d", &day);
+    day.tm_hour = 0;
+    day.tm_min = 0;
+    day.tm_sec = 0;
+    day.tm_isdst = -1;
+    ts->day_start = (int64_t)mktime(&day) * 1000;
+    day.tm_mday++;
+    day.tm_isdst = -1;
+    ts->day_end = (int64_t)mktime(&day) * 1000;
+}
+
+
+static int ts_segment_flush(TS_Segment *seg)
+{
+    if( seg->buflen == 0 ) return 0;
+    if( ts_write_all(seg->fd, seg->buf, seg->buflen) != 0 )
+    {
+        perror("tsstore: write");
+        return 1;
+    }
+    seg->buflen = 0;
+    return 0;
+}
+
+
+static int ts_close_segments(TS_Store *ts)
+{
+    int i;
+    int errors = 0;
+    TS_Segment *seg;
+
+    for( i = 0; i < TS_BUCKETS; i++ )
+    {
+        while( ts->bucket[i] != NULL )
+        {
+            seg = ts->bucket[i];
+            ts->bucket[i] = seg->next;
+            errors += ts_segment_flush(seg);
+            close(seg->fd);
+            close(seg->idxfd);
+            free(seg);
+        }
+    }
+    ts->open = 0;
+    return errors;
+}
+
+
+static int ts_close_lru(TS_Store *ts)
+{
+    /*
+     *  chiude il segmento usato meno di recente, gli altri restano aperti
+     *  return 1: errore di scrittura dei dati in attesa
+     */
+    int i;
+    int errors;
+    TS_Segment **pp;
+    TS_Segment **lru = NULL;
+    TS_Segment *seg;
+
+    for( i = 0; i < TS_BUCKETS; i++ )
+    {
+        for( pp = &ts->bucket[i]; *pp != NULL; pp = &(*pp)->next )
+        {
+            if( lru == NULL || (*pp)->uso < (*lru)->uso ) lru = pp;
+        }
+    }
+    if( lru == NULL ) return 0;
+
+    seg = *lru;
+    *lru = seg->next;
+    errors = ts_segment_flush(seg);
+    close(seg->fd);
+    close(seg->idxfd);
+    free(seg);
+    ts->open--;
+    return errors;
+}
+
+
+static int ts_recover(TS_Segment *seg, off_t size)
+{
+    /*
+     *  riapertura di un segmento esistente: scarta le voci di indice oltre la
+     *  fine dei dati e decodifica i record successivi all'ultima voce valida
+     */
+    TS_IndexEntry entry;
+    struct stat st;
+    unsigned char *data, *p, *end;
+    uint64_t delta;
+    uint16_t mittente, destinatario;
+    float valore;
+    int group, n;
+    off_t entries;
+    int64_t tempo;
+    uint32_t records = 0;
+
+    fstat(seg->idxfd, &st);
+    entries = st.st_size / sizeof(TS_IndexEntry);
+    while( entries > 0 )
+    {
+        if( pread(seg->idxfd, &entry, sizeof(entry), (entries - 1) * sizeof(TS_IndexEntry)) == sizeof(entry) &&
+            entry.offset < (uint64_t)size )
+        {
+            break;
+        }
+        entries--;
+    }
+    if( entries == 0 )
+    {
+        if( pread(seg->fd, &entry.tempo, sizeof(int64_t), 8) != sizeof(int64_t) ) return 1;
+        entry.offset = TS_HEADER_SIZE;
+    }
+    ftruncate(seg->idxfd, entries * sizeof(TS_IndexEntry));
+
+    data = (unsigned char*) malloc(size - entry.offset + 1);
+    if( data == NULL ) return 1;
+    n = pread(seg->fd, data, size - entry.offset, entry.offset);
+    p = data;
+    end = data + (n > 0 ? n : 0);
+    tempo = entry.tempo;
+    while( (n = ts_decode(p, end, &delta, &group, &mittente, &destinatario, &valore)) > 0 )
+    {
+        // il primo record dopo una voce di indice ha il tempo della voce stessa
+        if( records > 0 || entries == 0 ) tempo += delta;
+        records++;
+        p += n;
+    }
+
+    seg->last = tempo;
+    seg->records = records;
+    seg->offset = entry.offset + (p - data);
+    free(data);
+
+    if( (off_t)seg->offset < size )
+    {
+        ftruncate(seg->fd, seg->offset);
+    }
+    lseek(seg->fd, seg->offset, SEEK_SET);
+    return 0;
+}
+
+
+static TS_Segment *ts_segment_open(TS_Store *ts, uint32_t key, int64_t tempo)
+{
+    char path[512];
+    char idxpath[520];
+    unsigned char header[TS_HEADER_SIZE];
+    unsigned int indirizzo = key & 0xffff;
+    struct stat st;
+    TS_Segment *seg;
+    int errore;
+
+    if( ts->per_address )
+    {
+        snprintf(path, sizeof(path), "%s/%s", ts->dir, ts->day);
+        mkdir(path, 0755);
+        if( key >> 16 )
+        {
+            snprintf(path, sizeof(path), "%s/%s/%u-%u-%u.seg", ts->dir, ts->day,
+                     (indirizzo >> 11) & 0x0f, (indirizzo >> 8) & 0x07, indirizzo & 0xff);
+        }
+        else
+        {
+            snprintf(path, sizeof(path), "%s/%s/%u.%u.%u.seg", ts->dir, ts->day,
+                     (indirizzo >> 12) & 0x0f, (indirizzo >> 8) & 0x0f, indirizzo & 0xff);
+        }
+    }
+    else
+    {
+        snprintf(path, sizeof(path), "%s/%s.seg", ts->dir, ts->day);
+    }
+    snprintf(idxpath, sizeof(idxpath), "%s.idx", path);
+
+    seg = (TS_Segment*) malloc(sizeof(TS_Segment));
+    if( seg == NULL ) return NULL;
+    seg->key = key;
+    seg->buflen = 0;
+    seg->fd = open(path, O_RDWR | O_CREAT, 0644);
+    seg->idxfd = open(idxpath, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if( seg->fd < 0 || seg->idxfd < 0 )
+    {
+        errore = errno;
+        perror(path);
+        if( seg->fd >= 0 ) close(seg->fd);
+        if( seg->idxfd >= 0 ) close(seg->idxfd);
+        free(seg);
+        errno = errore;             // EMFILE viene gestito da ts_append
+        return NULL;
+    }
+
+    fstat(seg->fd, &st);
+    if( st.st_size > TS_HEADER_SIZE && ts_recover(seg, st.st_size) == 0 )
+    {
+        return seg;
+    }
+
+    // segmento nuovo (o vuoto): scrive l'intestazione
+    ftruncate(seg->fd, 0);
+    ftruncate(seg->idxfd, 0);
+    lseek(seg->fd, 0, SEEK_SET);
+    memcpy(header, TS_MAGIC, 8);
+    memcpy(header + 8, &tempo, sizeof(int64_t));
+    if( ts_write_all(seg->fd, header, TS_HEADER_SIZE) != 0 )
+    {
+        perror(path);
+        close(seg->fd);
+        close(seg->idxfd);
+        free(seg);
+        return NULL;
+    }
+    seg->last = tempo;
+    seg->records = 0;
+    seg->offset = TS_HEADER_SIZE;
+    return seg;
+}
+
+
+TS_Store *ts_open(char *dir, int per_address)
+{
+    TS_Store *ts;
+    struct rlimit limite;
+
+    if( mkdir(dir, 0755) != 0 && errno != EEXIST )
+    {
+        perror(dir);
+        return NULL;
+    }
+
+    ts = (TS_Store*) malloc(sizeof(TS_Store));
+    if( ts == NULL ) return NULL;
+    memset(ts, 0, sizeof(TS_Store));
+    strncpy(ts->dir, dir, sizeof(ts->dir) - 1);
+    ts->per_address = per_address;
+
+    //ogni segmento usa due descrittori (.seg e .idx): il limite segue RLIMIT_NOFILE
+    ts->max_open = TS_MAX_OPEN;
+    if( getrlimit(RLIMIT_NOFILE, &limite) == 0 && limite.rlim_cur != RLIM_INFINITY &&
+        limite.rlim_cur < (rlim_t)(2 * TS_MAX_OPEN + TS_FD_RISERVA) )
+    {
+        ts->max_open = (limite.rlim_cur > 2 * TS_FD_RISERVA) ? (int)(limite.rlim_cur - TS_FD_RISERVA) / 2 : 1;
+    }
+    return ts;
+}
+
+
+int ts_append(TS_Store *ts, int64_t tempo, uint16_t mittente, uint16_t destinatario, int group, float valore)
+{
+    /*
+     *  return 0: record aggiunto
+     *  return 1: impossibile aprire il segmento
+     *  return 2: errore di scrittura
+     */
+    TS_Segment *seg;
+    TS_IndexEntry entry;
+    unsigned char *p;
+    uint32_t key;
+    uint32_t bits;
+    int n;
+
+    group = (group != 0);
+    if( tempo < ts->day_start || tempo >= ts->day_end )
+    {
+        ts_close_segments(ts);
+        ts_set_day(ts, tempo);
+    }
+
+    key = ts->per_address ? ((uint32_t)group << 16) | destinatario : TS_DAILY_KEY;
+    for( seg = ts->bucket[key % TS_BUCKETS]; seg != NULL && seg->key != key; seg = seg->next );
+    if( seg == NULL )
+    {
+        if( ts->open >= ts->max_open )
+        {
+            ts_close_lru(ts);
+        }
+        seg = ts_segment_open(ts, key, tempo);
+        while( seg == NULL && errno == EMFILE && ts->open > 0 )
+        {
+            //descrittori esauriti da altre parti del programma: si chiude un segmento alla volta
+            ts_close_lru(ts);
+            seg = ts_segment_open(ts, key, tempo);
+        }
+        if( seg == NULL ) return 1;
+        seg->next = ts->bucket[key % TS_BUCKETS];
+        ts->bucket[key % TS_BUCKETS] = seg;
+        ts->open++;
+    }
+
+    seg->uso = ++ts->uso;
+
+    // l'orologio puo' tornare indietro (NTP): i tempi nel segmento restano crescenti
+    if( tempo < seg->last ) tempo = seg->last;
+
+    if( seg->buflen + TS_RECORD_MAX > TS_BUFSIZE && ts_segment_flush(seg) != 0 )
+    {
+        return 2;
+    }
+
+    if( seg->records % TS_INDEX_EVERY == 0 )
+    {
+        entry.tempo = tempo;
+        entry.offset = seg->offset;
+        if( ts_write_all(seg->idxfd, (unsigned char*)&entry, sizeof(entry)) != 0 )
+        {
+            perror("tsstore: index");
+            return 2;
+        }
+    }
+
+    p = seg->buf + seg->buflen;
+    n = ts_varint_put(p, ((uint64_t)(tempo - seg->last) << 1) | group);
+    p[n++] = mittente & 0xff;
+    p[n++] = mittente >> 8;
+    p[n++] = destinatario & 0xff;
+    p[n++] = destinatario >> 8;
+    memcpy(&bits, &valore, sizeof(float));
+    p[n++] = bits & 0xff;
+    p[n++] = (bits >> 8) & 0xff;
+    p[n++] = (bits >> 16) & 0xff;
+    p[n++] = bits >> 24;
+
+    seg->buflen += n;
+    seg->offset += n;
+    seg->last = tempo;
+    seg->records++;
+
+    if( tempo - ts->last_flush >= TS_FLUSH_INTERVAL )
+    {
+        ts->last_flush = tempo;
+        return ts_flush(ts) == 0 ? 0 : 2;
+    }
+    return 0;
+}
+
+
+int ts_flush(TS_Store *ts)
+{
+    int i;
+    int errors = 0;
+    TS_Segment *seg;
+
+    for( i = 0; i < TS_BUCKETS; i++ )
+    {
+        for( seg = ts->bucket[i]; seg != NULL; seg = seg->next )
+        {
+            errors += ts_segment_flush(seg);
+        }
+    }
+    return errors;
+}
+
+
+void ts_close(TS_Store *ts)
+{
+    if( ts == NULL ) return;
+    ts_close_segments(ts);
+    free(ts);
+}
+
+
+int ts_read(char *segment, int64_t from, int64_t to, TS_Callback callback, void *arg)
+{
+    /*
+     *  legge i record del segmento con tempo compreso tra from e to (inclusi)
+     *  return >= 0: numero di record passati alla callback
+     *  return -1: segmento non leggibile
+     */
+    char idxpath[520];
+    struct stat st;
+    int fd, idxfd;
+    unsigned char *data, *p, *end;
+    TS_IndexEntry *index = NULL;
+    size_t entries = 0;
+    size_t lo, hi, mid;
+    uint64_t start = TS_HEADER_SIZE;
+    int64_t tempo;
+    int from_index = 0;
+    uint64_t delta;
+    uint16_t mittente, destinatario;
+    float valore;
+    int group, n;
+    int count = 0;
+    size_t size;
+
+    fd = open(segment, O_RDONLY);
+    if( fd < 0 ) return -1;
+    if( fstat(fd, &st) != 0 || st.st_size < TS_HEADER_SIZE )
+    {
+        close(fd);
+        return -1;
+    }
+    size = st.st_size;
+    data = (unsigned char*) mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if( data == MAP_FAILED ) return -1;
+    if( memcmp(data, TS_MAGIC, 8) != 0 )
+    {
+        munmap(data, size);
+        return -1;
+    }
+    memcpy(&tempo, data + 8, sizeof(int64_t));
+
+    // ricerca binaria sull'indice: ultima voce con tempo <= from
+    snprintf(idxpath, sizeof(idxpath), "%s.idx", segment);
+    idxfd = open(idxpath, O_RDONLY);
+    if( idxfd >= 0 )
+    {
+        if( fstat(idxfd, &st) == 0 && st.st_size >= (off_t)sizeof(TS_IndexEntry) )
+        {
+            entries = st.st_size / sizeof(TS_IndexEntry);
+            index = (TS_IndexEntry*) mmap(NULL, entries * sizeof(TS_IndexEntry), PROT_READ, MAP_SHARED, idxfd, 0);
+            if( index == (TS_IndexEntry*) MAP_FAILED )
+            {
+                index = NULL;
+            }
+        }
+        close(idxfd);
+    }
+    if( index != NULL )
+    {
+        lo = 0;
+        hi = entries;
+        while( lo < hi )
+        {
+            mid = (lo + hi) / 2;
+            if( index[mid].tempo <= from ) lo = mid + 1;
+            else hi = mid;
+        }
+        while( lo > 0 && index[lo - 1].offset >= size ) lo--;
+        if( lo > 0 )
+        {
+            start = index[lo - 1].offset;
+            tempo = index[lo - 1].tempo;
+            from_index = 1;
+        }
+        munmap(index, entries * sizeof(TS_IndexEntry));
+    }
+
+    p = data + start;
+    end = data + size;
+    while( (n = ts_decode(p, end, &delta, &group, &mittente, &destinatario, &valore)) > 0 )
+    {
+        if( from_index ) from_index = 0;
+        else tempo += delta;
+        p += n;
+
+        if( tempo > to ) break;
+        if( tempo >= from )
+        {
+            count++;
+            if( callback(tempo, mittente, destinatario, group, valore, arg) != 0 ) break;
+        }
+    }
+
+    munmap(data, size);
+    return count;
+}
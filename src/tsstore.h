@@ -0,0 +1,60 @@
+/*
+ * File:   tsstore.h
+ *
+ * Archivio locale append-only per serie temporali, alternativo a MySQL.
+ *
+ * I dati sono divisi in segmenti giornalieri, uno per indirizzo
+ * (<dir>/<AAAAMMGG>/<indirizzo>.seg) oppure uno per giorno (<dir>/<AAAAMMGG>.seg).
+ * Un segmento e' composto da un'intestazione seguita dai record:
+ *
+ *   intestazione:  "EDCTS001" + int64 tempo base (ms dal 1970)
+ *   record:        varint ((delta ms dal record precedente) << 1 | gruppo)
+ *                  uint16 mittente, uint16 destinatario, float valore (little endian)
+ *
+ * Ogni TS_INDEX_EVERY record viene aggiunta una voce {int64 tempo, uint64 offset}
+ * al file indice <segmento>.idx, che in lettura viene mappato con mmap() per
+ * posizionarsi sul tempo richiesto senza leggere l'intero segmento.
+ */
+
+#ifndef _TSSTORE_H
+#define	_TSSTORE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define TS_MAGIC            "EDCTS001"
+#define TS_HEADER_SIZE      16
+#define TS_RECORD_MAX       (10 + 8)        // varint massimo + mittente, destinatario, valore
+#define TS_INDEX_EVERY      64
+#define TS_BUFSIZE          8192
+#define TS_BUCKETS          256
+#define TS_MAX_OPEN         512             // oltre questo numero si chiude il segmento usato meno di recente
+#define TS_FD_RISERVA       64              // descrittori lasciati a socket, database e sink
+#define TS_FLUSH_INTERVAL   1000            // ms massimi di permanenza dei dati nei buffer
+
+typedef struct
+{
+    int64_t tempo;
+    uint64_t offset;
+} TS_IndexEntry;
+
+typedef struct TS_Store TS_Store;
+
+/* chiamata per ogni record letto, un valore diverso da 0 interrompe la lettura */
+typedef int (*TS_Callback)(int64_t tempo, uint16_t mittente, uint16_t destinatario, int group, float valore, void *arg);
+
+
+TS_Store *ts_open(char *dir, int per_address);
+int ts_append(TS_Store *ts, int64_t tempo, uint16_t mittente, uint16_t destinatario, int group, float valore);
+int ts_flush(TS_Store *ts);
+void ts_close(TS_Store *ts);
+int ts_read(char *segment, int64_t from, int64_t to, TS_Callback callback, void *arg);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _TSSTORE_H */